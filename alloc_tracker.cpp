@@ -0,0 +1,185 @@
+#include "alloc_tracker.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> gAllocCount(0);
+    std::atomic<uint64_t> gAllocBytes(0);
+    std::atomic<uint64_t> gFreeCount(0);
+
+    // Strict mode: set between allocTrackerBeginFrame/EndFrame once warm-up is over
+    std::atomic<bool> gStrictActive(false);
+    std::atomic<uint64_t> gStrictViolations(0);
+    bool gStrictEnabled = false;
+    bool gStrictAbort = false;
+    uint64_t gWarmupFrames = 120;
+
+    std::atomic<uint64_t> gFrameIndex(0);
+    AllocStats gFrameStart = {0, 0, 0};
+    AllocStats gLastFrame = {0, 0, 0};
+    AllocStats gSteadyTotals = {0, 0, 0};
+    AllocStats gPeakFrame = {0, 0, 0};
+    uint64_t gAllocatingSteadyFrames = 0;
+
+    const uint64_t MAX_REPORTED_VIOLATIONS = 16;
+
+    void recordAllocation(std::size_t size)
+    {
+        gAllocCount.fetch_add(1, std::memory_order_relaxed);
+        gAllocBytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (gStrictActive.load(std::memory_order_relaxed))
+        {
+            uint64_t violation = gStrictViolations.fetch_add(1, std::memory_order_relaxed);
+            // stdio does not go through operator new, so reporting here cannot recurse
+            if (violation < MAX_REPORTED_VIOLATIONS)
+                fprintf(stderr, "ALLOC::STRICT heap allocation of %zu bytes in steady-state frame %llu\n",
+                        size, static_cast<unsigned long long>(gFrameIndex.load(std::memory_order_relaxed)));
+            if (gStrictAbort)
+                abort();
+        }
+    }
+
+    void *allocate(std::size_t size, std::size_t alignment)
+    {
+        recordAllocation(size);
+        if (size == 0)
+            size = 1;
+        if (alignment <= alignof(std::max_align_t))
+            return malloc(size);
+        // aligned_alloc needs the size rounded up to the alignment
+        return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+
+    void release(void *p)
+    {
+        if (!p)
+            return;
+        gFreeCount.fetch_add(1, std::memory_order_relaxed);
+        free(p);
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *p = allocate(size, 0))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return allocate(size, 0);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void *p = allocate(size, static_cast<std::size_t>(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept
+{
+    release(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    release(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    release(p);
+}
+
+AllocStats allocTrackerTotals()
+{
+    return {gAllocCount.load(std::memory_order_relaxed), gAllocBytes.load(std::memory_order_relaxed),
+            gFreeCount.load(std::memory_order_relaxed)};
+}
+
+void allocTrackerInit()
+{
+    const char *strict = getenv("ORBITAL_ALLOC_STRICT");
+    if (strict && strcmp(strict, "0") != 0)
+    {
+        gStrictEnabled = true;
+        gStrictAbort = strcmp(strict, "abort") == 0;
+    }
+    if (const char *warmup = getenv("ORBITAL_ALLOC_WARMUP"))
+        gWarmupFrames = strtoull(warmup, NULL, 10);
+}
+
+void allocTrackerBeginFrame()
+{
+    gFrameStart = allocTrackerTotals();
+    if (gStrictEnabled && gFrameIndex.load() >= gWarmupFrames)
+        gStrictActive.store(true, std::memory_order_relaxed);
+}
+
+void allocTrackerEndFrame()
+{
+    gStrictActive.store(false, std::memory_order_relaxed);
+
+    AllocStats now = allocTrackerTotals();
+    gLastFrame = {now.count - gFrameStart.count, now.bytes - gFrameStart.bytes, now.frees - gFrameStart.frees};
+
+    if (gFrameIndex.load() >= gWarmupFrames)
+    {
+        gSteadyTotals.count += gLastFrame.count;
+        gSteadyTotals.bytes += gLastFrame.bytes;
+        gSteadyTotals.frees += gLastFrame.frees;
+        if (gLastFrame.count > 0)
+            ++gAllocatingSteadyFrames;
+    }
+    if (gLastFrame.count > gPeakFrame.count)
+        gPeakFrame = gLastFrame;
+    gFrameIndex.fetch_add(1);
+}
+
+AllocStats allocTrackerLastFrame()
+{
+    return gLastFrame;
+}
+
+void allocTrackerPrintSummary()
+{
+    AllocStats totals = allocTrackerTotals();
+    uint64_t frames = gFrameIndex.load();
+    uint64_t steadyFrames = frames > gWarmupFrames ? frames - gWarmupFrames : 0;
+
+    fprintf(stderr, "\nHeap allocations: %llu (%llu bytes), %llu frees over %llu frames\n",
+            static_cast<unsigned long long>(totals.count), static_cast<unsigned long long>(totals.bytes),
+            static_cast<unsigned long long>(totals.frees), static_cast<unsigned long long>(frames));
+    fprintf(stderr, "Peak frame: %llu allocations (%llu bytes)\n",
+            static_cast<unsigned long long>(gPeakFrame.count), static_cast<unsigned long long>(gPeakFrame.bytes));
+    if (steadyFrames > 0)
+    {
+        fprintf(stderr, "Steady state (after %llu warm-up frames): %.2f allocations/frame, %.0f bytes/frame, %llu of %llu frames allocated\n",
+                static_cast<unsigned long long>(gWarmupFrames),
+                static_cast<double>(gSteadyTotals.count) / steadyFrames,
+                static_cast<double>(gSteadyTotals.bytes) / steadyFrames,
+                static_cast<unsigned long long>(gAllocatingSteadyFrames),
+                static_cast<unsigned long long>(steadyFrames));
+    }
+    if (gStrictEnabled)
+        fprintf(stderr, "Strict mode: %llu steady-state allocations flagged\n",
+                static_cast<unsigned long long>(gStrictViolations.load()));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// Global heap allocation tracker. Linking alloc_tracker.cpp replaces
+// operator new/delete (make TRACK_ALLOCS=1 for the app, always for the
+// benchmarks). Environment:
+//   ORBITAL_ALLOC_STRICT=1      report every allocation made inside a frame after warm-up
+//   ORBITAL_ALLOC_STRICT=abort  abort on the first one (run under a debugger for the stack)
+//   ORBITAL_ALLOC_WARMUP=N      frames before strict mode arms (default 120)
+
+struct AllocStats
+{
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t frees;
+};
+
+// Totals since process start, across all threads
+AllocStats allocTrackerTotals();
+
+void allocTrackerInit();
+
+// Bracket one frame of the main loop
+void allocTrackerBeginFrame();
+void allocTrackerEndFrame();
+
+// Counts for the most recently finished frame
+AllocStats allocTrackerLastFrame();
+
+// Per-frame totals, peaks and strict-mode violations
+void allocTrackerPrintSummary();
@@ -0,0 +1,151 @@
+#include "asteroid_pool.h"
+#include "frame_bench.h"
+#include "geometry.h"
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // Per-instance model matrix (locations 1-4) and mesh slot (location 5), starting at row firstRow
+    void setInstanceAttributes(GLuint instanceBuffer, int firstRow)
+    {
+        GLintptr base = static_cast<GLintptr>(firstRow) * sizeof(AsteroidInstance);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+        for (int column = 0; column < 4; ++column)
+        {
+            glVertexAttribPointer(1 + column, 4, GL_FLOAT, GL_FALSE, sizeof(AsteroidInstance),
+                                  (void *)(base + offsetof(AsteroidInstance, model) + column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(1 + column);
+            glVertexAttribDivisor(1 + column, 1);
+        }
+        glVertexAttribIPointer(5, 1, GL_INT, sizeof(AsteroidInstance), (void *)(base + offsetof(AsteroidInstance, slot)));
+        glEnableVertexAttribArray(5);
+        glVertexAttribDivisor(5, 1);
+    }
+
+    // Same winding as generateAsteroidMesh, over every other stack and sector
+    void appendCoarseIndices(int sectors, int stacks, std::vector<unsigned int> &indices)
+    {
+        for (int i = 0; i + 2 <= stacks; i += 2)
+        {
+            for (int j = 0; j + 2 <= sectors; j += 2)
+            {
+                int first = i * (sectors + 1) + j;
+                int second = first + 2 * (sectors + 1);
+
+                indices.push_back(first);
+                indices.push_back(second);
+                indices.push_back(first + 2);
+
+                indices.push_back(second);
+                indices.push_back(second + 2);
+                indices.push_back(first + 2);
+            }
+        }
+    }
+}
+
+bool asteroidPoolInit(AsteroidPool &pool, int capacity)
+{
+    // Every slot shares the topology of one generated mesh
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    generateAsteroidMesh(1.0f, ASTEROID_SECTORS, ASTEROID_STACKS, vertices, indices);
+
+    pool.capacity = capacity;
+    pool.vertsPerSlot = static_cast<int>(vertices.size() / 3);
+    pool.indexCount = static_cast<GLsizei>(indices.size());
+    appendCoarseIndices(ASTEROID_SECTORS, ASTEROID_STACKS, indices);
+    pool.coarseIndexCount = static_cast<GLsizei>(indices.size()) - pool.indexCount;
+
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if (static_cast<long long>(capacity) * pool.vertsPerSlot * 3 > maxTexels)
+    {
+        std::cerr << "ERROR::ASTEROID_POOL::CAPACITY_EXCEEDS_TEXTURE_BUFFER " << capacity << std::endl;
+        return false;
+    }
+
+    glGenVertexArrays(1, &pool.vao);
+    glGenVertexArrays(1, &pool.coarseVao);
+    glGenBuffers(1, &pool.meshBuffer);
+    glGenBuffers(1, &pool.indexBuffer);
+    glGenBuffers(1, &pool.instanceBuffer);
+    glGenTextures(1, &pool.meshTexture);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, pool.meshBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(capacity) * pool.vertsPerSlot * 3 * sizeof(float),
+                 NULL, GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, pool.meshTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, pool.meshBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindVertexArray(pool.vao);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, pool.instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(AsteroidInstance), NULL, GL_STREAM_DRAW);
+    setInstanceAttributes(pool.instanceBuffer, 0);
+
+    // GL 3.3 has no base instance, so the coarse VAO's attributes are re-pointed per draw
+    glBindVertexArray(pool.coarseVao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.indexBuffer);
+    setInstanceAttributes(pool.instanceBuffer, 0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return true;
+}
+
+void asteroidPoolDestroy(AsteroidPool &pool)
+{
+    glDeleteVertexArrays(1, &pool.vao);
+    glDeleteVertexArrays(1, &pool.coarseVao);
+    glDeleteBuffers(1, &pool.meshBuffer);
+    glDeleteBuffers(1, &pool.indexBuffer);
+    glDeleteBuffers(1, &pool.instanceBuffer);
+    glDeleteTextures(1, &pool.meshTexture);
+    pool = AsteroidPool();
+}
+
+void asteroidPoolUpload(AsteroidPool &pool, int slot, const float *positions)
+{
+    if (slot < 0 || slot >= pool.capacity)
+        return;
+
+    GLsizeiptr slotBytes = static_cast<GLsizeiptr>(pool.vertsPerSlot) * 3 * sizeof(float);
+    glBindBuffer(GL_TEXTURE_BUFFER, pool.meshBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, slot * slotBytes, slotBytes, positions);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void asteroidPoolDraw(AsteroidPool &pool, const AsteroidInstance *instances, int count, int fullDetailCount)
+{
+    if (count <= 0)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, pool.instanceBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(AsteroidInstance), instances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0);
+    statsBindTexture(GL_TEXTURE_BUFFER, pool.meshTexture);
+    if (fullDetailCount > 0)
+    {
+        statsBindVertexArray(pool.vao);
+        statsDrawElementsInstanced(GL_TRIANGLES, pool.indexCount, GL_UNSIGNED_INT, 0, fullDetailCount);
+    }
+    if (fullDetailCount < count)
+    {
+        statsBindVertexArray(pool.coarseVao);
+        setInstanceAttributes(pool.instanceBuffer, fullDetailCount);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        statsDrawElementsInstanced(GL_TRIANGLES, pool.coarseIndexCount, GL_UNSIGNED_INT,
+                                   (void *)(pool.indexCount * sizeof(unsigned int)), count - fullDetailCount);
+    }
+}
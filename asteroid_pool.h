@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Fixed-capacity pool of GPU slots for asteroid meshes. All GL objects are
+// created once in asteroidPoolInit: slot meshes live side by side in one
+// buffer (read in the vertex shader through a texture buffer), the index
+// buffer is shared because every asteroid has the same topology, and one
+// instance buffer holds a row per live asteroid. Which slots are free is
+// tracked by the simulation (see sim_thread.h); here a spawn is only a
+// glBufferSubData into an existing slot.
+//
+// The index buffer also holds a coarse level of detail that uses every other
+// stack and sector of the same vertices, so a far asteroid needs no mesh of
+// its own.
+struct AsteroidPool
+{
+    GLuint vao = 0;
+    GLuint coarseVao = 0; // same buffers; instance rows start after the full-detail ones
+    GLuint meshBuffer = 0;  // capacity * vertsPerSlot positions (3 floats each)
+    GLuint meshTexture = 0; // GL_R32F texture buffer view of meshBuffer
+    GLuint indexBuffer = 0;
+    GLuint instanceBuffer = 0; // capacity rows of AsteroidInstance
+    int capacity = 0;
+    int vertsPerSlot = 0;
+    GLsizei indexCount = 0;       // full-detail indices, first in the index buffer
+    GLsizei coarseIndexCount = 0; // coarse indices, after the full-detail ones
+};
+
+// One row of the instance buffer
+struct AsteroidInstance
+{
+    glm::mat4 model;
+    GLint slot;
+};
+
+// Mesh tessellation shared by every slot
+const int ASTEROID_SECTORS = 16;
+const int ASTEROID_STACKS = 8;
+
+bool asteroidPoolInit(AsteroidPool &pool, int capacity);
+void asteroidPoolDestroy(AsteroidPool &pool);
+
+// Overwrite a slot's mesh with vertsPerSlot positions (3 floats each)
+void asteroidPoolUpload(AsteroidPool &pool, int slot, const float *positions);
+
+// Upload count instance rows and draw them: the first fullDetailCount with the
+// full mesh, the rest with the coarse one (one instanced call each). The
+// asteroid program must already be in use; the mesh texture goes on unit 0.
+void asteroidPoolDraw(AsteroidPool &pool, const AsteroidInstance *instances, int count, int fullDetailCount);
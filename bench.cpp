@@ -0,0 +1,893 @@
+// Micro-benchmarks for the mesh, collision, asteroid update, star, BVH,
+// SGP4, catalog ingestion and force model hot paths.
+// Runs headless (no GL context) and writes results as JSON.
+//
+//   ./orbital_bench [--filter <substring>] [--min-time <seconds>] [--out <file>]
+
+#include "alloc_tracker.h"
+#include "body_bvh.h"
+#include "catalog_reader.h"
+#include "do_not_optimize.h"
+#include "drag.h"
+#include "force_model.h"
+#include "geometry.h"
+#include "geopotential.h"
+#include "gravity_grid.h"
+#include "integrator.h"
+#include "lunisolar.h"
+#include "satellite_catalog.h"
+#include "simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchResult
+{
+    std::string name;
+    std::string params; // pre-formatted JSON object
+    uint64_t iterations;
+    double nsPerOp;
+    double itemsPerSecond;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+struct BenchOptions
+{
+    std::string filter;
+    double minTime = 0.2;
+};
+
+static std::vector<BenchResult> gResults;
+static BenchOptions gOptions;
+
+static double nowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Run op in growing batches until minTime is reached, then report the median of 5 timed batches
+template <typename Op>
+static void runBench(const std::string &name, const std::string &params, double itemsPerOp, Op op)
+{
+    std::string fullName = name + params;
+    if (!gOptions.filter.empty() && fullName.find(gOptions.filter) == std::string::npos)
+        return;
+
+    // Warm up and calibrate the batch size
+    uint64_t batch = 1;
+    for (;;)
+    {
+        double start = nowSeconds();
+        for (uint64_t i = 0; i < batch; ++i)
+            op();
+        double elapsed = nowSeconds() - start;
+        if (elapsed >= gOptions.minTime / 5 || batch >= (1ull << 30))
+            break;
+        batch *= elapsed > 0 ? std::min<uint64_t>(10, static_cast<uint64_t>(gOptions.minTime / 5 / elapsed) + 1) : 10;
+    }
+
+    std::vector<double> samples;
+    samples.reserve(5); // keep the harness out of the allocation counts
+    uint64_t allocCount = 0;
+    uint64_t allocBytes = 0;
+    for (int run = 0; run < 5; ++run)
+    {
+        AllocStats before = allocTrackerTotals();
+        double start = nowSeconds();
+        for (uint64_t i = 0; i < batch; ++i)
+            op();
+        samples.push_back((nowSeconds() - start) / batch);
+        AllocStats after = allocTrackerTotals();
+        allocCount += after.count - before.count;
+        allocBytes += after.bytes - before.bytes;
+    }
+    std::sort(samples.begin(), samples.end());
+    double secondsPerOp = samples[samples.size() / 2];
+
+    BenchResult result;
+    result.name = name;
+    result.params = params;
+    result.iterations = batch * 5;
+    result.nsPerOp = secondsPerOp * 1e9;
+    result.itemsPerSecond = secondsPerOp > 0 ? itemsPerOp / secondsPerOp : 0.0;
+    result.allocsPerOp = static_cast<double>(allocCount) / result.iterations;
+    result.bytesPerOp = static_cast<double>(allocBytes) / result.iterations;
+    gResults.push_back(result);
+
+    std::cerr << fullName << ": " << result.nsPerOp << " ns/op, " << result.itemsPerSecond << " items/s, "
+              << result.allocsPerOp << " allocs/op" << std::endl;
+}
+
+static std::string params(const char *k1, double v1, const char *k2 = nullptr, double v2 = 0)
+{
+    std::ostringstream s;
+    s.precision(10);
+    s << "{\"" << k1 << "\":" << v1;
+    if (k2)
+        s << ",\"" << k2 << "\":" << v2;
+    s << "}";
+    return s.str();
+}
+
+// Deterministic asteroid field that stays inside the spawn annulus for a few steps
+static std::vector<Asteroid> makeField(int count)
+{
+    srand(1234);
+    std::vector<Asteroid> field(count);
+    for (Asteroid &asteroid : field)
+    {
+        float angle = static_cast<float>(rand()) / RAND_MAX * 2.0f * M_PI;
+        float radius = 3.0f + static_cast<float>(rand()) / RAND_MAX * 4.0f;
+        asteroid.position = glm::vec3(radius * cos(angle), radius * sin(angle), 0.0f);
+        asteroid.velocity = glm::normalize(-asteroid.position) * 2.0f;
+        asteroid.size = MIN_ASTEROID_SIZE + static_cast<float>(rand()) / RAND_MAX * (MAX_ASTEROID_SIZE - MIN_ASTEROID_SIZE);
+        asteroid.rotation = 0.0f;
+        asteroid.slot = -1;
+    }
+    return field;
+}
+
+static void benchMeshes()
+{
+    for (int segments : {16, 32, 64, 128})
+    {
+        std::vector<float> vertices;
+        std::vector<unsigned int> indices;
+        double items = (segments + 1) * (segments / 2 + 1);
+        runBench("generateSphere", params("segments", segments, "rings", segments / 2), items, [&]() {
+            vertices.clear();
+            indices.clear();
+            generateSphere(1.0f, segments, segments / 2, vertices, indices);
+            doNotOptimize(vertices.data());
+        });
+    }
+
+    for (int sectors : {16, 32, 64, 128})
+    {
+        double items = 6.0 * sectors * (sectors / 2);
+        runBench("createSphereVertices", params("sectors", sectors, "stacks", sectors / 2), items, [&]() {
+            std::vector<float> vertices = createSphereVertices(0.08f, sectors, sectors / 2);
+            doNotOptimize(vertices.data());
+        });
+    }
+
+    for (int sectors : {8, 16, 32, 64})
+    {
+        double items = (sectors + 1) * (sectors / 2 + 1);
+        runBench("generateAsteroidMesh", params("sectors", sectors, "stacks", sectors / 2), items, [&]() {
+            std::vector<float> vertices;
+            std::vector<unsigned int> indices;
+            generateAsteroidMesh(0.5f, sectors, sectors / 2, vertices, indices);
+            doNotOptimize(vertices.data());
+        });
+    }
+}
+
+static void benchCollision()
+{
+    for (int count : {100, 10000, 1000000})
+    {
+        std::vector<Asteroid> field = makeField(count);
+        glm::vec3 satellitePos(1.75f, 0.0f, 0.0f);
+        runBench("checkCollision", params("bodies", count), count, [&]() {
+            int hits = 0;
+            for (const Asteroid &asteroid : field)
+                hits += checkCollision(satellitePos, 0.08f, asteroid);
+            doNotOptimize(hits);
+        });
+    }
+}
+
+static void benchUpdate()
+{
+    for (int count : {100, 10000, 1000000})
+    {
+        for (float step : {1.0f / 240.0f, 1.0f / 60.0f, 1.0f / 15.0f})
+        {
+            std::vector<Asteroid> field = makeField(count);
+            std::vector<Asteroid> pristine = field;
+            glm::vec3 satellitePos(100.0f, 0.0f, 0.0f); // out of reach, no collisions
+
+            // Step forward then back so the field stays populated; one op is one step
+            bool forward = true;
+            runBench("updateAsteroids", params("bodies", count, "dt", step), count, [&]() {
+                stepAsteroids(field, forward ? step : -step, satellitePos, 0.08f, nullptr);
+                forward = !forward;
+                if (field.size() != pristine.size())
+                    field = pristine;
+                doNotOptimize(field.data());
+            });
+        }
+    }
+}
+
+static void benchStars()
+{
+    for (int count : {1000, 10000, 100000})
+    {
+        srand(1234);
+        std::vector<glm::vec3> stars;
+        generateStars(count, stars);
+        std::vector<glm::vec3> positions(count);
+        float time = 0.0f;
+        runBench("computeStarPositions", params("stars", count), count, [&]() {
+            computeStarPositions(stars, time, 3.0f, positions.data());
+            time += 1.0f / 60.0f;
+            doNotOptimize(positions.data());
+        });
+    }
+}
+
+static void benchBvh()
+{
+    for (int count : {10000, 1000000})
+    {
+        std::vector<Asteroid> field = makeField(count);
+        BodyBvh bvh;
+        bvhInit(bvh, count);
+        for (int i = 0; i < count; ++i)
+            bvhSetBody(bvh, i, field[i].position, asteroidBoundingRadius(field[i]));
+        bvhUpdate(bvh);
+
+        // One op moves every body a step and refits
+        float step = 1.0f / 60.0f;
+        runBench("bvhRefit", params("bodies", count), count, [&]() {
+            for (int i = 0; i < count; ++i)
+                bvhSetBody(bvh, i, field[i].position + field[i].velocity * step, asteroidBoundingRadius(field[i]));
+            bvhUpdate(bvh);
+            step = -step;
+            doNotOptimize(bvh.nodes.data());
+        });
+
+        // Rays from the camera through random points of the field, and queries around those points
+        std::vector<glm::vec3> targets(256);
+        for (glm::vec3 &target : targets)
+        {
+            target = glm::vec3(static_cast<float>(rand()) / RAND_MAX * 14.0f - 7.0f,
+                               static_cast<float>(rand()) / RAND_MAX * 14.0f - 7.0f, 0.0f);
+        }
+        size_t query = 0;
+        runBench("bvhRayPick", params("bodies", count), 1, [&]() {
+            glm::vec3 direction = glm::normalize(targets[query++ % targets.size()] - CAMERA_POSITION);
+            int hit = bvhRayPick(bvh, CAMERA_POSITION, direction, 100.0f, nullptr);
+            doNotOptimize(hit);
+        });
+
+        std::vector<int> found;
+        found.reserve(count);
+        runBench("bvhQueryRadius", params("bodies", count, "radius", 0.1), 1, [&]() {
+            bvhQueryRadius(bvh, targets[query++ % targets.size()], 0.1f, found);
+            doNotOptimize(found.data());
+        });
+    }
+}
+
+static void benchSgp4()
+{
+    // One near-Earth object (Vanguard 1), alone and in a full batch
+    TleElements elements;
+    parseTle("1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753",
+             "2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667", elements);
+    Sgp4Satellite satellite;
+    sgp4Init(elements, satellite);
+    double minutes = 0.0;
+    runBench("sgp4Propagate", params("objects", 1), 1, [&]() {
+        double position[3], velocity[3];
+        sgp4Propagate(satellite, minutes, position, velocity);
+        minutes += 1.0;
+        doNotOptimize(position);
+    });
+
+    Sgp4Batch batch;
+    batch.count = SGP4_LANES;
+    for (int lane = 0; lane < SGP4_LANES; ++lane)
+        sgp4BatchSet(batch, lane, satellite);
+    double jd = satellite.epochJd;
+    runBench("sgp4PropagateBatch", params("objects", SGP4_LANES), SGP4_LANES, [&]() {
+        double position[3][SGP4_LANES], velocity[3][SGP4_LANES];
+        int errors[SGP4_LANES];
+        sgp4PropagateBatch(batch, jd, position, velocity, errors);
+        jd += 1.0 / 1440.0;
+        doNotOptimize(position);
+    });
+
+    // A catalog-sized mix of near-Earth and deep-space orbits on one thread
+    for (int count : {30000})
+    {
+        SatelliteCatalog catalog;
+        catalogGenerate(catalog, count, 42);
+        std::vector<glm::vec4> positions(catalogSize(catalog));
+        double catalogJd = catalog.newestEpochJd;
+        runBench("catalogPropagate", params("objects", count, "deepSpace", catalog.deepSpace.size()), count, [&]() {
+            catalogPropagate(catalog, catalogJd, 0, 1, positions.data());
+            catalogJd += 1.0 / 1440.0;
+            doNotOptimize(positions.data());
+        });
+    }
+}
+
+// Calendar date and fraction of the day of a Julian date (Meeus)
+static void calendarDate(double jd, int &year, int &month, int &day, double &dayFraction)
+{
+    double z = std::floor(jd + 0.5);
+    dayFraction = jd + 0.5 - z;
+    double alpha = std::floor((z - 1867216.25) / 36524.25);
+    double b = z + 1.0 + alpha - std::floor(alpha / 4.0) + 1524.0;
+    double c = std::floor((b - 122.1) / 365.25);
+    double e = std::floor((b - std::floor(365.25 * c)) / 30.6001);
+    day = static_cast<int>(b - std::floor(365.25 * c) - std::floor(30.6001 * e));
+    month = static_cast<int>(e < 14.0 ? e - 1.0 : e - 13.0);
+    year = static_cast<int>(month > 2 ? c - 4716.0 : c - 4715.0);
+}
+
+// Three-line element sets (name line, then the pair) with valid checksums
+static void appendTle(std::string &out, const TleElements &elements)
+{
+    const double degrees = 180.0 / M_PI;
+    int year, month, day;
+    double dayFraction;
+    calendarDate(elements.epochJd, year, month, day, dayFraction);
+    double dayOfYear = elements.epochJd - julianDate(year, 1, 0, 0, 0, 0.0);
+
+    double magnitude = std::fabs(elements.bstar);
+    int exponent = magnitude > 0.0 ? static_cast<int>(std::floor(std::log10(magnitude))) + 1 : 0;
+    long mantissa = std::lround(magnitude / std::pow(10.0, exponent) * 1e5);
+    if (mantissa >= 100000)
+    {
+        mantissa /= 10;
+        ++exponent;
+    }
+
+    char lines[2][96];
+    snprintf(lines[0], sizeof(lines[0]), "1 %05dU 24001A   %02d%012.8f  .00000000  00000-0 %c%05ld%c%d 0  999",
+             elements.catalogNumber, year % 100, dayOfYear, elements.bstar < 0.0 ? '-' : ' ', mantissa,
+             exponent < 0 ? '-' : '+', std::abs(exponent));
+    snprintf(lines[1], sizeof(lines[1]), "2 %05d %8.4f %8.4f %07ld %8.4f %8.4f %11.8f%05d", elements.catalogNumber,
+             elements.inclination * degrees, elements.rightAscension * degrees,
+             std::lround(elements.eccentricity * 1e7), elements.argumentOfPerigee * degrees,
+             elements.meanAnomaly * degrees, elements.meanMotion * 1440.0 / (2.0 * M_PI), 1234);
+    out += "OBJECT " + std::to_string(elements.catalogNumber) + "\n";
+    for (char *line : lines)
+    {
+        int sum = 0;
+        for (int i = 0; i < 68; ++i)
+            sum += line[i] >= '0' && line[i] <= '9' ? line[i] - '0' : line[i] == '-';
+        out += line;
+        out += static_cast<char>('0' + sum % 10);
+        out += '\n';
+    }
+}
+
+// The OMM keywords CelesTrak writes, in order, for one object
+static std::vector<std::pair<const char *, std::string>> ommFields(const TleElements &elements)
+{
+    const double degrees = 180.0 / M_PI;
+    int year, month, day;
+    double dayFraction;
+    calendarDate(elements.epochJd, year, month, day, dayFraction);
+    double seconds = dayFraction * 86400.0;
+    int hour = static_cast<int>(seconds / 3600.0);
+    int minute = static_cast<int>((seconds - hour * 3600.0) / 60.0);
+
+    char epoch[40], number[8][32];
+    snprintf(epoch, sizeof(epoch), "%04d-%02d-%02dT%02d:%02d:%09.6f", year, month, day, hour, minute,
+             seconds - hour * 3600.0 - minute * 60.0);
+    snprintf(number[0], sizeof(number[0]), "%.8f", elements.meanMotion * 1440.0 / (2.0 * M_PI));
+    snprintf(number[1], sizeof(number[1]), "%.7f", elements.eccentricity);
+    snprintf(number[2], sizeof(number[2]), "%.4f", elements.inclination * degrees);
+    snprintf(number[3], sizeof(number[3]), "%.4f", elements.rightAscension * degrees);
+    snprintf(number[4], sizeof(number[4]), "%.4f", elements.argumentOfPerigee * degrees);
+    snprintf(number[5], sizeof(number[5]), "%.4f", elements.meanAnomaly * degrees);
+    snprintf(number[6], sizeof(number[6]), "%d", elements.catalogNumber);
+    snprintf(number[7], sizeof(number[7]), "%.5g", elements.bstar);
+    return {{"OBJECT_NAME", "OBJECT " + std::string(number[6])},
+            {"OBJECT_ID", "2024-001A"},
+            {"CENTER_NAME", "EARTH"},
+            {"REF_FRAME", "TEME"},
+            {"TIME_SYSTEM", "UTC"},
+            {"MEAN_ELEMENT_THEORY", "SGP4"},
+            {"EPOCH", epoch},
+            {"MEAN_MOTION", number[0]},
+            {"ECCENTRICITY", number[1]},
+            {"INCLINATION", number[2]},
+            {"RA_OF_ASC_NODE", number[3]},
+            {"ARG_OF_PERICENTER", number[4]},
+            {"MEAN_ANOMALY", number[5]},
+            {"EPHEMERIS_TYPE", "0"},
+            {"CLASSIFICATION_TYPE", "U"},
+            {"NORAD_CAT_ID", number[6]},
+            {"ELEMENT_SET_NO", "999"},
+            {"REV_AT_EPOCH", "1234"},
+            {"BSTAR", number[7]},
+            {"MEAN_MOTION_DOT", "0"},
+            {"MEAN_MOTION_DDOT", "0"}};
+}
+
+static void appendOmmKvn(std::string &out, const TleElements &elements)
+{
+    out += "CCSDS_OMM_VERS = 2.0\nCREATION_DATE = 2024-01-01T00:00:00\nORIGINATOR = ORBITAL\n";
+    for (const auto &field : ommFields(elements))
+        out += std::string(field.first) + " = " + field.second + "\n";
+}
+
+static void appendOmmXml(std::string &out, const TleElements &elements)
+{
+    out += "<omm id=\"CCSDS_OMM_VERS\" version=\"2.0\">\n<header><CREATION_DATE/><ORIGINATOR/></header>\n"
+           "<body><segment><metadata>\n";
+    for (const auto &field : ommFields(elements))
+    {
+        if (strcmp(field.first, "EPOCH") == 0)
+            out += "</metadata><data><meanElements>\n";
+        else if (strcmp(field.first, "EPHEMERIS_TYPE") == 0)
+            out += "</meanElements><tleParameters>\n";
+        out += std::string("<") + field.first + ">" + field.second + "</" + field.first + ">\n";
+    }
+    out += "</tleParameters></data></segment></body></omm>\n";
+}
+
+// Catalog ingestion from memory; items are bytes, so items/s is the throughput in bytes/s
+static void benchCatalogReader()
+{
+    ElementTable source;
+    catalogGenerateElements(source, 30000, 42);
+    std::string texts[3];
+    for (int row = 0; row < elementTableSize(source); ++row)
+    {
+        TleElements elements = elementTableRow(source, row);
+        appendTle(texts[CATALOG_FORMAT_TLE], elements);
+        appendOmmKvn(texts[CATALOG_FORMAT_OMM_KVN], elements);
+        appendOmmXml(texts[CATALOG_FORMAT_OMM_XML], elements);
+    }
+
+    const char *names[3] = {"parseCatalogTle", "parseCatalogOmmKvn", "parseCatalogOmmXml"};
+    for (int format = 0; format < 3; ++format)
+    {
+        const std::string &text = texts[format];
+        runBench(names[format], params("objects", elementTableSize(source), "bytes", text.size()), text.size(), [&]() {
+            ElementTable table;
+            parseCatalogBuffer(text.data(), text.size(), table);
+            doNotOptimize(table.meanMotion.data());
+        });
+    }
+
+    // The reference parser on the same line pairs, for comparison
+    const std::string &tle = texts[CATALOG_FORMAT_TLE];
+    std::vector<std::string> pairs[2];
+    for (size_t start = 0; start < tle.size();)
+    {
+        size_t end = tle.find('\n', start);
+        if (tle[start] == '1' || tle[start] == '2')
+            pairs[tle[start] - '1'].push_back(tle.substr(start, end - start));
+        start = end + 1;
+    }
+    runBench("parseTle", params("objects", pairs[0].size(), "bytes", tle.size()), tle.size(), [&]() {
+        TleElements elements;
+        for (size_t i = 0; i < pairs[0].size(); ++i)
+        {
+            parseTle(pairs[0][i].c_str(), pairs[1][i].c_str(), elements);
+            doNotOptimize(elements);
+        }
+    });
+}
+
+static void benchGeopotential()
+{
+    // EGM96 4x4, then zero-extended fields at typical precise-orbit degrees;
+    // the cost depends only on the degree and order
+    for (int degree : {4, 20, 70})
+    {
+        Geopotential field;
+        geopotentialEgm96(field, 4, 4);
+        geopotentialSetDegree(field, degree, degree);
+        GeopotentialScratch scratch;
+        double position[3] = {4200.0, -3100.0, 4500.0};
+        runBench("geopotentialAcceleration", params("degree", degree), 1, [&]() {
+            double acceleration[3];
+            geopotentialAcceleration(field, position, acceleration, scratch);
+            position[0] += 1e-3;
+            doNotOptimize(acceleration);
+        });
+
+        double positions[3][GEOPOTENTIAL_LANES];
+        for (int lane = 0; lane < GEOPOTENTIAL_LANES; ++lane)
+        {
+            positions[0][lane] = 4200.0 + 100.0 * lane;
+            positions[1][lane] = -3100.0 + 50.0 * lane;
+            positions[2][lane] = 4500.0 - 200.0 * lane;
+        }
+        runBench("geopotentialAccelerationBatch", params("degree", degree, "objects", GEOPOTENTIAL_LANES),
+                 GEOPOTENTIAL_LANES, [&]() {
+                     double accelerations[3][GEOPOTENTIAL_LANES];
+                     geopotentialAccelerationBatch(field, positions, accelerations, scratch);
+                     positions[0][0] += 1e-3;
+                     doNotOptimize(accelerations);
+                 });
+    }
+
+    // The default lookup grid at scattered points, so most lookups miss the cache
+    Geopotential field;
+    geopotentialEgm96(field, 4, 4);
+    GravityGrid grid;
+    GravityGridSettings settings;
+    gravityGridCreate(field, settings, grid);
+    GeopotentialScratch scratch;
+    gravityGridFillShells(field, grid, 0, grid.header.shells, scratch);
+    uint32_t state = 1;
+    runBench("gravityGridAcceleration", params("angleStepDeg", settings.angleStepDeg, "shellStepKm", settings.shellStepKm),
+             1, [&]() {
+                 state = state * 1664525u + 1013904223u;
+                 double lon = state * (2.0 * M_PI / 4294967296.0);
+                 double lat = (state >> 7) * (M_PI / 33554432.0) - 0.5 * M_PI;
+                 double r = grid.header.innerRadius + (state & 127) * 6.0;
+                 double position[3] = {r * std::cos(lat) * std::cos(lon), r * std::cos(lat) * std::sin(lon),
+                                       r * std::sin(lat)};
+                 double acceleration[3];
+                 gravityGridAcceleration(grid, position, acceleration);
+                 doNotOptimize(acceleration);
+             });
+    gravityGridClose(grid);
+}
+
+static void benchDrag()
+{
+    DensityTable table;
+    densityTableBuild(table, DENSITY_HARRIS_PRIESTER);
+    double sun[3] = {0.9, 0.4, 0.17}, apex[3];
+    dragBulgeApex(sun, apex);
+
+    double position[3] = {4000.0, 4300.0, 3100.0}, velocity[3] = {-5.0, 3.9, 2.9};
+    runBench("dragAcceleration", params("objects", 1), 1, [&]() {
+        double acceleration[3];
+        dragAcceleration(table, position, velocity, 0.02, apex, acceleration);
+        position[2] += 1e-3;
+        doNotOptimize(acceleration);
+    });
+
+    double positions[3][DRAG_LANES], velocities[3][DRAG_LANES], ballistic[DRAG_LANES];
+    for (int lane = 0; lane < DRAG_LANES; ++lane)
+    {
+        positions[0][lane] = 4000.0 + 20.0 * lane;
+        positions[1][lane] = 4300.0 - 30.0 * lane;
+        positions[2][lane] = 3100.0 + 10.0 * lane;
+        velocities[0][lane] = -5.0;
+        velocities[1][lane] = 3.9;
+        velocities[2][lane] = 2.9;
+        ballistic[lane] = 0.01 + 0.005 * lane;
+    }
+    runBench("dragAccelerationBatch", params("objects", DRAG_LANES), DRAG_LANES, [&]() {
+        double accelerations[3][DRAG_LANES];
+        dragAccelerationBatch(table, positions, velocities, ballistic, apex, accelerations);
+        positions[2][0] += 1e-3;
+        doNotOptimize(accelerations);
+    });
+
+    // Lifetimes of low orbits from 200 to 1000 km, most of which reenter within 25 years
+    const int count = 256;
+    std::vector<double> a(count), e(count), inclination(count), b(count), lifetime(count);
+    for (int i = 0; i < count; ++i)
+    {
+        e[i] = 0.001 * (i % 20);
+        a[i] = (6578.0 + 800.0 * i / count) / (1.0 - e[i]);
+        inclination[i] = 0.01 * (i % 170);
+        b[i] = 0.005 + 0.0003 * (i % 100);
+    }
+    DecaySettings settings;
+    runBench("predictDecay", params("objects", count), count, [&]() {
+        predictDecay(table, settings, a.data(), e.data(), inclination.data(), b.data(), count, lifetime.data());
+        doNotOptimize(lifetime.data());
+    });
+}
+
+static void benchLunisolar()
+{
+    // The shared ephemeris terms, then the per-object pass over a batch
+    LunisolarStep step;
+    double jd = 2461000.5;
+    runBench("lunisolarPrepare", params("objects", 1), 1, [&]() {
+        jd += 1.0 / 1440.0;
+        lunisolarPrepare(step, jd);
+        doNotOptimize(step.moon);
+    });
+
+    double positions[3][LUNISOLAR_LANES], reflectivity[LUNISOLAR_LANES];
+    for (int lane = 0; lane < LUNISOLAR_LANES; ++lane)
+    {
+        double angle = 2.0 * M_PI * lane / LUNISOLAR_LANES;
+        positions[0][lane] = 7000.0 * std::cos(angle);
+        positions[1][lane] = 7000.0 * std::sin(angle);
+        positions[2][lane] = 100.0 * lane;
+        reflectivity[lane] = 0.02;
+    }
+    runBench("thirdBodyAccelerationBatch", params("objects", LUNISOLAR_LANES), LUNISOLAR_LANES, [&]() {
+        double accelerations[3][LUNISOLAR_LANES];
+        thirdBodyAccelerationBatch(step, positions, accelerations);
+        positions[2][0] += 1e-3;
+        doNotOptimize(accelerations);
+    });
+    for (ShadowModel shadow : {SHADOW_CYLINDRICAL, SHADOW_CONICAL})
+        runBench("solarPressureAccelerationBatch", params("objects", LUNISOLAR_LANES, "shadow", shadow),
+                 LUNISOLAR_LANES, [&]() {
+                     double accelerations[3][LUNISOLAR_LANES];
+                     solarPressureAccelerationBatch(step, positions, reflectivity, shadow, accelerations);
+                     positions[2][0] += 1e-3;
+                     doNotOptimize(accelerations);
+                 });
+}
+
+// The same terms behind a virtual call each, as a runtime-composed model would have them
+struct VirtualForceTerm
+{
+    virtual ~VirtualForceTerm() = default;
+    virtual void add(const ForceStep &step, const ForceBody &body, const double position[3], const double velocity[3],
+                     double acceleration[3]) const = 0;
+};
+
+template <typename Term>
+struct VirtualForceAdapter : VirtualForceTerm
+{
+    Term term;
+    explicit VirtualForceAdapter(const Term &t) : term(t)
+    {
+    }
+    void add(const ForceStep &step, const ForceBody &body, const double position[3], const double velocity[3],
+             double acceleration[3]) const override
+    {
+        term.add(step, body, position, velocity, acceleration);
+    }
+};
+
+static void benchForceModel()
+{
+    DensityTable table;
+    densityTableBuild(table, DENSITY_HARRIS_PRIESTER);
+    auto model = makeForceModel(PointMass(), J2(), Drag{&table});
+    ForceStep step;
+    model.prepare(step, 2461000.5);
+
+    std::vector<std::unique_ptr<VirtualForceTerm>> terms;
+    terms.emplace_back(new VirtualForceAdapter<PointMass>(PointMass()));
+    terms.emplace_back(new VirtualForceAdapter<J2>(J2()));
+    terms.emplace_back(new VirtualForceAdapter<Drag>(Drag{&table}));
+
+    ForceBody body;
+    body.ballistic = 0.02;
+    double position[3] = {4000.0, 4300.0, 3100.0}, velocity[3] = {-5.0, 3.9, 2.9};
+    runBench("forceModelAcceleration", params("terms", 3), 1, [&]() {
+        double acceleration[3];
+        model.acceleration(step, body, position, velocity, acceleration);
+        position[2] += 1e-3;
+        doNotOptimize(acceleration);
+    });
+    runBench("virtualForceAcceleration", params("terms", 3), 1, [&]() {
+        double acceleration[3] = {};
+        for (const auto &term : terms)
+            term->add(step, body, position, velocity, acceleration);
+        position[2] += 1e-3;
+        doNotOptimize(acceleration);
+    });
+
+    ForceLanes lanes;
+    double positions[3][FORCE_LANES], velocities[3][FORCE_LANES];
+    for (int lane = 0; lane < FORCE_LANES; ++lane)
+    {
+        positions[0][lane] = 4000.0 + 20.0 * lane;
+        positions[1][lane] = 4300.0 - 30.0 * lane;
+        positions[2][lane] = 3100.0 + 10.0 * lane;
+        velocities[0][lane] = -5.0;
+        velocities[1][lane] = 3.9;
+        velocities[2][lane] = 2.9;
+        lanes.ballistic[lane] = 0.01 + 0.005 * lane;
+        lanes.reflectivity[lane] = 0.0;
+    }
+    runBench("forceModelAccelerationBatch", params("terms", 3, "objects", FORCE_LANES), FORCE_LANES, [&]() {
+        double accelerations[3][FORCE_LANES];
+        model.accelerationBatch(step, lanes, positions, velocities, accelerations);
+        positions[2][0] += 1e-3;
+        doNotOptimize(accelerations);
+    });
+}
+
+static void benchIntegrator()
+{
+    // One orbit period of low orbits at a range of heights and eccentricities under point mass and J2
+    const int count = 64;
+    IntegratorBodies start;
+    integratorBodiesResize(start, count);
+    for (int b = 0; b < count; ++b)
+    {
+        double e = 0.02 * (b % 8), a = (6778.0 + 100.0 * (b / 8)) / (1.0 - e), inclination = 0.1 * b;
+        double speed = std::sqrt(GEOPOTENTIAL_MU * (1.0 + e) / (a * (1.0 - e)));
+        start.x[b] = a * (1.0 - e);
+        start.vy[b] = speed * std::cos(inclination);
+        start.vz[b] = speed * std::sin(inclination);
+    }
+    ForceModel<PointMass, J2> model;
+    IntegratorBodies bodies = start;
+    IntegratorScratch scratch;
+    for (IntegratorMethod method : {INTEGRATOR_DOPRI5, INTEGRATOR_DOP853})
+    {
+        IntegratorSettings settings;
+        settings.method = method;
+        runBench("integrateBodies", params("bodies", count, "method", method), count, [&]() {
+            bodies = start;
+            integrateBodies(model, settings, bodies, 2461000.5, 5400.0, nullptr, 0, count, scratch);
+            doNotOptimize(bodies.x[0]);
+        });
+    }
+}
+
+// Two-body state t seconds after periapsis, for an orbit starting on +x and
+// moving in the plane tilted by inclination about x
+static void keplerState(double a, double e, double inclination, double t, double state[6])
+{
+    double n = std::sqrt(GEOPOTENTIAL_MU / (a * a * a));
+    double meanAnomaly = n * t, E = meanAnomaly;
+    for (int i = 0; i < 50; ++i)
+        E -= (E - e * std::sin(E) - meanAnomaly) / (1.0 - e * std::cos(E));
+    double b = a * std::sqrt(1.0 - e * e), rate = n / (1.0 - e * std::cos(E));
+    double along[2] = {a * (std::cos(E) - e), -a * std::sin(E) * rate};
+    double across[2] = {b * std::sin(E), b * std::cos(E) * rate};
+    for (int c = 0; c < 2; ++c)
+    {
+        state[3 * c] = along[c];
+        state[3 * c + 1] = across[c] * std::cos(inclination);
+        state[3 * c + 2] = across[c] * std::sin(inclination);
+    }
+}
+
+// Largest position error in m against the two-body solution after seconds
+static double keplerError(const IntegratorSettings &settings, double seconds, IntegratorScratch &scratch)
+{
+    const int count = 16;
+    double a[count], e[count], inclination[count];
+    IntegratorBodies bodies;
+    integratorBodiesResize(bodies, count);
+    for (int b = 0; b < count; ++b)
+    {
+        e[b] = 0.05 * (b % 8);
+        a[b] = (6778.0 + 400.0 * (b / 8)) / (1.0 - e[b]);
+        inclination[b] = 0.2 * b;
+        double state[6];
+        keplerState(a[b], e[b], inclination[b], 0.0, state);
+        bodies.x[b] = state[0];
+        bodies.y[b] = state[1];
+        bodies.z[b] = state[2];
+        bodies.vx[b] = state[3];
+        bodies.vy[b] = state[4];
+        bodies.vz[b] = state[5];
+    }
+    ForceModel<PointMass> model;
+    if (integrateBodies(model, settings, bodies, 2461000.5, seconds, nullptr, 0, count, scratch) != 0)
+        return INFINITY;
+
+    double largest = 0.0;
+    for (int b = 0; b < count; ++b)
+    {
+        double state[6];
+        keplerState(a[b], e[b], inclination[b], seconds, state);
+        double dx = bodies.x[b] - state[0], dy = bodies.y[b] - state[1], dz = bodies.z[b] - state[2];
+        largest = std::max(largest, 1000.0 * std::sqrt(dx * dx + dy * dy + dz * dz));
+    }
+    return largest;
+}
+
+// Accuracy of both integrators on two-body orbits: the error after a day at
+// the default tolerances, and the order seen at fixed steps (the tolerance
+// made loose, so maxStep alone sets the step) when the step is halved.
+// False if a bound is missed; run alone with make integrator-check.
+static bool checkIntegrator()
+{
+    if (!gOptions.filter.empty() && std::string("integratorKepler").find(gOptions.filter) == std::string::npos)
+        return true;
+
+    struct Bound
+    {
+        IntegratorMethod method;
+        const char *name;
+        double dayErrorM;  // largest error after a day at the default tolerances
+        double orderStep;  // s, the coarser fixed step
+        double minOrder;
+    };
+    const Bound bounds[] = {{INTEGRATOR_DOPRI5, "DOPRI5", 20.0, 60.0, 4.5},
+                            {INTEGRATOR_DOP853, "DOP853", 2.0, 240.0, 7.5}};
+
+    IntegratorScratch scratch;
+    bool passed = true;
+    for (const Bound &bound : bounds)
+    {
+        IntegratorSettings settings;
+        settings.method = bound.method;
+        double dayError = keplerError(settings, 86400.0, scratch);
+
+        IntegratorSettings fixed = settings;
+        fixed.relativeTolerance = 1.0;
+        fixed.positionTolerance = fixed.velocityTolerance = 1e9;
+        double errors[2];
+        for (int halving = 0; halving < 2; ++halving)
+        {
+            fixed.maxStep = std::ldexp(bound.orderStep, -halving);
+            errors[halving] = keplerError(fixed, 5760.0, scratch);
+        }
+        double order = std::log2(errors[0] / errors[1]);
+
+        bool ok = dayError <= bound.dayErrorM && order >= bound.minOrder;
+        passed = passed && ok;
+        std::cerr << "integratorKepler{" << bound.name << "}: " << dayError << " m after a day (bound "
+                  << bound.dayErrorM << "), order " << order << " (at least " << bound.minOrder << ")"
+                  << (ok ? "" : " FAILED") << std::endl;
+    }
+    return passed;
+}
+
+static bool writeResults(const std::string &path)
+{
+    std::ofstream file;
+    if (!path.empty())
+    {
+        file.open(path);
+        if (!file)
+        {
+            std::cerr << "Failed to open " << path << std::endl;
+            return false;
+        }
+    }
+    std::ostream &out = path.empty() ? std::cout : file;
+
+    out << "{\n  \"context\": {\"min_time_s\": " << gOptions.minTime << "},\n  \"benchmarks\": [";
+    for (size_t i = 0; i < gResults.size(); ++i)
+    {
+        const BenchResult &r = gResults[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"params\": " << r.params
+            << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << r.nsPerOp
+            << ", \"items_per_second\": " << r.itemsPerSecond << ", \"allocs_per_op\": " << r.allocsPerOp
+            << ", \"bytes_per_op\": " << r.bytesPerOp << "}";
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char **argv)
+{
+    std::string outPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            gOptions.filter = argv[++i];
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+            gOptions.minTime = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--min-time <seconds>] [--out <file>]" << std::endl;
+            return -1;
+        }
+    }
+
+    benchMeshes();
+    benchCollision();
+    benchUpdate();
+    benchStars();
+    benchBvh();
+    benchSgp4();
+    benchCatalogReader();
+    benchGeopotential();
+    benchDrag();
+    benchLunisolar();
+    benchForceModel();
+    benchIntegrator();
+    bool checked = checkIntegrator();
+
+    return writeResults(outPath) && checked ? 0 : -1;
+}
@@ -0,0 +1,316 @@
+#include "body_bvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    const int MAX_DEPTH = 64;        // traversal stack; median splits keep the tree far shallower
+    const int MIN_REBUILD_ADDS = 16; // below this many added bodies, testing them one by one is cheaper
+
+    float surfaceArea(const BvhNode &node)
+    {
+        glm::vec3 extent = node.boundsMax - node.boundsMin;
+        if (extent.x < 0.0f)
+            return 0.0f; // no live bodies below this node
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    void setEmpty(BvhNode &node)
+    {
+        node.boundsMin = glm::vec3(FLT_MAX);
+        node.boundsMax = glm::vec3(-FLT_MAX);
+    }
+
+    void growToSphere(BvhNode &node, const glm::vec4 &sphere)
+    {
+        glm::vec3 center(sphere.x, sphere.y, sphere.z);
+        node.boundsMin = glm::min(node.boundsMin, center - glm::vec3(sphere.w));
+        node.boundsMax = glm::max(node.boundsMax, center + glm::vec3(sphere.w));
+    }
+
+    void fitLeaf(const BodyBvh &bvh, BvhNode &node)
+    {
+        setEmpty(node);
+        for (int i = node.first; i < node.first + node.count; ++i)
+        {
+            const glm::vec4 &sphere = bvh.spheres[bvh.order[i]];
+            if (sphere.w >= 0.0f)
+                growToSphere(node, sphere);
+        }
+    }
+
+    void fitInner(BvhNode &node, const BvhNode &left, const BvhNode &right)
+    {
+        node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+        node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+    }
+
+    // Build the subtree over order[begin, end) and return its node
+    int buildNode(BodyBvh &bvh, int begin, int end)
+    {
+        int index = static_cast<int>(bvh.nodes.size());
+        bvh.nodes.push_back(BvhNode());
+        if (end - begin <= BVH_LEAF_BODIES)
+        {
+            BvhNode &leaf = bvh.nodes[index];
+            leaf.first = begin;
+            leaf.count = end - begin;
+            fitLeaf(bvh, leaf);
+            return index;
+        }
+
+        // Split at the median center along the axis where the centers spread most
+        glm::vec3 centerMin(FLT_MAX), centerMax(-FLT_MAX);
+        for (int i = begin; i < end; ++i)
+        {
+            glm::vec3 center(bvh.spheres[bvh.order[i]]);
+            centerMin = glm::min(centerMin, center);
+            centerMax = glm::max(centerMax, center);
+        }
+        glm::vec3 spread = centerMax - centerMin;
+        int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+        int middle = (begin + end) / 2;
+        std::nth_element(bvh.order.begin() + begin, bvh.order.begin() + middle, bvh.order.begin() + end,
+                         [&bvh, axis](int a, int b) { return bvh.spheres[a][axis] < bvh.spheres[b][axis]; });
+
+        int left = buildNode(bvh, begin, middle);
+        int right = buildNode(bvh, middle, end);
+        BvhNode &node = bvh.nodes[index];
+        node.first = right;
+        node.count = 0;
+        fitInner(node, bvh.nodes[left], bvh.nodes[right]);
+        bvh.cost += surfaceArea(node);
+        return index;
+    }
+
+    void build(BodyBvh &bvh)
+    {
+        bvh.order.clear();
+        for (int body = 0; body < static_cast<int>(bvh.spheres.size()); ++body)
+        {
+            bvh.indexed[body] = bvh.spheres[body].w >= 0.0f;
+            if (bvh.indexed[body])
+                bvh.order.push_back(body);
+        }
+        bvh.pending.clear();
+        bvh.nodes.clear();
+        bvh.cost = 0.0f;
+        if (!bvh.order.empty())
+            buildNode(bvh, 0, static_cast<int>(bvh.order.size()));
+        bvh.builtCost = bvh.cost;
+        ++bvh.builds;
+    }
+
+    void refit(BodyBvh &bvh)
+    {
+        // Children follow their parents, so walking backwards fits them first
+        bvh.cost = 0.0f;
+        for (int i = static_cast<int>(bvh.nodes.size()) - 1; i >= 0; --i)
+        {
+            BvhNode &node = bvh.nodes[i];
+            if (node.count > 0)
+            {
+                fitLeaf(bvh, node);
+            }
+            else
+            {
+                fitInner(node, bvh.nodes[i + 1], bvh.nodes[node.first]);
+                bvh.cost += surfaceArea(node);
+            }
+        }
+        ++bvh.refits;
+    }
+
+    // Distance along the ray to the box, or FLT_MAX if it is missed before maxDistance
+    float rayBoxDistance(const BvhNode &node, const glm::vec3 &origin, const glm::vec3 &inverseDirection,
+                         float maxDistance)
+    {
+        if (node.boundsMax.x < node.boundsMin.x)
+            return FLT_MAX; // no live bodies below this node
+        glm::vec3 t0 = (node.boundsMin - origin) * inverseDirection;
+        glm::vec3 t1 = (node.boundsMax - origin) * inverseDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return enter <= exit ? enter : FLT_MAX;
+    }
+
+    // Distance along the ray to the sphere (0 from inside), or FLT_MAX if missed
+    float raySphereDistance(const glm::vec4 &sphere, const glm::vec3 &origin, const glm::vec3 &direction)
+    {
+        if (sphere.w < 0.0f)
+            return FLT_MAX;
+        glm::vec3 offset = origin - glm::vec3(sphere);
+        float b = glm::dot(offset, direction);
+        float c = glm::dot(offset, offset) - sphere.w * sphere.w;
+        if (c <= 0.0f)
+            return 0.0f;
+        float discriminant = b * b - c;
+        if (b > 0.0f || discriminant < 0.0f)
+            return FLT_MAX;
+        return -b - std::sqrt(discriminant);
+    }
+
+    bool spheresOverlap(const glm::vec4 &sphere, const glm::vec3 &center, float radius)
+    {
+        if (sphere.w < 0.0f)
+            return false;
+        glm::vec3 offset = glm::vec3(sphere) - center;
+        float reach = sphere.w + radius;
+        return glm::dot(offset, offset) < reach * reach;
+    }
+}
+
+void bvhInit(BodyBvh &bvh, int capacity)
+{
+    bvh = BodyBvh();
+    bvh.spheres.assign(capacity, glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+    bvh.indexed.assign(capacity, 0);
+    bvh.order.reserve(capacity);
+    bvh.pending.reserve(capacity);
+    bvh.nodes.reserve(2 * capacity);
+}
+
+void bvhSetBody(BodyBvh &bvh, int body, const glm::vec3 &center, float radius)
+{
+    glm::vec4 &sphere = bvh.spheres[body];
+    if (sphere.w < 0.0f)
+    {
+        ++bvh.liveBodies;
+        // A body removed since the last build keeps its place in the tree
+        if (!bvh.indexed[body])
+            bvh.pending.push_back(body);
+    }
+    sphere = glm::vec4(center, radius);
+}
+
+void bvhRemoveBody(BodyBvh &bvh, int body)
+{
+    glm::vec4 &sphere = bvh.spheres[body];
+    if (sphere.w < 0.0f)
+        return;
+    sphere.w = -1.0f;
+    --bvh.liveBodies;
+    if (!bvh.indexed[body])
+        bvh.pending.erase(std::find(bvh.pending.begin(), bvh.pending.end(), body));
+}
+
+void bvhUpdate(BodyBvh &bvh)
+{
+    if (static_cast<int>(bvh.pending.size()) > std::max(MIN_REBUILD_ADDS, bvh.liveBodies / 32))
+    {
+        build(bvh);
+        return;
+    }
+    refit(bvh);
+    if (bvh.builtCost > 0.0f && bvh.cost > BVH_REBUILD_COST * bvh.builtCost)
+        build(bvh);
+}
+
+int bvhRayPick(const BodyBvh &bvh, const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+               float *hitDistance)
+{
+    int hit = -1;
+    float nearest = maxDistance;
+
+    for (int body : bvh.pending)
+    {
+        float distance = raySphereDistance(bvh.spheres[body], origin, direction);
+        if (distance < nearest)
+        {
+            nearest = distance;
+            hit = body;
+        }
+    }
+
+    if (!bvh.nodes.empty())
+    {
+        glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        int stack[MAX_DEPTH];
+        int depth = 0;
+        if (rayBoxDistance(bvh.nodes[0], origin, inverseDirection, nearest) != FLT_MAX)
+            stack[depth++] = 0;
+        while (depth > 0)
+        {
+            const BvhNode &node = bvh.nodes[stack[--depth]];
+            if (rayBoxDistance(node, origin, inverseDirection, nearest) == FLT_MAX)
+                continue; // a closer hit was found since this node was pushed
+
+            if (node.count > 0)
+            {
+                for (int i = node.first; i < node.first + node.count; ++i)
+                {
+                    float distance = raySphereDistance(bvh.spheres[bvh.order[i]], origin, direction);
+                    if (distance < nearest)
+                    {
+                        nearest = distance;
+                        hit = bvh.order[i];
+                    }
+                }
+                continue;
+            }
+
+            // Visit the nearer child first so it can cut the farther one short
+            int left = static_cast<int>(&node - bvh.nodes.data()) + 1;
+            int right = node.first;
+            float leftDistance = rayBoxDistance(bvh.nodes[left], origin, inverseDirection, nearest);
+            float rightDistance = rayBoxDistance(bvh.nodes[right], origin, inverseDirection, nearest);
+            if (leftDistance > rightDistance)
+            {
+                std::swap(left, right);
+                std::swap(leftDistance, rightDistance);
+            }
+            if (rightDistance != FLT_MAX)
+                stack[depth++] = right;
+            if (leftDistance != FLT_MAX)
+                stack[depth++] = left;
+        }
+    }
+
+    if (hit >= 0 && hitDistance)
+        *hitDistance = nearest;
+    return hit;
+}
+
+void bvhQueryRadius(const BodyBvh &bvh, const glm::vec3 &center, float radius, std::vector<int> &out)
+{
+    out.clear();
+    for (int body : bvh.pending)
+    {
+        if (spheresOverlap(bvh.spheres[body], center, radius))
+            out.push_back(body);
+    }
+    if (bvh.nodes.empty())
+        return;
+
+    int stack[MAX_DEPTH];
+    int depth = 0;
+    stack[depth++] = 0;
+    while (depth > 0)
+    {
+        int index = stack[--depth];
+        const BvhNode &node = bvh.nodes[index];
+        if (node.boundsMax.x < node.boundsMin.x)
+            continue;
+        // Distance from the query center to the box (which already holds the body radii)
+        glm::vec3 offset = center - glm::clamp(center, node.boundsMin, node.boundsMax);
+        if (glm::dot(offset, offset) >= radius * radius)
+            continue;
+
+        if (node.count > 0)
+        {
+            for (int i = node.first; i < node.first + node.count; ++i)
+            {
+                if (spheresOverlap(bvh.spheres[bvh.order[i]], center, radius))
+                    out.push_back(bvh.order[i]);
+            }
+        }
+        else
+        {
+            stack[depth++] = node.first;
+            stack[depth++] = index + 1;
+        }
+    }
+}
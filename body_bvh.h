@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// Bounding volume hierarchy over body bounding spheres, for mouse picking
+// and neighbourhood queries without testing every body. Bodies are keyed by
+// a small integer (the same numbering as the trails: satellite, moon, then
+// asteroid slots). The tree is built top-down by median splits in
+// depth-first order, so every child comes after its parent and a refit is
+// one backwards pass over the nodes. Each step only refits; the tree is
+// rebuilt when refitting has loosened it too far, or when enough bodies
+// were added since the last build. Added bodies are tested one by one until
+// then; removed bodies just stop counting in the bounds.
+
+struct BvhNode
+{
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    int first; // leaf: first entry in BodyBvh::order; inner node: index of the right child (the left follows this node)
+    int count; // bodies in a leaf, 0 for an inner node
+};
+
+struct BodyBvh
+{
+    std::vector<glm::vec4> spheres; // per body: center and radius, radius < 0 if there is no body
+    std::vector<char> indexed;      // body is in the tree
+    std::vector<int> order;         // bodies of the tree, leaf by leaf
+    std::vector<int> pending;       // bodies added since the last build
+    std::vector<BvhNode> nodes;
+    int liveBodies = 0;
+    float builtCost = 0.0f; // surface area of the inner nodes right after the build
+    float cost = 0.0f;      // and after the last refit
+    int builds = 0;
+    int refits = 0;
+};
+
+const int BVH_LEAF_BODIES = 4;
+const float BVH_REBUILD_COST = 2.0f; // rebuild once refitting has doubled the tree's surface area
+
+void bvhInit(BodyBvh &bvh, int capacity);
+
+// Set a body's sphere, adding the body if it is new
+void bvhSetBody(BodyBvh &bvh, int body, const glm::vec3 &center, float radius);
+void bvhRemoveBody(BodyBvh &bvh, int body);
+
+// Refit the tree to the current spheres, or rebuild it (once per step)
+void bvhUpdate(BodyBvh &bvh);
+
+// Nearest body whose sphere the ray (unit direction) enters within
+// maxDistance, or -1. hitDistance (may be null) receives the distance.
+int bvhRayPick(const BodyBvh &bvh, const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance,
+               float *hitDistance);
+
+// Bodies whose spheres overlap the query sphere (out is cleared first)
+void bvhQueryRadius(const BodyBvh &bvh, const glm::vec3 &center, float radius, std::vector<int> &out);
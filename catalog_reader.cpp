@@ -0,0 +1,601 @@
+#include "catalog_reader.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the digit conversion reads words little-endian");
+
+namespace
+{
+    const double DEG_TO_RAD = M_PI / 180.0;
+    const double TWO_PI = 2.0 * M_PI;
+    const double MINUTES_PER_DAY = 1440.0;
+
+    const uint64_t ONES = 0x0101010101010101ull;
+    const uint64_t HIGH_BITS = ONES * 0x80;
+
+    const double POWERS_OF_TEN[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const double NEGATIVE_POWERS_OF_TEN[] = {1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9};
+
+    uint64_t load8(const char *text)
+    {
+        uint64_t word;
+        memcpy(&word, text, sizeof(word));
+        return word;
+    }
+
+    // 0x80 in every byte of word that is zero, 0 elsewhere
+    uint64_t zeroBytes(uint64_t word)
+    {
+        return ~((((word & ~HIGH_BITS) + ~HIGH_BITS) | word) & HIGH_BITS) & HIGH_BITS;
+    }
+
+    uint64_t blanksToZeros(uint64_t word)
+    {
+        return word | zeroBytes(word ^ (ONES * ' ')) >> 3; // ' ' is 0x20, '0' is 0x30
+    }
+
+    // Eight ASCII digits, the first the most significant; false if any byte is not a digit
+    bool eightDigits(uint64_t word, uint32_t &value)
+    {
+        if (((word + ONES * 0x46) | (word - ONES * '0')) & HIGH_BITS)
+            return false;
+        word = (word & (ONES * 0x0F)) * 2561 >> 8;
+        word = (word & 0x00FF00FF00FF00FFull) * 6553601 >> 16;
+        value = static_cast<uint32_t>((word & 0x0000FFFF0000FFFFull) * 42949672960001ull >> 32);
+        return true;
+    }
+
+    // COUNT (at most eight) digits, blanks read as zeros
+    template <int COUNT>
+    bool digits(const char *text, uint32_t &value)
+    {
+        char word[8] = {'0', '0', '0', '0', '0', '0', '0', '0'};
+        memcpy(word + 8 - COUNT, text, COUNT);
+        return eightDigits(blanksToZeros(load8(word)), value);
+    }
+
+    // "DDD.DDDD" (an angle in degrees) as ten-thousandths: the point is
+    // shifted out of the word and a zero shifted in at the front
+    bool angle(const char *text, uint32_t &value)
+    {
+        uint64_t word = load8(text);
+        word = (word & 0xFFFFFFFF00000000ull) | (word & 0x0000000000FFFFFFull) << 8 | '0';
+        return text[3] == '.' && eightDigits(blanksToZeros(word), value);
+    }
+
+    // WHOLE digits, a decimal point and eight more, as hundred-millionths
+    template <int WHOLE>
+    bool wideFixedPoint(const char *text, uint64_t &value)
+    {
+        uint32_t whole, fraction;
+        if (text[WHOLE] != '.' || !digits<WHOLE>(text, whole) ||
+            !eightDigits(blanksToZeros(load8(text + WHOLE + 1)), fraction))
+            return false;
+        value = whole * 100000000ull + fraction;
+        return true;
+    }
+
+    // Columns 1-68 summed (digits at face value, 1 per minus sign) modulo 10 against column 69
+    bool checksumMatches(const char *line)
+    {
+        uint64_t sums = 0; // one running sum per byte, at most 8 * 9
+        for (int offset = 0; offset <= 64; offset += 8)
+        {
+            // The last word covers columns 61-68; drop the four already counted
+            uint64_t word = offset < 64 ? load8(line + offset) : load8(line + 60) & 0xFFFFFFFF00000000ull;
+            uint64_t ascii = word & ~HIGH_BITS;
+            uint64_t isDigit = (ascii + ONES * (0x80 - '0')) & ~(ascii + ONES * (0x80 - '9' - 1)) & ~word & HIGH_BITS;
+            uint64_t isMinus = zeroBytes(word ^ (ONES * '-'));
+            sums += (word & (ONES * 0x0F) & ((isDigit >> 7) * 0xFF)) + (isMinus >> 7);
+        }
+        sums = (sums & 0x00FF00FF00FF00FFull) + (sums >> 8 & 0x00FF00FF00FF00FFull);
+        int sum = static_cast<int>((sums * 0x0001000100010001ull) >> 48);
+        return line[68] >= '0' && line[68] <= '9' && sum % 10 == line[68] - '0';
+    }
+
+    // Alpha-5: a leading letter stands for 10-33 ten-thousands (I and O are skipped)
+    bool catalogNumber(const char *text, int &number)
+    {
+        char first = text[0];
+        int high;
+        if (first >= '0' && first <= '9')
+            high = first - '0';
+        else if (first == ' ')
+            high = 0;
+        else if (first >= 'A' && first <= 'Z' && first != 'I' && first != 'O')
+            high = 10 + (first - 'A') - (first > 'I') - (first > 'O');
+        else
+            return false;
+        uint32_t low;
+        if (!digits<4>(text + 1, low))
+            return false;
+        number = high * 10000 + static_cast<int>(low);
+        return true;
+    }
+
+    // Julian date of day 0 of the last epoch year seen; catalogs are mostly one or two years
+    struct YearStart
+    {
+        int year = -1;
+        double jd = 0.0;
+    };
+
+    // Fixed-column fast path for a line pair that passed its checksums. False
+    // if a field is out of place, so the caller can retry with parseTle.
+    bool fastTle(const char *line1, const char *line2, YearStart &yearStart, TleElements &elements)
+    {
+        int number2;
+        uint32_t year, mantissa, inclination, node, eccentricity, perigee, anomaly;
+        uint64_t dayOfYear, meanMotion;
+        char bstarSign = line1[53], exponentSign = line1[59], exponent = line1[60];
+        bool valid = catalogNumber(line1 + 2, elements.catalogNumber) && catalogNumber(line2 + 2, number2) &&
+                     number2 == elements.catalogNumber && digits<2>(line1 + 18, year) &&
+                     wideFixedPoint<3>(line1 + 20, dayOfYear) &&
+                     (bstarSign == ' ' || bstarSign == '+' || bstarSign == '-') &&
+                     eightDigits((load8(line1 + 51) & 0xFFFFFFFFFF000000ull) | (ONES * '0' >> 40), mantissa) &&
+                     (exponentSign == '+' || exponentSign == '-') && exponent >= '0' && exponent <= '9' &&
+                     angle(line2 + 8, inclination) && angle(line2 + 17, node) &&
+                     digits<7>(line2 + 26, eccentricity) && angle(line2 + 34, perigee) &&
+                     angle(line2 + 43, anomaly) && wideFixedPoint<2>(line2 + 52, meanMotion);
+        if (!valid)
+            return false;
+
+        // Integers over exact powers of ten round the same way strtod does,
+        // so the elements match parseTle's to the bit
+        double bstar = mantissa / 1e5;
+        bstar = exponentSign == '-' ? bstar * NEGATIVE_POWERS_OF_TEN[exponent - '0']
+                                    : bstar * POWERS_OF_TEN[exponent - '0'];
+        int fullYear = static_cast<int>(year) + (year < 57 ? 2000 : 1900);
+        if (fullYear != yearStart.year)
+            yearStart = {fullYear, julianDate(fullYear, 1, 0, 0, 0, 0.0)};
+        elements.epochJd = yearStart.jd + dayOfYear / 1e8;
+        elements.bstar = bstarSign == '-' ? -bstar : bstar;
+        elements.inclination = inclination / 1e4 * DEG_TO_RAD;
+        elements.rightAscension = node / 1e4 * DEG_TO_RAD;
+        elements.eccentricity = eccentricity * 1.0e-7;
+        elements.argumentOfPerigee = perigee / 1e4 * DEG_TO_RAD;
+        elements.meanAnomaly = anomaly / 1e4 * DEG_TO_RAD;
+        elements.meanMotion = meanMotion / 1e8 * TWO_PI / MINUTES_PER_DAY;
+        return true;
+    }
+
+    // A line without its terminator (and any carriage return)
+    struct Line
+    {
+        const char *text;
+        size_t length;
+    };
+
+    // Next line of [cursor, end); false at the end of the buffer
+    bool nextLine(const char *&cursor, const char *end, Line &line)
+    {
+        if (cursor >= end)
+            return false;
+        const char *newline = static_cast<const char *>(memchr(cursor, '\n', end - cursor));
+        const char *stop = newline ? newline : end;
+        line.text = cursor;
+        line.length = stop - cursor;
+        if (line.length > 0 && line.text[line.length - 1] == '\r')
+            --line.length;
+        cursor = newline ? newline + 1 : end;
+        return true;
+    }
+
+    void parseTleBuffer(const char *data, size_t size, ElementTable &table)
+    {
+        const char *cursor = data;
+        const char *end = data + size;
+        Line line, previous = {nullptr, 0};
+        YearStart yearStart;
+        TleElements elements;
+        while (nextLine(cursor, end, line))
+        {
+            if (line.length == 0 || line.text[0] != '2' || !previous.text || previous.text[0] != '1')
+            {
+                previous = line;
+                continue;
+            }
+
+            bool parsed = false;
+            if (previous.length >= 69 && line.length >= 69 && checksumMatches(previous.text) &&
+                checksumMatches(line.text))
+                parsed = fastTle(previous.text, line.text, yearStart, elements);
+            if (!parsed && previous.length < 128 && line.length < 128)
+            {
+                // Off the fixed layout (or failing a checksum): let the reference parser decide
+                char text1[128], text2[128];
+                memcpy(text1, previous.text, previous.length);
+                text1[previous.length] = '\0';
+                memcpy(text2, line.text, line.length);
+                text2[line.length] = '\0';
+                parsed = parseTle(text1, text2, elements);
+            }
+            if (parsed)
+                elementTableAppend(table, elements);
+            else
+                ++table.rejected;
+            previous = {nullptr, 0};
+        }
+    }
+
+    // ---------------------------------------------------------------- OMM
+
+    // Digits from text while it has any, eight at a time where it can
+    const char *digitRun(const char *text, const char *end, uint64_t &mantissa, int &count)
+    {
+        uint32_t value;
+        while (end - text >= 8 && eightDigits(load8(text), value))
+        {
+            mantissa = mantissa * 100000000ull + value;
+            count += 8;
+            text += 8;
+        }
+        while (text < end && *text >= '0' && *text <= '9')
+        {
+            mantissa = mantissa * 10 + (*text - '0');
+            ++count;
+            ++text;
+        }
+        return text;
+    }
+
+    // A decimal number filling [text, end) apart from surrounding blanks
+    bool parseDecimal(const char *text, const char *end, double &value)
+    {
+        while (text < end && (*text == ' ' || *text == '\t'))
+            ++text;
+        while (end > text && (end[-1] == ' ' || end[-1] == '\t'))
+            --end;
+        const char *start = text;
+        bool negative = text < end && *text == '-';
+        if (text < end && (*text == '-' || *text == '+'))
+            ++text;
+
+        uint64_t mantissa = 0;
+        int count = 0, fractionCount = 0;
+        text = digitRun(text, end, mantissa, count);
+        if (text < end && *text == '.')
+        {
+            int wholeCount = count;
+            text = digitRun(text + 1, end, mantissa, count);
+            fractionCount = count - wholeCount;
+        }
+        if (count == 0)
+            return false;
+
+        int exponent = 0;
+        if (text < end && (*text == 'e' || *text == 'E'))
+        {
+            ++text;
+            bool negativeExponent = text < end && *text == '-';
+            if (text < end && (*text == '-' || *text == '+'))
+                ++text;
+            if (text == end)
+                return false;
+            for (; text < end && *text >= '0' && *text <= '9' && exponent < 1000; ++text)
+                exponent = exponent * 10 + (*text - '0');
+            exponent = negativeExponent ? -exponent : exponent;
+        }
+        if (text != end)
+            return false;
+        exponent -= fractionCount;
+
+        // Exact mantissa and power of ten: one correctly rounded operation
+        if (count <= 19 && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22)
+        {
+            double magnitude = exponent < 0 ? mantissa / POWERS_OF_TEN[-exponent] : mantissa * POWERS_OF_TEN[exponent];
+            value = negative ? -magnitude : magnitude;
+            return true;
+        }
+        char copy[64];
+        if (static_cast<size_t>(end - start) >= sizeof(copy))
+            return false;
+        memcpy(copy, start, end - start);
+        copy[end - start] = '\0';
+        value = strtod(copy, nullptr);
+        return true;
+    }
+
+    bool smallNumber(const char *text, int count, int &value)
+    {
+        value = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            if (text[i] < '0' || text[i] > '9')
+                return false;
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    }
+
+    // YYYY-MM-DDThh:mm:ss[.fff][Z] or YYYY-DDDThh:mm:ss[.fff][Z], UTC
+    bool parseEpoch(const char *text, const char *end, double &jd)
+    {
+        while (text < end && *text == ' ')
+            ++text;
+        while (end > text && (end[-1] == ' ' || end[-1] == 'Z'))
+            --end;
+        int year, month = 1, day, hour, minute;
+        if (end - text < 17 || !smallNumber(text, 4, year) || text[4] != '-')
+            return false;
+        text += 5;
+        if (text[3] == 'T')
+        {
+            if (!smallNumber(text, 3, day))
+                return false;
+            text += 3;
+        }
+        else
+        {
+            if (end - text < 14 || !smallNumber(text, 2, month) || text[2] != '-' || !smallNumber(text + 3, 2, day))
+                return false;
+            text += 5;
+        }
+        double second;
+        if (text[0] != 'T' || !smallNumber(text + 1, 2, hour) || text[3] != ':' || !smallNumber(text + 4, 2, minute) ||
+            text[6] != ':' || !parseDecimal(text + 7, end, second))
+            return false;
+        jd = julianDate(year, month, day, hour, minute, second);
+        return true;
+    }
+
+    enum OmmField
+    {
+        OMM_NORAD_CAT_ID,
+        OMM_EPOCH,
+        OMM_MEAN_MOTION,        // revolutions per day
+        OMM_ECCENTRICITY,
+        OMM_INCLINATION,        // degrees, as are the other angles
+        OMM_RA_OF_ASC_NODE,
+        OMM_ARG_OF_PERICENTER,
+        OMM_MEAN_ANOMALY,
+        OMM_BSTAR,              // optional
+        OMM_FIELD_COUNT
+    };
+
+    struct OmmKey
+    {
+        const char *name;
+        size_t length;
+    };
+
+    const OmmKey OMM_KEYS[OMM_FIELD_COUNT] = {
+        {"NORAD_CAT_ID", 12},   {"EPOCH", 5},          {"MEAN_MOTION", 11},
+        {"ECCENTRICITY", 12},   {"INCLINATION", 11},   {"RA_OF_ASC_NODE", 14},
+        {"ARG_OF_PERICENTER", 17}, {"MEAN_ANOMALY", 12}, {"BSTAR", 5}};
+    const unsigned OMM_REQUIRED = (1u << OMM_BSTAR) - 1;
+
+    struct OmmRecord
+    {
+        double values[OMM_FIELD_COUNT];
+        unsigned present = 0;
+        bool malformed = false;
+    };
+
+    void setOmmField(OmmRecord &record, const char *key, size_t keyLength, const char *value, const char *valueEnd)
+    {
+        for (int field = 0; field < OMM_FIELD_COUNT; ++field)
+        {
+            if (OMM_KEYS[field].length != keyLength || memcmp(OMM_KEYS[field].name, key, keyLength) != 0)
+                continue;
+            bool valid = field == OMM_EPOCH ? parseEpoch(value, valueEnd, record.values[field])
+                                            : parseDecimal(value, valueEnd, record.values[field]);
+            record.present |= 1u << field;
+            record.malformed |= !valid;
+            return;
+        }
+    }
+
+    // Append a finished record (nothing if it is empty) and start the next
+    void flushOmm(OmmRecord &record, ElementTable &table)
+    {
+        if (record.present == 0 && !record.malformed)
+            return;
+        if (record.malformed || (record.present & OMM_REQUIRED) != OMM_REQUIRED)
+        {
+            ++table.rejected;
+            record = OmmRecord();
+            return;
+        }
+        TleElements elements;
+        const double *v = record.values;
+        elements.catalogNumber = static_cast<int>(v[OMM_NORAD_CAT_ID]);
+        elements.epochJd = v[OMM_EPOCH];
+        elements.bstar = record.present & (1u << OMM_BSTAR) ? v[OMM_BSTAR] : 0.0;
+        elements.inclination = v[OMM_INCLINATION] * DEG_TO_RAD;
+        elements.rightAscension = v[OMM_RA_OF_ASC_NODE] * DEG_TO_RAD;
+        elements.eccentricity = v[OMM_ECCENTRICITY];
+        elements.argumentOfPerigee = v[OMM_ARG_OF_PERICENTER] * DEG_TO_RAD;
+        elements.meanAnomaly = v[OMM_MEAN_ANOMALY] * DEG_TO_RAD;
+        elements.meanMotion = v[OMM_MEAN_MOTION] * TWO_PI / MINUTES_PER_DAY;
+        elementTableAppend(table, elements);
+        record = OmmRecord();
+    }
+
+    // KEY = value [units] lines; every message starts with CCSDS_OMM_VERS
+    void parseKvnBuffer(const char *data, size_t size, ElementTable &table)
+    {
+        const char *cursor = data;
+        const char *end = data + size;
+        OmmRecord record;
+        Line line;
+        while (nextLine(cursor, end, line))
+        {
+            const char *text = line.text;
+            const char *stop = line.text + line.length;
+            while (text < stop && (*text == ' ' || *text == '\t'))
+                ++text;
+            const char *equals = static_cast<const char *>(memchr(text, '=', stop - text));
+            if (!equals)
+                continue;
+            const char *keyEnd = equals;
+            while (keyEnd > text && (keyEnd[-1] == ' ' || keyEnd[-1] == '\t'))
+                --keyEnd;
+            if (keyEnd - text == 14 && memcmp(text, "CCSDS_OMM_VERS", 14) == 0)
+            {
+                flushOmm(record, table);
+                continue;
+            }
+            const char *units = static_cast<const char *>(memchr(equals, '[', stop - equals));
+            setOmmField(record, text, keyEnd - text, equals + 1, units ? units : stop);
+        }
+        flushOmm(record, table);
+    }
+
+    // <TAG>value</TAG> elements; each message is an <omm> element
+    void parseXmlBuffer(const char *data, size_t size, ElementTable &table)
+    {
+        const char *cursor = data;
+        const char *end = data + size;
+        OmmRecord record;
+        while ((cursor = static_cast<const char *>(memchr(cursor, '<', end - cursor))))
+        {
+            const char *name = cursor + 1;
+            const char *close = static_cast<const char *>(memchr(name, '>', end - name));
+            if (!close)
+                break;
+            cursor = close + 1;
+            bool closing = name < close && *name == '/';
+            name += closing;
+            const char *nameEnd = name;
+            while (nameEnd < close && *nameEnd != ' ' && *nameEnd != '/' && *nameEnd != '\t' && *nameEnd != '\r' &&
+                   *nameEnd != '\n')
+                ++nameEnd;
+            if (nameEnd - name == 3 && memcmp(name, "omm", 3) == 0)
+            {
+                flushOmm(record, table);
+                continue;
+            }
+            if (closing || close[-1] == '/' || *name == '?' || *name == '!')
+                continue;
+            const char *valueEnd = static_cast<const char *>(memchr(cursor, '<', end - cursor));
+            if (!valueEnd)
+                break;
+            setOmmField(record, name, nameEnd - name, cursor, valueEnd);
+        }
+        flushOmm(record, table);
+    }
+}
+
+void elementTableReserve(ElementTable &table, size_t rows)
+{
+    table.catalogNumber.reserve(rows);
+    table.epochJd.reserve(rows);
+    table.bstar.reserve(rows);
+    table.inclination.reserve(rows);
+    table.rightAscension.reserve(rows);
+    table.eccentricity.reserve(rows);
+    table.argumentOfPerigee.reserve(rows);
+    table.meanAnomaly.reserve(rows);
+    table.meanMotion.reserve(rows);
+}
+
+void elementTableAppend(ElementTable &table, const TleElements &elements)
+{
+    table.catalogNumber.push_back(elements.catalogNumber);
+    table.epochJd.push_back(elements.epochJd);
+    table.bstar.push_back(elements.bstar);
+    table.inclination.push_back(elements.inclination);
+    table.rightAscension.push_back(elements.rightAscension);
+    table.eccentricity.push_back(elements.eccentricity);
+    table.argumentOfPerigee.push_back(elements.argumentOfPerigee);
+    table.meanAnomaly.push_back(elements.meanAnomaly);
+    table.meanMotion.push_back(elements.meanMotion);
+}
+
+TleElements elementTableRow(const ElementTable &table, int row)
+{
+    TleElements elements;
+    elements.catalogNumber = table.catalogNumber[row];
+    elements.epochJd = table.epochJd[row];
+    elements.bstar = table.bstar[row];
+    elements.inclination = table.inclination[row];
+    elements.rightAscension = table.rightAscension[row];
+    elements.eccentricity = table.eccentricity[row];
+    elements.argumentOfPerigee = table.argumentOfPerigee[row];
+    elements.meanAnomaly = table.meanAnomaly[row];
+    elements.meanMotion = table.meanMotion[row];
+    return elements;
+}
+
+CatalogFormat detectCatalogFormat(const char *data, size_t size)
+{
+    const char *end = data + size;
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+        data += 3;
+    for (;;)
+    {
+        while (data < end && (*data == ' ' || *data == '\t' || *data == '\r' || *data == '\n'))
+            ++data;
+        if (data < end && *data == '<')
+            return CATALOG_FORMAT_OMM_XML;
+
+        // KVN messages may open with COMMENT lines; the first other line has a keyword
+        const char *newline = static_cast<const char *>(memchr(data, '\n', end - data));
+        const char *stop = newline ? newline : end;
+        if (stop - data >= 7 && memcmp(data, "COMMENT", 7) == 0)
+        {
+            data = stop;
+            continue;
+        }
+        return memchr(data, '=', stop - data) ? CATALOG_FORMAT_OMM_KVN : CATALOG_FORMAT_TLE;
+    }
+}
+
+CatalogFormat parseCatalogBuffer(const char *data, size_t size, ElementTable &table)
+{
+    // Typical bytes per object, to size the columns once
+    CatalogFormat format = detectCatalogFormat(data, size);
+    const size_t bytesPerObject[] = {140, 500, 1000};
+    elementTableReserve(table, elementTableSize(table) + size / bytesPerObject[format] + 1);
+
+    if (format == CATALOG_FORMAT_OMM_XML)
+        parseXmlBuffer(data, size, table);
+    else if (format == CATALOG_FORMAT_OMM_KVN)
+        parseKvnBuffer(data, size, table);
+    else
+        parseTleBuffer(data, size, table);
+    return format;
+}
+
+bool parseCatalogFile(const char *path, ElementTable &table, size_t *bytes)
+{
+    int descriptor = open(path, O_RDONLY);
+    struct stat status;
+    if (descriptor < 0 || fstat(descriptor, &status) != 0)
+    {
+        std::cerr << "ERROR::CATALOG::FILE_NOT_READ " << path << std::endl;
+        if (descriptor >= 0)
+            close(descriptor);
+        return false;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    if (bytes)
+        *bytes = size;
+    if (size == 0)
+    {
+        close(descriptor);
+        return true;
+    }
+
+    // The mapping keeps the file open
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED)
+    {
+        std::cerr << "ERROR::CATALOG::FILE_NOT_MAPPED " << path << std::endl;
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    parseCatalogBuffer(static_cast<const char *>(mapped), size, table);
+    munmap(mapped, size);
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "sgp4.h"
+#include <cstddef>
+#include <vector>
+
+// Catalog ingestion: two- or three-line element sets and CCSDS OMM
+// messages (KVN or XML), read from a memory-mapped file straight into a
+// structure-of-arrays element table. TLE fields sit in fixed columns, so
+// they are converted eight digits at a time inside a 64-bit word, with
+// the checksum summed the same way; a line pair that does not fit the
+// fixed layout falls back to parseTle. Records with bad checksums or
+// missing fields are counted and skipped.
+
+// One column per TleElements field; row i of every column is one object
+struct ElementTable
+{
+    std::vector<int> catalogNumber;
+    std::vector<double> epochJd;
+    std::vector<double> bstar;
+    std::vector<double> inclination;
+    std::vector<double> rightAscension;
+    std::vector<double> eccentricity;
+    std::vector<double> argumentOfPerigee;
+    std::vector<double> meanAnomaly;
+    std::vector<double> meanMotion;
+    int rejected = 0; // records that failed to parse
+};
+
+enum CatalogFormat
+{
+    CATALOG_FORMAT_TLE = 0,
+    CATALOG_FORMAT_OMM_KVN = 1,
+    CATALOG_FORMAT_OMM_XML = 2,
+};
+
+inline int elementTableSize(const ElementTable &table)
+{
+    return static_cast<int>(table.catalogNumber.size());
+}
+
+void elementTableReserve(ElementTable &table, size_t rows);
+void elementTableAppend(ElementTable &table, const TleElements &elements);
+TleElements elementTableRow(const ElementTable &table, int row);
+
+// Guess the format from the first non-blank text
+CatalogFormat detectCatalogFormat(const char *data, size_t size);
+
+// Parse a whole buffer, appending to the table; returns the detected format
+CatalogFormat parseCatalogBuffer(const char *data, size_t size, ElementTable &table);
+
+// Map a file and parse it; bytes (if given) receives the file size. False if it cannot be read.
+bool parseCatalogFile(const char *path, ElementTable &table, size_t *bytes);
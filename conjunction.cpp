@@ -0,0 +1,517 @@
+#include "conjunction.h"
+#include "job_graph.h"
+#include "sgp4.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    const int SCREEN_SLICES = 8;
+    const int SIEVE_CHUNK = 16;          // sorted objects claimed at a time
+    const int MAX_CROSSINGS = 32;        // windows per object and node in a segment
+    const double TWO_PI = 2.0 * M_PI;
+    const double TIME_PAD_MINUTES = 0.1; // along-track slack of the mean elements
+    const double SAME_APPROACH_MINUTES = 1.0;
+
+    // Into (-pi, pi]
+    double wrapAngle(double angle)
+    {
+        angle = std::fmod(angle, TWO_PI);
+        if (angle > M_PI)
+            angle -= TWO_PI;
+        else if (angle <= -M_PI)
+            angle += TWO_PI;
+        return angle;
+    }
+
+    double dot(const double a[3], const double b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void cross(const double a[3], const double b[3], double out[3])
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // One object's orbit over the current segment, as at its midpoint
+    struct SegmentOrbit
+    {
+        int row;
+        double perigee, apogee;   // radii, km, padded
+        double radialPad;         // km: padKm plus the drag change over the segment
+        double semiMajorAxis, eccentricity, semiLatusRectum;
+        double minorAxisRatio;    // sqrt(1 - e^2)
+        double normal[3];         // unit angular momentum
+        double perigeeAxis[3];    // unit vector towards perigee
+        double sideAxis[3];       // normal x perigeeAxis
+        double meanAnomaly;
+        double meanAnomalyRate;   // rad / min
+        double nodeDrift;         // rad over half the segment
+        double perigeeDrift;
+    };
+
+    struct Window
+    {
+        int first, second;
+        double start, end;        // minutes after the start of the screening
+    };
+
+    struct Screening
+    {
+        ScreeningSettings settings;
+        const ElementTable *elements;
+        int rows;
+        double startJd;
+        std::vector<Sgp4Satellite> satellites;
+        std::vector<double> epochOffsets;  // minutes from each element epoch to startJd
+        std::vector<char> usable;          // SGP4 accepted the row and it has not decayed
+        std::vector<Sgp4MeanElements> segmentStartElements;
+        std::vector<SegmentOrbit> orbits;  // per row, valid if usable
+        std::vector<SegmentOrbit> sorted;  // the usable ones by perigee
+
+        int segment;
+        double segmentStart, segmentEnd;   // minutes after startJd
+        std::atomic<int> nextChunk;
+        std::vector<Window> windows[SCREEN_SLICES];
+        std::vector<Conjunction> found[SCREEN_SLICES];
+        uint64_t apogeePerigeePairs[SCREEN_SLICES];
+        uint64_t pathPairs[SCREEN_SLICES];
+        uint64_t windowCount[SCREEN_SLICES];
+    };
+
+    struct ScreeningSlice
+    {
+        Screening *screening;
+        int index;
+    };
+
+    // Mean elements at both ends of the segment to the ellipse at its middle
+    void segmentOrbit(const Sgp4MeanElements &start, const Sgp4MeanElements &end, double minutes, double padKm,
+                      SegmentOrbit &orbit)
+    {
+        double half = 0.5 * minutes;
+        double nodeRate = wrapAngle(end.rightAscension - start.rightAscension) / minutes;
+        double perigeeRate = wrapAngle(end.argumentOfPerigee - start.argumentOfPerigee) / minutes;
+        // The whole revolutions lost to the wrap come back from the mean motion
+        double expected = start.meanMotion * minutes;
+        double anomalyRate = (expected + wrapAngle(end.meanAnomaly - start.meanAnomaly - expected)) / minutes;
+
+        double node = start.rightAscension + nodeRate * half;
+        double argument = start.argumentOfPerigee + perigeeRate * half;
+        double inclination = 0.5 * (start.inclination + end.inclination);
+        double a = 0.5 * (start.semiMajorAxis + end.semiMajorAxis);
+        double e = 0.5 * (start.eccentricity + end.eccentricity);
+
+        double cosNode = std::cos(node), sinNode = std::sin(node);
+        double cosArgument = std::cos(argument), sinArgument = std::sin(argument);
+        double cosInclination = std::cos(inclination), sinInclination = std::sin(inclination);
+        orbit.perigeeAxis[0] = cosNode * cosArgument - sinNode * sinArgument * cosInclination;
+        orbit.perigeeAxis[1] = sinNode * cosArgument + cosNode * sinArgument * cosInclination;
+        orbit.perigeeAxis[2] = sinArgument * sinInclination;
+        orbit.sideAxis[0] = -cosNode * sinArgument - sinNode * cosArgument * cosInclination;
+        orbit.sideAxis[1] = -sinNode * sinArgument + cosNode * cosArgument * cosInclination;
+        orbit.sideAxis[2] = cosArgument * sinInclination;
+        orbit.normal[0] = sinNode * sinInclination;
+        orbit.normal[1] = -cosNode * sinInclination;
+        orbit.normal[2] = cosInclination;
+
+        orbit.radialPad = padKm + std::fabs(end.semiMajorAxis - start.semiMajorAxis) +
+                          a * std::fabs(end.eccentricity - start.eccentricity);
+        orbit.perigee = a * (1.0 - e) - orbit.radialPad;
+        orbit.apogee = a * (1.0 + e) + orbit.radialPad;
+        orbit.semiMajorAxis = a;
+        orbit.eccentricity = e;
+        orbit.semiLatusRectum = a * (1.0 - e * e);
+        orbit.minorAxisRatio = std::sqrt(1.0 - e * e);
+        orbit.meanAnomaly = start.meanAnomaly + anomalyRate * half;
+        orbit.meanAnomalyRate = anomalyRate;
+        orbit.nodeDrift = std::fabs(nodeRate) * half;
+        orbit.perigeeDrift = std::fabs(perigeeRate) * half;
+    }
+
+    // Mean anomaly at the true anomaly with this cosine and sine
+    double meanAnomalyAt(const SegmentOrbit &orbit, double cosTrue, double sinTrue)
+    {
+        double e = orbit.eccentricity;
+        double eccentricAnomaly = std::atan2(orbit.minorAxisRatio * sinTrue, e + cosTrue);
+        return eccentricAnomaly - e * orbit.minorAxisRatio * sinTrue / (1.0 + e * cosTrue);
+    }
+
+    // Time windows (minutes) in which the orbit is within halfWidth in true
+    // anomaly of the plane crossing at (cosTrue, sinTrue), for the crossings
+    // that start before the segment ends; one window over the whole
+    // segment if there are too many to list
+    int crossingWindows(const SegmentOrbit &orbit, double cosTrue, double sinTrue, double halfWidth, const Screening &s,
+                        double windows[MAX_CROSSINGS][2])
+    {
+        double cosWidth = std::cos(halfWidth), sinWidth = std::sin(halfWidth);
+        double low = meanAnomalyAt(orbit, cosTrue * cosWidth + sinTrue * sinWidth, sinTrue * cosWidth - cosTrue * sinWidth);
+        double high = meanAnomalyAt(orbit, cosTrue * cosWidth - sinTrue * sinWidth, sinTrue * cosWidth + cosTrue * sinWidth);
+        double span = high - low < 0.0 ? high - low + TWO_PI : high - low;
+
+        double rate = orbit.meanAnomalyRate;
+        double period = TWO_PI / rate;
+        double duration = span / rate;
+        double midpoint = 0.5 * (s.segmentStart + s.segmentEnd);
+        double first = midpoint + wrapAngle(low - orbit.meanAnomaly) / rate;
+        first += period * std::ceil((s.segmentStart - first - duration) / period);
+
+        int count = 0;
+        for (double t = first; t < s.segmentEnd; t += period)
+        {
+            if (count == MAX_CROSSINGS)
+            {
+                windows[0][0] = s.segmentStart - TIME_PAD_MINUTES;
+                windows[0][1] = s.segmentEnd + TIME_PAD_MINUTES;
+                return 1;
+            }
+            windows[count][0] = t - TIME_PAD_MINUTES;
+            windows[count][1] = t + duration + TIME_PAD_MINUTES;
+            ++count;
+        }
+        return count;
+    }
+
+    // Clipped to the segment, padded so approaches on its edges are found
+    void addWindow(Screening &s, int slice, int a, int b, double start, double end)
+    {
+        start = std::max(start, s.segmentStart - TIME_PAD_MINUTES);
+        end = std::min(end, s.segmentEnd + TIME_PAD_MINUTES);
+        if (start >= end)
+            return;
+        s.windows[slice].push_back({std::min(a, b), std::max(a, b), start, end});
+        ++s.windowCount[slice];
+    }
+
+    // Orbit path and time filters for a pair that passed apogee/perigee
+    void sievePair(Screening &s, int slice, const SegmentOrbit &a, const SegmentOrbit &b)
+    {
+        double reach = s.settings.thresholdKm + a.radialPad + b.radialPad;
+        double axis[3];
+        cross(a.normal, b.normal, axis);
+        double sinRelative = std::max(std::sqrt(dot(axis, axis)), 1e-12);
+        double drift = (a.nodeDrift + b.nodeDrift) / sinRelative;
+
+        double windows[2][MAX_CROSSINGS][2];
+        bool pathPassed = false;
+        for (int node = 0; node < 2; ++node)
+        {
+            // Radii where the planes cross, and the arcs over which each
+            // orbit stays within reach of the other's plane
+            double sign = node == 0 ? 1.0 : -1.0;
+            double u[3] = {sign * axis[0] / sinRelative, sign * axis[1] / sinRelative, sign * axis[2] / sinRelative};
+            double cosA = dot(a.perigeeAxis, u), sinA = dot(a.sideAxis, u);
+            double cosB = dot(b.perigeeAxis, u), sinB = dot(b.sideAxis, u);
+            double radiusA = a.semiLatusRectum / (1.0 + a.eccentricity * cosA);
+            double radiusB = b.semiLatusRectum / (1.0 + b.eccentricity * cosB);
+            double widthA = std::asin(std::min(1.0, reach / (radiusA * sinRelative))) + drift + a.perigeeDrift;
+            double widthB = std::asin(std::min(1.0, reach / (radiusB * sinRelative))) + drift + b.perigeeDrift;
+
+            // Near-coplanar orbits can be close anywhere: one window for the whole segment
+            if (widthA >= 0.5 * M_PI || widthB >= 0.5 * M_PI)
+            {
+                ++s.pathPairs[slice];
+                addWindow(s, slice, a.row, b.row, s.segmentStart - TIME_PAD_MINUTES, s.segmentEnd + TIME_PAD_MINUTES);
+                return;
+            }
+            double slackA = radiusA * a.eccentricity * widthA / (1.0 - a.eccentricity);
+            double slackB = radiusB * b.eccentricity * widthB / (1.0 - b.eccentricity);
+            if (std::fabs(radiusA - radiusB) > reach + slackA + slackB)
+                continue;
+            pathPassed = true;
+
+            int countA = crossingWindows(a, cosA, sinA, widthA, s, windows[0]);
+            if (countA == 0)
+                continue;
+            int countB = crossingWindows(b, cosB, sinB, widthB, s, windows[1]);
+            for (int p = 0, q = 0; p < countA && q < countB;)
+            {
+                double start = std::max(windows[0][p][0], windows[1][q][0]);
+                double end = std::min(windows[0][p][1], windows[1][q][1]);
+                if (start < end)
+                    addWindow(s, slice, a.row, b.row, start, end);
+                if (windows[0][p][1] < windows[1][q][1])
+                    ++p;
+                else
+                    ++q;
+            }
+        }
+        if (pathPassed)
+            ++s.pathPairs[slice];
+    }
+
+    struct PairState
+    {
+        double position[2][3];
+        double velocity[2][3];
+    };
+
+    // Relative position . relative velocity (its sign is that of the range
+    // rate) at t minutes after the start; NaN if either object fails
+    double rangeRate(Sgp4Satellite satellites[2], const double offsets[2], double t, PairState &state)
+    {
+        for (int k = 0; k < 2; ++k)
+        {
+            if (sgp4Propagate(satellites[k], offsets[k] + t, state.position[k], state.velocity[k]) != SGP4_OK)
+                return NAN;
+        }
+        double product = 0.0;
+        for (int axis = 0; axis < 3; ++axis)
+            product += (state.position[0][axis] - state.position[1][axis]) *
+                       (state.velocity[0][axis] - state.velocity[1][axis]);
+        return product;
+    }
+
+    // Every closest approach within the threshold in a window. Short windows
+    // hold at most one; longer ones are bracketed at a sixteenth of the
+    // shorter period, then each closing-to-opening bracket is solved by
+    // regula falsi (Illinois).
+    void refineWindow(const Screening &s, const Window &window, std::vector<Conjunction> &found)
+    {
+        Sgp4Satellite satellites[2] = {s.satellites[window.first], s.satellites[window.second]};
+        double offsets[2] = {s.epochOffsets[window.first], s.epochOffsets[window.second]};
+        double step = TWO_PI / std::max(satellites[0].no, satellites[1].no) / 16.0;
+        int intervals = std::max(1, static_cast<int>(std::ceil((window.end - window.start) / step)));
+
+        PairState state;
+        double t0 = window.start;
+        double f0 = rangeRate(satellites, offsets, t0, state);
+        for (int k = 1; k <= intervals; ++k)
+        {
+            double t1 = window.start + (window.end - window.start) * k / intervals;
+            double f1 = rangeRate(satellites, offsets, t1, state);
+            if (f0 < 0.0 && f1 > 0.0)
+            {
+                double low = t0, fLow = f0, high = t1, fHigh = f1, t = t1, previous = t0;
+                int side = 0;
+                bool failed = false;
+                for (int iteration = 0; iteration < 60 && std::fabs(t - previous) > 1e-7; ++iteration)
+                {
+                    previous = t;
+                    t = (low * fHigh - high * fLow) / (fHigh - fLow);
+                    double f = rangeRate(satellites, offsets, t, state);
+                    if (std::isnan(f))
+                    {
+                        failed = true;
+                        break;
+                    }
+                    if (f > 0.0)
+                    {
+                        high = t;
+                        fHigh = f;
+                        fLow = side == 1 ? 0.5 * fLow : fLow;
+                        side = 1;
+                    }
+                    else
+                    {
+                        low = t;
+                        fLow = f;
+                        fHigh = side == -1 ? 0.5 * fHigh : fHigh;
+                        side = -1;
+                    }
+                }
+                if (!failed)
+                {
+                    rangeRate(satellites, offsets, t, state);
+                    double d[3] = {state.position[0][0] - state.position[1][0],
+                                   state.position[0][1] - state.position[1][1],
+                                   state.position[0][2] - state.position[1][2]};
+                    double miss = std::sqrt(dot(d, d));
+                    if (miss < s.settings.thresholdKm && t >= 0.0 && t <= s.settings.days * 1440.0)
+                    {
+                        Conjunction conjunction;
+                        conjunction.first = window.first;
+                        conjunction.second = window.second;
+                        conjunction.tcaJd = s.startJd + t / 1440.0;
+                        conjunction.missKm = miss;
+                        std::copy(&state.position[0][0], &state.position[0][0] + 6, &conjunction.position[0][0]);
+                        std::copy(&state.velocity[0][0], &state.velocity[0][0] + 6, &conjunction.velocity[0][0]);
+                        found.push_back(conjunction);
+                    }
+                }
+                // The bracket's right end must be evaluated again for the next interval
+                f1 = rangeRate(satellites, offsets, t1, state);
+            }
+            t0 = t1;
+            f0 = f1;
+        }
+    }
+
+    void meanElementsJob(void *context)
+    {
+        ScreeningSlice &slice = *static_cast<ScreeningSlice *>(context);
+        Screening &s = *slice.screening;
+        double minutes = s.segmentEnd - s.segmentStart;
+        for (int row = s.rows * slice.index / SCREEN_SLICES; row < s.rows * (slice.index + 1) / SCREEN_SLICES; ++row)
+        {
+            Sgp4Satellite &satellite = s.satellites[row];
+            if (s.segment == 0)
+            {
+                s.usable[row] = sgp4Init(elementTableRow(*s.elements, row), satellite) == SGP4_OK &&
+                                sgp4MeanElements(satellite, s.epochOffsets[row], s.segmentStartElements[row]) == SGP4_OK;
+            }
+            Sgp4MeanElements end;
+            if (!s.usable[row] || sgp4MeanElements(satellite, s.epochOffsets[row] + s.segmentEnd, end) != SGP4_OK)
+            {
+                s.usable[row] = 0;
+                continue;
+            }
+            segmentOrbit(s.segmentStartElements[row], end, minutes, s.settings.padKm, s.orbits[row]);
+            s.orbits[row].row = row;
+            s.segmentStartElements[row] = end;
+        }
+    }
+
+    void sortJob(void *context)
+    {
+        Screening &s = *static_cast<Screening *>(context);
+        s.sorted.clear();
+        for (int row = 0; row < s.rows; ++row)
+        {
+            if (s.usable[row])
+                s.sorted.push_back(s.orbits[row]);
+        }
+        std::sort(s.sorted.begin(), s.sorted.end(),
+                  [](const SegmentOrbit &a, const SegmentOrbit &b) { return a.perigee < b.perigee; });
+        for (std::vector<Window> &windows : s.windows)
+            windows.clear();
+        s.nextChunk.store(0, std::memory_order_relaxed);
+    }
+
+    // Apogee/perigee: sorted by perigee, each object only meets the ones
+    // after it whose perigee is below its apogee (plus the threshold)
+    void sieveJob(void *context)
+    {
+        ScreeningSlice &slice = *static_cast<ScreeningSlice *>(context);
+        Screening &s = *slice.screening;
+        int count = static_cast<int>(s.sorted.size());
+        for (int chunk = s.nextChunk.fetch_add(1); chunk * SIEVE_CHUNK < count; chunk = s.nextChunk.fetch_add(1))
+        {
+            for (int k = chunk * SIEVE_CHUNK; k < std::min(count, (chunk + 1) * SIEVE_CHUNK); ++k)
+            {
+                const SegmentOrbit &a = s.sorted[k];
+                double reach = a.apogee + s.settings.thresholdKm;
+                for (int m = k + 1; m < count && s.sorted[m].perigee <= reach; ++m)
+                {
+                    ++s.apogeePerigeePairs[slice.index];
+                    sievePair(s, slice.index, a, s.sorted[m]);
+                }
+            }
+        }
+    }
+
+    void refineJob(void *context)
+    {
+        ScreeningSlice &slice = *static_cast<ScreeningSlice *>(context);
+        Screening &s = *slice.screening;
+        for (const Window &window : s.windows[slice.index])
+            refineWindow(s, window, s.found[slice.index]);
+    }
+}
+
+void screenConjunctions(const ElementTable &elements, const ScreeningSettings &settings,
+                        std::vector<Conjunction> &conjunctions, ScreeningStats &stats)
+{
+    auto wallStart = std::chrono::steady_clock::now();
+    stats = ScreeningStats();
+    conjunctions.clear();
+
+    Screening s;
+    s.settings = settings;
+    s.elements = &elements;
+    s.rows = elementTableSize(elements);
+    double newestEpochJd = 0.0;
+    for (double epochJd : elements.epochJd)
+        newestEpochJd = std::max(newestEpochJd, epochJd);
+    s.startJd = settings.startJd > 0.0 ? settings.startJd : newestEpochJd;
+    s.satellites.resize(s.rows);
+    s.epochOffsets.resize(s.rows);
+    for (int row = 0; row < s.rows; ++row)
+        s.epochOffsets[row] = (s.startJd - elements.epochJd[row]) * 1440.0;
+    s.usable.assign(s.rows, 0);
+    s.segmentStartElements.resize(s.rows);
+    s.orbits.resize(s.rows);
+    s.sorted.reserve(s.rows);
+    for (int i = 0; i < SCREEN_SLICES; ++i)
+        s.apogeePerigeePairs[i] = s.pathPairs[i] = s.windowCount[i] = 0;
+
+    // meanElements (sliced) -> sort -> sieve (chunked) -> refine, each refine
+    // slice after the sieve slice whose windows it takes
+    JobGraph graph("screening");
+    ScreeningSlice slices[SCREEN_SLICES];
+    int meanElements[SCREEN_SLICES], sieve[SCREEN_SLICES], refine[SCREEN_SLICES];
+    int sort = graph.addJob("sort", sortJob, &s);
+    for (int i = 0; i < SCREEN_SLICES; ++i)
+    {
+        slices[i] = {&s, i};
+        meanElements[i] = graph.addJob("meanElements", meanElementsJob, &slices[i]);
+        sieve[i] = graph.addJob("sieve", sieveJob, &slices[i]);
+        refine[i] = graph.addJob("refine", refineJob, &slices[i]);
+        graph.addDependency(meanElements[i], sort);
+        graph.addDependency(sort, sieve[i]);
+        graph.addDependency(sieve[i], refine[i]);
+    }
+
+    double span = settings.days * 1440.0;
+    stats.segments = std::max(1, static_cast<int>(std::ceil(span / settings.segmentMinutes)));
+    for (int segment = 0; segment < stats.segments; ++segment)
+    {
+        s.segment = segment;
+        s.segmentStart = span * segment / stats.segments;
+        s.segmentEnd = span * (segment + 1) / stats.segments;
+        graph.run();
+
+        uint64_t objects = s.sorted.size();
+        stats.pairs += objects * (objects - 1) / 2;
+        if (segment == 0)
+            stats.objects = static_cast<int>(objects);
+        stats.stageMs[1] += graph.lastJobNs(sort) / 1e6;
+        for (int i = 0; i < SCREEN_SLICES; ++i)
+        {
+            stats.stageMs[0] += graph.lastJobNs(meanElements[i]) / 1e6;
+            stats.stageMs[2] += graph.lastJobNs(sieve[i]) / 1e6;
+            stats.stageMs[3] += graph.lastJobNs(refine[i]) / 1e6;
+        }
+    }
+
+    for (int i = 0; i < SCREEN_SLICES; ++i)
+    {
+        stats.apogeePerigeePairs += s.apogeePerigeePairs[i];
+        stats.pathPairs += s.pathPairs[i];
+        stats.windows += s.windowCount[i];
+        conjunctions.insert(conjunctions.end(), s.found[i].begin(), s.found[i].end());
+    }
+
+    // Windows from neighbouring segments (and both plane crossings of
+    // near-coplanar pairs) can find the same approach; keep the closest
+    std::sort(conjunctions.begin(), conjunctions.end(), [](const Conjunction &a, const Conjunction &b) {
+        if (a.first != b.first)
+            return a.first < b.first;
+        if (a.second != b.second)
+            return a.second < b.second;
+        return a.tcaJd < b.tcaJd;
+    });
+    size_t kept = 0;
+    for (size_t i = 0; i < conjunctions.size(); ++i)
+    {
+        Conjunction &last = conjunctions[kept - (kept > 0)];
+        if (kept > 0 && last.first == conjunctions[i].first && last.second == conjunctions[i].second &&
+            (conjunctions[i].tcaJd - last.tcaJd) * 1440.0 < SAME_APPROACH_MINUTES)
+        {
+            if (conjunctions[i].missKm < last.missKm)
+                last = conjunctions[i];
+            continue;
+        }
+        conjunctions[kept++] = conjunctions[i];
+    }
+    conjunctions.resize(kept);
+    std::sort(conjunctions.begin(), conjunctions.end(),
+              [](const Conjunction &a, const Conjunction &b) { return a.tcaJd < b.tcaJd; });
+
+    stats.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+}
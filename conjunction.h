@@ -0,0 +1,59 @@
+#pragma once
+
+#include "catalog_reader.h"
+#include <cstdint>
+#include <vector>
+
+// All-vs-all conjunction screening of a catalog over a span of days, with
+// the sieve of Hoots, Crawford and Roehrich (1984) run segment by segment:
+//
+//   apogee/perigee  pairs whose radial shells do not come within reach
+//   orbit path      pairs whose orbits are apart where their planes cross
+//   time            pairs that are never near the plane crossing together
+//
+// Within a segment each orbit is the ellipse of its SGP4 mean elements,
+// turning at their secular rates; the filters are padded for that and for
+// the short-period terms they leave out. The windows that survive are
+// refined with full SGP4: time of closest approach (TCA) is where the
+// range rate changes sign, found by bracketing and root finding.
+//
+// Every stage runs as job graph slices on the shared workers (see
+// job_graph.h): mean elements per object, a perigee sort, the filters per
+// chunk of sorted objects, and refinement of each slice's windows.
+
+struct ScreeningSettings
+{
+    double startJd = 0.0;          // 0: the newest element epoch
+    double days = 7.0;
+    double thresholdKm = 10.0;     // report approaches closer than this
+    double segmentMinutes = 360.0; // span over which the filters hold an orbit fixed
+    double padKm = 15.0;           // allowance for the mean elements' missing terms
+};
+
+struct Conjunction
+{
+    int first;                     // element table rows, first < second
+    int second;
+    double tcaJd;
+    double missKm;
+    double position[2][3];         // TEME at TCA, km: first, then second
+    double velocity[2][3];         // km/s
+};
+
+// Pair counts are summed over the segments
+struct ScreeningStats
+{
+    int objects = 0;               // that SGP4 could propagate
+    int segments = 0;
+    uint64_t pairs = 0;
+    uint64_t apogeePerigeePairs = 0; // left after each filter
+    uint64_t pathPairs = 0;
+    uint64_t windows = 0;            // time windows left for refinement
+    double stageMs[4] = {};          // job time: elements, sort, filters, refinement
+    double wallMs = 0.0;
+};
+
+// Screen every pair of rows. Conjunctions come back sorted by TCA, one per
+// approach.
+void screenConjunctions(const ElementTable &elements, const ScreeningSettings &settings,
+                        std::vector<Conjunction> &conjunctions, ScreeningStats &stats);
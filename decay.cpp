@@ -0,0 +1,217 @@
+// Orbital lifetime under drag of every object in a catalog file or a
+// synthetic catalog:
+//   orbital_decay --catalog active.txt --model harris-priester --out decay.csv
+#include "catalog_reader.h"
+#include "drag.h"
+#include "job_graph.h"
+#include "satellite_catalog.h"
+#include "sgp4.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const int DECAY_SLICES = 8;
+
+    // Inputs and results per element table row
+    struct DecayRun
+    {
+        const ElementTable *elements;
+        const DensityTable *table;
+        DecaySettings settings;
+        double fixedBallistic; // m^2 / kg in place of B* when positive
+        std::vector<double> semiMajorAxis, eccentricity, inclination, ballistic, lifetimeDays;
+        std::vector<char> usable;
+    };
+
+    struct DecaySlice
+    {
+        DecayRun *run;
+        int index;
+    };
+
+    // Mean elements at epoch for a slice of rows, then their lifetimes
+    void decayJob(void *context)
+    {
+        DecaySlice &slice = *static_cast<DecaySlice *>(context);
+        DecayRun &run = *slice.run;
+        int rows = elementTableSize(*run.elements);
+        int first = rows * slice.index / DECAY_SLICES;
+        int end = rows * (slice.index + 1) / DECAY_SLICES;
+        for (int row = first; row < end; ++row)
+        {
+            TleElements elements = elementTableRow(*run.elements, row);
+            Sgp4Satellite satellite;
+            Sgp4MeanElements mean;
+            run.usable[row] = sgp4Init(elements, satellite) == 0 && sgp4MeanElements(satellite, 0.0, mean) == 0;
+            run.semiMajorAxis[row] = run.usable[row] ? mean.semiMajorAxis : 0.0;
+            run.eccentricity[row] = run.usable[row] ? mean.eccentricity : 0.0;
+            run.inclination[row] = run.usable[row] ? mean.inclination : 0.0;
+            run.ballistic[row] = run.fixedBallistic > 0.0 ? run.fixedBallistic : ballisticFromBstar(elements.bstar);
+        }
+        predictDecay(*run.table, run.settings, &run.semiMajorAxis[first], &run.eccentricity[first],
+                     &run.inclination[first], &run.ballistic[first], end - first, &run.lifetimeDays[first]);
+    }
+
+    bool writeLifetimes(const std::string &path, const DecayRun &run)
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cerr << "ERROR::DECAY::FILE_NOT_WRITTEN " << path << std::endl;
+            return false;
+        }
+        file << "catalog_number,perigee_km,apogee_km,ballistic_m2_kg,lifetime_days,reentry_jd\n";
+        char line[160];
+        for (int row = 0; row < elementTableSize(*run.elements); ++row)
+        {
+            if (!run.usable[row])
+                continue;
+            double a = run.semiMajorAxis[row], e = run.eccentricity[row];
+            double days = run.lifetimeDays[row];
+            snprintf(line, sizeof(line), "%d,%.1f,%.1f,%.5f,%.2f,%.4f\n", run.elements->catalogNumber[row],
+                     a * (1.0 - e) - 6378.137, a * (1.0 + e) - 6378.137, run.ballistic[row], days,
+                     days >= 0.0 ? run.elements->epochJd[row] + days : -1.0);
+            file << line;
+        }
+        return true;
+    }
+}
+
+static void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " (--catalog <file> | --synthetic <count>) [--seed <n>]"
+              << " [--model exponential|harris-priester] [--density-table <file>] [--bulge-exponent <n>]"
+              << " [--horizon <years>] [--reentry <km>] [--ballistic <m2/kg>] [--out <csv>]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    const char *catalogPath = nullptr;
+    const char *densityPath = nullptr;
+    int synthetic = 0, bulgeExponent = 2;
+    unsigned int seed = 42;
+    std::string outPath;
+    DensityModel model = DENSITY_HARRIS_PRIESTER;
+    DecayRun run;
+    run.fixedBallistic = 0.0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--catalog") && i + 1 < argc)
+            catalogPath = argv[++i];
+        else if (!strcmp(argv[i], "--synthetic") && i + 1 < argc)
+            synthetic = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = static_cast<unsigned int>(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--model") && i + 1 < argc && !strcmp(argv[i + 1], "exponential"))
+        {
+            model = DENSITY_EXPONENTIAL;
+            ++i;
+        }
+        else if (!strcmp(argv[i], "--model") && i + 1 < argc && !strcmp(argv[i + 1], "harris-priester"))
+        {
+            model = DENSITY_HARRIS_PRIESTER;
+            ++i;
+        }
+        else if (!strcmp(argv[i], "--density-table") && i + 1 < argc)
+            densityPath = argv[++i];
+        else if (!strcmp(argv[i], "--bulge-exponent") && i + 1 < argc)
+            bulgeExponent = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--horizon") && i + 1 < argc)
+            run.settings.horizonDays = atof(argv[++i]) * 365.25;
+        else if (!strcmp(argv[i], "--reentry") && i + 1 < argc)
+            run.settings.reentryAltitudeKm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--ballistic") && i + 1 < argc)
+            run.fixedBallistic = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if ((catalogPath == nullptr) == (synthetic <= 0) || run.settings.horizonDays <= 0.0 || bulgeExponent < 0)
+    {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    DensityTable table;
+    if (densityPath)
+    {
+        if (!densityTableLoad(table, densityPath))
+            return -1;
+    }
+    else
+        densityTableBuild(table, model);
+    table.bulgeExponent = bulgeExponent;
+
+    ElementTable elements;
+    if (catalogPath && !parseCatalogFile(catalogPath, elements, nullptr))
+        return -1;
+    if (synthetic > 0)
+        catalogGenerateElements(elements, synthetic, seed);
+
+    int rows = elementTableSize(elements);
+    run.elements = &elements;
+    run.table = &table;
+    run.semiMajorAxis.resize(rows);
+    run.eccentricity.resize(rows);
+    run.inclination.resize(rows);
+    run.ballistic.resize(rows);
+    run.lifetimeDays.resize(rows);
+    run.usable.resize(rows);
+
+    auto start = std::chrono::steady_clock::now();
+    jobWorkersStart(0);
+    {
+        JobGraph graph("decay");
+        DecaySlice slices[DECAY_SLICES];
+        for (int i = 0; i < DECAY_SLICES; ++i)
+        {
+            slices[i] = {&run, i};
+            graph.addJob("decay", decayJob, &slices[i]);
+        }
+        graph.run();
+    }
+    jobWorkersStop();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Lifetimes in bins of years, up to the horizon
+    const double edges[] = {0.0, 1.0, 5.0, 25.0, 100.0, 1e9};
+    int counts[5] = {}, usable = 0, up = 0;
+    for (int row = 0; row < rows; ++row)
+    {
+        if (!run.usable[row])
+            continue;
+        ++usable;
+        double years = run.lifetimeDays[row] / 365.25;
+        if (years < 0.0)
+        {
+            ++up;
+            continue;
+        }
+        int bin = 0;
+        while (bin < 4 && years >= edges[bin + 1])
+            ++bin;
+        ++counts[bin];
+    }
+    double horizonYears = run.settings.horizonDays / 365.25;
+    printf("Lifetimes of %d objects in %.2f s (%d could not be initialized)\n", usable, seconds, rows - usable);
+    for (int bin = 0; bin < 5 && edges[bin] < horizonYears; ++bin)
+        printf("  %3.0f to %3.0f years  %d\n", edges[bin], std::min(edges[bin + 1], horizonYears), counts[bin]);
+    printf("  still up         %d\n", up);
+
+    if (!outPath.empty() && !writeLifetimes(outPath, run))
+        return -1;
+    return 0;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Keeps the optimizer from discarding a result that is only computed to be
+// timed (benchmarks and the lookup timings of the tools)
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
@@ -0,0 +1,383 @@
+#include "drag.h"
+#include "geopotential.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    const double EARTH_RADIUS = 6378.137;         // km, WGS-84 equatorial, for geodetic heights
+    const double EARTH_FLATTENING = 1.0 / 298.257223563;
+    const double EARTH_MU = GEOPOTENTIAL_MU;      // km^3 / s^2
+    const double EARTH_ROTATION = 7.292115e-5;    // rad / s
+    const double SECONDS_PER_DAY = 86400.0;
+    const double BULGE_LAG = 30.0 * M_PI / 180.0; // apex east of the subsolar point
+    const int DECAY_NODES = 33;                   // eccentric anomaly 0..pi; the average is symmetric
+
+    // A profile as rows of altitude (km) and densities (kg/m^3)
+    struct DensityRow
+    {
+        double altitude, night, day;
+    };
+
+    // Exponential atmosphere, Vallado table 8-4: base altitude, density, scale height
+    struct ExponentialBand
+    {
+        double altitude, density, scaleHeight;
+    };
+
+    const ExponentialBand EXPONENTIAL[] = {
+        {0.0, 1.225, 7.249},        {25.0, 3.899e-2, 6.349},   {30.0, 1.774e-2, 6.682},
+        {40.0, 3.972e-3, 7.554},    {50.0, 1.057e-3, 8.382},   {60.0, 3.206e-4, 7.714},
+        {70.0, 8.770e-5, 6.549},    {80.0, 1.905e-5, 5.799},   {90.0, 3.396e-6, 5.382},
+        {100.0, 5.297e-7, 5.877},   {110.0, 9.661e-8, 7.263},  {120.0, 2.438e-8, 9.473},
+        {130.0, 8.484e-9, 12.636},  {140.0, 3.845e-9, 16.149}, {150.0, 2.070e-9, 22.523},
+        {180.0, 5.464e-10, 29.740}, {200.0, 2.789e-10, 37.105}, {250.0, 7.248e-11, 45.546},
+        {300.0, 2.418e-11, 53.628}, {350.0, 9.518e-12, 53.298}, {400.0, 3.725e-12, 58.515},
+        {450.0, 1.585e-12, 60.828}, {500.0, 6.967e-13, 63.822}, {600.0, 1.454e-13, 71.835},
+        {700.0, 3.614e-14, 88.667}, {800.0, 1.170e-14, 124.64}, {900.0, 5.245e-15, 181.05},
+        {1000.0, 3.019e-15, 268.00},
+    };
+    const double EXPONENTIAL_TOP = 1500.0;
+
+    // Harris-Priester for mean solar activity (Montenbruck and Gill table 3.8),
+    // minimum and maximum density in g/km^3
+    const DensityRow HARRIS_PRIESTER[] = {
+        {100.0, 497400.0, 497400.0}, {120.0, 24900.0, 24900.0}, {130.0, 8377.0, 8710.0},
+        {140.0, 3899.0, 4059.0},     {150.0, 2122.0, 2215.0},   {160.0, 1263.0, 1344.0},
+        {170.0, 800.8, 875.8},       {180.0, 528.3, 601.0},     {190.0, 361.7, 429.7},
+        {200.0, 255.7, 316.2},       {210.0, 183.9, 239.6},     {220.0, 134.1, 185.3},
+        {230.0, 99.49, 145.5},       {240.0, 74.88, 115.7},     {250.0, 57.09, 93.08},
+        {260.0, 44.03, 75.55},       {270.0, 34.30, 61.82},     {280.0, 26.97, 50.95},
+        {290.0, 21.39, 42.26},       {300.0, 17.08, 35.26},     {320.0, 10.99, 25.11},
+        {340.0, 7.214, 18.19},       {360.0, 4.824, 13.37},     {380.0, 3.274, 9.955},
+        {400.0, 2.249, 7.492},       {420.0, 1.558, 5.684},     {440.0, 1.091, 4.355},
+        {460.0, 0.7701, 3.362},      {480.0, 0.5474, 2.612},    {500.0, 0.3916, 2.042},
+        {520.0, 0.2819, 1.605},      {540.0, 0.2042, 1.267},    {560.0, 0.1488, 1.005},
+        {580.0, 0.1092, 0.7997},     {600.0, 0.08070, 0.6390},  {620.0, 0.06012, 0.5123},
+        {640.0, 0.04519, 0.4121},    {660.0, 0.03430, 0.3325},  {680.0, 0.02632, 0.2691},
+        {700.0, 0.02043, 0.2185},    {720.0, 0.01607, 0.1779},  {740.0, 0.01281, 0.1452},
+        {760.0, 0.01036, 0.1190},    {780.0, 0.008496, 0.09776}, {800.0, 0.007069, 0.08059},
+        {840.0, 0.004680, 0.05741},  {880.0, 0.003200, 0.04210}, {920.0, 0.002210, 0.03130},
+        {960.0, 0.001560, 0.02360},  {1000.0, 0.001150, 0.01810},
+    };
+    const double GRAMS_PER_KM3 = 1e-12; // in kg/m^3
+
+    void resizeTable(DensityTable &table, double minAltitude, double maxAltitude, double stepKm)
+    {
+        table.minAltitude = minAltitude;
+        table.step = stepKm;
+        table.count = static_cast<int>(std::floor((maxAltitude - minAltitude) / stepKm)) + 1;
+        table.night.assign(table.count + 2, 0.0);
+        table.day.assign(table.count + 2, 0.0);
+    }
+
+    // Fill the table from profile rows, exponential between neighbours
+    void fillFromRows(DensityTable &table, const std::vector<DensityRow> &rows, double stepKm)
+    {
+        resizeTable(table, rows.front().altitude, rows.back().altitude, stepKm);
+        size_t row = 0;
+        for (int i = 0; i < table.count; ++i)
+        {
+            double altitude = table.minAltitude + i * stepKm;
+            while (row + 2 < rows.size() && altitude > rows[row + 1].altitude)
+                ++row;
+            const DensityRow &a = rows[row];
+            const DensityRow &b = rows[row + 1];
+            double f = (altitude - a.altitude) / (b.altitude - a.altitude);
+            table.night[i] = a.night * std::pow(b.night / a.night, f);
+            table.day[i] = a.day * std::pow(b.day / a.day, f);
+        }
+    }
+
+    // The diurnal bulge averaged over a day: the mean of cos^n(psi / 2) over the sphere
+    double meanBulgeWeight(const DensityTable &table)
+    {
+        return 2.0 / (table.bulgeExponent + 2.0);
+    }
+
+    template <int L>
+    void evaluate(const DensityTable &t, const double *x, const double *y, const double *z, const double *vx,
+                  const double *vy, const double *vz, const double *ballistic, const double *apex, double *ax,
+                  double *ay, double *az)
+    {
+        const double mean = meanBulgeWeight(t);
+        const double noApex[3] = {0.0, 0.0, 0.0};
+        const double *toward = apex ? apex : noApex;
+        for (int i = 0; i < L; ++i)
+        {
+            double r2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+            double r = std::sqrt(r2);
+
+            // cos^n(psi / 2) = ((1 + cos psi) / 2)^(n / 2) towards the bulge apex
+            double half = 0.5 + 0.5 * (x[i] * toward[0] + y[i] * toward[1] + z[i] * toward[2]) / r;
+            double weight = t.bulgeExponent % 2 ? std::sqrt(half) : 1.0;
+            for (int k = 0; k < t.bulgeExponent / 2; ++k)
+                weight *= half;
+            weight = apex ? weight : mean;
+
+            // Geodetic height from the ellipsoid radius at the geocentric latitude
+            double height = r - EARTH_RADIUS * (1.0 - EARTH_FLATTENING * z[i] * z[i] / r2);
+            double u = (height - t.minAltitude) / t.step;
+            u = u < 0.0 ? 0.0 : u;
+            u = u > t.count ? t.count : u;
+            int j = static_cast<int>(u);
+            double f = u - j;
+            double night = t.night[j] + f * (t.night[j + 1] - t.night[j]);
+            double day = t.day[j] + f * (t.day[j + 1] - t.day[j]);
+            double density = night + weight * (day - night);
+
+            // Velocity relative to the turning atmosphere
+            double rx = vx[i] + EARTH_ROTATION * y[i];
+            double ry = vy[i] - EARTH_ROTATION * x[i];
+            double rz = vz[i];
+            double speed = std::sqrt(rx * rx + ry * ry + rz * rz);
+
+            // 1/2 rho Cd A / m v^2, with rho Cd A / m in 1 / m
+            double k = -0.5e3 * density * ballistic[i] * speed;
+            ax[i] = k * rx;
+            ay[i] = k * ry;
+            az[i] = k * rz;
+        }
+    }
+
+    // Rates of the mean semi-major axis (km / day) and eccentricity (1 / day)
+    // averaged over a revolution, for DRAG_LANES orbits. drag is 1/2 Cd A / m
+    // times the atmosphere's rotation factor, in km^-1 per kg/m^3.
+    void averageRates(const DensityTable &t, const double cosine[DECAY_NODES], const double *a, const double *e,
+                      const double *radius, const double *drag, double *aRate, double *eRate)
+    {
+        const double mean = meanBulgeWeight(t);
+        double sumA[DRAG_LANES] = {}, sumE[DRAG_LANES] = {};
+        for (int k = 0; k < DECAY_NODES; ++k)
+        {
+            double c = cosine[k];
+            double nodeWeight = (k == 0 || k == DECAY_NODES - 1) ? 0.5 : 1.0;
+            for (int i = 0; i < DRAG_LANES; ++i)
+            {
+                double ec = e[i] * c;
+                double u = (a[i] * (1.0 - ec) - radius[i] - t.minAltitude) / t.step;
+                u = u < 0.0 ? 0.0 : u;
+                u = u > t.count ? t.count : u;
+                int j = static_cast<int>(u);
+                double f = u - j;
+                double night = t.night[j] + f * (t.night[j + 1] - t.night[j]);
+                double day = t.day[j] + f * (t.day[j + 1] - t.day[j]);
+                double density = nodeWeight * (night + mean * (day - night));
+
+                double speed2 = EARTH_MU / a[i] * (1.0 + ec) / (1.0 - ec);
+                double speed = std::sqrt(speed2);
+                sumA[i] += density * speed * speed2 * (1.0 - ec);
+                sumE[i] += density * speed * c;
+            }
+        }
+        for (int i = 0; i < DRAG_LANES; ++i)
+        {
+            double scale = 2.0 * drag[i] * SECONDS_PER_DAY / (DECAY_NODES - 1);
+            aRate[i] = -scale * a[i] * a[i] / EARTH_MU * sumA[i];
+            eRate[i] = -scale * (1.0 - e[i] * e[i]) * sumE[i];
+        }
+    }
+}
+
+void densityTableBuild(DensityTable &table, DensityModel model, double stepKm)
+{
+    if (model == DENSITY_HARRIS_PRIESTER)
+    {
+        std::vector<DensityRow> rows;
+        for (const DensityRow &row : HARRIS_PRIESTER)
+            rows.push_back({row.altitude, row.night * GRAMS_PER_KM3, row.day * GRAMS_PER_KM3});
+        fillFromRows(table, rows, stepKm);
+        return;
+    }
+
+    resizeTable(table, 0.0, EXPONENTIAL_TOP, stepKm);
+    int band = 0;
+    const int bands = sizeof(EXPONENTIAL) / sizeof(EXPONENTIAL[0]);
+    for (int i = 0; i < table.count; ++i)
+    {
+        double altitude = i * stepKm;
+        while (band + 1 < bands && altitude >= EXPONENTIAL[band + 1].altitude)
+            ++band;
+        const ExponentialBand &b = EXPONENTIAL[band];
+        table.night[i] = table.day[i] = b.density * std::exp(-(altitude - b.altitude) / b.scaleHeight);
+    }
+}
+
+bool densityTableLoad(DensityTable &table, const char *path, double stepKm)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "ERROR::DRAG::FILE_NOT_READ " << path << std::endl;
+        return false;
+    }
+    std::vector<DensityRow> rows;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        DensityRow row;
+        int fields = sscanf(line.c_str(), "%lf %lf %lf", &row.altitude, &row.night, &row.day);
+        if (fields < 2 || line[0] == '#')
+            continue;
+        if (fields == 2)
+            row.day = row.night;
+        if (row.night <= 0.0 || row.day <= 0.0 || (!rows.empty() && row.altitude <= rows.back().altitude))
+        {
+            std::cerr << "ERROR::DRAG::INVALID_TABLE " << path << std::endl;
+            return false;
+        }
+        rows.push_back(row);
+    }
+    if (rows.size() < 2)
+    {
+        std::cerr << "ERROR::DRAG::INVALID_TABLE " << path << std::endl;
+        return false;
+    }
+    fillFromRows(table, rows, stepKm);
+    return true;
+}
+
+double densityTableTop(const DensityTable &table)
+{
+    return table.minAltitude + (table.count - 1) * table.step;
+}
+
+double atmosphericDensity(const DensityTable &table, double altitudeKm, double bulgeWeight)
+{
+    double u = std::min(std::max((altitudeKm - table.minAltitude) / table.step, 0.0), static_cast<double>(table.count));
+    int j = static_cast<int>(u);
+    double f = u - j;
+    double night = table.night[j] + f * (table.night[j + 1] - table.night[j]);
+    double day = table.day[j] + f * (table.day[j + 1] - table.day[j]);
+    return night + bulgeWeight * (day - night);
+}
+
+void dragBulgeApex(const double sunDirection[3], double apex[3])
+{
+    apex[0] = sunDirection[0] * std::cos(BULGE_LAG) - sunDirection[1] * std::sin(BULGE_LAG);
+    apex[1] = sunDirection[0] * std::sin(BULGE_LAG) + sunDirection[1] * std::cos(BULGE_LAG);
+    apex[2] = sunDirection[2];
+}
+
+void dragAcceleration(const DensityTable &table, const double position[3], const double velocity[3], double ballistic,
+                      const double *bulgeApex, double acceleration[3])
+{
+    evaluate<1>(table, &position[0], &position[1], &position[2], &velocity[0], &velocity[1], &velocity[2], &ballistic,
+                bulgeApex, &acceleration[0], &acceleration[1], &acceleration[2]);
+}
+
+void dragAccelerationBatch(const DensityTable &table, const double position[3][DRAG_LANES],
+                           const double velocity[3][DRAG_LANES], const double ballistic[DRAG_LANES],
+                           const double *bulgeApex, double acceleration[3][DRAG_LANES])
+{
+    evaluate<DRAG_LANES>(table, position[0], position[1], position[2], velocity[0], velocity[1], velocity[2],
+                         ballistic, bulgeApex, acceleration[0], acceleration[1], acceleration[2]);
+}
+
+void predictDecay(const DensityTable &table, const DecaySettings &settings, const double *semiMajorAxis,
+                  const double *eccentricity, const double *inclination, const double *ballistic, int count,
+                  double *lifetimeDays)
+{
+    double cosine[DECAY_NODES];
+    for (int k = 0; k < DECAY_NODES; ++k)
+        cosine[k] = std::cos(M_PI * k / (DECAY_NODES - 1));
+    double top = densityTableTop(table);
+
+    // Lane state; an idle lane sits above the table where every rate is zero
+    int object[DRAG_LANES];
+    double a[DRAG_LANES], e[DRAG_LANES], radius[DRAG_LANES], drag[DRAG_LANES], elapsed[DRAG_LANES];
+    double aRate[DRAG_LANES], eRate[DRAG_LANES], a1[DRAG_LANES], e1[DRAG_LANES], aRate1[DRAG_LANES],
+        eRate1[DRAG_LANES], step[DRAG_LANES];
+    int next = 0, active = 0;
+
+    // Load the next object that needs integrating into a lane
+    auto refill = [&](int lane) {
+        object[lane] = -1;
+        a[lane] = EARTH_RADIUS + top + 1000.0;
+        e[lane] = 0.0;
+        radius[lane] = EARTH_RADIUS;
+        drag[lane] = 0.0;
+        elapsed[lane] = 0.0;
+        while (next < count)
+        {
+            int i = next++;
+            // Mean Earth radius under the orbit: sin^2 of latitude averages sin^2(i) / 2
+            double sinI = std::sin(inclination[i]);
+            double r = EARTH_RADIUS * (1.0 - 0.5 * EARTH_FLATTENING * sinI * sinI);
+            double perigee = semiMajorAxis[i] * (1.0 - eccentricity[i]);
+            if (perigee - r <= settings.reentryAltitudeKm)
+            {
+                lifetimeDays[i] = 0.0;
+                continue;
+            }
+            if (!(ballistic[i] > 0.0) || perigee - r >= top)
+            {
+                lifetimeDays[i] = -1.0;
+                continue;
+            }
+            // The atmosphere turning with the Earth cuts the relative speed at perigee (King-Hele)
+            double perigeeSpeed = std::sqrt(EARTH_MU / semiMajorAxis[i] * (1.0 + eccentricity[i]) / (1.0 - eccentricity[i]));
+            double wind = 1.0 - perigee * EARTH_ROTATION * std::cos(inclination[i]) / perigeeSpeed;
+            object[lane] = i;
+            a[lane] = semiMajorAxis[i];
+            e[lane] = eccentricity[i];
+            radius[lane] = r;
+            drag[lane] = 0.5e3 * ballistic[i] * wind * wind;
+            ++active;
+            return;
+        }
+    };
+    for (int lane = 0; lane < DRAG_LANES; ++lane)
+        refill(lane);
+
+    // Heun steps sized per lane so the perigee drops a small fraction of its
+    // height above reentry
+    while (active > 0)
+    {
+        averageRates(table, cosine, a, e, radius, drag, aRate, eRate);
+        for (int lane = 0; lane < DRAG_LANES; ++lane)
+        {
+            double perigee = a[lane] * (1.0 - e[lane]) - radius[lane] - settings.reentryAltitudeKm;
+            double apogee = a[lane] * (1.0 + e[lane]) - radius[lane] - settings.reentryAltitudeKm;
+            double perigeeDrop = -(aRate[lane] * (1.0 - e[lane]) - a[lane] * eRate[lane]);
+            double apogeeDrop = -(aRate[lane] * (1.0 + e[lane]) + a[lane] * eRate[lane]);
+            double dt = settings.maxStepDays;
+            if (perigeeDrop > 0.0)
+                dt = std::min(dt, settings.stepFraction * perigee / perigeeDrop);
+            if (apogeeDrop > 0.0)
+                dt = std::min(dt, settings.stepFraction * apogee / apogeeDrop);
+            dt = std::max(dt, settings.minStepDays);
+            step[lane] = std::min(dt, settings.horizonDays - elapsed[lane]);
+            a1[lane] = a[lane] + step[lane] * aRate[lane];
+            e1[lane] = std::max(e[lane] + step[lane] * eRate[lane], 0.0);
+        }
+        averageRates(table, cosine, a1, e1, radius, drag, aRate1, eRate1);
+        for (int lane = 0; lane < DRAG_LANES; ++lane)
+        {
+            if (object[lane] < 0)
+                continue;
+            double before = a[lane] * (1.0 - e[lane]) - radius[lane] - settings.reentryAltitudeKm;
+            a[lane] += 0.5 * step[lane] * (aRate[lane] + aRate1[lane]);
+            e[lane] = std::max(e[lane] + 0.5 * step[lane] * (eRate[lane] + eRate1[lane]), 0.0);
+            elapsed[lane] += step[lane];
+            double after = a[lane] * (1.0 - e[lane]) - radius[lane] - settings.reentryAltitudeKm;
+            if (after <= 0.0)
+            {
+                // Reentry inside the step, where the perigee height crossed
+                lifetimeDays[object[lane]] = elapsed[lane] - step[lane] * (-after) / (before - after);
+                --active;
+                refill(lane);
+            }
+            else if (elapsed[lane] >= settings.horizonDays)
+            {
+                lifetimeDays[object[lane]] = -1.0;
+                --active;
+                refill(lane);
+            }
+        }
+    }
+}
@@ -0,0 +1,263 @@
+#include "dynamic_resolution.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    // Timestamp pairs in flight; results are read this many frames late at most
+    const int QUERY_FRAMES = 4;
+    const float SMOOTHING = 0.1f;   // weight of a new GPU time sample
+    const float MIN_CHANGE = 0.05f; // smaller scale corrections are ignored
+    const float MAX_STEP = 1.25f;   // largest per-change factor in either direction
+
+    DynamicResolutionConfig gConfig;
+    bool gFixedScale = false;
+    int gOutputWidth = 0;
+    int gOutputHeight = 0;
+    int gRenderWidth = 0;
+    int gRenderHeight = 0;
+    float gScale = 1.0f;
+
+    GLuint gFramebuffer = 0;
+    GLuint gColorBuffer = 0;
+    GLuint gDepthBuffer = 0;
+
+    GLuint gQueries[QUERY_FRAMES][2];
+    unsigned long long gQueriesIssued = 0;
+    unsigned long long gQueriesRead = 0;
+    bool gQueryOpen = false;
+
+    // Software rasterizers draw on the CPU when the frame is flushed and their
+    // timestamp queries do not cover that work, so time a glFinish instead
+    bool gSoftwareTiming = false;
+
+    float gSmoothedGpuMs = 0.0f;
+    int gFramesSinceChange = 0;
+
+    // Metrics
+    unsigned long long gFrames = 0;
+    unsigned long long gScaleChanges = 0;
+    double gScaleSum = 0.0;
+    float gScaleMin = 1.0f;
+    float gScaleMax = 1.0f;
+    unsigned long long gGpuSamples = 0;
+    double gGpuMsSum = 0.0;
+
+    void setScale(float scale)
+    {
+        gScale = std::min(std::max(scale, gConfig.minScale), gConfig.maxScale);
+        gRenderWidth = std::max(1, static_cast<int>(std::lround(gOutputWidth * gScale)));
+        gRenderHeight = std::max(1, static_cast<int>(std::lround(gOutputHeight * gScale)));
+    }
+
+    void addGpuSample(float gpuMs)
+    {
+        gSmoothedGpuMs = gGpuSamples == 0 ? gpuMs : gSmoothedGpuMs + SMOOTHING * (gpuMs - gSmoothedGpuMs);
+        ++gGpuSamples;
+        gGpuMsSum += gpuMs;
+    }
+
+    bool isSoftwareRenderer()
+    {
+        const char *renderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+        const char *names[] = {"llvmpipe", "softpipe", "SwiftShader", "Software Rasterizer"};
+        for (const char *name : names)
+        {
+            if (renderer && strstr(renderer, name))
+                return true;
+        }
+        return false;
+    }
+
+    // Fold in every finished timestamp pair without waiting on the GPU
+    void readQueries()
+    {
+        while (gQueriesRead < gQueriesIssued)
+        {
+            GLuint *pair = gQueries[gQueriesRead % QUERY_FRAMES];
+            GLint available = 0;
+            glGetQueryObjectiv(pair[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+
+            GLuint64 start = 0;
+            GLuint64 end = 0;
+            glGetQueryObjectui64v(pair[0], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(pair[1], GL_QUERY_RESULT, &end);
+            addGpuSample((end - start) / 1e6f);
+            ++gQueriesRead;
+        }
+    }
+
+    // GPU time is taken to be proportional to pixel count, i.e. to scale squared
+    void adaptScale()
+    {
+        if (gFixedScale || gGpuSamples == 0 || ++gFramesSinceChange < gConfig.settleFrames)
+            return;
+
+        float factor = std::sqrt(gConfig.targetGpuMs / std::max(gSmoothedGpuMs, 0.01f));
+        factor = std::min(std::max(factor, 1.0f / MAX_STEP), MAX_STEP);
+        float previous = gScale;
+        setScale(gScale * factor);
+        if (std::fabs(gScale - previous) < MIN_CHANGE)
+        {
+            setScale(previous);
+            return;
+        }
+        gFramesSinceChange = 0;
+        ++gScaleChanges;
+    }
+}
+
+bool dynamicResolutionInit(const DynamicResolutionConfig &config, int outputWidth, int outputHeight)
+{
+    gConfig = config;
+    const char *enabled = getenv("ORBITAL_DYNAMIC_RESOLUTION");
+    if (enabled)
+        gConfig.enabled = atoi(enabled) != 0;
+    const char *target = getenv("ORBITAL_GPU_TARGET_MS");
+    if (target && atof(target) > 0.0)
+        gConfig.targetGpuMs = static_cast<float>(atof(target));
+    const char *fixedScale = getenv("ORBITAL_RENDER_SCALE");
+    gFixedScale = fixedScale && atof(fixedScale) > 0.0;
+
+    gOutputWidth = outputWidth;
+    gOutputHeight = outputHeight;
+    setScale(gConfig.maxScale);
+    if (gFixedScale)
+    {
+        gConfig.enabled = true;
+        gConfig.minScale = 0.1f;
+        setScale(static_cast<float>(atof(fixedScale)));
+    }
+    gScaleMin = gScaleMax = gScale;
+    if (!gConfig.enabled)
+    {
+        gScale = 1.0f;
+        return true;
+    }
+
+    glGenFramebuffers(1, &gFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, gFramebuffer);
+
+    glGenRenderbuffers(1, &gColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, gColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, outputWidth, outputHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, gColorBuffer);
+
+    glGenRenderbuffers(1, &gDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, gDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, outputWidth, outputHeight);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, gDepthBuffer);
+
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete)
+    {
+        std::cerr << "ERROR::DYNAMIC_RESOLUTION::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        dynamicResolutionDestroy();
+        return false;
+    }
+
+    glGenQueries(QUERY_FRAMES * 2, &gQueries[0][0]);
+    gSoftwareTiming = isSoftwareRenderer();
+    gQueriesIssued = gQueriesRead = 0;
+    gQueryOpen = false;
+    gSmoothedGpuMs = 0.0f;
+    gFramesSinceChange = 0;
+    return true;
+}
+
+void dynamicResolutionDestroy()
+{
+    if (gFramebuffer)
+        glDeleteQueries(QUERY_FRAMES * 2, &gQueries[0][0]);
+    glDeleteRenderbuffers(1, &gDepthBuffer);
+    glDeleteRenderbuffers(1, &gColorBuffer);
+    glDeleteFramebuffers(1, &gFramebuffer);
+    gFramebuffer = gColorBuffer = gDepthBuffer = 0;
+}
+
+void dynamicResolutionBeginFrame()
+{
+    if (!gFramebuffer)
+        return;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, gFramebuffer);
+    glViewport(0, 0, gRenderWidth, gRenderHeight);
+    // glClear ignores the viewport, so keep it to the scaled area too
+    glScissor(0, 0, gRenderWidth, gRenderHeight);
+    glEnable(GL_SCISSOR_TEST);
+
+    // Timestamps rather than GL_TIME_ELAPSED, which the profiler's GPU zones use
+    gQueryOpen = !gSoftwareTiming && gQueriesIssued - gQueriesRead < QUERY_FRAMES;
+    if (gQueryOpen)
+        glQueryCounter(gQueries[gQueriesIssued % QUERY_FRAMES][0], GL_TIMESTAMP);
+}
+
+void dynamicResolutionEndFrame(GLuint outputFramebuffer)
+{
+    if (!gFramebuffer)
+        return;
+
+    if (gQueryOpen)
+    {
+        glQueryCounter(gQueries[gQueriesIssued % QUERY_FRAMES][1], GL_TIMESTAMP);
+        ++gQueriesIssued;
+    }
+
+    // The blit is clipped by the scissor test
+    auto blitStart = std::chrono::steady_clock::now();
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, gFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+    glBlitFramebuffer(0, 0, gRenderWidth, gRenderHeight, 0, 0, gOutputWidth, gOutputHeight, GL_COLOR_BUFFER_BIT,
+                      gRenderWidth == gOutputWidth && gRenderHeight == gOutputHeight ? GL_NEAREST : GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+    glViewport(0, 0, gOutputWidth, gOutputHeight);
+
+    if (gSoftwareTiming)
+    {
+        // Reading the target for the blit flushes the frame, and the buffer swap would wait for the same work
+        glFinish();
+        addGpuSample(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - blitStart).count());
+    }
+
+    ++gFrames;
+    gScaleSum += gScale;
+    gScaleMin = std::min(gScaleMin, gScale);
+    gScaleMax = std::max(gScaleMax, gScale);
+
+    readQueries();
+    adaptScale();
+}
+
+float dynamicResolutionScale()
+{
+    return gFramebuffer ? gScale : 1.0f;
+}
+
+void dynamicResolutionWriteJson(std::ostream &out)
+{
+    out << "{\"enabled\": " << (gFramebuffer ? "true" : "false") << ", \"timing\": \""
+        << (gSoftwareTiming ? "finish" : "timestamp") << "\", \"fixed_scale\": "
+        << (gFixedScale ? "true" : "false") << ", \"target_gpu_ms\": " << gConfig.targetGpuMs
+        << ", \"scale\": " << dynamicResolutionScale() << ", \"scale_mean\": " << (gFrames ? gScaleSum / gFrames : 1.0)
+        << ", \"scale_min\": " << gScaleMin << ", \"scale_max\": " << gScaleMax << ", \"scale_changes\": " << gScaleChanges
+        << ", \"gpu_ms_mean\": " << (gGpuSamples ? gGpuMsSum / gGpuSamples : 0.0) << "}";
+}
+
+void dynamicResolutionPrintSummary()
+{
+    if (!gFramebuffer)
+        return;
+
+    fprintf(stderr, "\nDynamic resolution: target %.1f ms GPU, scale %.2f (mean %.2f, range %.2f-%.2f), %llu changes, mean GPU %.2f ms\n",
+            gConfig.targetGpuMs, gScale, gFrames ? gScaleSum / gFrames : 1.0, gScaleMin, gScaleMax, gScaleChanges,
+            gGpuSamples ? gGpuMsSum / gGpuSamples : 0.0);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <ostream>
+
+// Dynamic resolution. The scene is drawn into an offscreen framebuffer,
+// allocated once at the output size, using only a scaled sub-rectangle, and
+// is then blitted (linear filtering) to the output framebuffer. The scale
+// follows the GPU time of recent frames, measured with timestamp queries
+// read a few frames late so the CPU never waits on them. On software
+// rasterizers, whose timestamps miss the rasterization, the CPU time of the
+// blit plus a glFinish (which together flush the frame) is used instead.
+// GPU time is assumed to scale with pixel count.
+
+struct DynamicResolutionConfig
+{
+    bool enabled = true;
+    float targetGpuMs = 12.0f; // GPU time per frame to aim for
+    float minScale = 0.5f;     // per axis
+    float maxScale = 1.0f;
+    int settleFrames = 30; // frames between scale changes
+};
+
+// Read ORBITAL_DYNAMIC_RESOLUTION (0 disables), ORBITAL_GPU_TARGET_MS and
+// ORBITAL_RENDER_SCALE (a fixed scale) on top of config. Returns false if
+// the framebuffer cannot be created; disabled instances always succeed and
+// draw to the output directly.
+bool dynamicResolutionInit(const DynamicResolutionConfig &config, int outputWidth, int outputHeight);
+void dynamicResolutionDestroy();
+
+// Bracket the frame's drawing: Begin binds the offscreen target and sets the
+// scaled viewport, End blits it to outputFramebuffer and leaves that bound.
+void dynamicResolutionBeginFrame();
+void dynamicResolutionEndFrame(GLuint outputFramebuffer);
+
+// Current per-axis scale (1 when disabled)
+float dynamicResolutionScale();
+
+// JSON object with the config, the scale range used and the GPU time seen
+void dynamicResolutionWriteJson(std::ostream &out);
+void dynamicResolutionPrintSummary();
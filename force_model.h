@@ -0,0 +1,379 @@
+#pragma once
+
+#include "drag.h"
+#include "geopotential.h"
+#include "gravity_grid.h"
+#include "lunisolar.h"
+#include "sgp4.h"
+#include <cmath>
+#include <tuple>
+#include <utility>
+
+// Force models composed at compile time from a list of terms:
+//
+//   ForceModel<PointMass, J2> model;
+//   auto full = makeForceModel(PointMass(), Harmonics{&field, &scratch}, Drag{&table}, ThirdBody());
+//   auto fast = makeForceModel(PointMass(), GridHarmonics{&grid, &field, &scratch}, Drag{&table});
+//
+// The model sums its terms with a fold expression, so the whole
+// acceleration inlines into the integrator loop that calls it: no virtual
+// calls, no per-term flags, and a term left out of the list costs nothing.
+// ForceModel<> adds no work at all (see ForceModel::empty).
+//
+// Work shared by every body at one time (Sun and Moon, the Earth's
+// rotation, the bulge apex) goes into a ForceStep, filled once per step by
+// prepare() with only what the listed terms use.
+//
+// Positions are inertial (TEME) in km, velocities in km/s and
+// accelerations in km/s^2. PointMass and J2 take any scalar type, so with
+// scaled constants they also work in float scene units. Their defaults are
+// the EGM96 constants of the embedded field (see geopotential.h); with a
+// field loaded from a file, give PointMass the field's mu.
+//
+// A term is a type with
+//   void prepare(ForceStep &step) const;
+//   void add(const ForceStep &, const ForceBody &, const T position[3], const T velocity[3], T acceleration[3]) const;
+//   void addBatch(const ForceStep &, const ForceLanes &, const double position[3][FORCE_LANES],
+//                 const double velocity[3][FORCE_LANES], double acceleration[3][FORCE_LANES]) const;
+// adding its part into acceleration.
+
+const int FORCE_LANES = 8;
+static_assert(FORCE_LANES == GEOPOTENTIAL_LANES && FORCE_LANES == DRAG_LANES && FORCE_LANES == LUNISOLAR_LANES,
+              "force model batches run every term at the same width");
+
+// Terms shared by every body at one time
+struct ForceStep
+{
+    double jd = 0.0;          // UT1 Julian date
+    double earthAngle = 0.0;  // Greenwich sidereal angle, rad: TEME to body-fixed
+    double bulgeApex[3] = {}; // unit, see dragBulgeApex
+    LunisolarStep lunisolar;
+};
+
+// Per-body parameters, m^2 / kg
+struct ForceBody
+{
+    double ballistic = 0.0;    // Cd * A / m
+    double reflectivity = 0.0; // Cr * A / m
+};
+
+struct ForceLanes
+{
+    double ballistic[FORCE_LANES];
+    double reflectivity[FORCE_LANES];
+};
+
+// Central attraction
+struct PointMass
+{
+    double mu = GEOPOTENTIAL_MU; // km^3 / s^2
+
+    void prepare(ForceStep &) const
+    {
+    }
+
+    template <typename T>
+    void add(const ForceStep &, const ForceBody &, const T position[3], const T *, T acceleration[3]) const
+    {
+        T r2 = position[0] * position[0] + position[1] * position[1] + position[2] * position[2];
+        T k = -T(mu) / (r2 * std::sqrt(r2));
+        for (int axis = 0; axis < 3; ++axis)
+            acceleration[axis] += k * position[axis];
+    }
+
+    void addBatch(const ForceStep &, const ForceLanes &, const double position[3][FORCE_LANES],
+                  const double (*)[FORCE_LANES], double acceleration[3][FORCE_LANES]) const
+    {
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            double r2 = position[0][i] * position[0][i] + position[1][i] * position[1][i] + position[2][i] * position[2][i];
+            double k = -mu / (r2 * std::sqrt(r2));
+            acceleration[0][i] += k * position[0][i];
+            acceleration[1][i] += k * position[1][i];
+            acceleration[2][i] += k * position[2][i];
+        }
+    }
+};
+
+// Oblateness alone, in closed form about the frame's z axis. Use either
+// this or Harmonics, which already holds J2.
+struct J2
+{
+    double mu = GEOPOTENTIAL_MU;
+    double radius = GEOPOTENTIAL_RADIUS;
+    double j2 = GEOPOTENTIAL_J2;
+
+    void prepare(ForceStep &) const
+    {
+    }
+
+    template <typename T>
+    void add(const ForceStep &, const ForceBody &, const T position[3], const T *, T acceleration[3]) const
+    {
+        T r2 = position[0] * position[0] + position[1] * position[1] + position[2] * position[2];
+        T z2 = position[2] * position[2] / r2;
+        T k = T(-1.5 * j2 * mu * radius * radius) / (r2 * r2 * std::sqrt(r2));
+        acceleration[0] += k * position[0] * (T(1) - T(5) * z2);
+        acceleration[1] += k * position[1] * (T(1) - T(5) * z2);
+        acceleration[2] += k * position[2] * (T(3) - T(5) * z2);
+    }
+
+    void addBatch(const ForceStep &, const ForceLanes &, const double position[3][FORCE_LANES],
+                  const double (*)[FORCE_LANES], double acceleration[3][FORCE_LANES]) const
+    {
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            double r2 = position[0][i] * position[0][i] + position[1][i] * position[1][i] + position[2][i] * position[2][i];
+            double z2 = position[2][i] * position[2][i] / r2;
+            double k = -1.5 * j2 * mu * radius * radius / (r2 * r2 * std::sqrt(r2));
+            acceleration[0][i] += k * position[0][i] * (1.0 - 5.0 * z2);
+            acceleration[1][i] += k * position[1][i] * (1.0 - 5.0 * z2);
+            acceleration[2][i] += k * position[2][i] * (3.0 - 5.0 * z2);
+        }
+    }
+};
+
+// Full geopotential, evaluated in the Earth-fixed frame turned by the
+// sidereal angle (no polar motion). The scratch is the caller's, one per thread.
+struct Harmonics
+{
+    const Geopotential *field = nullptr;
+    GeopotentialScratch *scratch = nullptr;
+
+    void prepare(ForceStep &step) const
+    {
+        step.earthAngle = greenwichSiderealTime(step.jd);
+    }
+
+    void add(const ForceStep &step, const ForceBody &, const double position[3], const double *,
+             double acceleration[3]) const
+    {
+        double c = std::cos(step.earthAngle), s = std::sin(step.earthAngle);
+        double fixed[3] = {c * position[0] + s * position[1], c * position[1] - s * position[0], position[2]};
+        double a[3];
+        geopotentialAcceleration(*field, fixed, a, *scratch);
+        acceleration[0] += c * a[0] - s * a[1];
+        acceleration[1] += s * a[0] + c * a[1];
+        acceleration[2] += a[2];
+    }
+
+    void addBatch(const ForceStep &step, const ForceLanes &, const double position[3][FORCE_LANES],
+                  const double (*)[FORCE_LANES], double acceleration[3][FORCE_LANES]) const
+    {
+        double c = std::cos(step.earthAngle), s = std::sin(step.earthAngle);
+        double fixed[3][FORCE_LANES], a[3][FORCE_LANES];
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            fixed[0][i] = c * position[0][i] + s * position[1][i];
+            fixed[1][i] = c * position[1][i] - s * position[0][i];
+            fixed[2][i] = position[2][i];
+        }
+        geopotentialAccelerationBatch(*field, fixed, a, *scratch);
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            acceleration[0][i] += c * a[0][i] - s * a[1][i];
+            acceleration[1][i] += s * a[0][i] + c * a[1][i];
+            acceleration[2][i] += a[2][i];
+        }
+    }
+};
+
+// Full geopotential from a lookup grid (see gravity_grid.h) inside the
+// grid's altitude band, and from the field it was built from outside it.
+// Same frame handling as Harmonics.
+struct GridHarmonics
+{
+    const GravityGrid *grid = nullptr;
+    const Geopotential *field = nullptr;
+    GeopotentialScratch *scratch = nullptr;
+
+    void prepare(ForceStep &step) const
+    {
+        step.earthAngle = greenwichSiderealTime(step.jd);
+    }
+
+    void add(const ForceStep &step, const ForceBody &, const double position[3], const double *,
+             double acceleration[3]) const
+    {
+        double c = std::cos(step.earthAngle), s = std::sin(step.earthAngle);
+        double fixed[3] = {c * position[0] + s * position[1], c * position[1] - s * position[0], position[2]};
+        double a[3];
+        if (!gravityGridAcceleration(*grid, fixed, a))
+            geopotentialAcceleration(*field, fixed, a, *scratch);
+        acceleration[0] += c * a[0] - s * a[1];
+        acceleration[1] += s * a[0] + c * a[1];
+        acceleration[2] += a[2];
+    }
+
+    // Lookups are per lane; lanes outside the band share one direct batch
+    void addBatch(const ForceStep &step, const ForceLanes &, const double position[3][FORCE_LANES],
+                  const double (*)[FORCE_LANES], double acceleration[3][FORCE_LANES]) const
+    {
+        double c = std::cos(step.earthAngle), s = std::sin(step.earthAngle);
+        double fixed[3][FORCE_LANES], a[3][FORCE_LANES];
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            fixed[0][i] = c * position[0][i] + s * position[1][i];
+            fixed[1][i] = c * position[1][i] - s * position[0][i];
+            fixed[2][i] = position[2][i];
+        }
+        bool inBand[FORCE_LANES];
+        bool missed = false;
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            double point[3] = {fixed[0][i], fixed[1][i], fixed[2][i]}, lookup[3] = {};
+            inBand[i] = gravityGridAcceleration(*grid, point, lookup);
+            for (int axis = 0; axis < 3; ++axis)
+                a[axis][i] = lookup[axis];
+            missed = missed || !inBand[i];
+        }
+        if (missed)
+        {
+            double direct[3][FORCE_LANES];
+            geopotentialAccelerationBatch(*field, fixed, direct, *scratch);
+            for (int i = 0; i < FORCE_LANES; ++i)
+                for (int axis = 0; axis < 3 && !inBand[i]; ++axis)
+                    a[axis][i] = direct[axis][i];
+        }
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            acceleration[0][i] += c * a[0][i] - s * a[1][i];
+            acceleration[1][i] += s * a[0][i] + c * a[1][i];
+            acceleration[2][i] += a[2][i];
+        }
+    }
+};
+
+// Atmospheric drag with the body's ballistic term; the diurnal bulge
+// follows the Sun unless diurnal is off, when it is averaged over the day
+struct Drag
+{
+    const DensityTable *table = nullptr;
+    bool diurnal = true;
+
+    void prepare(ForceStep &step) const
+    {
+        if (!diurnal)
+            return;
+        lunisolarPrepare(step.lunisolar, step.jd);
+        dragBulgeApex(step.lunisolar.sunDirection, step.bulgeApex);
+    }
+
+    void add(const ForceStep &step, const ForceBody &body, const double position[3], const double velocity[3],
+             double acceleration[3]) const
+    {
+        double a[3];
+        dragAcceleration(*table, position, velocity, body.ballistic, diurnal ? step.bulgeApex : nullptr, a);
+        for (int axis = 0; axis < 3; ++axis)
+            acceleration[axis] += a[axis];
+    }
+
+    void addBatch(const ForceStep &step, const ForceLanes &lanes, const double position[3][FORCE_LANES],
+                  const double velocity[3][FORCE_LANES], double acceleration[3][FORCE_LANES]) const
+    {
+        double a[3][FORCE_LANES];
+        dragAccelerationBatch(*table, position, velocity, lanes.ballistic, diurnal ? step.bulgeApex : nullptr, a);
+        for (int axis = 0; axis < 3; ++axis)
+            for (int i = 0; i < FORCE_LANES; ++i)
+                acceleration[axis][i] += a[axis][i];
+    }
+};
+
+// Moon and Sun
+struct ThirdBody
+{
+    void prepare(ForceStep &step) const
+    {
+        lunisolarPrepare(step.lunisolar, step.jd);
+    }
+
+    void add(const ForceStep &step, const ForceBody &, const double position[3], const double *,
+             double acceleration[3]) const
+    {
+        double a[3];
+        thirdBodyAcceleration(step.lunisolar, position, a);
+        for (int axis = 0; axis < 3; ++axis)
+            acceleration[axis] += a[axis];
+    }
+
+    void addBatch(const ForceStep &step, const ForceLanes &, const double position[3][FORCE_LANES],
+                  const double (*)[FORCE_LANES], double acceleration[3][FORCE_LANES]) const
+    {
+        double a[3][FORCE_LANES];
+        thirdBodyAccelerationBatch(step.lunisolar, position, a);
+        for (int axis = 0; axis < 3; ++axis)
+            for (int i = 0; i < FORCE_LANES; ++i)
+                acceleration[axis][i] += a[axis][i];
+    }
+};
+
+// Solar radiation pressure with the body's reflectivity term
+struct SolarPressure
+{
+    ShadowModel shadow = SHADOW_CONICAL;
+
+    void prepare(ForceStep &step) const
+    {
+        lunisolarPrepare(step.lunisolar, step.jd);
+    }
+
+    void add(const ForceStep &step, const ForceBody &body, const double position[3], const double *,
+             double acceleration[3]) const
+    {
+        double a[3];
+        solarPressureAcceleration(step.lunisolar, position, body.reflectivity, shadow, a);
+        for (int axis = 0; axis < 3; ++axis)
+            acceleration[axis] += a[axis];
+    }
+
+    void addBatch(const ForceStep &step, const ForceLanes &lanes, const double position[3][FORCE_LANES],
+                  const double (*)[FORCE_LANES], double acceleration[3][FORCE_LANES]) const
+    {
+        double a[3][FORCE_LANES];
+        solarPressureAccelerationBatch(step.lunisolar, position, lanes.reflectivity, shadow, a);
+        for (int axis = 0; axis < 3; ++axis)
+            for (int i = 0; i < FORCE_LANES; ++i)
+                acceleration[axis][i] += a[axis][i];
+    }
+};
+
+template <typename... Terms>
+struct ForceModel
+{
+    // True for ForceModel<>: callers skip the velocity update entirely
+    static constexpr bool empty = sizeof...(Terms) == 0;
+
+    std::tuple<Terms...> terms;
+
+    // Shared terms at a Julian date, for every term in the list
+    void prepare(ForceStep &step, double jd) const
+    {
+        step.jd = jd;
+        std::apply([&step](const Terms &...term) { (term.prepare(step), ...); }, terms);
+    }
+
+    template <typename T>
+    void acceleration(const ForceStep &step, const ForceBody &body, const T position[3], const T velocity[3],
+                      T total[3]) const
+    {
+        total[0] = total[1] = total[2] = T(0);
+        std::apply([&](const Terms &...term) { (term.add(step, body, position, velocity, total), ...); }, terms);
+    }
+
+    void accelerationBatch(const ForceStep &step, const ForceLanes &lanes, const double position[3][FORCE_LANES],
+                           const double velocity[3][FORCE_LANES], double total[3][FORCE_LANES]) const
+    {
+        // Summed in a local, which the compiler knows aliases none of the inputs
+        double sum[3][FORCE_LANES] = {};
+        std::apply([&](const Terms &...term) { (term.addBatch(step, lanes, position, velocity, sum), ...); }, terms);
+        for (int axis = 0; axis < 3; ++axis)
+            for (int i = 0; i < FORCE_LANES; ++i)
+                total[axis][i] = sum[axis][i];
+    }
+};
+
+template <typename... Terms>
+ForceModel<Terms...> makeForceModel(const Terms &...terms)
+{
+    return ForceModel<Terms...>{std::make_tuple(terms...)};
+}
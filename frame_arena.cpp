@@ -0,0 +1,115 @@
+#include "frame_arena.h"
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+LinearArena::LinearArena(size_t capacity)
+    : buffer(nullptr), size(0), peak(0), overflowBytes(0), offset(0)
+{
+    reserve(capacity);
+}
+
+LinearArena::~LinearArena()
+{
+    for (void *p : overflows)
+        free(p);
+    free(buffer);
+}
+
+void *LinearArena::allocate(size_t bytes, size_t alignment)
+{
+    // A zero-byte request still gets a distinct, usable pointer
+    if (bytes == 0)
+        bytes = 1;
+    uintptr_t base = reinterpret_cast<uintptr_t>(buffer);
+    size_t current = offset.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        uintptr_t aligned = (base + current + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+        size_t next = aligned - base + bytes;
+        if (!buffer || next > size)
+            break;
+        if (offset.compare_exchange_weak(current, next, std::memory_order_relaxed))
+            return reinterpret_cast<void *>(aligned);
+    }
+
+    // Out of space: serve from the heap until the next reset
+    if (alignment < alignof(std::max_align_t))
+        alignment = alignof(std::max_align_t);
+    void *p = aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+    if (!p)
+        throw std::bad_alloc();
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflows.push_back(p);
+    overflowBytes += bytes;
+    return p;
+}
+
+void LinearArena::reset()
+{
+    size_t used = offset.load(std::memory_order_relaxed);
+    if (used + overflowBytes > peak)
+        peak = used + overflowBytes;
+
+    for (void *p : overflows)
+        free(p);
+    overflows.clear();
+
+    // Grow so the next frame of the same size fits without touching the heap
+    if (overflowBytes > 0)
+    {
+        size_t grown = size * 2 > peak ? size * 2 : peak;
+        std::cerr << "Frame arena grown from " << size << " to " << grown << " bytes" << std::endl;
+        overflowBytes = 0;
+        reserve(grown);
+    }
+
+    offset.store(0, std::memory_order_relaxed);
+}
+
+void LinearArena::reserve(size_t capacity)
+{
+    free(buffer);
+    buffer = capacity > 0 ? static_cast<unsigned char *>(malloc(capacity)) : nullptr;
+    size = buffer ? capacity : 0;
+    offset.store(0, std::memory_order_relaxed);
+}
+
+void frameArenasInit(FrameArenas &frames, size_t bytesPerFrame)
+{
+    for (LinearArena &arena : frames.arenas)
+    {
+        arena.reset();
+        arena.reserve(bytesPerFrame);
+    }
+    frames.current = 0;
+}
+
+void frameArenasAdvance(FrameArenas &frames)
+{
+    frames.current ^= 1;
+    frames.arenas[frames.current].reset();
+}
+
+static FrameArenas gFrameArenas;
+
+void frameArenaInit(size_t bytesPerFrame)
+{
+    frameArenasInit(gFrameArenas, bytesPerFrame);
+}
+
+void frameArenaAdvance()
+{
+    frameArenasAdvance(gFrameArenas);
+}
+
+LinearArena &frameArena()
+{
+    return gFrameArenas.arenas[gFrameArenas.current];
+}
+
+LinearArena &previousFrameArena()
+{
+    return gFrameArenas.arenas[gFrameArenas.current ^ 1];
+}
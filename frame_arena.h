@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Bump allocator for data that only lives for a frame. Allocation is an
+// aligned pointer increment; everything is released at once by reset().
+// Requests that do not fit fall back to the heap, are freed at the next
+// reset, and make that reset grow the buffer so the overflow does not repeat.
+class LinearArena
+{
+public:
+    explicit LinearArena(size_t capacity = 0);
+    ~LinearArena();
+
+    LinearArena(const LinearArena &) = delete;
+    LinearArena &operator=(const LinearArena &) = delete;
+
+    // Safe to call from several threads at once
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+    // Frees everything; must not race with allocate()
+    void reset();
+
+    // Resize the buffer; only valid while nothing is allocated
+    void reserve(size_t capacity);
+
+    size_t used() const { return offset.load(std::memory_order_relaxed); }
+    size_t capacity() const { return size; }
+    size_t highWater() const { return peak; }
+    size_t overflowCount() const { return overflows.size(); }
+
+private:
+    unsigned char *buffer;
+    size_t size;
+    size_t peak;
+    size_t overflowBytes;
+    std::atomic<size_t> offset;
+    std::vector<void *> overflows;
+    std::mutex overflowMutex;
+};
+
+// Two arenas used alternately: data allocated in frame N stays valid until
+// the start of frame N + 2, so a consumer may still read the previous
+// frame's data while the next one is being built. Each producer thread
+// (render, simulation) advances its own pair once per frame or step.
+struct FrameArenas
+{
+    LinearArena arenas[2];
+    int current = 0;
+};
+
+void frameArenasInit(FrameArenas &frames, size_t bytesPerFrame);
+void frameArenasAdvance(FrameArenas &frames);
+
+// The render thread's pair
+void frameArenaInit(size_t bytesPerFrame);
+void frameArenaAdvance();
+LinearArena &frameArena();
+LinearArena &previousFrameArena();
+
+// Uninitialized array of count T from the current frame arena
+template <typename T>
+T *frameAlloc(size_t count)
+{
+    return static_cast<T *>(frameArena().allocate(count * sizeof(T), alignof(T)));
+}
+
+// STL allocator adaptor; deallocate is a no-op because reset() frees everything
+template <typename T>
+struct ArenaAllocator
+{
+    typedef T value_type;
+
+    LinearArena *arena;
+
+    explicit ArenaAllocator(LinearArena &target) : arena(&target) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+};
+
+// Vector whose storage comes from a frame arena; must not outlive its reset
+template <typename T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+template <typename T>
+FrameVector<T> makeFrameVector(LinearArena &arena, size_t reserveCount = 0)
+{
+    FrameVector<T> vector{ArenaAllocator<T>(arena)};
+    vector.reserve(reserveCount);
+    return vector;
+}
@@ -0,0 +1,155 @@
+#include "frame_bench.h"
+#include "dynamic_resolution.h"
+#include "frame_governor.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+RenderStats gRenderStats;
+
+static std::chrono::steady_clock::time_point gFrameStart;
+static std::vector<double> gFrameTimesMs;
+static std::vector<RenderStats> gFrameStats;
+
+bool parseFrameBenchArgs(int argc, char **argv, FrameBenchConfig &config)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--bench-frames") && hasValue)
+        {
+            config.enabled = true;
+            config.frames = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--bench-warmup") && hasValue)
+            config.warmupFrames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench-asteroids") && hasValue)
+            config.asteroids = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench-stars") && hasValue)
+            config.stars = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench-orbits") && hasValue)
+            config.orbits = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench-catalog") && hasValue)
+            config.catalog = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench-seed") && hasValue)
+            config.seed = static_cast<unsigned int>(strtoul(argv[++i], NULL, 10));
+        else if (!strcmp(argv[i], "--bench-governor"))
+            config.governor = true;
+        else if (!strcmp(argv[i], "--bench-dynamic-resolution"))
+            config.dynamicResolution = true;
+        else if (!strcmp(argv[i], "--bench-out") && hasValue)
+            config.outPath = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--bench-frames N] [--bench-warmup N] [--bench-asteroids N]"
+                         " [--bench-stars M] [--bench-orbits N] [--bench-catalog N] [--bench-seed S] [--bench-governor]"
+                         " [--bench-dynamic-resolution] [--bench-out file.json]"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    if (config.frames <= 0 || config.warmupFrames < 0 || config.asteroids < 0 || config.stars < 0 ||
+        config.catalog < 0)
+    {
+        std::cerr << "Benchmark frame, asteroid, star and catalog counts must not be negative" << std::endl;
+        return false;
+    }
+    if (config.enabled)
+    {
+        gFrameTimesMs.reserve(config.frames);
+        gFrameStats.reserve(config.frames);
+    }
+    return true;
+}
+
+void beginBenchFrame()
+{
+    gRenderStats = RenderStats();
+    gFrameStart = std::chrono::steady_clock::now();
+}
+
+void endBenchFrame(bool record)
+{
+    if (!record)
+        return;
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - gFrameStart;
+    gFrameTimesMs.push_back(elapsed.count());
+    gFrameStats.push_back(gRenderStats);
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool writeFrameBenchReport(const FrameBenchConfig &config)
+{
+    std::ofstream file;
+    if (!config.outPath.empty())
+    {
+        file.open(config.outPath);
+        if (!file)
+        {
+            std::cerr << "Failed to open " << config.outPath << std::endl;
+            return false;
+        }
+    }
+    std::ostream &out = config.outPath.empty() ? std::cout : file;
+
+    std::vector<double> sorted = gFrameTimesMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : sorted)
+        total += ms;
+    size_t frames = std::max<size_t>(sorted.size(), 1);
+
+    RenderStats sum;
+    RenderStats peak;
+    for (const RenderStats &stats : gFrameStats)
+    {
+        sum.drawCalls += stats.drawCalls;
+        sum.stateChanges += stats.stateChanges;
+        sum.triangles += stats.triangles;
+        sum.points += stats.points;
+        peak.drawCalls = std::max(peak.drawCalls, stats.drawCalls);
+        peak.stateChanges = std::max(peak.stateChanges, stats.stateChanges);
+        peak.triangles = std::max(peak.triangles, stats.triangles);
+        peak.points = std::max(peak.points, stats.points);
+    }
+
+    const GLubyte *renderer = glGetString(GL_RENDERER);
+    const GLubyte *version = glGetString(GL_VERSION);
+
+    out << "{\n";
+    out << "  \"renderer\": \"" << (renderer ? (const char *)renderer : "unknown") << "\",\n";
+    out << "  \"gl_version\": \"" << (version ? (const char *)version : "unknown") << "\",\n";
+    out << "  \"scenario\": {\"frames\": " << config.frames << ", \"warmup_frames\": " << config.warmupFrames
+        << ", \"asteroids\": " << config.asteroids << ", \"stars\": " << config.stars
+        << ", \"orbits\": " << config.orbits << ", \"catalog\": " << config.catalog
+        << ", \"seed\": " << config.seed << ", \"dt\": " << FRAME_BENCH_DT << "},\n";
+    out << "  \"frame_time_ms\": {\"mean\": " << total / frames << ", \"p50\": " << percentile(sorted, 50)
+        << ", \"p90\": " << percentile(sorted, 90) << ", \"p95\": " << percentile(sorted, 95)
+        << ", \"p99\": " << percentile(sorted, 99) << ", \"max\": " << (sorted.empty() ? 0.0 : sorted.back())
+        << "},\n";
+    out << "  \"per_frame\": {\"draw_calls\": " << static_cast<double>(sum.drawCalls) / frames
+        << ", \"state_changes\": " << static_cast<double>(sum.stateChanges) / frames
+        << ", \"triangles\": " << static_cast<double>(sum.triangles) / frames
+        << ", \"points\": " << static_cast<double>(sum.points) / frames << "},\n";
+    out << "  \"per_frame_max\": {\"draw_calls\": " << peak.drawCalls << ", \"state_changes\": " << peak.stateChanges
+        << ", \"triangles\": " << peak.triangles << ", \"points\": " << peak.points << "},\n";
+    out << "  \"governor\": ";
+    governorWriteJson(out);
+    out << ",\n  \"dynamic_resolution\": ";
+    dynamicResolutionWriteJson(out);
+    out << "\n}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+
+// Per-frame GL submission counters. The stats* wrappers below are used for
+// every call made inside the frame loop so the counts are exact.
+struct RenderStats
+{
+    uint64_t drawCalls = 0;
+    uint64_t stateChanges = 0; // program, VAO and texture binds plus MVP uploads
+    uint64_t triangles = 0;
+    uint64_t points = 0;
+};
+
+extern RenderStats gRenderStats;
+
+inline void statsUseProgram(GLuint program)
+{
+    glUseProgram(program);
+    ++gRenderStats.stateChanges;
+}
+
+inline void statsBindVertexArray(GLuint vao)
+{
+    glBindVertexArray(vao);
+    ++gRenderStats.stateChanges;
+}
+
+inline void statsBindTexture(GLenum target, GLuint texture)
+{
+    glBindTexture(target, texture);
+    ++gRenderStats.stateChanges;
+}
+
+inline void statsUniformMatrix4fv(GLint location, const GLfloat *value)
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    ++gRenderStats.stateChanges;
+}
+
+inline void statsCountPrimitives(GLenum mode, GLsizei count)
+{
+    ++gRenderStats.drawCalls;
+    if (mode == GL_TRIANGLES)
+        gRenderStats.triangles += count / 3;
+    else if (mode == GL_POINTS)
+        gRenderStats.points += count;
+}
+
+inline void statsDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    glDrawArrays(mode, first, count);
+    statsCountPrimitives(mode, count);
+}
+
+inline void statsDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+{
+    glDrawElements(mode, count, type, indices);
+    statsCountPrimitives(mode, count);
+}
+
+inline void statsDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+                                       GLsizei instances)
+{
+    glDrawElementsInstanced(mode, count, type, indices, instances);
+    statsCountPrimitives(mode, count * instances);
+}
+
+// Line primitives are not tallied
+inline void statsDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances)
+{
+    glDrawArraysInstanced(mode, first, count, instances);
+    statsCountPrimitives(mode, count * instances);
+}
+
+// Counted as one draw call; line primitives are not tallied
+inline void statsMultiDrawArrays(GLenum mode, const GLint *first, const GLsizei *count, GLsizei drawCount)
+{
+    glMultiDrawArrays(mode, first, count, drawCount);
+    ++gRenderStats.drawCalls;
+}
+
+// Fixed scenario for the end-to-end frame benchmark (--bench-frames N)
+struct FrameBenchConfig
+{
+    bool enabled = false;
+    int frames = 600;
+    int warmupFrames = 60;
+    int asteroids = 50;
+    int stars = 1000;
+    unsigned int seed = 42;
+    bool governor = false;          // let the frame governor adjust quality during the run
+    bool dynamicResolution = false; // let the render scale follow GPU time during the run
+    int orbits = 0;                 // extra random orbit tracks drawn alongside the satellite and moon
+    int catalog = 0;                // objects of a made-up satellite catalog, propagated and drawn each step
+    std::string outPath;            // empty: stdout
+};
+
+// Fixed simulation step used in benchmark mode so every run sees the same scene
+const float FRAME_BENCH_DT = 1.0f / 60.0f;
+
+// Parse benchmark options; returns false (after printing usage) on bad arguments
+bool parseFrameBenchArgs(int argc, char **argv, FrameBenchConfig &config);
+
+// Bracket one frame; frames before warm-up ends are not recorded
+void beginBenchFrame();
+void endBenchFrame(bool record);
+
+// Write frame-time percentiles and per-frame GL counters as JSON
+bool writeFrameBenchReport(const FrameBenchConfig &config);
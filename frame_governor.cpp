@@ -0,0 +1,217 @@
+#include "frame_governor.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    // Quality ladders; level 0 is full quality
+    const float STAR_FRACTIONS[] = {1.0f, 0.75f, 0.5f, 0.25f};
+    const float LOD_DISTANCES[] = {1000.0f, 9.0f, 7.0f, 0.0f};
+    const float SPAWN_SCALES[] = {1.0f, 1.5f, 2.25f, 3.0f};
+    const int SUBSTEPS[] = {4, 2, 1};
+
+    const int LEVEL_COUNTS[GOVERNOR_KNOB_COUNT] = {
+        sizeof(STAR_FRACTIONS) / sizeof(STAR_FRACTIONS[0]),
+        sizeof(LOD_DISTANCES) / sizeof(LOD_DISTANCES[0]),
+        sizeof(SPAWN_SCALES) / sizeof(SPAWN_SCALES[0]),
+        sizeof(SUBSTEPS) / sizeof(SUBSTEPS[0]),
+    };
+
+    const char *KNOB_NAMES[GOVERNOR_KNOB_COUNT] = {"stars", "asteroid_lod", "spawn_rate", "substeps"};
+
+    // Knobs that relieve each stage, cheapest quality loss first
+    const int STAGE_KNOBS[GOVERNOR_STAGE_COUNT][2] = {
+        {GOVERNOR_STARS, -1},
+        {GOVERNOR_ASTEROID_LOD, GOVERNOR_SPAWN_RATE},
+        {GOVERNOR_SUBSTEPS, GOVERNOR_SPAWN_RATE},
+    };
+
+    const size_t MAX_DECISIONS = 256;
+    const int MAX_DEGRADED = 16;
+
+    struct Decision
+    {
+        uint64_t frame;
+        int knob;
+        int level;
+        float percentileMs;
+    };
+
+    GovernorConfig gConfig;
+    std::atomic<int> gLevels[GOVERNOR_KNOB_COUNT];
+
+    std::vector<float> gWindow;
+    std::vector<float> gScratch;
+    double gStageTotals[GOVERNOR_STAGE_COUNT];
+    int gDegraded[MAX_DEGRADED]; // knobs in the order they were lowered
+    int gDegradedCount = 0;
+    std::vector<Decision> gDecisions;
+    GovernorMetrics gMetrics = {};
+
+    float windowPercentile()
+    {
+        gScratch.assign(gWindow.begin(), gWindow.end());
+        size_t rank = std::min(gScratch.size() - 1, static_cast<size_t>(gConfig.percentile / 100.0f * gScratch.size()));
+        std::nth_element(gScratch.begin(), gScratch.begin() + rank, gScratch.end());
+        return gScratch[rank];
+    }
+
+    void recordDecision(int knob, int level, float percentileMs)
+    {
+        gLevels[knob].store(level, std::memory_order_relaxed);
+        if (gDecisions.size() < MAX_DECISIONS)
+            gDecisions.push_back({gMetrics.frames, knob, level, percentileMs});
+    }
+
+    // Lower the first knob of the most expensive stage that still has a level left
+    bool degrade(float percentileMs)
+    {
+        int stages[GOVERNOR_STAGE_COUNT];
+        for (int i = 0; i < GOVERNOR_STAGE_COUNT; ++i)
+            stages[i] = i;
+        std::sort(stages, stages + GOVERNOR_STAGE_COUNT,
+                  [](int a, int b) { return gStageTotals[a] > gStageTotals[b]; });
+
+        for (int stage : stages)
+        {
+            for (int knob : STAGE_KNOBS[stage])
+            {
+                if (knob < 0 || gDegradedCount >= MAX_DEGRADED)
+                    continue;
+                int level = gLevels[knob].load(std::memory_order_relaxed);
+                if (level + 1 < LEVEL_COUNTS[knob])
+                {
+                    gDegraded[gDegradedCount++] = knob;
+                    recordDecision(knob, level + 1, percentileMs);
+                    ++gMetrics.degrades;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Restore the knob that was lowered last
+    bool upgrade(float percentileMs)
+    {
+        if (gDegradedCount == 0)
+            return false;
+        int knob = gDegraded[--gDegradedCount];
+        recordDecision(knob, gLevels[knob].load(std::memory_order_relaxed) - 1, percentileMs);
+        ++gMetrics.upgrades;
+        return true;
+    }
+}
+
+void governorInit(const GovernorConfig &config)
+{
+    gConfig = config;
+    const char *enabled = getenv("ORBITAL_GOVERNOR");
+    if (enabled)
+        gConfig.enabled = atoi(enabled) != 0;
+    const char *target = getenv("ORBITAL_FRAME_TARGET_MS");
+    if (target && atof(target) > 0.0)
+        gConfig.targetMs = static_cast<float>(atof(target));
+    gConfig.window = std::max(gConfig.window, 1);
+
+    for (int knob = 0; knob < GOVERNOR_KNOB_COUNT; ++knob)
+        gLevels[knob].store(0);
+    gWindow.clear();
+    gWindow.reserve(gConfig.window);
+    gScratch.reserve(gConfig.window);
+    gDecisions.clear();
+    gDecisions.reserve(MAX_DECISIONS);
+    std::fill(gStageTotals, gStageTotals + GOVERNOR_STAGE_COUNT, 0.0);
+    gDegradedCount = 0;
+    gMetrics = GovernorMetrics();
+}
+
+void governorEndFrame(float frameMs, const float stageMs[GOVERNOR_STAGE_COUNT])
+{
+    ++gMetrics.frames;
+    if (frameMs > gConfig.targetMs)
+        ++gMetrics.framesOverBudget;
+    if (!gConfig.enabled)
+        return;
+
+    gWindow.push_back(frameMs);
+    for (int stage = 0; stage < GOVERNOR_STAGE_COUNT; ++stage)
+        gStageTotals[stage] += stageMs[stage];
+    if (gWindow.size() < static_cast<size_t>(gConfig.window))
+        return;
+
+    float percentileMs = windowPercentile();
+    gMetrics.lastPercentileMs = percentileMs;
+    if (percentileMs > gConfig.targetMs)
+        degrade(percentileMs);
+    else if (percentileMs < gConfig.targetMs * gConfig.headroom)
+        upgrade(percentileMs);
+
+    gWindow.clear();
+    std::fill(gStageTotals, gStageTotals + GOVERNOR_STAGE_COUNT, 0.0);
+}
+
+float governorStarFraction()
+{
+    return STAR_FRACTIONS[gLevels[GOVERNOR_STARS].load(std::memory_order_relaxed)];
+}
+
+float governorLodDistance()
+{
+    return LOD_DISTANCES[gLevels[GOVERNOR_ASTEROID_LOD].load(std::memory_order_relaxed)];
+}
+
+float governorSpawnIntervalScale()
+{
+    return SPAWN_SCALES[gLevels[GOVERNOR_SPAWN_RATE].load(std::memory_order_relaxed)];
+}
+
+int governorSubsteps()
+{
+    return SUBSTEPS[gLevels[GOVERNOR_SUBSTEPS].load(std::memory_order_relaxed)];
+}
+
+GovernorMetrics governorMetrics()
+{
+    GovernorMetrics metrics = gMetrics;
+    for (int knob = 0; knob < GOVERNOR_KNOB_COUNT; ++knob)
+        metrics.levels[knob] = gLevels[knob].load(std::memory_order_relaxed);
+    return metrics;
+}
+
+void governorWriteJson(std::ostream &out)
+{
+    GovernorMetrics metrics = governorMetrics();
+    out << "{\"enabled\": " << (gConfig.enabled ? "true" : "false") << ", \"target_ms\": " << gConfig.targetMs
+        << ", \"percentile\": " << gConfig.percentile << ", \"window\": " << gConfig.window
+        << ", \"frames\": " << metrics.frames << ", \"frames_over_budget\": " << metrics.framesOverBudget
+        << ", \"degrades\": " << metrics.degrades << ", \"upgrades\": " << metrics.upgrades
+        << ", \"last_window_percentile_ms\": " << metrics.lastPercentileMs << ",\n    \"settings\": {\"star_fraction\": "
+        << governorStarFraction() << ", \"lod_distance\": " << governorLodDistance()
+        << ", \"spawn_interval_scale\": " << governorSpawnIntervalScale() << ", \"substeps\": " << governorSubsteps()
+        << "},\n    \"decisions\": [";
+    for (size_t i = 0; i < gDecisions.size(); ++i)
+    {
+        const Decision &decision = gDecisions[i];
+        out << (i ? ", " : "") << "{\"frame\": " << decision.frame << ", \"knob\": \"" << KNOB_NAMES[decision.knob]
+            << "\", \"level\": " << decision.level << ", \"percentile_ms\": " << decision.percentileMs << "}";
+    }
+    out << "]}";
+}
+
+void governorPrintSummary()
+{
+    if (!gConfig.enabled)
+        return;
+
+    GovernorMetrics metrics = governorMetrics();
+    fprintf(stderr, "\nFrame governor: target %.1f ms p%.0f, %llu of %llu frames over budget, %llu degrades, %llu upgrades\n",
+            gConfig.targetMs, gConfig.percentile, static_cast<unsigned long long>(metrics.framesOverBudget),
+            static_cast<unsigned long long>(metrics.frames), static_cast<unsigned long long>(metrics.degrades),
+            static_cast<unsigned long long>(metrics.upgrades));
+    fprintf(stderr, "Final settings: stars %.0f%%, LOD distance %.1f, spawn interval x%.2f, %d substeps\n",
+            governorStarFraction() * 100.0f, governorLodDistance(), governorSpawnIntervalScale(), governorSubsteps());
+}
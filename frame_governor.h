@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+// Adaptive frame-budget governor. Every frame the render thread reports the
+// frame's cost (vsync waits excluded) and the cost of the main stages. Once a
+// window of frames is collected, the governor compares its percentile
+// frame time with the target. Over budget, it lowers one quality knob, picked
+// from the most expensive stage. With clear headroom, it restores the knob it
+// lowered last. The window restarts after each decision so the next one sees
+// the effect of the last.
+
+enum GovernorKnob
+{
+    GOVERNOR_STARS,        // fraction of the starfield drawn
+    GOVERNOR_ASTEROID_LOD, // camera distance beyond which asteroids use the coarse mesh
+    GOVERNOR_SPAWN_RATE,   // scale on the asteroid spawn interval
+    GOVERNOR_SUBSTEPS,     // collision substeps per simulation step
+    GOVERNOR_KNOB_COUNT
+};
+
+enum GovernorStage
+{
+    GOVERNOR_STAGE_STARS,
+    GOVERNOR_STAGE_ASTEROIDS,
+    GOVERNOR_STAGE_SIMULATION,
+    GOVERNOR_STAGE_COUNT
+};
+
+struct GovernorConfig
+{
+    bool enabled = true;
+    float targetMs = 16.6f;    // frame-time budget
+    float percentile = 99.0f;  // percentile of the window held under the budget
+    int window = 120;          // frames per decision
+    float headroom = 0.75f;    // restore quality below targetMs * headroom
+};
+
+// Read ORBITAL_GOVERNOR (0 disables) and ORBITAL_FRAME_TARGET_MS on top of config
+void governorInit(const GovernorConfig &config);
+
+// Called once per frame on the render thread
+void governorEndFrame(float frameMs, const float stageMs[GOVERNOR_STAGE_COUNT]);
+
+// Current settings; safe to read from any thread
+float governorStarFraction();
+float governorLodDistance();
+float governorSpawnIntervalScale();
+int governorSubsteps();
+
+struct GovernorMetrics
+{
+    uint64_t frames;
+    uint64_t framesOverBudget;
+    uint64_t degrades;
+    uint64_t upgrades;
+    float lastPercentileMs; // percentile of the last full window
+    int levels[GOVERNOR_KNOB_COUNT];
+};
+
+GovernorMetrics governorMetrics();
+
+// JSON object with the config, metrics, current settings and every decision
+void governorWriteJson(std::ostream &out);
+void governorPrintSummary();
@@ -0,0 +1,233 @@
+#include "geometry.h"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <random>
+
+// Function to generate sphere vertices and texture coordinates
+void generateSphere(float radius, int segments, int rings, std::vector<float> &vertices, std::vector<unsigned int> &indices)
+{
+    vertices.reserve(vertices.size() + (rings + 1) * (segments + 1) * 5);
+    indices.reserve(indices.size() + rings * segments * 6);
+
+    for (int y = 0; y <= rings; ++y)
+    {
+        for (int x = 0; x <= segments; ++x)
+        {
+            float xSegment = static_cast<float>(x) / segments;
+            float ySegment = static_cast<float>(y) / rings;
+            float xPos = radius * cos(xSegment * 2.0f * M_PI) * sin(ySegment * M_PI);
+            float yPos = radius * cos(ySegment * M_PI);
+            float zPos = radius * sin(xSegment * 2.0f * M_PI) * sin(ySegment * M_PI);
+
+            // Position
+            vertices.push_back(xPos);
+            vertices.push_back(yPos);
+            vertices.push_back(zPos);
+
+            // Texture coordinates (flip y coordinate)
+            vertices.push_back(xSegment);        // S
+            vertices.push_back(1.0f - ySegment); // T
+        }
+    }
+
+    for (int y = 0; y < rings; ++y)
+    {
+        for (int x = 0; x < segments; ++x)
+        {
+            int first = (y * (segments + 1)) + x;
+            int second = first + segments + 1;
+
+            indices.push_back(first);
+            indices.push_back(second);
+            indices.push_back(first + 1);
+
+            indices.push_back(second);
+            indices.push_back(second + 1);
+            indices.push_back(first + 1);
+        }
+    }
+}
+
+void generateAsteroid(float radius, int sectors, int stacks,
+                      std::vector<float> &vertices, std::vector<unsigned int> &indices)
+{
+    vertices.reserve(vertices.size() + (stacks + 1) * (sectors + 1) * 6);
+    indices.reserve(indices.size() + stacks * sectors * 6);
+
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_real_distribution<float> dis(-0.15f, 0.15f);
+
+    // Generate vertices
+    for (int i = 0; i <= stacks; ++i)
+    {
+        float phi = M_PI * float(i) / float(stacks);
+        for (int j = 0; j <= sectors; ++j)
+        {
+            float theta = 2.0f * M_PI * float(j) / float(sectors);
+
+            // Base sphere coordinates
+            float x = cos(theta) * sin(phi);
+            float y = cos(phi);
+            float z = sin(theta) * sin(phi);
+
+            // Add random displacement
+            float noise = 1.0f + dis(gen);
+            x *= radius * noise;
+            y *= radius * noise;
+            z *= radius * noise;
+
+            // Position
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
+
+            // Normal vector for lighting
+            glm::vec3 normal = glm::normalize(glm::vec3(x, y, z));
+            vertices.push_back(normal.x);
+            vertices.push_back(normal.y);
+            vertices.push_back(normal.z);
+        }
+    }
+
+    // Generate indices
+    for (int i = 0; i < stacks; ++i)
+    {
+        for (int j = 0; j < sectors; ++j)
+        {
+            int first = i * (sectors + 1) + j;
+            int second = first + sectors + 1;
+
+            indices.push_back(first);
+            indices.push_back(second);
+            indices.push_back(first + 1);
+
+            indices.push_back(second);
+            indices.push_back(second + 1);
+            indices.push_back(first + 1);
+        }
+    }
+}
+
+namespace
+{
+    // Shared by the heap and frame-arena overloads
+    template <typename Vertices, typename Indices>
+    void appendAsteroidMesh(float radius, int sectors, int stacks, Vertices &vertices, Indices &indices)
+    {
+        vertices.reserve(vertices.size() + (stacks + 1) * (sectors + 1) * 3);
+        indices.reserve(indices.size() + stacks * sectors * 6);
+
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution<float> dis(-0.15f, 0.15f);
+
+        // Generate vertices
+        for (int i = 0; i <= stacks; ++i)
+        {
+            float phi = M_PI * float(i) / float(stacks);
+            for (int j = 0; j <= sectors; ++j)
+            {
+                float theta = 2.0f * M_PI * float(j) / float(sectors);
+
+                float x = cos(theta) * sin(phi);
+                float y = cos(phi);
+                float z = sin(theta) * sin(phi);
+
+                // Add random displacement
+                float noise = 1.0f + dis(gen);
+                x *= radius * noise;
+                y *= radius * noise;
+                z *= radius * noise;
+
+                // Only position
+                vertices.push_back(x);
+                vertices.push_back(y);
+                vertices.push_back(z);
+            }
+        }
+
+        // Generate indices
+        for (int i = 0; i < stacks; ++i)
+        {
+            for (int j = 0; j < sectors; ++j)
+            {
+                int first = i * (sectors + 1) + j;
+                int second = first + sectors + 1;
+
+                indices.push_back(first);
+                indices.push_back(second);
+                indices.push_back(first + 1);
+
+                indices.push_back(second);
+                indices.push_back(second + 1);
+                indices.push_back(first + 1);
+            }
+        }
+    }
+}
+
+void generateAsteroidMesh(float radius, int sectors, int stacks,
+                          std::vector<float> &vertices, std::vector<unsigned int> &indices)
+{
+    appendAsteroidMesh(radius, sectors, stacks, vertices, indices);
+}
+
+void generateAsteroidMesh(float radius, int sectors, int stacks,
+                          FrameVector<float> &vertices, FrameVector<unsigned int> &indices)
+{
+    appendAsteroidMesh(radius, sectors, stacks, vertices, indices);
+}
+
+// Function to create sphere vertices
+std::vector<float> createSphereVertices(float radius, int sectors, int stacks)
+{
+    std::vector<float> vertices;
+    vertices.reserve((stacks + 1) * (sectors + 1) * 3);
+
+    for (int i = 0; i <= stacks; ++i)
+    {
+        float stackAngle = M_PI / 2 - i * M_PI / stacks; // from pi/2 to -pi/2
+        float xy = radius * cosf(stackAngle);            // radius at current stack
+        float z = radius * sinf(stackAngle);             // z coordinate
+
+        for (int j = 0; j <= sectors; ++j)
+        {
+            float sectorAngle = j * 2 * M_PI / sectors; // from 0 to 2pi
+            float x = xy * cosf(sectorAngle);           // x coordinate
+            float y = xy * sinf(sectorAngle);           // y coordinate
+            vertices.push_back(x);
+            vertices.push_back(y);
+            vertices.push_back(z);
+        }
+    }
+
+    // Indices for drawing triangles
+    std::vector<unsigned int> indices;
+    indices.reserve(stacks * sectors * 6);
+    for (int i = 0; i < stacks; ++i)
+    {
+        for (int j = 0; j < sectors; ++j)
+        {
+            unsigned int first = (i * (sectors + 1)) + j;
+            unsigned int second = first + sectors + 1;
+            indices.push_back(first);
+            indices.push_back(second);
+            indices.push_back(first + 1);
+            indices.push_back(second);
+            indices.push_back(second + 1);
+            indices.push_back(first + 1);
+        }
+    }
+
+    // Convert indices to a flat vertex list
+    std::vector<float> indexedVertices;
+    indexedVertices.reserve(indices.size() * 3);
+    for (const auto &index : indices)
+    {
+        indexedVertices.push_back(vertices[index * 3]);
+        indexedVertices.push_back(vertices[index * 3 + 1]);
+        indexedVertices.push_back(vertices[index * 3 + 2]);
+    }
+    return indexedVertices;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "frame_arena.h"
+#include <vector>
+
+// Function to generate sphere vertices and texture coordinates
+void generateSphere(float radius, int segments, int rings, std::vector<float> &vertices, std::vector<unsigned int> &indices);
+
+// Function to generate a noisy asteroid mesh with positions and normals
+void generateAsteroid(float radius, int sectors, int stacks,
+                      std::vector<float> &vertices, std::vector<unsigned int> &indices);
+
+// Function to generate a noisy asteroid mesh with positions only
+void generateAsteroidMesh(float radius, int sectors, int stacks,
+                          std::vector<float> &vertices, std::vector<unsigned int> &indices);
+void generateAsteroidMesh(float radius, int sectors, int stacks,
+                          FrameVector<float> &vertices, FrameVector<unsigned int> &indices);
+
+// Function to create sphere vertices (flat, non-indexed triangle list)
+std::vector<float> createSphereVertices(float radius, int sectors, int stacks);
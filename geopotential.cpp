@@ -0,0 +1,319 @@
+#include "geopotential.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    // EGM96 fully normalized coefficients through degree and order 4
+    struct Coefficient
+    {
+        int n, m;
+        double c, s;
+    };
+
+    const Coefficient EGM96[] = {
+        {2, 0, -0.484165371736e-03, 0.0},
+        {2, 1, -0.186987635955e-09, 0.119528012031e-08},
+        {2, 2, 0.243914352398e-05, -0.140016683654e-05},
+        {3, 0, 0.957254173792e-06, 0.0},
+        {3, 1, 0.203046201047e-05, 0.248200415856e-06},
+        {3, 2, 0.904787894809e-06, -0.619005475177e-06},
+        {3, 3, 0.721321757121e-06, 0.141434926192e-05},
+        {4, 0, 0.539873863789e-06, 0.0},
+        {4, 1, -0.536157389388e-06, -0.473567346518e-06},
+        {4, 2, 0.350501623962e-06, 0.662480026275e-06},
+        {4, 3, 0.990856766672e-06, -0.200956723567e-06},
+        {4, 4, -0.188560802735e-06, 0.308803882149e-06},
+    };
+    const int EGM96_DEGREE = 4;
+
+    // V/W harmonics to degree + 1 for L lanes, then the acceleration sums.
+    // Scratch entries are [geopotentialIndex(n, m)][lane].
+    template <int L>
+    void evaluate(const Geopotential &f, const double *x, const double *y, const double *z, double *ax, double *ay,
+                  double *az, GeopotentialScratch &scratch)
+    {
+        int top = f.degree + 1;
+        int topOrder = std::min(f.order + 1, top);
+        size_t entries = static_cast<size_t>(geopotentialIndex(top, top) + 1) * L;
+        if (scratch.v.size() < entries)
+        {
+            scratch.v.resize(entries);
+            scratch.w.resize(entries);
+        }
+        double *v = scratch.v.data();
+        double *w = scratch.w.data();
+
+        double rho[L], x0[L], y0[L], z0[L];
+        for (int i = 0; i < L; ++i)
+        {
+            double r2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+            double scale = f.radius / r2;
+            rho[i] = f.radius * scale;
+            x0[i] = x[i] * scale;
+            y0[i] = y[i] * scale;
+            z0[i] = z[i] * scale;
+            v[i] = f.radius / std::sqrt(r2);
+            w[i] = 0.0;
+        }
+
+        for (int m = 0; m <= topOrder; ++m)
+        {
+            double *vmm = v + geopotentialIndex(m, m) * L;
+            double *wmm = w + geopotentialIndex(m, m) * L;
+            if (m > 0)
+            {
+                const double *vp = v + geopotentialIndex(m - 1, m - 1) * L;
+                const double *wp = w + geopotentialIndex(m - 1, m - 1) * L;
+                double k = f.sectorial[m];
+                for (int i = 0; i < L; ++i)
+                {
+                    vmm[i] = k * (x0[i] * vp[i] - y0[i] * wp[i]);
+                    wmm[i] = k * (x0[i] * wp[i] + y0[i] * vp[i]);
+                }
+            }
+            if (m + 1 <= top)
+            {
+                int index = geopotentialIndex(m + 1, m);
+                double a = f.verticalA[index];
+                for (int i = 0; i < L; ++i)
+                {
+                    v[index * L + i] = a * z0[i] * vmm[i];
+                    w[index * L + i] = a * z0[i] * wmm[i];
+                }
+            }
+            for (int n = m + 2; n <= top; ++n)
+            {
+                int index = geopotentialIndex(n, m);
+                double a = f.verticalA[index], b = f.verticalB[index];
+                const double *v1 = v + geopotentialIndex(n - 1, m) * L, *w1 = w + geopotentialIndex(n - 1, m) * L;
+                const double *v2 = v + geopotentialIndex(n - 2, m) * L, *w2 = w + geopotentialIndex(n - 2, m) * L;
+                for (int i = 0; i < L; ++i)
+                {
+                    v[index * L + i] = a * z0[i] * v1[i] - b * rho[i] * v2[i];
+                    w[index * L + i] = a * z0[i] * w1[i] - b * rho[i] * w2[i];
+                }
+            }
+        }
+
+        double sumX[L] = {}, sumY[L] = {}, sumZ[L] = {};
+        for (int n = 2; n <= f.degree; ++n)
+        {
+            // Zonal term
+            int index = geopotentialIndex(n, 0);
+            double up = f.upFactor[index] * f.c[index];
+            double along = f.zFactor[index] * f.c[index];
+            const double *vu = v + geopotentialIndex(n + 1, 1) * L, *wu = w + geopotentialIndex(n + 1, 1) * L;
+            const double *vz = v + geopotentialIndex(n + 1, 0) * L;
+            for (int i = 0; i < L; ++i)
+            {
+                sumX[i] -= up * vu[i];
+                sumY[i] -= up * wu[i];
+                sumZ[i] -= along * vz[i];
+            }
+
+            // Tesseral and sectorial terms
+            for (int m = 1; m <= std::min(n, f.order); ++m)
+            {
+                index = geopotentialIndex(n, m);
+                double c = f.c[index], s = f.s[index];
+                double upHalf = 0.5 * f.upFactor[index], downHalf = 0.5 * f.downFactor[index];
+                double zf = f.zFactor[index];
+                vu = v + geopotentialIndex(n + 1, m + 1) * L;
+                wu = w + geopotentialIndex(n + 1, m + 1) * L;
+                const double *vd = v + geopotentialIndex(n + 1, m - 1) * L, *wd = w + geopotentialIndex(n + 1, m - 1) * L;
+                vz = v + geopotentialIndex(n + 1, m) * L;
+                const double *wz = w + geopotentialIndex(n + 1, m) * L;
+                for (int i = 0; i < L; ++i)
+                {
+                    sumX[i] += upHalf * (-c * vu[i] - s * wu[i]) + downHalf * (c * vd[i] + s * wd[i]);
+                    sumY[i] += upHalf * (-c * wu[i] + s * vu[i]) + downHalf * (-c * wd[i] + s * vd[i]);
+                    sumZ[i] -= zf * (c * vz[i] + s * wz[i]);
+                }
+            }
+        }
+
+        double scale = f.mu / (f.radius * f.radius);
+        for (int i = 0; i < L; ++i)
+        {
+            ax[i] = scale * sumX[i];
+            ay[i] = scale * sumY[i];
+            az[i] = scale * sumZ[i];
+        }
+    }
+
+    // Fortran-style exponents (1.0D-06) as strtod reads them
+    double parseNumber(std::string text)
+    {
+        std::replace(text.begin(), text.end(), 'D', 'E');
+        std::replace(text.begin(), text.end(), 'd', 'e');
+        return std::strtod(text.c_str(), nullptr);
+    }
+}
+
+void geopotentialSetDegree(Geopotential &field, int degree, int order)
+{
+    degree = std::max(degree, 0);
+    order = std::min(std::max(order, 0), degree);
+    int top = degree + 1;
+    size_t coefficients = geopotentialIndex(degree, degree) + 1;
+    size_t entries = geopotentialIndex(top, top) + 1;
+
+    // Coefficients past the new order are dropped so the sums never see them
+    std::vector<double> c(coefficients, 0.0), s(coefficients, 0.0);
+    for (int n = 0; n <= std::min(degree, field.degree); ++n)
+    {
+        for (int m = 0; m <= std::min(n, order); ++m)
+        {
+            size_t index = geopotentialIndex(n, m);
+            if (index < field.c.size())
+            {
+                c[index] = field.c[index];
+                s[index] = field.s[index];
+            }
+        }
+    }
+    field.c.swap(c);
+    field.s.swap(s);
+    field.degree = degree;
+    field.order = order;
+
+    // Normalized recursion (with N_nm = sqrt((2 - delta_m0) (2n + 1) (n - m)! / (n + m)!)):
+    //   V_mm = sectorial_m (x0 V_m-1,m-1 - y0 W_m-1,m-1)
+    //   V_nm = A_nm z0 V_n-1,m - B_nm rho V_n-2,m
+    field.sectorial.assign(top + 1, 0.0);
+    for (int m = 1; m <= top; ++m)
+        field.sectorial[m] = std::sqrt((m == 1 ? 2.0 : 1.0) * (2.0 * m + 1.0) / (2.0 * m));
+    field.verticalA.assign(entries, 0.0);
+    field.verticalB.assign(entries, 0.0);
+    for (int n = 1; n <= top; ++n)
+    {
+        for (int m = 0; m < n; ++m)
+        {
+            double nn = n, mm = m;
+            field.verticalA[geopotentialIndex(n, m)] =
+                std::sqrt((2.0 * nn - 1.0) * (2.0 * nn + 1.0) / ((nn - mm) * (nn + mm)));
+            if (n - m >= 2)
+                field.verticalB[geopotentialIndex(n, m)] = std::sqrt(
+                    (2.0 * nn + 1.0) * (nn + mm - 1.0) * (nn - mm - 1.0) / ((nn - mm) * (nn + mm) * (2.0 * nn - 3.0)));
+        }
+    }
+
+    // Montenbruck and Gill's acceleration sums, with the ratios of N_nm to
+    // the normalization of the degree n + 1 harmonic each term reads
+    field.upFactor.assign(coefficients, 0.0);
+    field.downFactor.assign(coefficients, 0.0);
+    field.zFactor.assign(coefficients, 0.0);
+    for (int n = 0; n <= degree; ++n)
+    {
+        double nn = n, ratio = (2.0 * nn + 1.0) / (2.0 * nn + 3.0);
+        for (int m = 0; m <= n; ++m)
+        {
+            double mm = m;
+            int index = geopotentialIndex(n, m);
+            field.upFactor[index] = std::sqrt((m == 0 ? 0.5 : 1.0) * ratio * (nn + mm + 1.0) * (nn + mm + 2.0));
+            if (m > 0)
+                field.downFactor[index] =
+                    std::sqrt((m == 1 ? 2.0 : 1.0) * ratio * (nn - mm + 1.0) * (nn - mm + 2.0));
+            field.zFactor[index] = std::sqrt(ratio * (nn + mm + 1.0) * (nn - mm + 1.0));
+        }
+    }
+}
+
+void geopotentialEgm96(Geopotential &field, int degree, int order)
+{
+    field = Geopotential();
+    field.degree = EGM96_DEGREE;
+    field.c.assign(geopotentialIndex(EGM96_DEGREE, EGM96_DEGREE) + 1, 0.0);
+    field.s.assign(field.c.size(), 0.0);
+    field.c[0] = 1.0;
+    for (const Coefficient &coefficient : EGM96)
+    {
+        field.c[geopotentialIndex(coefficient.n, coefficient.m)] = coefficient.c;
+        field.s[geopotentialIndex(coefficient.n, coefficient.m)] = coefficient.s;
+    }
+    geopotentialSetDegree(field, std::min(degree, EGM96_DEGREE), order);
+}
+
+bool geopotentialLoad(Geopotential &field, const char *path, int degree, int order)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::cerr << "ERROR::GEOPOTENTIAL::FILE_NOT_READ " << path << std::endl;
+        return false;
+    }
+
+    field = Geopotential();
+    field.degree = std::max(degree, 0);
+    field.c.assign(geopotentialIndex(field.degree, field.degree) + 1, 0.0);
+    field.s.assign(field.c.size(), 0.0);
+    field.c[0] = 1.0;
+
+    // ICGEM header keys until end_of_head (absent in plain coefficient lists)
+    std::string line;
+    int maxDegree = 0;
+    char key[64], value[64], n[32], m[32], c[64], s[64];
+    while (std::getline(file, line))
+    {
+        if (sscanf(line.c_str(), "%63s %63s", key, value) == 2)
+        {
+            if (!strcmp(key, "earth_gravity_constant"))
+                field.mu = parseNumber(value) * 1e-9;
+            else if (!strcmp(key, "radius"))
+                field.radius = parseNumber(value) * 1e-3;
+            else if (!strcmp(key, "norm") && strcmp(value, "fully_normalized"))
+            {
+                std::cerr << "ERROR::GEOPOTENTIAL::NOT_NORMALIZED " << path << std::endl;
+                return false;
+            }
+        }
+        const char *fields = line.c_str();
+        if (!strncmp(fields, "gfc", 3))
+            fields += strspn(fields + 3, "t") + 3;
+        if (sscanf(fields, "%31s %31s %63s %63s", n, m, c, s) != 4)
+            continue;
+        char *end;
+        long degreeN = strtol(n, &end, 10);
+        if (*end != '\0')
+            continue;
+        long orderM = strtol(m, &end, 10);
+        if (*end != '\0' || orderM < 0 || orderM > degreeN)
+            continue;
+        maxDegree = std::max(maxDegree, static_cast<int>(degreeN));
+        if (degreeN > field.degree || orderM > order)
+            continue;
+        int index = geopotentialIndex(static_cast<int>(degreeN), static_cast<int>(orderM));
+        field.c[index] = parseNumber(c);
+        field.s[index] = parseNumber(s);
+    }
+    if (maxDegree < 2)
+    {
+        std::cerr << "ERROR::GEOPOTENTIAL::NO_COEFFICIENTS " << path << std::endl;
+        return false;
+    }
+
+    // C00 is the central term, which the acceleration leaves out
+    field.c[0] = 1.0;
+    geopotentialSetDegree(field, std::min(field.degree, maxDegree), order);
+    return true;
+}
+
+void geopotentialAcceleration(const Geopotential &field, const double position[3], double acceleration[3],
+                              GeopotentialScratch &scratch)
+{
+    evaluate<1>(field, &position[0], &position[1], &position[2], &acceleration[0], &acceleration[1],
+                &acceleration[2], scratch);
+}
+
+void geopotentialAccelerationBatch(const Geopotential &field, const double position[3][GEOPOTENTIAL_LANES],
+                                   double acceleration[3][GEOPOTENTIAL_LANES], GeopotentialScratch &scratch)
+{
+    evaluate<GEOPOTENTIAL_LANES>(field, position[0], position[1], position[2], acceleration[0], acceleration[1],
+                                 acceleration[2], scratch);
+}
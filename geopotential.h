@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+// Spherical-harmonic gravity field of the Earth (zonal and tesseral terms,
+// J2 up to any degree and order) from fully normalized coefficients.
+//
+// The normalized Cunningham recursion builds the V/W harmonics straight
+// from Cartesian body-fixed coordinates, so there is no singularity at the
+// poles and no sin/cos per order. The recursion factors are cached when
+// the degree is set. The harmonics live in a caller-owned scratch, one per
+// thread, sized on first use.
+//
+// GEOPOTENTIAL_LANES objects can be evaluated together from a
+// structure-of-arrays batch. Every lane runs the same recursion with no
+// branches, so the compiler vectorizes the lane loops.
+//
+// Accelerations leave out the central term (see the point-mass force) and
+// are in the body-fixed frame of the position, km/s^2.
+
+const int GEOPOTENTIAL_LANES = 8;
+
+// EGM96 gravitational parameter, reference radius and J2 (-sqrt(5) times
+// its normalized C20). Every numerical force term defaults to these, so a
+// composed model sees one Earth. The WGS-84 ellipsoid used for geodetic
+// heights (drag) and the shadow cone is geometry, not gravity, and SGP4
+// keeps the WGS-72 constants that are part of its theory.
+const double GEOPOTENTIAL_MU = 398600.4415;    // km^3 / s^2
+const double GEOPOTENTIAL_RADIUS = 6378.1363;  // km
+const double GEOPOTENTIAL_J2 = 1.0826266835e-3;
+
+struct Geopotential
+{
+    double mu = GEOPOTENTIAL_MU;         // km^3 / s^2
+    double radius = GEOPOTENTIAL_RADIUS; // km, reference radius of the coefficients
+    int degree = 0;
+    int order = 0;
+    std::vector<double> c, s;  // normalized, at geopotentialIndex(n, m)
+
+    // Recursion factors up to degree + 1, cached by geopotentialSetDegree
+    std::vector<double> sectorial;
+    std::vector<double> verticalA, verticalB;
+    std::vector<double> upFactor, downFactor, zFactor;
+};
+
+struct GeopotentialScratch
+{
+    std::vector<double> v, w;
+};
+
+inline int geopotentialIndex(int n, int m)
+{
+    return n * (n + 1) / 2 + m;
+}
+
+// Truncate (or extend with zeros) to degree x order and cache the recursion factors
+void geopotentialSetDegree(Geopotential &field, int degree, int order);
+
+// EGM96 through degree and order 4; higher requests are capped there
+void geopotentialEgm96(Geopotential &field, int degree, int order);
+
+// ICGEM .gfc file (or plain "n m C S" lines), truncated to degree x order; false if it cannot be read
+bool geopotentialLoad(Geopotential &field, const char *path, int degree, int order);
+
+// Body-fixed position in km to acceleration in km/s^2
+void geopotentialAcceleration(const Geopotential &field, const double position[3], double acceleration[3],
+                              GeopotentialScratch &scratch);
+
+void geopotentialAccelerationBatch(const Geopotential &field, const double position[3][GEOPOTENTIAL_LANES],
+                                   double acceleration[3][GEOPOTENTIAL_LANES], GeopotentialScratch &scratch);
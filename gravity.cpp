@@ -0,0 +1,182 @@
+// Builds the gravity lookup grid of a geopotential field and checks it:
+//   orbital_gravity --gfc EGM2008.gfc --degree 70 --out gravity_grid.bin
+// Without --gfc the embedded EGM96 field (degree and order 4) is used.
+#include "do_not_optimize.h"
+#include "geopotential.h"
+#include "gravity_grid.h"
+#include "job_graph.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const int BUILD_SLICES = 8;
+
+    struct BuildSlice
+    {
+        const Geopotential *field;
+        GravityGrid *grid;
+        int firstShell, endShell;
+        GeopotentialScratch scratch;
+    };
+
+    void buildJob(void *context)
+    {
+        BuildSlice &slice = *static_cast<BuildSlice *>(context);
+        gravityGridFillShells(*slice.field, *slice.grid, slice.firstShell, slice.endShell, slice.scratch);
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Nanoseconds per call of the direct field and of the grid at the same points
+    void timeLookups(const Geopotential &field, const GravityGrid &grid)
+    {
+        const int points = 4096;
+        const GravityGridHeader &h = grid.header;
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        std::vector<double> positions(points * 3);
+        for (int i = 0; i < points; ++i)
+        {
+            double r = h.innerRadius + unit(generator) * (h.outerRadius - h.innerRadius);
+            double z = 2.0 * unit(generator) - 1.0;
+            double lon = 2.0 * M_PI * unit(generator);
+            positions[i * 3] = r * std::sqrt(1.0 - z * z) * std::cos(lon);
+            positions[i * 3 + 1] = r * std::sqrt(1.0 - z * z) * std::sin(lon);
+            positions[i * 3 + 2] = r * z;
+        }
+
+        GeopotentialScratch scratch;
+        double acceleration[3];
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < points; ++i)
+        {
+            geopotentialAcceleration(field, &positions[i * 3], acceleration, scratch);
+            doNotOptimize(acceleration);
+        }
+        double directNs = secondsSince(start) * 1e9 / points;
+
+        int rounds = 0;
+        start = std::chrono::steady_clock::now();
+        do
+        {
+            for (int i = 0; i < points; ++i)
+            {
+                gravityGridAcceleration(grid, &positions[i * 3], acceleration);
+                doNotOptimize(acceleration);
+            }
+            ++rounds;
+        } while (secondsSince(start) < 0.2);
+        double gridNs = secondsSince(start) * 1e9 / (static_cast<double>(points) * rounds);
+
+        printf("Direct %.0f ns, grid %.0f ns per acceleration (%.0fx)\n", directNs, gridNs, directNs / gridNs);
+    }
+}
+
+static void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [--gfc <file>] [--degree <n>] [--order <m>] [--min-altitude <km>]"
+              << " [--max-altitude <km>] [--shell-step <km>] [--angle-step <deg>] [--check <points>] [--out <file>]"
+              << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    const char *gfcPath = nullptr;
+    const char *outPath = "gravity_grid.bin";
+    int degree = 4, order = -1, checkPoints = 20000;
+    GravityGridSettings settings;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--gfc") && i + 1 < argc)
+            gfcPath = argv[++i];
+        else if (!strcmp(argv[i], "--degree") && i + 1 < argc)
+            degree = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--order") && i + 1 < argc)
+            order = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--min-altitude") && i + 1 < argc)
+            settings.minAltitudeKm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--max-altitude") && i + 1 < argc)
+            settings.maxAltitudeKm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--shell-step") && i + 1 < argc)
+            settings.shellStepKm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--angle-step") && i + 1 < argc)
+            settings.angleStepDeg = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--check") && i + 1 < argc)
+            checkPoints = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (degree < 2)
+    {
+        printUsage(argv[0]);
+        return -1;
+    }
+    if (order < 0)
+        order = degree;
+
+    Geopotential field;
+    if (gfcPath)
+    {
+        if (!geopotentialLoad(field, gfcPath, degree, order))
+            return -1;
+    }
+    else
+        geopotentialEgm96(field, degree, order);
+
+    GravityGrid grid;
+    if (!gravityGridCreate(field, settings, grid))
+        return -1;
+    const GravityGridHeader &h = grid.header;
+    printf("Degree %d x %d: %d shells x %d x %d nodes, %.1f MB\n", field.degree, field.order, h.shells, h.latitudes,
+           h.longitudes, (sizeof(GravityGridHeader) + grid.storage.size() * sizeof(float)) / 1e6);
+
+    // Shells split into slices on the shared workers
+    auto start = std::chrono::steady_clock::now();
+    jobWorkersStart(0);
+    {
+        JobGraph graph("gravityGrid");
+        std::vector<BuildSlice> slices(BUILD_SLICES);
+        for (int i = 0; i < BUILD_SLICES; ++i)
+        {
+            slices[i].field = &field;
+            slices[i].grid = &grid;
+            slices[i].firstShell = h.shells * i / BUILD_SLICES;
+            slices[i].endShell = h.shells * (i + 1) / BUILD_SLICES;
+            graph.addJob("fillShells", buildJob, &slices[i]);
+        }
+        graph.run();
+    }
+    jobWorkersStop();
+    double buildSeconds = secondsSince(start);
+
+    gravityGridCheck(field, grid, checkPoints, 1);
+    printf("Built in %.1f s; over %d check points the error is at most %.2e km/s^2 (RMS %.2e)\n", buildSeconds,
+           h.checkPoints, h.maxError, h.rmsError);
+    timeLookups(field, grid);
+
+    if (!gravityGridSave(grid, outPath))
+        return -1;
+
+    // Read it back through the mapping as users will
+    GravityGrid mapped;
+    if (!gravityGridOpen(outPath, mapped))
+        return -1;
+    gravityGridClose(mapped);
+    printf("Wrote %s\n", outPath);
+    return 0;
+}
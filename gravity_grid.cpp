@@ -0,0 +1,254 @@
+#include "gravity_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const uint32_t GRID_MAGIC = 0x6767424f; // "OBgg"
+    const uint32_t GRID_VERSION = 1;
+
+    size_t nodeCount(const GravityGridHeader &h)
+    {
+        return static_cast<size_t>(h.shells) * h.latitudes * h.longitudes;
+    }
+
+    // Cubic Lagrange weights of the nodes at -1, 0, 1 and 2 for t in [0, 1]
+    void lagrangeWeights(double t, double w[4])
+    {
+        double a = t + 1.0, b = t - 1.0, c = t - 2.0;
+        w[0] = -t * b * c / 6.0;
+        w[1] = a * b * c / 2.0;
+        w[2] = -a * t * c / 2.0;
+        w[3] = a * t * b / 6.0;
+    }
+
+    // Stored node (shell, latitude, longitude) as a body-fixed position. Rows
+    // past a pole land on the far side of it, which keeps the samples smooth
+    // in latitude across the pole.
+    void nodePosition(const GravityGridHeader &h, int shell, int latitude, int longitude, double position[3])
+    {
+        double r = h.innerRadius + (shell - 1) * h.shellStep;
+        double lat = -0.5 * M_PI + (latitude - 1) * h.angleStep;
+        double lon = (longitude - 1) * h.angleStep;
+        position[0] = r * std::cos(lat) * std::cos(lon);
+        position[1] = r * std::cos(lat) * std::sin(lon);
+        position[2] = r * std::sin(lat);
+    }
+}
+
+bool gravityGridCreate(const Geopotential &field, const GravityGridSettings &settings, GravityGrid &grid)
+{
+    if (settings.minAltitudeKm >= settings.maxAltitudeKm || settings.shellStepKm <= 0.0 ||
+        settings.angleStepDeg <= 0.0 || settings.angleStepDeg > 45.0 ||
+        field.radius + settings.minAltitudeKm - settings.shellStepKm <= 0.0)
+    {
+        std::cerr << "ERROR::GRAVITY_GRID::INVALID_SETTINGS" << std::endl;
+        return false;
+    }
+    gravityGridClose(grid);
+
+    // An even number of longitude steps puts a row on each pole
+    int columns = 2 * std::max(1, static_cast<int>(std::lround(180.0 / settings.angleStepDeg)));
+    int bandShells = static_cast<int>(std::ceil((settings.maxAltitudeKm - settings.minAltitudeKm) / settings.shellStepKm)) + 1;
+
+    GravityGridHeader &h = grid.header;
+    h = {};
+    h.magic = GRID_MAGIC;
+    h.version = GRID_VERSION;
+    h.degree = field.degree;
+    h.order = field.order;
+    h.shells = bandShells + 2;
+    h.latitudes = columns / 2 + 3;
+    h.longitudes = columns + 3;
+    h.mu = field.mu;
+    h.radius = field.radius;
+    h.innerRadius = field.radius + settings.minAltitudeKm;
+    h.outerRadius = h.innerRadius + (bandShells - 1) * settings.shellStepKm;
+    h.shellStep = settings.shellStepKm;
+    h.angleStep = 2.0 * M_PI / columns;
+    grid.storage.assign(nodeCount(h) * 3, 0.0f);
+    grid.nodes = grid.storage.data();
+    return true;
+}
+
+void gravityGridFillShells(const Geopotential &field, GravityGrid &grid, int firstShell, int endShell,
+                           GeopotentialScratch &scratch)
+{
+    const GravityGridHeader &h = grid.header;
+    endShell = std::min(endShell, h.shells);
+    double position[3][GEOPOTENTIAL_LANES], acceleration[3][GEOPOTENTIAL_LANES];
+    for (int shell = std::max(firstShell, 0); shell < endShell; ++shell)
+        for (int latitude = 0; latitude < h.latitudes; ++latitude)
+        {
+            float *row = grid.storage.data() + (static_cast<size_t>(shell) * h.latitudes + latitude) * h.longitudes * 3;
+            for (int start = 0; start < h.longitudes; start += GEOPOTENTIAL_LANES)
+            {
+                // The last batch repeats its final node in the unused lanes
+                int count = std::min(GEOPOTENTIAL_LANES, h.longitudes - start);
+                for (int lane = 0; lane < GEOPOTENTIAL_LANES; ++lane)
+                {
+                    double node[3];
+                    nodePosition(h, shell, latitude, start + std::min(lane, count - 1), node);
+                    for (int axis = 0; axis < 3; ++axis)
+                        position[axis][lane] = node[axis];
+                }
+                geopotentialAccelerationBatch(field, position, acceleration, scratch);
+                for (int lane = 0; lane < count; ++lane)
+                    for (int axis = 0; axis < 3; ++axis)
+                        row[(start + lane) * 3 + axis] = static_cast<float>(acceleration[axis][lane]);
+            }
+        }
+}
+
+void gravityGridCheck(const Geopotential &field, GravityGrid &grid, int points, unsigned int seed)
+{
+    GravityGridHeader &h = grid.header;
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    GeopotentialScratch scratch;
+    double maxError = 0.0, sumSquares = 0.0;
+    for (int i = 0; i < points; ++i)
+    {
+        double r = h.innerRadius + unit(generator) * (h.outerRadius - h.innerRadius);
+        double z = 2.0 * unit(generator) - 1.0;
+        double lon = 2.0 * M_PI * unit(generator);
+        double position[3] = {r * std::sqrt(1.0 - z * z) * std::cos(lon), r * std::sqrt(1.0 - z * z) * std::sin(lon),
+                              r * z};
+        double exact[3], lookup[3];
+        geopotentialAcceleration(field, position, exact, scratch);
+        gravityGridAcceleration(grid, position, lookup);
+        double error = 0.0;
+        for (int axis = 0; axis < 3; ++axis)
+            error += (lookup[axis] - exact[axis]) * (lookup[axis] - exact[axis]);
+        maxError = std::max(maxError, std::sqrt(error));
+        sumSquares += error;
+    }
+    h.checkPoints = points;
+    h.maxError = maxError;
+    h.rmsError = points > 0 ? std::sqrt(sumSquares / points) : 0.0;
+}
+
+bool gravityGridSave(const GravityGrid &grid, const char *path)
+{
+    // Write a temporary file and rename it so a running process never maps half a grid
+    std::string temporary = std::string(path) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&grid.header), sizeof(grid.header));
+        out.write(reinterpret_cast<const char *>(grid.nodes), nodeCount(grid.header) * 3 * sizeof(float));
+        if (!out)
+        {
+            std::cerr << "ERROR::GRAVITY_GRID::FILE_NOT_WRITTEN " << path << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path) != 0)
+    {
+        std::cerr << "ERROR::GRAVITY_GRID::FILE_NOT_WRITTEN " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool gravityGridOpen(const char *path, GravityGrid &grid)
+{
+    gravityGridClose(grid);
+    int descriptor = open(path, O_RDONLY);
+    struct stat status;
+    if (descriptor < 0 || fstat(descriptor, &status) != 0)
+    {
+        std::cerr << "ERROR::GRAVITY_GRID::FILE_NOT_READ " << path << std::endl;
+        if (descriptor >= 0)
+            close(descriptor);
+        return false;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+    if (size < sizeof(GravityGridHeader))
+    {
+        std::cerr << "ERROR::GRAVITY_GRID::INVALID_FILE " << path << std::endl;
+        close(descriptor);
+        return false;
+    }
+
+    // Shared, so every process using the grid reads the same page cache
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED)
+    {
+        std::cerr << "ERROR::GRAVITY_GRID::FILE_NOT_MAPPED " << path << std::endl;
+        return false;
+    }
+    const GravityGridHeader &h = *static_cast<const GravityGridHeader *>(mapped);
+    if (h.magic != GRID_MAGIC || h.version != GRID_VERSION || h.shells < 4 || h.latitudes < 4 || h.longitudes < 4 ||
+        size != sizeof(GravityGridHeader) + nodeCount(h) * 3 * sizeof(float))
+    {
+        std::cerr << "ERROR::GRAVITY_GRID::INVALID_FILE " << path << std::endl;
+        munmap(mapped, size);
+        return false;
+    }
+    grid.header = h;
+    grid.mapping = mapped;
+    grid.mappedBytes = size;
+    grid.nodes = reinterpret_cast<const float *>(static_cast<const char *>(mapped) + sizeof(GravityGridHeader));
+    return true;
+}
+
+void gravityGridClose(GravityGrid &grid)
+{
+    if (grid.mapping)
+        munmap(grid.mapping, grid.mappedBytes);
+    grid.mapping = nullptr;
+    grid.mappedBytes = 0;
+    grid.storage.clear();
+    grid.storage.shrink_to_fit();
+    grid.nodes = nullptr;
+}
+
+bool gravityGridAcceleration(const GravityGrid &grid, const double position[3], double acceleration[3])
+{
+    const GravityGridHeader &h = grid.header;
+    double horizontal = std::sqrt(position[0] * position[0] + position[1] * position[1]);
+    double r = std::sqrt(horizontal * horizontal + position[2] * position[2]);
+    if (!(r >= h.innerRadius && r <= h.outerRadius))
+        return false;
+
+    // Cell of the point and its fractions; the stencil starts one node before
+    // the cell, which is stored index cell + 1 - 1
+    double radial = (r - h.innerRadius) / h.shellStep;
+    double polar = (std::atan2(position[2], horizontal) + 0.5 * M_PI) / h.angleStep;
+    double lon = std::atan2(position[1], position[0]);
+    double azimuthal = (lon < 0.0 ? lon + 2.0 * M_PI : lon) / h.angleStep;
+    int shell = std::min(static_cast<int>(radial), h.shells - 4);
+    int latitude = std::min(static_cast<int>(polar), h.latitudes - 4);
+    int longitude = std::min(static_cast<int>(azimuthal), h.longitudes - 4);
+    double wr[4], wa[4], wo[4];
+    lagrangeWeights(radial - shell, wr);
+    lagrangeWeights(polar - latitude, wa);
+    lagrangeWeights(azimuthal - longitude, wo);
+
+    double sum[3] = {0.0, 0.0, 0.0};
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+        {
+            const float *node =
+                grid.nodes + ((static_cast<size_t>(shell + i) * h.latitudes + latitude + j) * h.longitudes + longitude) * 3;
+            double weight = wr[i] * wa[j];
+            for (int axis = 0; axis < 3; ++axis)
+                sum[axis] += weight * (wo[0] * node[axis] + wo[1] * node[3 + axis] + wo[2] * node[6 + axis] +
+                                       wo[3] * node[9 + axis]);
+        }
+    for (int axis = 0; axis < 3; ++axis)
+        acceleration[axis] = sum[axis];
+    return true;
+}
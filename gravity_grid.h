@@ -0,0 +1,78 @@
+#pragma once
+
+#include "geopotential.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Precomputed lookup of the geopotential acceleration for high degrees.
+//
+// The body-fixed acceleration is sampled once on a grid of spherical shells
+// (radius x latitude x longitude, equal angle steps) across an altitude
+// band. A lookup is then tricubic Lagrange interpolation over the 4x4x4
+// nodes around the point, with no cost that depends on the degree. The
+// grid is padded by a row of nodes past each pole, a shell on each side of
+// the band and the longitude wrap, so every stencil reads straight from
+// the table.
+//
+// Nodes are stored as floats in a flat file that is memory-mapped for
+// lookups, so several processes share one copy. The build checks the grid
+// against the direct evaluation at random points and records the largest
+// and RMS error in the file; that is the accuracy bound it is used with.
+
+struct GravityGridSettings
+{
+    double minAltitudeKm = 200.0;
+    double maxAltitudeKm = 1000.0;
+    double shellStepKm = 25.0;
+    double angleStepDeg = 0.5;
+};
+
+// Start of the file; the nodes follow as float[shell][latitude][longitude][3]
+struct GravityGridHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t degree, order;
+    int32_t shells, latitudes, longitudes; // stored counts, padding included
+    int32_t checkPoints;
+    double mu, radius;
+    double innerRadius;  // km, radius of the first shell inside the band
+    double outerRadius;  // km, radius of the last one
+    double shellStep;    // km
+    double angleStep;    // rad
+    double maxError;     // km/s^2 over the check points
+    double rmsError;
+};
+
+// Either built in memory (nodes point into storage) or opened from a file
+// (nodes point into the mapping). Release with gravityGridClose.
+struct GravityGrid
+{
+    GravityGridHeader header = {};
+    const float *nodes = nullptr;
+    std::vector<float> storage;
+    void *mapping = nullptr;
+    size_t mappedBytes = 0;
+};
+
+// Size an empty grid for the field and band; false if the settings are unusable
+bool gravityGridCreate(const Geopotential &field, const GravityGridSettings &settings, GravityGrid &grid);
+
+// Fill stored shells [firstShell, endShell); slices can run on different threads, each with its own scratch
+void gravityGridFillShells(const Geopotential &field, GravityGrid &grid, int firstShell, int endShell,
+                           GeopotentialScratch &scratch);
+
+// Compare lookups with the field at random points in the band and record the errors in the header
+void gravityGridCheck(const Geopotential &field, GravityGrid &grid, int points, unsigned int seed);
+
+bool gravityGridSave(const GravityGrid &grid, const char *path);
+
+// Map a saved grid read-only; false (after logging) if it cannot be read or is not a grid
+bool gravityGridOpen(const char *path, GravityGrid &grid);
+
+void gravityGridClose(GravityGrid &grid);
+
+// Body-fixed position in km to acceleration in km/s^2, as geopotentialAcceleration.
+// False (and acceleration untouched) outside the altitude band.
+bool gravityGridAcceleration(const GravityGrid &grid, const double position[3], double acceleration[3]);
@@ -0,0 +1,166 @@
+#include "headless.h"
+#include <GL/glew.h>
+#include <iostream>
+
+#ifdef HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+static EGLDisplay gDisplay = EGL_NO_DISPLAY;
+static EGLContext gContext = EGL_NO_CONTEXT;
+static EGLSurface gSurface = EGL_NO_SURFACE;
+
+// Prefer the surfaceless Mesa platform so no X server or render node is needed
+static EGLDisplay openDisplay()
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+    {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+            return display;
+    }
+
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display != EGL_NO_DISPLAY && eglInitialize(display, NULL, NULL))
+        return display;
+    return EGL_NO_DISPLAY;
+}
+
+bool createHeadlessContext()
+{
+    gDisplay = openDisplay();
+    if (gDisplay == EGL_NO_DISPLAY)
+    {
+        std::cerr << "ERROR::HEADLESS::NO_EGL_DISPLAY" << std::endl;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "ERROR::HEADLESS::NO_DESKTOP_GL" << std::endl;
+        destroyHeadlessContext();
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_DEPTH_SIZE, 24,
+        EGL_NONE};
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(gDisplay, configAttribs, &config, 1, &numConfigs) || numConfigs == 0)
+    {
+        // Surfaceless platforms may expose no pbuffer configs; a context without surfaces is enough
+        const EGLint anyConfigAttribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        if (!eglChooseConfig(gDisplay, anyConfigAttribs, &config, 1, &numConfigs) || numConfigs == 0)
+        {
+            std::cerr << "ERROR::HEADLESS::NO_EGL_CONFIG" << std::endl;
+            destroyHeadlessContext();
+            return false;
+        }
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    gContext = eglCreateContext(gDisplay, config, EGL_NO_CONTEXT, contextAttribs);
+    if (gContext == EGL_NO_CONTEXT)
+    {
+        std::cerr << "ERROR::HEADLESS::CONTEXT_CREATION_FAILED" << std::endl;
+        destroyHeadlessContext();
+        return false;
+    }
+
+    // Rendering goes to an FBO, so the surface (if any) is only needed to make the context current
+    if (!eglMakeCurrent(gDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, gContext))
+    {
+        const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        gSurface = eglCreatePbufferSurface(gDisplay, config, pbufferAttribs);
+        if (gSurface == EGL_NO_SURFACE || !eglMakeCurrent(gDisplay, gSurface, gSurface, gContext))
+        {
+            std::cerr << "ERROR::HEADLESS::MAKE_CURRENT_FAILED" << std::endl;
+            destroyHeadlessContext();
+            return false;
+        }
+    }
+    return true;
+}
+
+void destroyHeadlessContext()
+{
+    if (gDisplay == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(gDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (gSurface != EGL_NO_SURFACE)
+        eglDestroySurface(gDisplay, gSurface);
+    if (gContext != EGL_NO_CONTEXT)
+        eglDestroyContext(gDisplay, gContext);
+    eglTerminate(gDisplay);
+    gDisplay = EGL_NO_DISPLAY;
+    gContext = EGL_NO_CONTEXT;
+    gSurface = EGL_NO_SURFACE;
+}
+
+#else
+
+bool createHeadlessContext()
+{
+    std::cerr << "Headless EGL context not available in this build, using a hidden window" << std::endl;
+    return false;
+}
+
+void destroyHeadlessContext()
+{
+}
+
+#endif
+
+static GLuint gFramebuffer = 0;
+static GLuint gColorBuffer = 0;
+static GLuint gDepthBuffer = 0;
+
+bool createHeadlessFramebuffer(int width, int height)
+{
+    glGenFramebuffers(1, &gFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, gFramebuffer);
+
+    glGenRenderbuffers(1, &gColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, gColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, gColorBuffer);
+
+    glGenRenderbuffers(1, &gDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, gDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, gDepthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        destroyHeadlessFramebuffer();
+        return false;
+    }
+    return true;
+}
+
+unsigned int headlessFramebuffer()
+{
+    return gFramebuffer;
+}
+
+void destroyHeadlessFramebuffer()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteRenderbuffers(1, &gDepthBuffer);
+    glDeleteRenderbuffers(1, &gColorBuffer);
+    glDeleteFramebuffers(1, &gFramebuffer);
+    gFramebuffer = gColorBuffer = gDepthBuffer = 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Offscreen OpenGL 3.3 core context for machines without a display or GPU.
+// Uses EGL (surfaceless Mesa platform, falling back to a pbuffer) when built
+// with HEADLESS_EGL; otherwise createHeadlessContext() fails and the caller
+// should fall back to a hidden GLFW window.
+
+bool createHeadlessContext();
+void destroyHeadlessContext();
+
+// Framebuffer object that stands in for the default framebuffer (call after glewInit)
+bool createHeadlessFramebuffer(int width, int height);
+void destroyHeadlessFramebuffer();
+unsigned int headlessFramebuffer(); // the GL name of that framebuffer, 0 if none
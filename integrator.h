@@ -0,0 +1,593 @@
+#pragma once
+
+#include "force_model.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Adaptive embedded Runge-Kutta integration of many independent bodies
+// under a ForceModel: Dormand-Prince 5(4) (DOPRI5) and 8(5,3) (DOP853, with
+// the error estimate and dense output of Hairer's code), with per-body
+// error control and dense output.
+//
+// Steps are block steps: each body's step is its controller's choice
+// rounded down to the interval over a power of two (its level), and it
+// only moves to a coarser level where its time lines up with it. Bodies at
+// the same time and level are one group: they share the stage times, so
+// the force model's per-step work (Sun, Moon, Earth rotation) is prepared
+// once per stage for the group, and they run FORCE_LANES at a time through
+// the batch forces. A body needing short steps (low perigee, high
+// eccentricity) takes them without holding any other body to them.
+//
+// Times are whole ticks of the interval over 2^INTEGRATOR_MAX_LEVEL, so
+// group times compare exactly and the last step ends on the interval.
+
+const int INTEGRATOR_MAX_LEVEL = 40;
+
+enum IntegratorMethod
+{
+    INTEGRATOR_DOPRI5 = 0,
+    INTEGRATOR_DOP853 = 1,
+};
+
+struct IntegratorSettings
+{
+    IntegratorMethod method = INTEGRATOR_DOP853;
+    double relativeTolerance = 1e-10;
+    double positionTolerance = 1e-6; // km, absolute
+    double velocityTolerance = 1e-9; // km/s, absolute
+    double maxStep = 0.0;            // s, none when 0
+    double safety = 0.9;
+    double minShrink = 0.2;          // smallest step factor after one step
+};
+
+// Bodies as a structure of arrays; integrateBodies advances them in place
+struct IntegratorBodies
+{
+    std::vector<double> x, y, z;          // km, inertial (TEME)
+    std::vector<double> vx, vy, vz;       // km/s
+    std::vector<double> ballistic;        // Cd * A / m, m^2 / kg, for Drag
+    std::vector<double> reflectivity;     // Cr * A / m, m^2 / kg, for SolarPressure
+    std::vector<double> step;             // s, the controller's next step; 0 to start from an estimate
+    std::vector<int> accepted, rejected;  // steps, over every call
+    std::vector<char> failed;             // the step fell below the finest level; the body is left there
+};
+
+inline int integratorBodiesSize(const IntegratorBodies &bodies)
+{
+    return static_cast<int>(bodies.x.size());
+}
+
+inline void integratorBodiesResize(IntegratorBodies &bodies, int count)
+{
+    for (std::vector<double> *column : {&bodies.x, &bodies.y, &bodies.z, &bodies.vx, &bodies.vy, &bodies.vz,
+                                        &bodies.ballistic, &bodies.reflectivity, &bodies.step})
+        column->resize(count, 0.0);
+    bodies.accepted.resize(count, 0);
+    bodies.rejected.resize(count, 0);
+    bodies.failed.resize(count, 0);
+}
+
+// States at chosen times from the dense output, without shortening any step
+struct IntegratorSamples
+{
+    std::vector<double> times;  // s from the start of the interval, rising
+    std::vector<double> states; // body-major, 6 per time (position km, velocity km/s); sized by the caller
+};
+
+inline double *integratorSample(IntegratorSamples &samples, int body, int time)
+{
+    return &samples.states[(static_cast<size_t>(body) * samples.times.size() + time) * 6];
+}
+
+// Working arrays of integrateBodies, one per thread like GeopotentialScratch.
+// They keep their capacity across calls, so once they have grown to the
+// body count an integration no longer allocates.
+struct IntegratorScratch
+{
+    std::vector<long long> ticks;
+    std::vector<int> levels;
+    std::vector<double> accelerations;
+    std::vector<int> active;
+    std::vector<std::vector<int>> groups; // bodies per level in the current round
+};
+
+// Dormand and Prince's 5(4) pair. The last stage is at the new state and
+// is the next step's first (FSAL). Dense output is Shampine's, fourth order.
+struct DormandPrince5
+{
+    static constexpr int STAGES = 7;
+    static constexpr int DENSE_STAGES = 0;
+    static constexpr int DENSE_TERMS = 5;
+    static constexpr double ERROR_EXPONENT = 1.0 / 5.0;
+    static constexpr double MAX_GROWTH = 10.0;
+
+    static constexpr double C[STAGES] = {0.0, 1.0 / 5.0, 3.0 / 10.0, 4.0 / 5.0, 8.0 / 9.0, 1.0, 1.0};
+    static constexpr double A[STAGES][STAGES] = {
+        {},
+        {1.0 / 5.0},
+        {3.0 / 40.0, 9.0 / 40.0},
+        {44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0},
+        {19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0},
+        {9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0},
+        {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0},
+    };
+    // Fifth less fourth order weights
+    static constexpr double E[STAGES] = {71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0,
+                                         -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0};
+    static constexpr double D[DENSE_TERMS - 4][STAGES] = {
+        {-12715105075.0 / 11282082432.0, 0.0, 87487479700.0 / 32700410799.0, -10690763975.0 / 1880347072.0,
+         701980252875.0 / 199316789632.0, -1453857185.0 / 822651844.0, 69997945.0 / 29380423.0},
+    };
+
+    // Error per lane relative to the tolerance scale: the step is kept at <= 1
+    static void errorNorm(double h, const double k[][6][FORCE_LANES], const double scale[6][FORCE_LANES],
+                          double error[FORCE_LANES])
+    {
+        for (int i = 0; i < FORCE_LANES; ++i)
+            error[i] = 0.0;
+        for (int c = 0; c < 6; ++c)
+            for (int i = 0; i < FORCE_LANES; ++i)
+            {
+                double e = 0.0;
+                for (int j = 0; j < STAGES; ++j)
+                    e += E[j] * k[j][c][i];
+                e *= h / scale[c][i];
+                error[i] += e * e;
+            }
+        for (int i = 0; i < FORCE_LANES; ++i)
+            error[i] = std::sqrt(error[i] / 6.0);
+    }
+};
+
+// Dormand and Prince's 8th order method as in Hairer's DOP853: a fifth
+// order error estimate weighted against a third order one, and a seventh
+// order dense output from three more stages, run only for steps that hold
+// a sample time. Stage 13 is at the new state (FSAL).
+struct DormandPrince853
+{
+    static constexpr int STAGES = 13;
+    static constexpr int DENSE_STAGES = 3;
+    static constexpr int DENSE_TERMS = 8;
+    static constexpr double ERROR_EXPONENT = 1.0 / 8.0;
+    static constexpr double MAX_GROWTH = 6.0;
+
+    static constexpr double C[STAGES + DENSE_STAGES] = {
+        0.0, 0.526001519587677318785587544488e-01, 0.789002279381515978178381316732e-01,
+        0.118350341907227396726757197510, 0.281649658092772603273242802490, 0.333333333333333333333333333333,
+        0.25, 0.307692307692307692307692307692, 0.651282051282051282051282051282, 0.6,
+        0.857142857142857142857142857142, 1.0, 1.0, 0.1, 0.2, 0.777777777777777777777777777778};
+
+    static constexpr double A[STAGES + DENSE_STAGES][STAGES + DENSE_STAGES] = {
+        {},
+        {5.26001519587677318785587544488e-2},
+        {1.97250569845378994544595329183e-2, 5.91751709536136983633785987549e-2},
+        {2.95875854768068491816892993775e-2, 0.0, 8.87627564304205475450678981324e-2},
+        {2.41365134159266685502369798665e-1, 0.0, -8.84549479328286085344864962717e-1,
+         9.24834003261792003115737966543e-1},
+        {3.7037037037037037037037037037e-2, 0.0, 0.0, 1.70828608729473871279604482173e-1,
+         1.25467687566822425016691814123e-1},
+        {3.7109375e-2, 0.0, 0.0, 1.70252211019544039314978060272e-1, 6.02165389804559606850219397283e-2,
+         -1.7578125e-2},
+        {3.70920001185047927108779319836e-2, 0.0, 0.0, 1.70383925712239993810214054705e-1,
+         1.07262030446373284651809199168e-1, -1.53194377486244017527936158236e-2,
+         8.27378916381402288758473766002e-3},
+        {6.24110958716075717114429577812e-1, 0.0, 0.0, -3.36089262944694129406857109825,
+         -8.68219346841726006818189891453e-1, 2.75920996994467083049415600797e1, 2.01540675504778934086186788979e1,
+         -4.34898841810699588477366255144e1},
+        {4.77662536438264365890433908527e-1, 0.0, 0.0, -2.48811461997166764192642586468,
+         -5.90290826836842996371446475743e-1, 2.12300514481811942347288949897e1, 1.52792336328824235832596922938e1,
+         -3.32882109689848629194453265587e1, -2.03312017085086261358222928593e-2},
+        {-9.3714243008598732571704021658e-1, 0.0, 0.0, 5.18637242884406370830023853209,
+         1.09143734899672957818500254654, -8.14978701074692612513997267357, -1.85200656599969598641566180701e1,
+         2.27394870993505042818970056734e1, 2.49360555267965238987089396762, -3.0467644718982195003823669022},
+        {2.27331014751653820792359768449, 0.0, 0.0, -1.05344954667372501984066689879e1,
+         -2.00087205822486249909675718444, -1.79589318631187989172765950534e1, 2.79488845294199600508499808837e1,
+         -2.85899827713502369474065508674, -8.87285693353062954433549289258, 1.23605671757943030647266201528e1,
+         6.43392746015763530355970484046e-1},
+        // The eighth order weights
+        {5.42937341165687622380535766363e-2, 0.0, 0.0, 0.0, 0.0, 4.45031289275240888144113950566,
+         1.89151789931450038304281599044, -5.8012039600105847814672114227, 3.1116436695781989440891606237e-1,
+         -1.52160949662516078556178806805e-1, 2.01365400804030348374776537501e-1,
+         4.47106157277725905176885569043e-2},
+        {5.61675022830479523392909219681e-2, 0.0, 0.0, 0.0, 0.0, 0.0, 2.53500210216624811088794765333e-1,
+         -2.46239037470802489917441475441e-1, -1.24191423263816360469010140626e-1,
+         1.5329179827876569731206322685e-1, 8.20105229563468988491666602057e-3,
+         7.56789766054569976138603589584e-3, -8.298e-3},
+        {3.18346481635021405060768473261e-2, 0.0, 0.0, 0.0, 0.0, 2.83009096723667755288322961402e-2,
+         5.35419883074385676223797384372e-2, -5.49237485713909884646569340306e-2, 0.0, 0.0,
+         -1.08347328697249322858509316994e-4, 3.82571090835658412954920192323e-4,
+         -3.40465008687404560802977114492e-4, 1.41312443674632500278074618366e-1},
+        {-4.28896301583791923408573538692e-1, 0.0, 0.0, 0.0, 0.0, -4.69762141536116384314449447206,
+         7.68342119606259904184240953878, 4.06898981839711007970213554331, 3.56727187455281109270669543021e-1,
+         0.0, 0.0, 0.0, -1.39902416515901462129418009734e-3, 2.9475147891527723389556272149,
+         -9.15095847217987001081870187138},
+    };
+
+    // Fifth order error weights, and the third order solution the
+    // eighth order one is also compared with
+    static constexpr double E5[STAGES] = {
+        0.1312004499419488073250102996e-01, 0.0, 0.0, 0.0, 0.0, -0.1225156446376204440720569753e+01,
+        -0.4957589496572501915214079952, 0.1664377182454986536961530415e+01, -0.3503288487499736816886487290,
+        0.3341791187130174790297318841, 0.8192320648511571246570742613e-01, -0.2235530786388629525884427845e-01,
+        0.0};
+    static constexpr double B3[STAGES] = {0.244094488188976377952755905512, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0,
+                                          0.733846688281611857341361741547, 0.0, 0.0,
+                                          0.220588235294117647058823529412e-01, 0.0};
+
+    static constexpr double D[DENSE_TERMS - 4][STAGES + DENSE_STAGES] = {
+        {-0.84289382761090128651353491142e+01, 0.0, 0.0, 0.0, 0.0, 0.56671495351937776962531783590e+00,
+         -0.30689499459498916912797304727e+01, 0.23846676565120698287728149680e+01,
+         0.21170345824450282767155149946e+01, -0.87139158377797299206789907490e+00,
+         0.22404374302607882758541771650e+01, 0.63157877876946881815570249290e+00,
+         -0.88990336451333310820698117400e-01, 0.18148505520854727256656404962e+02,
+         -0.91946323924783554000451984436e+01, -0.44360363875948939664310572000e+01},
+        {0.10427508642579134603413151009e+02, 0.0, 0.0, 0.0, 0.0, 0.24228349177525818288430175319e+03,
+         0.16520045171727028198505394887e+03, -0.37454675472269020279518312152e+03,
+         -0.22113666853125306036270938578e+02, 0.77334326684722638389603898808e+01,
+         -0.30674084731089398182061213626e+02, -0.93321305264302278729567221706e+01,
+         0.15697238121770843886131091075e+02, -0.31139403219565177677282850411e+02,
+         -0.93529243588444783865713862664e+01, 0.35816841486394083752465898540e+02},
+        {0.19985053242002433820987653617e+02, 0.0, 0.0, 0.0, 0.0, -0.38703730874935176555105901742e+03,
+         -0.18917813819516756882830838328e+03, 0.52780815920542364900561016686e+03,
+         -0.11573902539959630126141871134e+02, 0.68812326946963000169666922661e+01,
+         -0.10006050966910838403183860980e+01, 0.77771377980534432092869265740e+00,
+         -0.27782057523535084065932004339e+01, -0.60196695231264120758267380846e+02,
+         0.84320405506677161018159903784e+02, 0.11992291136182789328035130030e+02},
+        {-0.25693933462703749003312586129e+02, 0.0, 0.0, 0.0, 0.0, -0.15418974869023643374053993627e+03,
+         -0.23152937917604549567536039109e+03, 0.35763911791061412378285349910e+03,
+         0.93405324183624310003907691704e+02, -0.37458323136451633156875139351e+02,
+         0.10409964950896230045147246184e+03, 0.29840293426660503123344363579e+02,
+         -0.43533456590011143754432175058e+02, 0.96324553959188282948394950600e+02,
+         -0.39177261675615439165231486172e+02, -0.14972683625798562581422125276e+03},
+    };
+
+    static void errorNorm(double h, const double k[][6][FORCE_LANES], const double scale[6][FORCE_LANES],
+                          double error[FORCE_LANES])
+    {
+        double fifth[FORCE_LANES] = {}, third[FORCE_LANES] = {};
+        for (int c = 0; c < 6; ++c)
+            for (int i = 0; i < FORCE_LANES; ++i)
+            {
+                double e5 = 0.0, e3 = 0.0;
+                for (int j = 0; j < STAGES; ++j)
+                {
+                    e5 += E5[j] * k[j][c][i];
+                    e3 += (A[STAGES - 1][j] - B3[j]) * k[j][c][i];
+                }
+                e5 /= scale[c][i];
+                e3 /= scale[c][i];
+                fifth[i] += e5 * e5;
+                third[i] += e3 * e3;
+            }
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            double denominator = fifth[i] + 0.01 * third[i];
+            error[i] = std::fabs(h) * fifth[i] / std::sqrt(6.0 * (denominator > 0.0 ? denominator : 1.0));
+        }
+    }
+};
+
+// State of stage s: y + h * sum of A[s][j] k[j]
+template <typename Method>
+void rungeKuttaStage(int s, double h, const double y[6][FORCE_LANES], const double k[][6][FORCE_LANES],
+                     double out[6][FORCE_LANES])
+{
+    double sum[6][FORCE_LANES] = {};
+    for (int j = 0; j < s; ++j)
+    {
+        double a = Method::A[s][j];
+        if (a == 0.0)
+            continue;
+        for (int c = 0; c < 6; ++c)
+            for (int i = 0; i < FORCE_LANES; ++i)
+                sum[c][i] += a * k[j][c][i];
+    }
+    for (int c = 0; c < 6; ++c)
+        for (int i = 0; i < FORCE_LANES; ++i)
+            out[c][i] = y[c][i] + h * sum[c][i];
+}
+
+// Time derivative of a batch of states: velocity and acceleration
+template <typename Model>
+void rungeKuttaDerivative(const Model &model, const ForceStep &step, const ForceLanes &lanes,
+                          const double state[6][FORCE_LANES], double derivative[6][FORCE_LANES])
+{
+    for (int c = 0; c < 3; ++c)
+        for (int i = 0; i < FORCE_LANES; ++i)
+            derivative[c][i] = state[c + 3][i];
+    model.accelerationBatch(step, lanes, state, state + 3, derivative + 3);
+}
+
+// One step of h from y for a lane batch, k[0] holding the derivative at
+// y. Leaves the new state in y1, every stage's derivative in k (the last
+// is the derivative at y1) and the scaled error per lane.
+template <typename Method, typename Model>
+void rungeKuttaStepBatch(const Model &model, const ForceStep *stageSteps, const ForceLanes &lanes,
+                         const IntegratorSettings &settings, double h, const double y[6][FORCE_LANES],
+                         double k[][6][FORCE_LANES], double y1[6][FORCE_LANES], double error[FORCE_LANES])
+{
+    for (int s = 1; s < Method::STAGES; ++s)
+    {
+        rungeKuttaStage<Method>(s, h, y, k, y1);
+        rungeKuttaDerivative(model, stageSteps[s], lanes, y1, k[s]);
+    }
+
+    double scale[6][FORCE_LANES];
+    for (int c = 0; c < 6; ++c)
+    {
+        double tolerance = c < 3 ? settings.positionTolerance : settings.velocityTolerance;
+        for (int i = 0; i < FORCE_LANES; ++i)
+            scale[c][i] = tolerance + settings.relativeTolerance * std::max(std::fabs(y[c][i]), std::fabs(y1[c][i]));
+    }
+    Method::errorNorm(h, k, scale, error);
+}
+
+// Dense output coefficients of an accepted step; the extra stages must be in k
+template <typename Method>
+void rungeKuttaDense(double h, const double y[6][FORCE_LANES], const double y1[6][FORCE_LANES],
+                     const double k[][6][FORCE_LANES], double dense[][6][FORCE_LANES])
+{
+    const int last = Method::STAGES - 1;
+    for (int c = 0; c < 6; ++c)
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            double change = y1[c][i] - y[c][i];
+            double start = h * k[0][c][i] - change;
+            dense[0][c][i] = y[c][i];
+            dense[1][c][i] = change;
+            dense[2][c][i] = start;
+            dense[3][c][i] = change - h * k[last][c][i] - start;
+        }
+    for (int m = 4; m < Method::DENSE_TERMS; ++m)
+        for (int c = 0; c < 6; ++c)
+            for (int i = 0; i < FORCE_LANES; ++i)
+            {
+                double sum = 0.0;
+                for (int j = 0; j < Method::STAGES + Method::DENSE_STAGES; ++j)
+                    sum += Method::D[m - 4][j] * k[j][c][i];
+                dense[m][c][i] = h * sum;
+            }
+}
+
+// State of one lane at theta in [0, 1] of the step
+template <typename Method>
+void rungeKuttaDenseState(const double dense[][6][FORCE_LANES], int lane, double theta, double state[6])
+{
+    for (int c = 0; c < 6; ++c)
+    {
+        double value = dense[Method::DENSE_TERMS - 1][c][lane];
+        for (int m = Method::DENSE_TERMS - 2; m >= 0; --m)
+            value = dense[m][c][lane] + (m % 2 == 0 ? theta : 1.0 - theta) * value;
+        state[c] = value;
+    }
+}
+
+template <typename Method, typename Model>
+int integrateBodiesWith(const Model &model, const IntegratorSettings &settings, IntegratorBodies &bodies,
+                        double jdStart, double seconds, IntegratorSamples *samples, int first, int end,
+                        IntegratorScratch &scratch)
+{
+    typedef long long Tick;
+    const Tick total = Tick(1) << INTEGRATOR_MAX_LEVEL;
+    const int stages = Method::STAGES + Method::DENSE_STAGES;
+    int count = end - first;
+    if (count <= 0 || seconds <= 0.0)
+        return 0;
+
+    // Finest level whose step is no longer than h, and the coarsest allowed
+    auto levelFor = [seconds](double h) {
+        return h >= seconds ? 0 : std::min(static_cast<int>(std::ceil(std::log2(seconds / h))), INTEGRATOR_MAX_LEVEL + 1);
+    };
+    int minLevel = settings.maxStep > 0.0 ? levelFor(settings.maxStep) : 0;
+
+    std::vector<Tick> &ticks = scratch.ticks;
+    std::vector<int> &levels = scratch.levels;
+    std::vector<double> &accelerations = scratch.accelerations;
+    std::vector<int> &active = scratch.active;
+    ticks.assign(count, 0);
+    levels.resize(count);
+    accelerations.resize(3 * count);
+    active.clear();
+    for (int b = 0; b < count; ++b)
+        if (!bodies.failed[first + b])
+            active.push_back(b);
+
+    // Gather a batch of bodies into lanes, the last body filling any spare lanes
+    auto gather = [&](const int *members, int size, double y[6][FORCE_LANES], ForceLanes &lanes) {
+        for (int i = 0; i < FORCE_LANES; ++i)
+        {
+            int b = first + members[std::min(i, size - 1)];
+            y[0][i] = bodies.x[b];
+            y[1][i] = bodies.y[b];
+            y[2][i] = bodies.z[b];
+            y[3][i] = bodies.vx[b];
+            y[4][i] = bodies.vy[b];
+            y[5][i] = bodies.vz[b];
+            lanes.ballistic[i] = bodies.ballistic[b];
+            lanes.reflectivity[i] = bodies.reflectivity[b];
+        }
+    };
+    auto store = [&](int b, const double *state) {
+        double *columns[6] = {&bodies.x[first + b], &bodies.y[first + b], &bodies.z[first + b],
+                              &bodies.vx[first + b], &bodies.vy[first + b], &bodies.vz[first + b]};
+        for (int c = 0; c < 6; ++c)
+            *columns[c] = state[c];
+    };
+
+    // Accelerations at the start, first steps and samples at time 0
+    ForceStep stageSteps[stages];
+    model.prepare(stageSteps[0], jdStart);
+    for (size_t start = 0; start < active.size(); start += FORCE_LANES)
+    {
+        int size = static_cast<int>(std::min<size_t>(FORCE_LANES, active.size() - start));
+        double y[6][FORCE_LANES], f[6][FORCE_LANES];
+        ForceLanes lanes;
+        gather(&active[start], size, y, lanes);
+        rungeKuttaDerivative(model, stageSteps[0], lanes, y, f);
+        for (int i = 0; i < size; ++i)
+        {
+            int b = active[start + i];
+            double h = bodies.step[first + b];
+            if (h <= 0.0)
+            {
+                // Hairer's first guess: 1% of the state over its rate of change, in tolerance units
+                double state = 0.0, rate = 0.0;
+                for (int c = 0; c < 6; ++c)
+                {
+                    double scale = (c < 3 ? settings.positionTolerance : settings.velocityTolerance) +
+                                   settings.relativeTolerance * std::fabs(y[c][i]);
+                    state += y[c][i] * y[c][i] / (scale * scale);
+                    rate += f[c][i] * f[c][i] / (scale * scale);
+                }
+                h = state < 1e-10 || rate < 1e-10 ? 1e-6 : 0.01 * std::sqrt(state / rate);
+                bodies.step[first + b] = h;
+            }
+            levels[b] = std::max(levelFor(h), minLevel);
+            for (int c = 0; c < 3; ++c)
+                accelerations[3 * b + c] = f[c + 3][i];
+            if (samples)
+                for (size_t t = 0; t < samples->times.size() && samples->times[t] <= 0.0; ++t)
+                {
+                    double state[6] = {y[0][i], y[1][i], y[2][i], y[3][i], y[4][i], y[5][i]};
+                    std::copy(state, state + 6, integratorSample(*samples, first + b, static_cast<int>(t)));
+                }
+        }
+    }
+
+    std::vector<std::vector<int>> &groups = scratch.groups;
+    groups.resize(INTEGRATOR_MAX_LEVEL + 1);
+    int failures = 0;
+    while (!active.empty())
+    {
+        // Bodies furthest behind, by level
+        Tick now = total;
+        for (int b : active)
+            now = std::min(now, ticks[b]);
+        for (int b : active)
+            if (ticks[b] == now)
+                groups[levels[b]].push_back(b);
+
+        for (int level = 0; level <= INTEGRATOR_MAX_LEVEL; ++level)
+        {
+            std::vector<int> &members = groups[level];
+            if (members.empty())
+                continue;
+            Tick stepTicks = Tick(1) << (INTEGRATOR_MAX_LEVEL - level);
+            double h = std::ldexp(seconds, -level);
+            double t = std::ldexp(static_cast<double>(now), -INTEGRATOR_MAX_LEVEL) * seconds;
+            for (int s = 1; s < Method::STAGES; ++s)
+                model.prepare(stageSteps[s], jdStart + (t + Method::C[s] * h) / 86400.0);
+
+            // Sample times inside this step, shared by the whole group
+            size_t sampleFirst = 0, sampleEnd = 0;
+            if (samples)
+            {
+                const std::vector<double> &times = samples->times;
+                sampleFirst = std::upper_bound(times.begin(), times.end(), t) - times.begin();
+                sampleEnd = (now + stepTicks == total ? times.end()
+                                                      : std::upper_bound(times.begin(), times.end(), t + h)) -
+                            times.begin();
+                for (int s = Method::STAGES; s < stages && sampleFirst < sampleEnd; ++s)
+                    model.prepare(stageSteps[s], jdStart + (t + Method::C[s] * h) / 86400.0);
+            }
+
+            for (size_t start = 0; start < members.size(); start += FORCE_LANES)
+            {
+                int size = static_cast<int>(std::min<size_t>(FORCE_LANES, members.size() - start));
+                double y[6][FORCE_LANES], y1[6][FORCE_LANES], k[stages][6][FORCE_LANES], error[FORCE_LANES];
+                ForceLanes lanes;
+                gather(&members[start], size, y, lanes);
+                for (int i = 0; i < FORCE_LANES; ++i)
+                {
+                    int b = members[start + std::min(i, size - 1)];
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        k[0][c][i] = y[c + 3][i];
+                        k[0][c + 3][i] = accelerations[3 * b + c];
+                    }
+                }
+                rungeKuttaStepBatch<Method>(model, stageSteps, lanes, settings, h, y, k, y1, error);
+
+                bool dense = false;
+                for (int i = 0; i < size; ++i)
+                    dense = dense || (sampleFirst < sampleEnd && error[i] <= 1.0);
+                double coefficients[Method::DENSE_TERMS][6][FORCE_LANES];
+                if (dense)
+                {
+                    double extra[6][FORCE_LANES];
+                    for (int s = Method::STAGES; s < stages; ++s)
+                    {
+                        rungeKuttaStage<Method>(s, h, y, k, extra);
+                        rungeKuttaDerivative(model, stageSteps[s], lanes, extra, k[s]);
+                    }
+                    rungeKuttaDense<Method>(h, y, y1, k, coefficients);
+                }
+
+                for (int i = 0; i < size; ++i)
+                {
+                    int b = members[start + i];
+                    bool accept = error[i] <= 1.0;
+                    double growth = error[i] > 0.0 ? settings.safety * std::pow(error[i], -Method::ERROR_EXPONENT)
+                                                   : Method::MAX_GROWTH;
+                    growth = std::min(accept ? Method::MAX_GROWTH : 1.0, std::max(settings.minShrink, growth));
+                    double next = h * growth;
+                    bodies.step[first + b] = next;
+                    if (!accept)
+                    {
+                        ++bodies.rejected[first + b];
+                        levels[b] = std::max(levelFor(next), level + 1);
+                        if (levels[b] > INTEGRATOR_MAX_LEVEL)
+                        {
+                            bodies.failed[first + b] = 1;
+                            ++failures;
+                        }
+                        continue;
+                    }
+
+                    ++bodies.accepted[first + b];
+                    double state[6];
+                    for (size_t sample = sampleFirst; sample < sampleEnd; ++sample)
+                    {
+                        rungeKuttaDenseState<Method>(coefficients, i, (samples->times[sample] - t) / h, state);
+                        std::copy(state, state + 6, integratorSample(*samples, first + b, static_cast<int>(sample)));
+                    }
+                    for (int c = 0; c < 6; ++c)
+                        state[c] = y1[c][i];
+                    store(b, state);
+                    for (int c = 0; c < 3; ++c)
+                        accelerations[3 * b + c] = k[Method::STAGES - 1][c + 3][i];
+                    ticks[b] = now + stepTicks;
+
+                    // Finer at once; coarser only where the new time lines up with the coarser step
+                    int nextLevel = std::max(std::max(levelFor(next), minLevel), level - 1);
+                    if (nextLevel < level && ticks[b] % (stepTicks * 2) != 0)
+                        nextLevel = level;
+                    levels[b] = std::min(nextLevel, INTEGRATOR_MAX_LEVEL);
+                }
+            }
+            members.clear();
+        }
+
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [&](int b) { return ticks[b] == total || bodies.failed[first + b]; }),
+                     active.end());
+    }
+    return failures;
+}
+
+// Integrate bodies [first, end) for seconds from a UT1 Julian date, in
+// place. Samples (may be null) get each body's state at every sample
+// time; their states must hold bodies x times x 6 values. Returns how many
+// bodies failed (the step fell below the finest level); they are marked
+// and left at their last good state. The scratch is the caller's, one per thread.
+template <typename Model>
+int integrateBodies(const Model &model, const IntegratorSettings &settings, IntegratorBodies &bodies, double jdStart,
+                    double seconds, IntegratorSamples *samples, int first, int end, IntegratorScratch &scratch)
+{
+    if (settings.method == INTEGRATOR_DOPRI5)
+        return integrateBodiesWith<DormandPrince5>(model, settings, bodies, jdStart, seconds, samples, first, end,
+                                                   scratch);
+    return integrateBodiesWith<DormandPrince853>(model, settings, bodies, jdStart, seconds, samples, first, end,
+                                                 scratch);
+}
@@ -0,0 +1,336 @@
+#include "job_graph.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct ReadyJob
+    {
+        JobGraph *graph;
+        int job;
+        bool callerOnly;
+    };
+
+    const size_t MAX_READY_JOBS = 256;
+
+    // Jobs are coarse (a handful per frame), so one mutex-guarded ready list is enough
+    std::mutex gQueueMutex;
+    std::condition_variable gQueueCondition;
+    std::vector<ReadyJob> gReady;
+    std::vector<std::thread> gWorkers;
+    bool gStopping = false;
+
+    // Take the first job this thread may run; caller must hold gQueueMutex
+    bool takeJob(JobGraph *graph, ReadyJob &out)
+    {
+        for (size_t i = 0; i < gReady.size(); ++i)
+        {
+            const ReadyJob &ready = gReady[i];
+            bool allowed = graph ? ready.graph == graph : !ready.callerOnly;
+            if (allowed)
+            {
+                out = ready;
+                gReady.erase(gReady.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerMain(int index)
+    {
+#ifdef ENABLE_PROFILER
+        std::string threadName = "job worker " + std::to_string(index);
+        profilerSetThreadName(threadName.c_str());
+#else
+        (void)index;
+#endif
+        for (;;)
+        {
+            ReadyJob ready;
+            {
+                std::unique_lock<std::mutex> lock(gQueueMutex);
+                gQueueCondition.wait(lock, [&] { return gStopping || takeJob(nullptr, ready); });
+                if (gStopping)
+                    return;
+            }
+            ready.graph->execute(ready.job);
+        }
+    }
+
+    void pushReady(JobGraph *graph, int job, bool callerOnly)
+    {
+        {
+            std::lock_guard<std::mutex> lock(gQueueMutex);
+            if (gReady.size() >= MAX_READY_JOBS)
+            {
+                std::cerr << "ERROR::JOB_GRAPH::READY_QUEUE_FULL" << std::endl;
+                abort();
+            }
+            gReady.push_back({graph, job, callerOnly});
+        }
+        gQueueCondition.notify_all();
+    }
+}
+
+void jobWorkersStart(int count)
+{
+    if (!gWorkers.empty())
+        return;
+
+    // ORBITAL_JOB_WORKERS overrides the default of one worker per core left
+    // after the render and simulation threads
+    const char *override = getenv("ORBITAL_JOB_WORKERS");
+    if (count <= 0 && override)
+        count = atoi(override);
+    else if (count <= 0)
+        count = static_cast<int>(std::thread::hardware_concurrency()) - 2;
+    if (count <= 0)
+        return;
+
+    gReady.reserve(MAX_READY_JOBS);
+    gStopping = false;
+    gWorkers.reserve(count);
+    for (int i = 0; i < count; ++i)
+        gWorkers.emplace_back(workerMain, i + 1);
+}
+
+void jobWorkersStop()
+{
+    {
+        std::lock_guard<std::mutex> lock(gQueueMutex);
+        gStopping = true;
+    }
+    gQueueCondition.notify_all();
+    for (std::thread &worker : gWorkers)
+        worker.join();
+    gWorkers.clear();
+}
+
+int jobWorkerCount()
+{
+    return static_cast<int>(gWorkers.size());
+}
+
+JobGraph::JobGraph(const char *graphName)
+    : name(graphName), trackName(std::string("critical path: ") + graphName), profileTrack(-1), jobCount(0),
+      validated(false), valid(false), remaining(0), criticalLength(0), wallNs(0), criticalNs(0), workersUsed(0), runs(0),
+      totalWallNs(0), totalCriticalNs(0)
+{
+#ifdef ENABLE_PROFILER
+    profileTrack = profilerCreateTrack(trackName.c_str());
+#endif
+}
+
+int JobGraph::addJob(const char *jobName, JobFunction function, void *context, bool callerOnly)
+{
+    if (jobCount >= MAX_JOBS)
+    {
+        std::cerr << "ERROR::JOB_GRAPH::TOO_MANY_JOBS " << name << std::endl;
+        return -1;
+    }
+
+    Job &job = jobs[jobCount];
+    job.name = jobName;
+    job.function = function;
+    job.context = context;
+    job.callerOnly = callerOnly;
+    job.successorCount = 0;
+    job.predecessorCount = 0;
+    job.pending.store(0);
+    job.startNs = job.endNs = 0;
+    job.gatingPredecessor = -1;
+    job.totalNs = 0;
+    job.criticalRuns = 0;
+    validated = false;
+    return jobCount++;
+}
+
+bool JobGraph::addDependency(int before, int after)
+{
+    if (before < 0 || before >= jobCount || after < 0 || after >= jobCount || before == after)
+        return false;
+
+    Job &job = jobs[before];
+    if (job.successorCount >= MAX_SUCCESSORS)
+    {
+        std::cerr << "ERROR::JOB_GRAPH::TOO_MANY_SUCCESSORS " << job.name << std::endl;
+        return false;
+    }
+    job.successors[job.successorCount++] = after;
+    ++jobs[after].predecessorCount;
+    validated = false;
+    return true;
+}
+
+// Kahn's algorithm: builds a topological order and rejects cycles
+bool JobGraph::validate()
+{
+    int indegree[MAX_JOBS];
+    int count = 0;
+    for (int i = 0; i < jobCount; ++i)
+    {
+        indegree[i] = jobs[i].predecessorCount;
+        if (indegree[i] == 0)
+            order[count++] = i;
+    }
+    for (int next = 0; next < count; ++next)
+    {
+        const Job &job = jobs[order[next]];
+        for (int s = 0; s < job.successorCount; ++s)
+        {
+            if (--indegree[job.successors[s]] == 0)
+                order[count++] = job.successors[s];
+        }
+    }
+
+    validated = true;
+    if (count != jobCount)
+    {
+        std::cerr << "ERROR::JOB_GRAPH::CYCLE " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void JobGraph::execute(int index)
+{
+    Job &job = jobs[index];
+    job.startNs = profilerNowNs();
+    {
+        PROFILE_STAGE(job.name);
+        job.function(job.context);
+    }
+    job.endNs = profilerNowNs();
+
+    // The job that releases a successor is, by construction, its last predecessor to finish
+    for (int s = 0; s < job.successorCount; ++s)
+    {
+        Job &successor = jobs[job.successors[s]];
+        if (successor.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            successor.gatingPredecessor = index;
+            if (!gWorkers.empty())
+                pushReady(this, job.successors[s], successor.callerOnly);
+        }
+    }
+
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // Take the lock so the waiting caller cannot miss the wake-up
+        std::lock_guard<std::mutex> lock(gQueueMutex);
+        gQueueCondition.notify_all();
+    }
+}
+
+bool JobGraph::run()
+{
+    if (!validated)
+        valid = validate();
+    if (!valid)
+        return false;
+
+    for (int i = 0; i < jobCount; ++i)
+    {
+        jobs[i].pending.store(jobs[i].predecessorCount, std::memory_order_relaxed);
+        jobs[i].gatingPredecessor = -1;
+    }
+    remaining.store(jobCount, std::memory_order_release);
+    workersUsed = jobWorkerCount();
+    uint64_t runStartNs = profilerNowNs();
+
+    if (gWorkers.empty())
+    {
+        // No workers: run everything here in topological order
+        for (int i = 0; i < jobCount; ++i)
+            execute(order[i]);
+    }
+    else
+    {
+        for (int i = 0; i < jobCount; ++i)
+        {
+            if (jobs[i].predecessorCount == 0)
+                pushReady(this, i, jobs[i].callerOnly);
+        }
+
+        // Run this graph's jobs here while waiting, including the caller-only ones
+        for (;;)
+        {
+            ReadyJob ready;
+            {
+                std::unique_lock<std::mutex> lock(gQueueMutex);
+                gQueueCondition.wait(lock, [&] {
+                    return remaining.load(std::memory_order_acquire) == 0 || takeJob(this, ready);
+                });
+                if (remaining.load(std::memory_order_acquire) == 0)
+                    break;
+            }
+            execute(ready.job);
+        }
+    }
+
+    computeCriticalPath(runStartNs);
+    return true;
+}
+
+void JobGraph::computeCriticalPath(uint64_t runStartNs)
+{
+    if (jobCount == 0)
+        return;
+
+    // Walk back from the last job to finish along the predecessors that released each job
+    int last = 0;
+    for (int i = 1; i < jobCount; ++i)
+    {
+        if (jobs[i].endNs > jobs[last].endNs)
+            last = i;
+    }
+
+    criticalLength = 0;
+    criticalNs = 0;
+    for (int i = last; i >= 0; i = jobs[i].gatingPredecessor)
+    {
+        criticalPath[criticalLength++] = i;
+        criticalNs += jobs[i].endNs - jobs[i].startNs;
+        ++jobs[i].criticalRuns;
+#ifdef ENABLE_PROFILER
+        if (profilerIsCapturing())
+            profilerRecordOnTrack(profileTrack, jobs[i].name, jobs[i].startNs, jobs[i].endNs);
+#endif
+    }
+
+    wallNs = jobs[last].endNs - runStartNs;
+    for (int i = 0; i < jobCount; ++i)
+        jobs[i].totalNs += jobs[i].endNs - jobs[i].startNs;
+    totalWallNs += wallNs;
+    totalCriticalNs += criticalNs;
+    ++runs;
+}
+
+void JobGraph::printSummary() const
+{
+    if (runs == 0)
+        return;
+
+    fprintf(stderr, "\nJob graph \"%s\": %llu runs on %d workers, mean wall %.3f ms, mean critical path %.3f ms\n",
+            name, static_cast<unsigned long long>(runs), workersUsed, totalWallNs / 1e6 / runs,
+            totalCriticalNs / 1e6 / runs);
+    fprintf(stderr, "%-18s %10s %12s\n", "job", "mean ms", "critical %");
+    for (int i = 0; i < jobCount; ++i)
+    {
+        fprintf(stderr, "%-18s %10.3f %11.1f%%\n", jobs[i].name, jobs[i].totalNs / 1e6 / runs,
+                100.0 * jobs[i].criticalRuns / runs);
+    }
+
+    // The last run's path, in execution order
+    fprintf(stderr, "Last critical path:");
+    for (int i = criticalLength - 1; i >= 0; --i)
+        fprintf(stderr, " %s%s", jobs[criticalPath[i]].name, i ? " ->" : "\n");
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Per-frame job graph. A graph is built once (jobs plus "runs before"
+// edges) and then run every frame: jobs whose dependencies are done are
+// handed to the shared worker pool, so independent stages run concurrently.
+// Jobs marked callerOnly (GL submission) always run on the thread that calls
+// run(), which also picks up other ready jobs while it waits.
+//
+// After each run the critical path (the chain of jobs that gated the last
+// one to finish) is computed. Profiling builds record every job as a zone on
+// the thread that ran it, and each graph's critical path on its own
+// "critical path: <graph>" trace track.
+
+typedef void (*JobFunction)(void *context);
+
+class JobGraph
+{
+public:
+    static const int MAX_JOBS = 32;
+    static const int MAX_SUCCESSORS = 8;
+
+    explicit JobGraph(const char *graphName);
+
+    JobGraph(const JobGraph &) = delete;
+    JobGraph &operator=(const JobGraph &) = delete;
+
+    // Returns the job index, or -1 when the graph is full
+    int addJob(const char *name, JobFunction function, void *context, bool callerOnly = false);
+
+    // Callable object (e.g. a lambda) that must outlive the graph
+    template <typename F>
+    int addJob(const char *name, F &functor, bool callerOnly = false)
+    {
+        return addJob(name, [](void *context) { (*static_cast<F *>(context))(); }, &functor, callerOnly);
+    }
+
+    // before must finish before after starts
+    bool addDependency(int before, int after);
+
+    // Run every job once; false (and nothing runs) if the graph has a cycle
+    bool run();
+
+    // Wall time and critical-path length of the last run, in nanoseconds
+    uint64_t lastWallNs() const { return wallNs; }
+    uint64_t lastCriticalPathNs() const { return criticalNs; }
+
+    // Duration of one job (an index returned by addJob) in the last run
+    uint64_t lastJobNs(int job) const { return jobs[job].endNs - jobs[job].startNs; }
+
+    // Mean job times and how often each job was on the critical path
+    void printSummary() const;
+
+    // Called by the worker pool
+    void execute(int job);
+
+private:
+    struct Job
+    {
+        const char *name;
+        JobFunction function;
+        void *context;
+        bool callerOnly;
+        int successors[MAX_SUCCESSORS];
+        int successorCount;
+        int predecessorCount;
+        std::atomic<int> pending;
+        uint64_t startNs;
+        uint64_t endNs;
+        int gatingPredecessor; // predecessor that finished last, -1 for roots
+        // Totals over every run
+        uint64_t totalNs;
+        uint64_t criticalRuns;
+    };
+
+    bool validate();
+    void computeCriticalPath(uint64_t runStartNs);
+
+    const char *name;
+    std::string trackName;
+    int profileTrack;
+    Job jobs[MAX_JOBS];
+    int jobCount;
+    int order[MAX_JOBS]; // a topological order, built by validate()
+    bool validated;
+    bool valid;
+
+    std::atomic<int> remaining;
+
+    int criticalPath[MAX_JOBS];
+    int criticalLength;
+    uint64_t wallNs;
+    uint64_t criticalNs;
+    int workersUsed; // pool size during the last run
+    uint64_t runs;
+    uint64_t totalWallNs;
+    uint64_t totalCriticalNs;
+};
+
+// Shared worker threads for every graph; count <= 0 uses ORBITAL_JOB_WORKERS
+// if set, else one per core left over by the render and simulation threads.
+// Without workers, run() executes every job on the calling thread.
+void jobWorkersStart(int count);
+void jobWorkersStop();
+int jobWorkerCount();
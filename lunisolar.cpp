@@ -0,0 +1,197 @@
+#include "lunisolar.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const double MU_SUN = 1.32712440018e11; // km^3 / s^2
+    const double MU_MOON = 4902.800066;
+    const double EARTH_RADIUS = 6378.137;   // km, WGS-84 equatorial, for the shadow cone
+    const double SUN_RADIUS = 696000.0;     // km
+    const double ASTRONOMICAL_UNIT = 149597870.7;
+    const double SOLAR_PRESSURE = 4.56e-6;  // N / m^2 at 1 AU
+    const double DEGREES = M_PI / 180.0;
+    const double ARCSECONDS = DEGREES / 3600.0;
+    const double OBLIQUITY = 23.43929111 * DEGREES;
+
+    // Ecliptic longitude, latitude and distance to equatorial coordinates
+    void fromEcliptic(double longitude, double latitude, double distance, double out[3])
+    {
+        double x = distance * std::cos(latitude) * std::cos(longitude);
+        double y = distance * std::cos(latitude) * std::sin(longitude);
+        double z = distance * std::sin(latitude);
+        out[0] = x;
+        out[1] = y * std::cos(OBLIQUITY) - z * std::sin(OBLIQUITY);
+        out[2] = y * std::sin(OBLIQUITY) + z * std::cos(OBLIQUITY);
+    }
+
+    template <int L>
+    void thirdBody(const LunisolarStep &step, const double *x, const double *y, const double *z, double *ax,
+                   double *ay, double *az)
+    {
+        for (int i = 0; i < L; ++i)
+        {
+            // Towards each body, mu d / |d|^3 less the Earth's own pull
+            double sx = step.sun[0] - x[i], sy = step.sun[1] - y[i], sz = step.sun[2] - z[i];
+            double mx = step.moon[0] - x[i], my = step.moon[1] - y[i], mz = step.moon[2] - z[i];
+            double s2 = sx * sx + sy * sy + sz * sz;
+            double m2 = mx * mx + my * my + mz * mz;
+            double sunScale = MU_SUN / (s2 * std::sqrt(s2));
+            double moonScale = MU_MOON / (m2 * std::sqrt(m2));
+            ax[i] = sunScale * sx + moonScale * mx - step.sunIndirect[0] - step.moonIndirect[0];
+            ay[i] = sunScale * sy + moonScale * my - step.sunIndirect[1] - step.moonIndirect[1];
+            az[i] = sunScale * sz + moonScale * mz - step.sunIndirect[2] - step.moonIndirect[2];
+        }
+    }
+
+    // Sunlit fraction per lane
+    template <int L>
+    void shadowLanes(const LunisolarStep &step, const double *x, const double *y, const double *z, ShadowModel shadow,
+                     double *fraction)
+    {
+        if (shadow == SHADOW_NONE)
+        {
+            for (int i = 0; i < L; ++i)
+                fraction[i] = 1.0;
+            return;
+        }
+        if (shadow == SHADOW_CYLINDRICAL)
+        {
+            const double *s = step.sunDirection;
+            for (int i = 0; i < L; ++i)
+            {
+                double along = x[i] * s[0] + y[i] * s[1] + z[i] * s[2];
+                double across2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i] - along * along;
+                fraction[i] = along < 0.0 && across2 < EARTH_RADIUS * EARTH_RADIUS ? 0.0 : 1.0;
+            }
+            return;
+        }
+
+        // Apparent radii of the Sun (a) and Earth (b) and their separation
+        // (c); the overlap of two disks gives the hidden part (Montenbruck
+        // and Gill 3.4.2). Every case is computed and the right one picked.
+        for (int i = 0; i < L; ++i)
+        {
+            double dx = step.sun[0] - x[i], dy = step.sun[1] - y[i], dz = step.sun[2] - z[i];
+            double sunDistance = std::sqrt(dx * dx + dy * dy + dz * dz);
+            double r = std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+            double a = std::asin(SUN_RADIUS / sunDistance);
+            double b = std::asin(std::min(EARTH_RADIUS / r, 1.0));
+            double cosine = -(x[i] * dx + y[i] * dy + z[i] * dz) / (r * sunDistance);
+            double c = std::max(std::acos(std::min(std::max(cosine, -1.0), 1.0)), 1e-12);
+
+            double u = (c * c + a * a - b * b) / (2.0 * c);
+            double v = std::sqrt(std::max(a * a - u * u, 0.0));
+            double hidden = a * a * std::acos(std::min(std::max(u / a, -1.0), 1.0)) +
+                            b * b * std::acos(std::min(std::max((c - u) / b, -1.0), 1.0)) - c * v;
+            double partial = 1.0 - hidden / (M_PI * a * a);
+            double annular = 1.0 - b * b / (a * a);
+            fraction[i] = c >= a + b ? 1.0 : c <= b - a ? 0.0 : c <= a - b ? annular : partial;
+        }
+    }
+
+    template <int L>
+    void solarPressure(const LunisolarStep &step, const double *x, const double *y, const double *z,
+                       const double *reflectivity, ShadowModel shadow, double *ax, double *ay, double *az)
+    {
+        double fraction[L];
+        shadowLanes<L>(step, x, y, z, shadow, fraction);
+        for (int i = 0; i < L; ++i)
+        {
+            // Away from the Sun, falling off with the square of its distance
+            double dx = x[i] - step.sun[0], dy = y[i] - step.sun[1], dz = z[i] - step.sun[2];
+            double d2 = dx * dx + dy * dy + dz * dz;
+            double pressure = SOLAR_PRESSURE * ASTRONOMICAL_UNIT * ASTRONOMICAL_UNIT / d2;
+            double k = 1e-3 * fraction[i] * pressure * reflectivity[i] / std::sqrt(d2);
+            ax[i] = k * dx;
+            ay[i] = k * dy;
+            az[i] = k * dz;
+        }
+    }
+}
+
+void sunMoonPositions(double jd, double sun[3], double moon[3])
+{
+    // Julian centuries from J2000; longitudes are of the equinox of date
+    double t = (jd - 2451545.0) / 36525.0;
+
+    double m = (357.5256 + 35999.049 * t) * DEGREES;
+    double sunLongitude = (282.94 + 1.3972 * t) * DEGREES + m + (6892.0 * std::sin(m) + 72.0 * std::sin(2.0 * m)) * ARCSECONDS;
+    double sunDistance = (149.619 - 2.499 * std::cos(m) - 0.021 * std::cos(2.0 * m)) * 1e6;
+    fromEcliptic(sunLongitude, 0.0, sunDistance, sun);
+
+    // Mean longitude, anomalies of the Moon and Sun, argument of latitude and elongation
+    double l0 = (218.31617 + 481267.88088 * t) * DEGREES;
+    double l = (134.96292 + 477198.86753 * t) * DEGREES;
+    double lp = (357.52543 + 35999.04944 * t) * DEGREES;
+    double f = (93.27283 + 483202.01873 * t) * DEGREES;
+    double d = (297.85027 + 445267.11135 * t) * DEGREES;
+    double longitude =
+        l0 + (22640.0 * std::sin(l) + 769.0 * std::sin(2.0 * l) - 4586.0 * std::sin(l - 2.0 * d) +
+              2370.0 * std::sin(2.0 * d) - 668.0 * std::sin(lp) - 412.0 * std::sin(2.0 * f) -
+              212.0 * std::sin(2.0 * l - 2.0 * d) - 206.0 * std::sin(l + lp - 2.0 * d) + 192.0 * std::sin(l + 2.0 * d) -
+              165.0 * std::sin(lp - 2.0 * d) + 148.0 * std::sin(l - lp) - 125.0 * std::sin(d) -
+              110.0 * std::sin(l + lp) - 55.0 * std::sin(2.0 * f - 2.0 * d)) *
+                 ARCSECONDS;
+    double latitude =
+        (18520.0 * std::sin(f + longitude - l0 + (412.0 * std::sin(2.0 * f) + 541.0 * std::sin(lp)) * ARCSECONDS) -
+         526.0 * std::sin(f - 2.0 * d) + 44.0 * std::sin(l + f - 2.0 * d) - 31.0 * std::sin(-l + f - 2.0 * d) -
+         25.0 * std::sin(-2.0 * l + f) - 23.0 * std::sin(lp + f - 2.0 * d) + 21.0 * std::sin(-l + f) +
+         11.0 * std::sin(-lp + f - 2.0 * d)) *
+        ARCSECONDS;
+    double distance = 385000.0 - 20905.0 * std::cos(l) - 3699.0 * std::cos(2.0 * d - l) - 2956.0 * std::cos(2.0 * d) -
+                      570.0 * std::cos(2.0 * l) + 246.0 * std::cos(2.0 * l - 2.0 * d) - 205.0 * std::cos(lp - 2.0 * d) -
+                      171.0 * std::cos(l + 2.0 * d) - 152.0 * std::cos(l + lp - 2.0 * d);
+    fromEcliptic(longitude, latitude, distance, moon);
+}
+
+void lunisolarPrepare(LunisolarStep &step, double jd)
+{
+    if (step.jd == jd)
+        return;
+    step.jd = jd;
+    sunMoonPositions(jd, step.sun, step.moon);
+    double sunDistance = std::sqrt(step.sun[0] * step.sun[0] + step.sun[1] * step.sun[1] + step.sun[2] * step.sun[2]);
+    double moonDistance =
+        std::sqrt(step.moon[0] * step.moon[0] + step.moon[1] * step.moon[1] + step.moon[2] * step.moon[2]);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        step.sunDirection[axis] = step.sun[axis] / sunDistance;
+        step.sunIndirect[axis] = MU_SUN * step.sun[axis] / (sunDistance * sunDistance * sunDistance);
+        step.moonIndirect[axis] = MU_MOON * step.moon[axis] / (moonDistance * moonDistance * moonDistance);
+    }
+}
+
+void thirdBodyAcceleration(const LunisolarStep &step, const double position[3], double acceleration[3])
+{
+    thirdBody<1>(step, &position[0], &position[1], &position[2], &acceleration[0], &acceleration[1], &acceleration[2]);
+}
+
+void thirdBodyAccelerationBatch(const LunisolarStep &step, const double position[3][LUNISOLAR_LANES],
+                                double acceleration[3][LUNISOLAR_LANES])
+{
+    thirdBody<LUNISOLAR_LANES>(step, position[0], position[1], position[2], acceleration[0], acceleration[1],
+                               acceleration[2]);
+}
+
+double shadowFraction(const LunisolarStep &step, const double position[3], ShadowModel shadow)
+{
+    double fraction;
+    shadowLanes<1>(step, &position[0], &position[1], &position[2], shadow, &fraction);
+    return fraction;
+}
+
+void solarPressureAcceleration(const LunisolarStep &step, const double position[3], double reflectivity,
+                               ShadowModel shadow, double acceleration[3])
+{
+    solarPressure<1>(step, &position[0], &position[1], &position[2], &reflectivity, shadow, &acceleration[0],
+                     &acceleration[1], &acceleration[2]);
+}
+
+void solarPressureAccelerationBatch(const LunisolarStep &step, const double position[3][LUNISOLAR_LANES],
+                                    const double reflectivity[LUNISOLAR_LANES], ShadowModel shadow,
+                                    double acceleration[3][LUNISOLAR_LANES])
+{
+    solarPressure<LUNISOLAR_LANES>(step, position[0], position[1], position[2], reflectivity, shadow,
+                                   acceleration[0], acceleration[1], acceleration[2]);
+}
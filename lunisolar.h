@@ -0,0 +1,54 @@
+#pragma once
+
+// Third-body gravity of the Moon and Sun, and solar radiation pressure
+// with the Earth's shadow, on Earth-orbiting objects.
+//
+// Sun and Moon positions come from the low-precision analytic series of
+// Montenbruck and Gill (about 1 arcminute for the Sun, a few for the
+// Moon), in the mean equator and equinox of date, which is TEME to within
+// the accuracy of the series. They and every term that depends only on
+// them are computed once per step into a LunisolarStep; the per-object pass
+// then runs LUNISOLAR_LANES objects together from a structure-of-arrays
+// batch with no per-lane branches.
+
+const int LUNISOLAR_LANES = 8;
+
+enum ShadowModel
+{
+    SHADOW_NONE = 0,
+    SHADOW_CYLINDRICAL = 1, // umbra only, a cylinder of the Earth's radius
+    SHADOW_CONICAL = 2,     // umbra and penumbra from the apparent disks of the Sun and Earth
+};
+
+// Terms shared by every object at one time
+struct LunisolarStep
+{
+    double jd = 0.0;             // Julian date the terms are for
+    double sun[3], moon[3];      // geocentric positions, km
+    double sunDirection[3];      // unit
+    double sunIndirect[3];       // mu s / |s|^3 of each body, km/s^2: the Earth's own acceleration
+    double moonIndirect[3];
+};
+
+// Geocentric Sun and Moon positions (km) at a Julian date
+void sunMoonPositions(double jd, double sun[3], double moon[3]);
+
+// Fill the shared terms; a step already at jd is kept as it is
+void lunisolarPrepare(LunisolarStep &step, double jd);
+
+// Geocentric position in km to the Moon's and Sun's perturbing acceleration in km/s^2
+void thirdBodyAcceleration(const LunisolarStep &step, const double position[3], double acceleration[3]);
+
+void thirdBodyAccelerationBatch(const LunisolarStep &step, const double position[3][LUNISOLAR_LANES],
+                                double acceleration[3][LUNISOLAR_LANES]);
+
+// Fraction of the Sun's disk seen from a position: 1 in sunlight, 0 in umbra
+double shadowFraction(const LunisolarStep &step, const double position[3], ShadowModel shadow);
+
+// Cannonball radiation pressure in km/s^2. reflectivity is Cr * A / m in m^2 / kg.
+void solarPressureAcceleration(const LunisolarStep &step, const double position[3], double reflectivity,
+                               ShadowModel shadow, double acceleration[3]);
+
+void solarPressureAccelerationBatch(const LunisolarStep &step, const double position[3][LUNISOLAR_LANES],
+                                    const double reflectivity[LUNISOLAR_LANES], ShadowModel shadow,
+                                    double acceleration[3][LUNISOLAR_LANES]);
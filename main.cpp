@@ -5,31 +5,31 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <iostream>
 #include <random>
 #include <cstdlib>
 #include <ctime>
-
-// Structure for asteroid
-struct Asteroid
-{
-    glm::vec3 position;
-    glm::vec3 velocity;
-    float size;
-    float rotation;
-    GLuint VAO;
-    GLuint VBO;
-    GLuint EBO;
-    size_t indexCount;
-};
-
-// Global variables
-std::vector<Asteroid> asteroids;
-const float SPAWN_RADIUS = 8.0f;
-const float MIN_ASTEROID_SIZE = 0.4f;
-const float MAX_ASTEROID_SIZE = 0.6f;
+#include "alloc_tracker.h"
+#include "asteroid_pool.h"
+#include "dynamic_resolution.h"
+#include "frame_arena.h"
+#include "frame_bench.h"
+#include "frame_governor.h"
+#include "geometry.h"
+#include "headless.h"
+#include "job_graph.h"
+#include "orbit_paths.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "profiler_gpu.h"
+#include "satellite_catalog.h"
+#include "shader_cache.h"
+#include "sim_thread.h"
+#include "simulation.h"
+#include "trails.h"
 
 // Vertex Shader Source
 const char *vertexShaderSource = R"(
@@ -59,13 +59,20 @@ void main() {
 }
 )";
 
-// Simplified asteroid vertex shader
+// Instanced asteroid vertex shader; positions come from the pool's mesh slots
 const char *asteroidVertexShader = R"(
     #version 330 core
-    layout(location = 0) in vec3 position;
-    uniform mat4 mvp;
+    layout(location = 1) in mat4 model;
+    layout(location = 5) in int slot;
+    uniform mat4 viewProjection;
+    uniform int vertsPerSlot;
+    uniform samplerBuffer meshPositions;
     void main() {
-        gl_Position = mvp * vec4(position, 1.0);
+        int base = (slot * vertsPerSlot + gl_VertexID) * 3;
+        vec3 position = vec3(texelFetch(meshPositions, base).r,
+                             texelFetch(meshPositions, base + 1).r,
+                             texelFetch(meshPositions, base + 2).r);
+        gl_Position = viewProjection * model * vec4(position, 1.0);
     }
 )";
 
@@ -78,454 +85,98 @@ const char *asteroidFragmentShader = R"(
     }
 )";
 
-float satelliteOrbitRadius = 1.75f;
-float satelliteAngle = 0.0f;
-float satelliteX = satelliteOrbitRadius;
-float satelliteY = 0.0f;
-
-float satelliteOrbitRadius2 = 1.75f;
-float satelliteAngle2 = 0.0f;
-float satelliteX2 = satelliteOrbitRadius2;
-float satelliteY2 = 0.0f;
-float satelliteZ2 = 0.0f;
-GLuint satelliteVAO2, satelliteVBO2;
-
-// Function to generate sphere vertices and texture coordinates
-void generateSphere(float radius, int segments, int rings, std::vector<float> &vertices, std::vector<unsigned int> &indices)
-{
-    for (int y = 0; y <= rings; ++y)
-    {
-        for (int x = 0; x <= segments; ++x)
-        {
-            float xSegment = static_cast<float>(x) / segments;
-            float ySegment = static_cast<float>(y) / rings;
-            float xPos = radius * cos(xSegment * 2.0f * M_PI) * sin(ySegment * M_PI);
-            float yPos = radius * cos(ySegment * M_PI);
-            float zPos = radius * sin(xSegment * 2.0f * M_PI) * sin(ySegment * M_PI);
-
-            // Position
-            vertices.push_back(xPos);
-            vertices.push_back(yPos);
-            vertices.push_back(zPos);
-
-            // Texture coordinates (flip y coordinate)
-            vertices.push_back(xSegment);        // S
-            vertices.push_back(1.0f - ySegment); // T
-        }
-    }
-
-    for (int y = 0; y < rings; ++y)
-    {
-        for (int x = 0; x < segments; ++x)
-        {
-            int first = (y * (segments + 1)) + x;
-            int second = first + segments + 1;
-
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
-
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
-        }
-    }
-}
-
-bool checkCollision(const glm::vec3 &satellitePos, float satelliteRadius, const Asteroid &asteroid)
-{
-    // Calculate distance between centers
-    float distance = glm::length(satellitePos - asteroid.position);
-
-    // If distance is less than satellite radius + asteroid size, collision occurred
-    return distance < (satelliteRadius + asteroid.size);
-}
-
-// Function to generate random star positions
-void generateStars(int numStars, std::vector<glm::vec3> &stars)
-{
-    for (int i = 0; i < numStars; ++i)
-    {
-        // Random distance from the center (you can adjust the range)
-        float distance = 4.0f + static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0f; // Range from 8 to 10
-        // Random initial angle
-        float angle = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0f * M_PI; // Random angle in radians
-
-        // Push the generated star position into the vector
-        stars.push_back(glm::vec3(distance * cos(angle), distance * sin(angle), 0.0f)); // Using the proper constructor
+// Orbit tracks: positions only, one color per multi-draw
+const char *orbitVertexShader = R"(
+    #version 330 core
+    layout(location = 0) in vec3 position;
+    uniform mat4 viewProjection;
+    void main() {
+        gl_Position = viewProjection * vec4(position, 1.0);
     }
-}
-
-void generateAsteroid(float radius, int sectors, int stacks,
-                      std::vector<float> &vertices, std::vector<unsigned int> &indices)
-{
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dis(-0.15f, 0.15f);
+)";
 
-    // Generate vertices
-    for (int i = 0; i <= stacks; ++i)
-    {
-        float phi = M_PI * float(i) / float(stacks);
-        for (int j = 0; j <= sectors; ++j)
-        {
-            float theta = 2.0f * M_PI * float(j) / float(sectors);
-
-            // Base sphere coordinates
-            float x = cos(theta) * sin(phi);
-            float y = cos(phi);
-            float z = sin(theta) * sin(phi);
-
-            // Add random displacement
-            float noise = 1.0f + dis(gen);
-            x *= radius * noise;
-            y *= radius * noise;
-            z *= radius * noise;
-
-            // Position
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-
-            // Normal vector for lighting
-            glm::vec3 normal = glm::normalize(glm::vec3(x, y, z));
-            vertices.push_back(normal.x);
-            vertices.push_back(normal.y);
-            vertices.push_back(normal.z);
-        }
+const char *orbitFragmentShader = R"(
+    #version 330 core
+    out vec4 FragColor;
+    uniform vec3 color;
+    void main() {
+        FragColor = vec4(color, 1.0);
     }
+)";
 
-    // Generate indices
-    for (int i = 0; i < stacks; ++i)
-    {
-        for (int j = 0; j < sectors; ++j)
-        {
-            int first = i * (sectors + 1) + j;
-            int second = first + sectors + 1;
-
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
-
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
-        }
+// Motion trails: vertex pair k of instance b is the segment from sample age k
+// to age k + 1 of body b, read from the sample ring (see trails.h)
+const char *trailVertexShader = R"(
+    #version 330 core
+    uniform mat4 viewProjection;
+    uniform samplerBuffer trailSamples;
+    uniform int head;
+    uniform int bodies;
+    uniform int trailLength;
+    out float fade;
+    vec4 fetchSample(int age) {
+        return texelFetch(trailSamples, ((head - age + trailLength) % trailLength) * bodies + gl_InstanceID);
     }
-}
-
-void generateAsteroidMesh(float radius, int sectors, int stacks,
-                          std::vector<float> &vertices, std::vector<unsigned int> &indices)
-{
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> dis(-0.15f, 0.15f);
-
-    // Generate vertices
-    for (int i = 0; i <= stacks; ++i)
-    {
-        float phi = M_PI * float(i) / float(stacks);
-        for (int j = 0; j <= sectors; ++j)
-        {
-            float theta = 2.0f * M_PI * float(j) / float(sectors);
-
-            float x = cos(theta) * sin(phi);
-            float y = cos(phi);
-            float z = sin(theta) * sin(phi);
-
-            // Add random displacement
-            float noise = 1.0f + dis(gen);
-            x *= radius * noise;
-            y *= radius * noise;
-            z *= radius * noise;
-
-            // Only position
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-        }
+    void main() {
+        int segment = gl_VertexID / 2;
+        int age = segment + gl_VertexID % 2;
+        vec4 newest = fetchSample(0);
+        vec4 older = fetchSample(segment + 1);
+        fade = 1.0 - float(age) / float(trailLength);
+        // Ids only match within one body's lifetime; other segments are clipped away
+        if (newest.w == 0.0 || older.w != newest.w)
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        else
+            gl_Position = viewProjection * vec4(fetchSample(age).xyz, 1.0);
     }
+)";
 
-    // Generate indices
-    for (int i = 0; i < stacks; ++i)
-    {
-        for (int j = 0; j < sectors; ++j)
-        {
-            int first = i * (sectors + 1) + j;
-            int second = first + sectors + 1;
-
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
-
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
-        }
+const char *trailFragmentShader = R"(
+    #version 330 core
+    in float fade;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vec4(0.9, 0.8, 0.6, 0.5 * fade);
     }
-}
-
-Asteroid createAsteroid()
-{
-    Asteroid asteroid;
-
-    // Random spawn position
-    float angle = static_cast<float>(rand()) / RAND_MAX * 2.0f * M_PI;
-    asteroid.position = glm::vec3(
-        SPAWN_RADIUS * cos(angle),
-        SPAWN_RADIUS * sin(angle),
-        0.0f);
-
-    // Calculate velocity towards center
-    glm::vec3 direction = glm::normalize(-asteroid.position);
-    float speed = 1.0f + static_cast<float>(rand()) / RAND_MAX * 1.0f;
-    asteroid.velocity = direction * speed;
-
-    // Random size and rotation
-    asteroid.size = MIN_ASTEROID_SIZE + static_cast<float>(rand()) / RAND_MAX * (MAX_ASTEROID_SIZE - MIN_ASTEROID_SIZE);
-    asteroid.rotation = static_cast<float>(rand()) / RAND_MAX * 360.0f;
-
-    // Generate mesh
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-    generateAsteroidMesh(asteroid.size, 16, 8, vertices, indices);
-    asteroid.indexCount = indices.size();
-
-    // Create OpenGL buffers
-    glGenVertexArrays(1, &asteroid.VAO);
-    glGenBuffers(1, &asteroid.VBO);
-    glGenBuffers(1, &asteroid.EBO);
-
-    glBindVertexArray(asteroid.VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, asteroid.VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, asteroid.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    // Position attribute only
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-
-    return asteroid;
-}
-// Function to update asteroids
-void updateAsteroids(float deltaTime, const glm::vec3 &satellitePos, float satelliteRadius)
-{
-    auto it = asteroids.begin();
-    while (it != asteroids.end())
-    {
-        // Update position
-        it->position += it->velocity * deltaTime;
-
-        // Update rotation
-        it->rotation += 45.0f * deltaTime;
-
-        // Check for collision with satellite
-        if (checkCollision(satellitePos, satelliteRadius, *it))
-        {
-            // Delete asteroid buffers
-            glDeleteVertexArrays(1, &it->VAO);
-            glDeleteBuffers(1, &it->VBO);
-            glDeleteBuffers(1, &it->EBO);
-            // Remove asteroid
-            it = asteroids.erase(it);
-            continue;
-        }
+)";
 
-        // Check if asteroid should be removed (too close to center or too far)
-        float distance = glm::length(it->position);
-        if (distance < 1.0f || distance > SPAWN_RADIUS + 2.0f)
-        {
-            glDeleteVertexArrays(1, &it->VAO);
-            glDeleteBuffers(1, &it->VBO);
-            glDeleteBuffers(1, &it->EBO);
-            it = asteroids.erase(it);
-        }
+// Satellite catalog: one point instance per object, colored by orbit regime
+// (see satellite_catalog.h); w < 0 marks objects that could not be propagated
+const char *catalogVertexShader = R"(
+    #version 330 core
+    layout(location = 0) in vec4 object;
+    uniform mat4 viewProjection;
+    out vec3 objectColor;
+    const vec3 regimeColors[4] = vec3[4](vec3(0.55, 0.8, 1.0), vec3(0.6, 1.0, 0.6),
+                                         vec3(1.0, 0.85, 0.4), vec3(1.0, 0.5, 0.8));
+    void main() {
+        if (object.w < 0.0)
+            gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
         else
-        {
-            ++it;
-        }
-    }
-}
-
-void renderAsteroid(GLuint shaderProgram, const Asteroid &asteroid,
-                    const glm::mat4 &view, const glm::mat4 &projection)
-{
-    static std::vector<float> asteroidVertices;
-    static std::vector<unsigned int> asteroidIndices;
-    static GLuint asteroidVAO = 0;
-    static GLuint asteroidVBO = 0;
-    static GLuint asteroidEBO = 0;
-
-    // Initialize the asteroid mesh only once
-    if (asteroidVAO == 0)
-    {
-        generateAsteroid(1.0f, 16, 8, asteroidVertices, asteroidIndices);
-
-        glGenVertexArrays(1, &asteroidVAO);
-        glGenBuffers(1, &asteroidVBO);
-        glGenBuffers(1, &asteroidEBO);
-
-        glBindVertexArray(asteroidVAO);
-
-        glBindBuffer(GL_ARRAY_BUFFER, asteroidVBO);
-        glBufferData(GL_ARRAY_BUFFER, asteroidVertices.size() * sizeof(float),
-                     asteroidVertices.data(), GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, asteroidEBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, asteroidIndices.size() * sizeof(unsigned int),
-                     asteroidIndices.data(), GL_STATIC_DRAW);
-
-        // Position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
-        glEnableVertexAttribArray(0);
-
-        // Normal attribute
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float),
-                              (void *)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
+            gl_Position = viewProjection * vec4(object.xyz, 1.0);
+        objectColor = regimeColors[int(max(object.w, 0.0))];
     }
-    glUseProgram(shaderProgram);
-
-    // Create transformation matrices
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, asteroid.position);
-    model = glm::rotate(model, glm::radians(asteroid.rotation), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::scale(model, glm::vec3(asteroid.size / 2));
-
-    glm::mat4 mvp = projection * view * model;
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"), 1, GL_FALSE, glm::value_ptr(mvp));
-
-    // Draw asteroid
-    glBindVertexArray(asteroid.VAO);
-    glDrawElements(GL_TRIANGLES, asteroid.indexCount, GL_UNSIGNED_INT, 0);
-}
-
-// Function to spawn a new asteroid
-void spawnAsteroid()
-{
-    Asteroid asteroid;
-
-    // Random angle for spawn position
-    float angle = static_cast<float>(rand()) / RAND_MAX * 2.0f * M_PI;
-
-    // Set random position on circle
-    asteroid.position = glm::vec3(
-        SPAWN_RADIUS * cos(angle),
-        SPAWN_RADIUS * sin(angle),
-        0.0f);
-
-    // Calculate velocity vector towards center
-    glm::vec3 direction = glm::normalize(-asteroid.position);
-    float speed = 2.0f + static_cast<float>(rand()) / RAND_MAX * 2.0f;
-    asteroid.velocity = direction * speed;
-
-    // Random size and rotation
-    asteroid.size = MIN_ASTEROID_SIZE +
-                    static_cast<float>(rand()) / RAND_MAX * (MAX_ASTEROID_SIZE - MIN_ASTEROID_SIZE);
-    asteroid.rotation = static_cast<float>(rand()) / RAND_MAX * 360.0f;
-
-    // Generate mesh
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
-    generateAsteroidMesh(asteroid.size, 16, 8, vertices, indices);
-    asteroid.indexCount = indices.size();
-
-    // Create OpenGL buffers
-    glGenVertexArrays(1, &asteroid.VAO);
-    glGenBuffers(1, &asteroid.VBO);
-    glGenBuffers(1, &asteroid.EBO);
-
-    glBindVertexArray(asteroid.VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, asteroid.VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, asteroid.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-
-    // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // Add asteroid to the vector
-    asteroids.push_back(asteroid);
-}
+)";
 
-// Function to compile shaders
-GLuint compileShader(GLenum type, const char *source)
-{
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &source, NULL);
-    glCompileShader(shader);
-    // Check for compilation errors
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        GLchar infoLog[512];
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
+const char *catalogFragmentShader = R"(
+    #version 330 core
+    in vec3 objectColor;
+    out vec4 FragColor;
+    void main() {
+        FragColor = vec4(objectColor, 1.0);
     }
-    return shader;
-}
-
-// Function to create sphere vertices
-std::vector<float> createSphereVertices(float radius, int sectors, int stacks)
-{
-    std::vector<float> vertices;
-
-    for (int i = 0; i <= stacks; ++i)
-    {
-        float stackAngle = M_PI / 2 - i * M_PI / stacks; // from pi/2 to -pi/2
-        float xy = radius * cosf(stackAngle);            // radius at current stack
-        float z = radius * sinf(stackAngle);             // z coordinate
+)";
 
-        for (int j = 0; j <= sectors; ++j)
-        {
-            float sectorAngle = j * 2 * M_PI / sectors; // from 0 to 2pi
-            float x = xy * cosf(sectorAngle);           // x coordinate
-            float y = xy * sinf(sectorAngle);           // y coordinate
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-        }
-    }
+GLuint satelliteVAO2, satelliteVBO2;
 
-    // Indices for drawing triangles
-    std::vector<unsigned int> indices;
-    for (int i = 0; i < stacks; ++i)
-    {
-        for (int j = 0; j < sectors; ++j)
-        {
-            unsigned int first = (i * (sectors + 1)) + j;
-            unsigned int second = first + sectors + 1;
-            indices.push_back(first);
-            indices.push_back(second);
-            indices.push_back(first + 1);
-            indices.push_back(second);
-            indices.push_back(second + 1);
-            indices.push_back(first + 1);
-        }
-    }
+AsteroidPool asteroidPool;
+OrbitPaths orbitPaths;
+TrailBuffer trails;
 
-    // Convert indices to a flat vertex list
-    std::vector<float> indexedVertices;
-    for (const auto &index : indices)
-    {
-        indexedVertices.push_back(vertices[index * 3]);
-        indexedVertices.push_back(vertices[index * 3 + 1]);
-        indexedVertices.push_back(vertices[index * 3 + 2]);
-    }
-    return indexedVertices;
-}
+// Window size; the scene itself may be drawn smaller (see dynamic_resolution.h)
+const int WINDOW_WIDTH = 800;
+const int WINDOW_HEIGHT = 600;
+const char *WINDOW_TITLE = "OpenGL Textured Sphere with Stars";
 
 // Function to load texture
 GLuint loadTexture(const char *path)
@@ -559,47 +210,114 @@ GLuint loadTexture(const char *path)
     return textureID;
 }
 
-int main()
+// One line about the selected body: position, velocity, its orbit and its neighbourhood
+void describeSelection(const SimSnapshot &snapshot, char *text, size_t size)
 {
-    // Initialize GLFW
-    if (!glfwInit())
+    const glm::vec3 &p = snapshot.selectedPosition;
+    const glm::vec3 &v = snapshot.selectedVelocity;
+    char orbit[96];
+    if (snapshot.selectedId == 1)
     {
-        return -1;
+        snprintf(orbit, sizeof(orbit), "circular orbit r=%.2f", snapshot.satelliteOrbitRadius);
+    }
+    else if (snapshot.selectedId == 2)
+    {
+        snprintf(orbit, sizeof(orbit), "circular orbit r=%.2f, tilt %.1f deg", snapshot.moonOrbitRadius,
+                 glm::degrees(snapshot.moonOrbitTilt));
+    }
+    else
+    {
+        // Asteroids fly in straight lines
+        float closestTime = -glm::dot(p, v) / std::max(glm::dot(v, v), 1e-6f);
+        if (closestTime > 0.0f)
+            snprintf(orbit, sizeof(orbit), "straight path, passes %.2f from Earth's center in %.1f s",
+                     glm::length(p + v * closestTime), closestTime);
+        else
+            snprintf(orbit, sizeof(orbit), "straight path, moving away from Earth");
     }
 
-    srand(static_cast<unsigned int>(time(nullptr)));
+    const char *name = snapshot.selectedId == 1 ? "Satellite" : snapshot.selectedId == 2 ? "Moon" : "Asteroid";
+    snprintf(text, size, "%s #%u  pos (%.2f, %.2f, %.2f)  vel (%.2f, %.2f, %.2f) |v|=%.2f  %s  %d bodies within %.1f",
+             name, snapshot.selectedId, p.x, p.y, p.z, v.x, v.y, v.z, glm::length(v), orbit,
+             snapshot.selectedNeighbours, SIM_NEIGHBOUR_RADIUS);
+}
 
-    // Set GLFW context version (OpenGL 3.3)
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+int main(int argc, char **argv)
+{
+#ifdef ENABLE_ALLOC_TRACKING
+    allocTrackerInit();
+#endif
 
-    // Create a windowed mode window and its OpenGL context
-    GLFWwindow *window = glfwCreateWindow(800, 600, "OpenGL Textured Sphere with Stars", NULL, NULL);
-    if (!window)
+    // Benchmark mode runs a fixed scenario offscreen and exits
+    FrameBenchConfig bench;
+    if (!parseFrameBenchArgs(argc, argv, bench))
     {
-        glfwTerminate();
         return -1;
     }
 
-    // Make the window's context current
-    glfwMakeContextCurrent(window);
+    GLFWwindow *window = nullptr;
+    bool headless = bench.enabled && createHeadlessContext();
+    if (!headless)
+    {
+        // Initialize GLFW
+        if (!glfwInit())
+        {
+            return -1;
+        }
+
+        // Set GLFW context version (OpenGL 3.3)
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        if (bench.enabled)
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        // Create a windowed mode window and its OpenGL context
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+            return -1;
+        }
+
+        // Make the window's context current
+        glfwMakeContextCurrent(window);
+    }
+
+    srand(bench.enabled ? bench.seed : static_cast<unsigned int>(time(nullptr)));
 
     // Initialize GLEW
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK)
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLX-only GLEW builds report this under EGL even though the GL entry points loaded fine
+    if (headless && glewStatus == GLEW_ERROR_NO_GLX_DISPLAY)
+        glewStatus = GLEW_OK;
+#endif
+    if (glewStatus != GLEW_OK)
+    {
+        return -1;
+    }
+
+    if (headless && !createHeadlessFramebuffer(WINDOW_WIDTH, WINDOW_HEIGHT))
     {
+        destroyHeadlessContext();
         return -1;
     }
 
-    // Set viewport
-    glViewport(0, 0, 800, 600);
+    // Set viewport (a window's framebuffer can be larger than the window on high-DPI screens)
+    int outputWidth = WINDOW_WIDTH;
+    int outputHeight = WINDOW_HEIGHT;
+    if (window)
+        glfwGetFramebufferSize(window, &outputWidth, &outputHeight);
+    GLuint outputFramebuffer = headless ? headlessFramebuffer() : 0;
+    glViewport(0, 0, outputWidth, outputHeight);
     glEnable(GL_DEPTH_TEST); // Enable depth testing
 
     // Generate sphere vertices and indices
     std::vector<float> vertices;
     std::vector<unsigned int> indices;
-    generateSphere(1.0f, 64, 32, vertices, indices);
+    generateSphere(EARTH_RADIUS, 64, 32, vertices, indices);
 
     // Create Vertex Array Object and Vertex Buffer Objects
     GLuint VAO, VBO, EBO;
@@ -624,32 +342,22 @@ int main()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    // Compile shaders
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-
-    // Create shader program
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    // Build shader programs (reloaded from the program binary cache when possible)
+    shaderCacheInit();
+    GLuint shaderProgram = linkProgram("scene", vertexShaderSource, fragmentShaderSource);
+    GLuint asteroidShaderProgram = linkProgram("asteroid", asteroidVertexShader, asteroidFragmentShader);
+    GLuint orbitShaderProgram = linkProgram("orbit", orbitVertexShader, orbitFragmentShader);
+    GLuint trailShaderProgram = linkProgram("trail", trailVertexShader, trailFragmentShader);
+    GLuint catalogShaderProgram = linkProgram("catalog", catalogVertexShader, catalogFragmentShader);
+    if (!shaderProgram || !asteroidShaderProgram || !orbitShaderProgram || !trailShaderProgram ||
+        !catalogShaderProgram)
+    {
+        return -1;
+    }
 
     std::vector<float> satelliteVertices = createSphereVertices(0.08f, 32, 16);
 
-    // Cleanup shaders as they are now linked
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    GLuint asteroidVertShader = compileShader(GL_VERTEX_SHADER, asteroidVertexShader);
-    GLuint asteroidFragShader = compileShader(GL_FRAGMENT_SHADER, asteroidFragmentShader);
-
-    GLuint asteroidShaderProgram = glCreateProgram();
-    glAttachShader(asteroidShaderProgram, asteroidVertShader);
-    glAttachShader(asteroidShaderProgram, asteroidFragShader);
-    glLinkProgram(asteroidShaderProgram);
-
-    glDeleteShader(asteroidVertShader);
-    glDeleteShader(asteroidFragShader);
+    GLint viewProjectionLocation = glGetUniformLocation(asteroidShaderProgram, "viewProjection");
 
     // Load texture
     GLuint satelliteTexture = loadTexture("satellite_texture.jpg");
@@ -685,77 +393,164 @@ int main()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    // Initialize timing variables
-    float currentTime = glfwGetTime();
-    float lastTime = currentTime;
-    float lastSpawnTime = currentTime;
-    float spawnInterval = 2.0f;
-
     // Generate stars with their original positions
     std::vector<glm::vec3> stars;
-    glPointSize(8.0f);
-    generateStars(1000, stars); // Generate 300 stars within a range of 10.0 units
+    const float starPointSize = 8.0f;
+    generateStars(bench.enabled ? bench.stars : 1000, stars); // Generate 300 stars within a range of 10.0 units
 
-    // Main loop
-    while (!glfwWindowShouldClose(window))
+    // Asteroid mesh slots and instance rows are allocated once up front
+    int asteroidCapacity = bench.enabled ? std::max(bench.asteroids, 1024) : 1024;
+    if (!asteroidPoolInit(asteroidPool, asteroidCapacity))
     {
+        return -1;
+    }
+    glUseProgram(asteroidShaderProgram);
+    glUniform1i(glGetUniformLocation(asteroidShaderProgram, "vertsPerSlot"), asteroidPool.vertsPerSlot);
+    glUniform1i(glGetUniformLocation(asteroidShaderProgram, "meshPositions"), 0);
 
-        currentTime = glfwGetTime();
-        float deltaTime = currentTime - lastTime;
-        lastTime = currentTime;
-
-        // Update spawn timer
-        if (currentTime - lastSpawnTime >= spawnInterval)
-        {
-            spawnAsteroid();
-            lastSpawnTime = currentTime;
-        }
+    // Trail bodies: the satellite, the moon, then one per asteroid slot
+    if (!trailsInit(trails, trailShaderProgram, asteroidPool.capacity + 2))
+    {
+        return -1;
+    }
+    GLint trailViewProjectionLocation = glGetUniformLocation(trailShaderProgram, "viewProjection");
+
+    // Orbit tracks for the satellite and moon (set from each snapshot), plus
+    // random ones in benchmark mode to load the orbit renderer
+    orbitPathsInit(orbitPaths, 64 * 1024);
+    OrbitElements circle = orbitElementsFromAngles(1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    int satelliteOrbit = orbitPathsAdd(orbitPaths, circle, glm::vec3(0.8f, 0.3f, 0.3f));
+    int moonOrbit = orbitPathsAdd(orbitPaths, circle, glm::vec3(0.5f, 0.5f, 0.55f));
+    for (int i = 0; i < bench.orbits; ++i)
+    {
+        float random[5];
+        for (float &value : random)
+            value = static_cast<float>(rand()) / RAND_MAX;
+        // One in ten is an escape trajectory
+        float eccentricity = i % 10 == 9 ? 1.05f + 0.5f * random[1] : 0.7f * random[1];
+        orbitPathsAdd(orbitPaths,
+                      orbitElementsFromAngles(1.2f + 3.0f * random[0], eccentricity, M_PI * random[2],
+                                              2.0f * M_PI * random[3], 2.0f * M_PI * random[4]),
+                      glm::vec3(0.25f, 0.35f, 0.3f));
+    }
+    GLint orbitViewProjectionLocation = glGetUniformLocation(orbitShaderProgram, "viewProjection");
+    GLint orbitColorLocation = glGetUniformLocation(orbitShaderProgram, "color");
+
+    // Catalog positions are streamed once per snapshot into a per-instance attribute
+    GLuint catalogVAO, catalogVBO;
+    size_t catalogCapacity = 0; // objects the buffer holds; the catalog is loaded by the simulation thread
+    const float catalogPointSize = 2.0f;
+    glGenVertexArrays(1, &catalogVAO);
+    glGenBuffers(1, &catalogVBO);
+    glBindVertexArray(catalogVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, catalogVBO);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    GLint catalogViewProjectionLocation = glGetUniformLocation(catalogShaderProgram, "viewProjection");
+
+    // Transient per-frame data (star positions, the star MVP batch) comes from the frame arenas
+    frameArenaInit(4 * 1024 * 1024);
+
+#ifdef ENABLE_PROFILER
+    profilerSetThreadName("main");
+    perfCountersInit();
+    bool traceKeyWasDown = false;
+#endif
+
+    // Worker threads for the render and simulation job graphs
+    jobWorkersStart(0);
+
+    // Simulation runs on its own thread; benchmark mode steps time at a fixed
+    // rate and holds the asteroid population so every run sees the same scene
+    SimConfig simConfig;
+    simConfig.slotCapacity = asteroidPool.capacity;
+    simConfig.vertsPerSlot = asteroidPool.vertsPerSlot;
+    simConfig.fixedStep = bench.enabled ? FRAME_BENCH_DT : 0.0f;
+    simConfig.holdAsteroids = bench.enabled ? bench.asteroids : 0;
+    simConfig.spawnInterval = 2.0f; // scaled by the governor
+
+    // Satellite catalog: a TLE or OMM file from ORBITAL_CATALOG, shown at the current
+    // time, or in benchmark mode a made-up one starting at its element epochs
+    const char *catalogPath = getenv("ORBITAL_CATALOG");
+    if (catalogPath)
+        simConfig.catalogPath = catalogPath;
+    simConfig.syntheticCatalog = bench.enabled ? bench.catalog : 0;
+    simConfig.catalogSeed = bench.seed;
+    simConfig.catalogStartJd = bench.enabled ? 0.0 : julianDateFromUnix(static_cast<double>(time(nullptr)));
+
+    // The governor trades star count, asteroid detail, spawn rate and collision
+    // substeps for frame time; benchmarks only run it when asked, so runs stay comparable
+    GovernorConfig governorConfig;
+    governorConfig.enabled = !bench.enabled || bench.governor;
+    governorInit(governorConfig);
+
+    // The render scale follows GPU time; benchmarks use it only when asked
+    DynamicResolutionConfig resolutionConfig;
+    resolutionConfig.enabled = !bench.enabled || bench.dynamicResolution;
+    if (!dynamicResolutionInit(resolutionConfig, outputWidth, outputHeight))
+    {
+        return -1;
+    }
+    if (!simThreadStart(simConfig))
+    {
+        return -1;
+    }
 
+    // Create transformation matrices
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)outputWidth / (float)outputHeight, 0.1f, 100.0f);
+    glm::mat4 view = glm::translate(glm::mat4(1.0f), -CAMERA_POSITION);
+    glm::mat4 viewProjection = projection * view;
+
+    // State shared by the render jobs of the current frame
+    const SimSnapshot *snapshot = nullptr;
+    glm::vec3 *starPositions = nullptr;
+    glm::mat4 *starMVPs = nullptr;
+    size_t starsDrawn = stars.size();
+    float starDistance = 3.0f; // Adjust star distance if necessary
+    bool newTrailSample = false;
+    uint64_t trailSequence = 0;
+    uint64_t catalogSequence = 0;
+    bool pickButtonWasDown = false;
+    uint32_t shownSelection = 0;
+    float shownSelectionTime = 0.0f;
+
+    // Earth, satellite and moon
+    auto drawScene = [&]() {
         // Clear the screen
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Use shader program
-        glUseProgram(shaderProgram);
+        statsUseProgram(shaderProgram);
 
-        // Create transformation matrices
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)800 / (float)600, 0.1f, 100.0f);
-        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
-        glm::mat4 model = glm::rotate(glm::mat4(1.0f), (float)glfwGetTime(), glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 model = glm::rotate(glm::mat4(1.0f), snapshot->time, glm::vec3(0.0f, 1.0f, 0.0f));
         glm::mat4 mvp = projection * view * model;
 
         // Set the MVP uniform
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"), 1, GL_FALSE, glm::value_ptr(mvp));
+        statsUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"), glm::value_ptr(mvp));
 
         // Bind texture
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, earthTexture);
+        statsBindTexture(GL_TEXTURE_2D, earthTexture);
         glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0); // Use texture unit 0
 
         // Draw the sphere
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        {
+            PROFILE_STAGE("earth");
+            PROFILE_GPU_ZONE("earth");
+            statsBindVertexArray(VAO);
+            statsDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        }
 
         // Satellite
         model = glm::mat4(1.0f);
 
-        // Satellite movement logic
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-            satelliteAngle += 0.02f;
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-            satelliteAngle -= 0.02f;
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-            satelliteOrbitRadius += 0.01f;
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-            satelliteOrbitRadius -= 0.01f;
-
-        // Clamp the orbit radius
-        if (satelliteOrbitRadius < 0.1f)
-            satelliteOrbitRadius = 0.1f;
-
         // Position of the satellite
         glm::mat4 satelliteModel = glm::mat4(1.0f);
-        satelliteX = satelliteOrbitRadius * cos(satelliteAngle);
-        satelliteY = satelliteOrbitRadius * sin(satelliteAngle);
+        float satelliteX = snapshot->satellitePos.x;
+        float satelliteY = snapshot->satellitePos.y;
         // satelliteModel = glm::translate(satelliteModel, glm::vec3(0.0f, satelliteY, satelliteX));
 
         // Position of the satellite
@@ -772,84 +567,304 @@ int main()
         mvp = projection * view * model;
 
         // Set the MVP uniform for the satellite
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"), 1, GL_FALSE, glm::value_ptr(mvp));
+        statsUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"), glm::value_ptr(mvp));
         glUniform3f(glGetUniformLocation(shaderProgram, "color"), 1.0f, 0.0f, 0.0f);
         // Bind texture
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, satelliteTexture);
+        statsBindTexture(GL_TEXTURE_2D, satelliteTexture);
         glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0); // Use texture unit 0
         // Draw the satellite (bind its VAO and draw)
-        glBindVertexArray(satelliteVAO1);
-        glDrawArrays(GL_TRIANGLES, 0, satelliteVertices.size());
-
-        glm::vec3 satellitePos(satelliteX, satelliteY, 0.0f);
-        float satelliteRadius = 0.08f;
-
-        updateAsteroids(deltaTime, satellitePos, satelliteRadius);
-
-        // Reduced speed for tilt oscillation (from 10.0f to 2.0f)
-        float tiltAngle = glm::radians(45.0f + 2.0f * sin(glfwGetTime()));
-
-        // Calculate position with tilt
-        satelliteX2 = satelliteOrbitRadius2 * cos(satelliteAngle2);
-        satelliteY2 = satelliteOrbitRadius2 * sin(satelliteAngle2) * sin(tiltAngle);
-        satelliteZ2 = satelliteOrbitRadius2 * sin(satelliteAngle2) * cos(tiltAngle);
-
-        // Reduced orbital rotation speed (from 0.01f to 0.003f)
-        satelliteAngle2 += 0.01f;
+        statsBindVertexArray(satelliteVAO1);
+        statsDrawArrays(GL_TRIANGLES, 0, satelliteVertices.size());
 
         // Create moon satellite's model matrix with tilted orbit
-        glm::mat4 satelliteModel2 = glm::translate(glm::mat4(1.0f),
-                                                   glm::vec3(satelliteX2, satelliteY2, satelliteZ2));
+        glm::mat4 satelliteModel2 = glm::translate(glm::mat4(1.0f), snapshot->moonPos);
         float moonScale = 4.0f; // Makes the moon 3 times larger
         satelliteModel2 = glm::scale(satelliteModel2,
                                      glm::vec3(moonScale)); // Uniform scaling in all directions
         mvp = projection * view * satelliteModel2;
 
         // Update MVP uniform for moon
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"),
-                           1, GL_FALSE, glm::value_ptr(mvp));
+        statsUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"), glm::value_ptr(mvp));
         // Bind Texture
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, moonTexture);
+        statsBindTexture(GL_TEXTURE_2D, moonTexture);
         glUniform1i(glGetUniformLocation(shaderProgram, "texture1"), 0); // Use texture unit 0
 
         // Draw moon satellite
-        glBindVertexArray(satelliteVAO2);
-        glDrawArrays(GL_TRIANGLES, 0, satelliteVertices.size());
-
-        float starDistance = 3.0f; // Adjust star distance if necessary
-        for (size_t i = 0; i < stars.size(); ++i)
+        statsBindVertexArray(satelliteVAO2);
+        statsDrawArrays(GL_TRIANGLES, 0, satelliteVertices.size());
+    };
+
+    auto computeStars = [&]() {
+        starPositions = frameAlloc<glm::vec3>(stars.size());
+        computeStarPositions(stars, snapshot->time, starDistance, starPositions);
+    };
+
+    // Build the MVP batch first, then submit
+    auto buildStarMatrices = [&]() {
+        starMVPs = frameAlloc<glm::mat4>(starsDrawn);
+        for (size_t i = 0; i < starsDrawn; ++i)
         {
-            // Calculate angle for revolution
-            float angle = glfwGetTime() + (i * (2.0f * M_PI / stars.size())); // Offset each star's angle
-
-            // Position stars in a circular path around the sphere
-            float x = starDistance * cos(angle);      // Circular motion on x-axis
-            float z = starDistance * sin(angle);      // Circular motion on z-axis
-            glm::vec3 starPosition(x, stars[i].y, z); // Keep the original y position of the star
-
             // Create the star model matrix
-            glm::mat4 starModel = glm::translate(glm::mat4(5.0f), starPosition);
+            glm::mat4 starModel = glm::translate(glm::mat4(5.0f), starPositions[i]);
             starModel = glm::scale(starModel, glm::vec3(10.0f)); // Scale stars down
-            glm::mat4 starMVP = projection * view * starModel;
+            starMVPs[i] = viewProjection * starModel;
+        }
+    };
 
-            glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "mvp"), 1, GL_FALSE, glm::value_ptr(starMVP));
+    auto drawStars = [&]() {
+        PROFILE_GPU_ZONE("stars");
+        GLint mvpLocation = glGetUniformLocation(shaderProgram, "mvp");
+        for (size_t i = 0; i < starsDrawn; ++i)
+        {
+            statsUniformMatrix4fv(mvpLocation, glm::value_ptr(starMVPs[i]));
 
             // Draw a point for the star
-            glDrawArrays(GL_POINTS, 0, 1); // Drawing a single point
+            statsDrawArrays(GL_POINTS, 0, 1); // Drawing a single point
+        }
+    };
+
+    auto drawAsteroids = [&]() {
+        PROFILE_GPU_ZONE("asteroids");
+        // One instanced draw per level of detail for the whole field
+        statsUseProgram(asteroidShaderProgram);
+        statsUniformMatrix4fv(viewProjectionLocation, glm::value_ptr(viewProjection));
+        asteroidPoolDraw(asteroidPool, snapshot->asteroidInstances.data(),
+                         static_cast<int>(snapshot->asteroidInstances.size()), snapshot->fullDetailCount);
+    };
+
+    auto drawOrbits = [&]() {
+        PROFILE_GPU_ZONE("orbits");
+        // Only tracks whose elements changed are resampled
+        OrbitElements satelliteElements = circle;
+        satelliteElements.semiLatusRectum = snapshot->satelliteOrbitRadius;
+        orbitPathsUpdate(orbitPaths, satelliteOrbit, satelliteElements);
+        OrbitElements moonElements = circle;
+        moonElements.semiLatusRectum = snapshot->moonOrbitRadius;
+        moonElements.ahead = glm::vec3(0.0f, sin(snapshot->moonOrbitTilt), cos(snapshot->moonOrbitTilt));
+        orbitPathsUpdate(orbitPaths, moonOrbit, moonElements);
+
+        statsUseProgram(orbitShaderProgram);
+        statsUniformMatrix4fv(orbitViewProjectionLocation, glm::value_ptr(viewProjection));
+        orbitPathsDraw(orbitPaths, orbitColorLocation);
+    };
+
+    auto drawCatalog = [&]() {
+        size_t objects = snapshot->catalogPositions.size();
+        if (objects == 0)
+            return;
+        PROFILE_GPU_ZONE("catalog");
+        glBindBuffer(GL_ARRAY_BUFFER, catalogVBO);
+        if (objects > catalogCapacity)
+        {
+            glBufferData(GL_ARRAY_BUFFER, objects * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+            catalogCapacity = objects;
+            catalogSequence = 0;
+        }
+        if (snapshot->sequence != catalogSequence)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, objects * sizeof(glm::vec4), snapshot->catalogPositions.data());
+            catalogSequence = snapshot->sequence;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        statsUseProgram(catalogShaderProgram);
+        statsUniformMatrix4fv(catalogViewProjectionLocation, glm::value_ptr(viewProjection));
+        glPointSize(catalogPointSize * dynamicResolutionScale());
+        statsBindVertexArray(catalogVAO);
+        statsDrawArraysInstanced(GL_POINTS, 0, 1, static_cast<GLsizei>(objects));
+    };
+
+    // One trail sample per simulation snapshot
+    auto sampleTrails = [&]() {
+        if (!newTrailSample)
+            return;
+        trailsBeginSample(trails);
+        trailsSetBody(trails, 0, snapshot->satellitePos, 1);
+        trailsSetBody(trails, 1, snapshot->moonPos, 2);
+        for (size_t i = 0; i < snapshot->asteroidInstances.size(); ++i)
+        {
+            const AsteroidInstance &instance = snapshot->asteroidInstances[i];
+            trailsSetBody(trails, instance.slot + 2, glm::vec3(instance.model[3]), snapshot->asteroidIds[i]);
+        }
+    };
+
+    auto drawTrails = [&]() {
+        PROFILE_GPU_ZONE("trails");
+        if (newTrailSample)
+            trailsEndSample(trails);
+        statsUseProgram(trailShaderProgram);
+        statsUniformMatrix4fv(trailViewProjectionLocation, glm::value_ptr(viewProjection));
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+        trailsDraw(trails);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    };
+
+    // GL submission stays on this thread and in the original order; the star
+    // positions and matrices are built on a worker while the scene is drawn
+    JobGraph renderGraph("render");
+    int sceneJob = renderGraph.addJob("scene", drawScene, true);
+    int starPositionsJob = renderGraph.addJob("starPositions", computeStars);
+    int starMatricesJob = renderGraph.addJob("starMatrices", buildStarMatrices);
+    int starsJob = renderGraph.addJob("stars", drawStars, true);
+    int asteroidsJob = renderGraph.addJob("asteroids", drawAsteroids, true);
+    int catalogJob = renderGraph.addJob("catalog", drawCatalog, true);
+    int orbitsJob = renderGraph.addJob("orbits", drawOrbits, true);
+    int trailSampleJob = renderGraph.addJob("trailSample", sampleTrails);
+    int trailsJob = renderGraph.addJob("trails", drawTrails, true);
+    renderGraph.addDependency(starPositionsJob, starMatricesJob);
+    renderGraph.addDependency(sceneJob, starsJob);
+    renderGraph.addDependency(starMatricesJob, starsJob);
+    renderGraph.addDependency(starsJob, asteroidsJob);
+    renderGraph.addDependency(asteroidsJob, catalogJob);
+    renderGraph.addDependency(catalogJob, orbitsJob);
+    renderGraph.addDependency(orbitsJob, trailsJob);
+    renderGraph.addDependency(trailSampleJob, trailsJob);
+
+    // Main loop
+    int frameIndex = 0;
+    while (bench.enabled ? frameIndex < bench.warmupFrames + bench.frames : !glfwWindowShouldClose(window))
+    {
+        PROFILE_STAGE("frame");
+        uint64_t frameStartNs = profilerNowNs();
+        beginBenchFrame();
+        frameArenaAdvance();
+#ifdef ENABLE_ALLOC_TRACKING
+        allocTrackerBeginFrame();
+#endif
+
+        // Satellite controls are sampled here and applied by the next simulation step
+        if (!bench.enabled)
+        {
+            unsigned input = 0;
+            if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+                input |= SIM_INPUT_ANGLE_UP;
+            if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+                input |= SIM_INPUT_ANGLE_DOWN;
+            if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+                input |= SIM_INPUT_RADIUS_UP;
+            if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+                input |= SIM_INPUT_RADIUS_DOWN;
+            simSetInput(input);
+
+            // Left click selects the body under the cursor (or clears the selection)
+            bool pickButtonDown = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            if (pickButtonDown && !pickButtonWasDown)
+            {
+                double cursorX, cursorY;
+                int windowWidth, windowHeight;
+                glfwGetCursorPos(window, &cursorX, &cursorY);
+                glfwGetWindowSize(window, &windowWidth, &windowHeight);
+                float ndcX = 2.0f * static_cast<float>(cursorX) / windowWidth - 1.0f;
+                float ndcY = 1.0f - 2.0f * static_cast<float>(cursorY) / windowHeight;
+                glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+                glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+                glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+                glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+                simRequestPick(origin, glm::vec3(farPoint) / farPoint.w - origin);
+            }
+            pickButtonWasDown = pickButtonDown;
+        }
+
+        // Draw the newest simulation state; benchmark mode draws every step exactly once
+        snapshot = simAcquireSnapshot(bench.enabled);
+        if (!snapshot)
+            break;
+        simUploadPendingMeshes(asteroidPool);
+        starsDrawn = static_cast<size_t>(stars.size() * governorStarFraction());
+        newTrailSample = snapshot->sequence != trailSequence;
+        trailSequence = snapshot->sequence;
+
+        // Print a new selection once, and keep the window title on the selected body
+        bool selectionChanged = snapshot->selectedId != shownSelection;
+        if (!bench.enabled && (selectionChanged || (shownSelection && snapshot->time - shownSelectionTime >= 0.25f)))
+        {
+            char description[256];
+            if (snapshot->selectedId)
+                describeSelection(*snapshot, description, sizeof(description));
+            if (selectionChanged && snapshot->selectedId)
+                std::cout << description << std::endl;
+            glfwSetWindowTitle(window, snapshot->selectedId ? description : WINDOW_TITLE);
+            shownSelection = snapshot->selectedId;
+            shownSelectionTime = snapshot->time;
         }
 
-        for (const auto &asteroid : asteroids)
+        // Record the frame's GL commands; star preparation overlaps with the scene
+        dynamicResolutionBeginFrame();
+        glPointSize(starPointSize * dynamicResolutionScale()); // keep stars the same size on screen
+        renderGraph.run();
+        dynamicResolutionEndFrame(outputFramebuffer);
+
+#ifdef ENABLE_PROFILER
+        // F12 starts/stops a trace capture (open the file in ui.perfetto.dev or chrome://tracing)
+        bool traceKeyDown = window && glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+        if (traceKeyDown && !traceKeyWasDown)
         {
-            renderAsteroid(asteroidShaderProgram, asteroid, view, projection);
+            if (profilerIsCapturing())
+                profilerStopCapture("orbital_trace.json");
+            else
+                profilerStartCapture();
         }
+        traceKeyWasDown = traceKeyDown;
+        profilerEndFrame();
+#endif
 
         // Swap buffers and poll events
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        uint64_t swapNs = 0;
+        {
+            PROFILE_STAGE("glfwSwapBuffers");
+            if (window)
+            {
+                uint64_t swapStartNs = profilerNowNs();
+                glfwSwapBuffers(window);
+                swapNs = profilerNowNs() - swapStartNs;
+            }
+            if (bench.enabled)
+                glFinish(); // include the GPU (or software rasterizer) work in the frame time
+        }
+
+        // The governor sees the frame's own cost, without the wait for vsync
+        float stageMs[GOVERNOR_STAGE_COUNT];
+        stageMs[GOVERNOR_STAGE_STARS] = (renderGraph.lastJobNs(starPositionsJob) + renderGraph.lastJobNs(starMatricesJob) +
+                                         renderGraph.lastJobNs(starsJob)) / 1e6f;
+        stageMs[GOVERNOR_STAGE_ASTEROIDS] = renderGraph.lastJobNs(asteroidsJob) / 1e6f;
+        stageMs[GOVERNOR_STAGE_SIMULATION] = snapshot->stepNs / 1e6f;
+        governorEndFrame((profilerNowNs() - frameStartNs - swapNs) / 1e6f, stageMs);
+        if (window)
+            glfwPollEvents();
+
+#ifdef ENABLE_ALLOC_TRACKING
+        allocTrackerEndFrame();
+#endif
+        endBenchFrame(bench.enabled && frameIndex >= bench.warmupFrames);
+        ++frameIndex;
     }
 
+    simThreadStop();
+    jobWorkersStop();
+    governorPrintSummary();
+    dynamicResolutionPrintSummary();
+    shaderCachePrintSummary();
+
+#ifdef ENABLE_ALLOC_TRACKING
+    allocTrackerPrintSummary();
+#endif
+
+    int exitCode = 0;
+    if (bench.enabled && !writeFrameBenchReport(bench))
+        exitCode = -1;
+
+#ifdef ENABLE_PROFILER
+    profilerStopCapture("orbital_trace.json");
+    profilerShutdownGpu();
+    renderGraph.printSummary();
+    perfPrintSummary();
+#endif
+
     // Cleanup
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
@@ -859,7 +874,25 @@ int main()
     glDeleteVertexArrays(1, &satelliteVAO1);
     glDeleteVertexArrays(1, &satelliteVAO2);
     glDeleteProgram(shaderProgram);
-    glfwTerminate();
+    glDeleteProgram(asteroidShaderProgram);
+    glDeleteProgram(orbitShaderProgram);
+    glDeleteProgram(trailShaderProgram);
+    glDeleteProgram(catalogShaderProgram);
+    glDeleteVertexArrays(1, &catalogVAO);
+    glDeleteBuffers(1, &catalogVBO);
+    trailsDestroy(trails);
+    orbitPathsDestroy(orbitPaths);
+    asteroidPoolDestroy(asteroidPool);
+    dynamicResolutionDestroy();
+    if (headless)
+    {
+        destroyHeadlessFramebuffer();
+        destroyHeadlessContext();
+    }
+    else
+    {
+        glfwTerminate();
+    }
 
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
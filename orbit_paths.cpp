@@ -0,0 +1,262 @@
+#include "orbit_paths.h"
+#include "frame_bench.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const int INITIAL_SEGMENTS = 16; // coarse split before refining, so no bend is skipped entirely
+    const int MAX_DEPTH = 10;        // at most 2^10 segments per initial segment
+    const int BLOCK_VERTICES = 64;   // tracks reserve whole blocks so small changes rewrite in place
+
+    glm::vec3 orbitPoint(const OrbitElements &elements, float nu)
+    {
+        float r = elements.semiLatusRectum / (1.0f + elements.eccentricity * std::cos(nu));
+        return r * (std::cos(nu) * elements.periapsis + std::sin(nu) * elements.ahead);
+    }
+
+    // Emit the end of [nu0, nu1], splitting first while the midpoint strays from the chord
+    void refine(const OrbitElements &elements, float tolerance, float nu0, const glm::vec3 &p0, float nu1,
+                const glm::vec3 &p1, int depth, std::vector<glm::vec3> &out)
+    {
+        float nuMid = 0.5f * (nu0 + nu1);
+        glm::vec3 mid = orbitPoint(elements, nuMid);
+        if (depth < MAX_DEPTH && glm::length(mid - 0.5f * (p0 + p1)) > tolerance)
+        {
+            refine(elements, tolerance, nu0, p0, nuMid, mid, depth + 1, out);
+            refine(elements, tolerance, nuMid, mid, nu1, p1, depth + 1, out);
+        }
+        else
+        {
+            out.push_back(p1);
+        }
+    }
+
+    bool sameElements(const OrbitElements &a, const OrbitElements &b)
+    {
+        return a.semiLatusRectum == b.semiLatusRectum && a.eccentricity == b.eccentricity &&
+               a.periapsis == b.periapsis && a.ahead == b.ahead;
+    }
+
+    int roundToBlock(int count)
+    {
+        return (count + BLOCK_VERTICES - 1) / BLOCK_VERTICES * BLOCK_VERTICES;
+    }
+
+    void markDirty(OrbitPaths &paths, int first, int end)
+    {
+        if (paths.dirtyFirst >= paths.dirtyEnd)
+        {
+            paths.dirtyFirst = first;
+            paths.dirtyEnd = end;
+        }
+        else
+        {
+            paths.dirtyFirst = std::min(paths.dirtyFirst, first);
+            paths.dirtyEnd = std::max(paths.dirtyEnd, end);
+        }
+    }
+
+    // Move every track to the front, dropping the gaps left by moved tracks.
+    // Tracks are taken in buffer order, not id order (a moved track sits past
+    // higher ids), so each one only slides down over space already vacated.
+    void repack(OrbitPaths &paths)
+    {
+        std::vector<int> order(paths.tracks.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<int>(i);
+        std::sort(order.begin(), order.end(),
+                  [&paths](int a, int b) { return paths.tracks[a].first < paths.tracks[b].first; });
+
+        int next = 0;
+        for (int index : order)
+        {
+            OrbitTrack &track = paths.tracks[index];
+            if (track.first != next)
+                memmove(&paths.vertices[next], &paths.vertices[track.first], track.count * sizeof(glm::vec3));
+            track.first = next;
+            next += track.reserved;
+        }
+        paths.used = next;
+        markDirty(paths, 0, next);
+        paths.batchesDirty = true;
+    }
+
+    // Copy the sampled vertices into the track's block, finding it a new one if they no longer fit
+    void storeTrack(OrbitPaths &paths, OrbitTrack &track)
+    {
+        int count = static_cast<int>(paths.scratch.size());
+        if (count > track.reserved)
+        {
+            int reserved = roundToBlock(count);
+            if (paths.used + reserved > paths.capacity)
+            {
+                // Its old block is reclaimed by the repack
+                track.count = 0;
+                track.reserved = 0;
+                repack(paths);
+            }
+            if (paths.used + reserved > paths.capacity)
+            {
+                paths.capacity = std::max(paths.capacity * 2, paths.used + reserved);
+                paths.reallocate = true;
+            }
+            if (static_cast<int>(paths.vertices.size()) < paths.capacity)
+                paths.vertices.resize(paths.capacity);
+            track.first = paths.used;
+            track.reserved = reserved;
+            paths.used += reserved;
+            paths.batchesDirty = true;
+        }
+        else if (count != track.count)
+        {
+            paths.batchesDirty = true;
+        }
+
+        std::copy(paths.scratch.begin(), paths.scratch.end(), paths.vertices.begin() + track.first);
+        track.count = count;
+        markDirty(paths, track.first, track.first + count);
+        ++paths.resamples;
+    }
+
+    void rebuildBatches(OrbitPaths &paths)
+    {
+        for (size_t i = 0; i < paths.batchColors.size(); ++i)
+        {
+            paths.batchFirsts[i].clear();
+            paths.batchCounts[i].clear();
+        }
+        for (const OrbitTrack &track : paths.tracks)
+        {
+            size_t batch = std::find(paths.batchColors.begin(), paths.batchColors.end(), track.color) -
+                           paths.batchColors.begin();
+            if (batch == paths.batchColors.size())
+            {
+                paths.batchColors.push_back(track.color);
+                paths.batchFirsts.emplace_back();
+                paths.batchCounts.emplace_back();
+            }
+            paths.batchFirsts[batch].push_back(track.first);
+            paths.batchCounts[batch].push_back(track.count);
+        }
+        paths.batchesDirty = false;
+    }
+}
+
+void sampleOrbit(const OrbitElements &elements, float tolerance, std::vector<glm::vec3> &out)
+{
+    out.clear();
+
+    // Closed orbits go all the way round; open ones stop where r reaches ORBIT_MAX_RADIUS
+    float nuMax = static_cast<float>(M_PI);
+    bool closed = elements.eccentricity < 1.0f;
+    if (!closed)
+    {
+        float cosLimit = (elements.semiLatusRectum / ORBIT_MAX_RADIUS - 1.0f) / elements.eccentricity;
+        nuMax = std::acos(std::min(std::max(cosLimit, -1.0f), 1.0f));
+    }
+
+    float nuStart = -nuMax;
+    glm::vec3 start = orbitPoint(elements, nuStart);
+    out.push_back(start);
+    for (int i = 1; i <= INITIAL_SEGMENTS; ++i)
+    {
+        float nuEnd = -nuMax + 2.0f * nuMax * i / INITIAL_SEGMENTS;
+        glm::vec3 end = i == INITIAL_SEGMENTS && closed ? out.front() : orbitPoint(elements, nuEnd);
+        refine(elements, tolerance, nuStart, start, nuEnd, end, 0, out);
+        nuStart = nuEnd;
+        start = end;
+    }
+}
+
+OrbitElements orbitElementsFromAngles(float semiLatusRectum, float eccentricity, float inclination,
+                                      float ascendingNode, float argumentOfPeriapsis)
+{
+    float cosNode = std::cos(ascendingNode), sinNode = std::sin(ascendingNode);
+    float cosArg = std::cos(argumentOfPeriapsis), sinArg = std::sin(argumentOfPeriapsis);
+    float cosInc = std::cos(inclination), sinInc = std::sin(inclination);
+
+    OrbitElements elements;
+    elements.semiLatusRectum = semiLatusRectum;
+    elements.eccentricity = eccentricity;
+    elements.periapsis = glm::vec3(cosNode * cosArg - sinNode * sinArg * cosInc,
+                                   sinNode * cosArg + cosNode * sinArg * cosInc, sinArg * sinInc);
+    elements.ahead = glm::vec3(-cosNode * sinArg - sinNode * cosArg * cosInc,
+                               -sinNode * sinArg + cosNode * cosArg * cosInc, cosArg * sinInc);
+    return elements;
+}
+
+bool orbitPathsInit(OrbitPaths &paths, int initialVertices)
+{
+    paths.capacity = std::max(initialVertices, BLOCK_VERTICES);
+    paths.vertices.resize(paths.capacity);
+
+    glGenVertexArrays(1, &paths.vao);
+    glGenBuffers(1, &paths.vertexBuffer);
+    glBindVertexArray(paths.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, paths.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, paths.capacity * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void orbitPathsDestroy(OrbitPaths &paths)
+{
+    glDeleteVertexArrays(1, &paths.vao);
+    glDeleteBuffers(1, &paths.vertexBuffer);
+    paths = OrbitPaths();
+}
+
+int orbitPathsAdd(OrbitPaths &paths, const OrbitElements &elements, const glm::vec3 &color)
+{
+    paths.tracks.push_back({elements, color, 0, 0, 0});
+    sampleOrbit(elements, ORBIT_TOLERANCE, paths.scratch);
+    storeTrack(paths, paths.tracks.back());
+    paths.batchesDirty = true;
+    return static_cast<int>(paths.tracks.size()) - 1;
+}
+
+void orbitPathsUpdate(OrbitPaths &paths, int track, const OrbitElements &elements)
+{
+    OrbitTrack &cached = paths.tracks[track];
+    if (sameElements(cached.elements, elements))
+        return;
+
+    cached.elements = elements;
+    sampleOrbit(elements, ORBIT_TOLERANCE, paths.scratch);
+    storeTrack(paths, cached);
+}
+
+void orbitPathsDraw(OrbitPaths &paths, GLint colorLocation)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, paths.vertexBuffer);
+    if (paths.reallocate)
+    {
+        glBufferData(GL_ARRAY_BUFFER, paths.capacity * sizeof(glm::vec3), paths.vertices.data(), GL_DYNAMIC_DRAW);
+        paths.reallocate = false;
+    }
+    else if (paths.dirtyFirst < paths.dirtyEnd)
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, paths.dirtyFirst * sizeof(glm::vec3),
+                        (paths.dirtyEnd - paths.dirtyFirst) * sizeof(glm::vec3), &paths.vertices[paths.dirtyFirst]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    paths.dirtyFirst = paths.dirtyEnd = 0;
+
+    if (paths.batchesDirty)
+        rebuildBatches(paths);
+
+    statsBindVertexArray(paths.vao);
+    for (size_t i = 0; i < paths.batchColors.size(); ++i)
+    {
+        if (paths.batchFirsts[i].empty())
+            continue;
+        glUniform3fv(colorLocation, 1, &paths.batchColors[i].x);
+        statsMultiDrawArrays(GL_LINE_STRIP, paths.batchFirsts[i].data(), paths.batchCounts[i].data(),
+                             static_cast<GLsizei>(paths.batchFirsts[i].size()));
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Orbit tracks drawn as line strips from one shared vertex buffer. Each
+// conic is sampled adaptively: segments are split where the curve bends
+// away from its chord by more than a tolerance, so tight periapsis passes
+// get many vertices and gentle arcs few. A track is resampled only when its
+// elements change; it is rewritten in place if it still fits its block of
+// the buffer, and otherwise moves to the end. The buffer is repacked when
+// full. All tracks of one color are drawn with a single glMultiDrawArrays.
+
+// Conic with a focus at the origin: r(nu) = semiLatusRectum / (1 + eccentricity * cos(nu)),
+// at angle nu from periapsis in the plane spanned by periapsis and ahead
+struct OrbitElements
+{
+    float semiLatusRectum;
+    float eccentricity;    // < 1 closed ellipse, >= 1 open arc clipped at ORBIT_MAX_RADIUS
+    glm::vec3 periapsis;   // unit vector towards periapsis
+    glm::vec3 ahead;       // unit vector 90 degrees ahead of periapsis, in the direction of motion
+};
+
+// Elements from the classical angles (radians): inclination, longitude of
+// the ascending node and argument of periapsis, about the Z axis
+OrbitElements orbitElementsFromAngles(float semiLatusRectum, float eccentricity, float inclination,
+                                      float ascendingNode, float argumentOfPeriapsis);
+
+const float ORBIT_TOLERANCE = 0.003f; // largest chord-to-curve distance (about half a pixel at the default camera)
+const float ORBIT_MAX_RADIUS = 12.0f; // open orbits are drawn out to this distance
+
+struct OrbitTrack
+{
+    OrbitElements elements;
+    glm::vec3 color;
+    int first;    // first vertex in the shared buffer
+    int count;    // vertices in use
+    int reserved; // vertices set aside for this track
+};
+
+struct OrbitPaths
+{
+    GLuint vao = 0;
+    GLuint vertexBuffer = 0;
+    int capacity = 0;                // vertices the GL buffer holds
+    int used = 0;                    // vertices handed out to tracks
+    std::vector<glm::vec3> vertices; // CPU copy of the buffer, for in-place rewrites and repacking
+    std::vector<OrbitTrack> tracks;
+    int dirtyFirst = 0; // vertex range to upload before the next draw
+    int dirtyEnd = 0;
+    bool reallocate = false;  // the GL buffer must be recreated at capacity
+    bool batchesDirty = true; // a track moved; rebuild the draw lists
+    // One multi-draw list per color
+    std::vector<glm::vec3> batchColors;
+    std::vector<std::vector<GLint>> batchFirsts;
+    std::vector<std::vector<GLsizei>> batchCounts;
+    std::vector<glm::vec3> scratch; // sampling output
+    int resamples = 0;               // tracks sampled since init, for reporting
+};
+
+bool orbitPathsInit(OrbitPaths &paths, int initialVertices);
+void orbitPathsDestroy(OrbitPaths &paths);
+
+// Returns the track id
+int orbitPathsAdd(OrbitPaths &paths, const OrbitElements &elements, const glm::vec3 &color);
+
+// Resample a track only if its elements differ from the cached ones
+void orbitPathsUpdate(OrbitPaths &paths, int track, const OrbitElements &elements);
+
+// Upload changed vertices and draw every track. The orbit program must be in
+// use; colorLocation is its vec3 color uniform.
+void orbitPathsDraw(OrbitPaths &paths, GLint colorLocation);
+
+// Sample one conic into out (replacing its contents)
+void sampleOrbit(const OrbitElements &elements, float tolerance, std::vector<glm::vec3> &out);
@@ -0,0 +1,336 @@
+#include "pc.h"
+#include "job_graph.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    const int PC_NODES = 64;
+    const int MONTE_CARLO_SLICES = 8;
+
+    double dot(const double a[3], const double b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    void cross(const double a[3], const double b[3], double out[3])
+    {
+        out[0] = a[1] * b[2] - a[2] * b[1];
+        out[1] = a[2] * b[0] - a[0] * b[2];
+        out[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    void normalize(double v[3])
+    {
+        double length = std::sqrt(dot(v, v));
+        for (int axis = 0; axis < 3; ++axis)
+            v[axis] /= length;
+    }
+
+    // Gauss-Legendre rule in phi over [-pi/2, pi/2], where x = R sin(phi)
+    // takes the sqrt(R^2 - x^2) edge of the circle out of the integrand
+    struct CircleRule
+    {
+        double sine[PC_NODES], cosine[PC_NODES], weight[PC_NODES];
+
+        CircleRule()
+        {
+            // Roots of P_n by Newton's method from the usual estimates
+            for (int i = 0; i < PC_NODES / 2; ++i)
+            {
+                double x = std::cos(M_PI * (i + 0.75) / (PC_NODES + 0.5));
+                double derivative = 1.0;
+                for (int iteration = 0; iteration < 100; ++iteration)
+                {
+                    double previous = 1.0, current = x;
+                    for (int n = 2; n <= PC_NODES; ++n)
+                    {
+                        double next = ((2 * n - 1) * x * current - (n - 1) * previous) / n;
+                        previous = current;
+                        current = next;
+                    }
+                    derivative = PC_NODES * (x * current - previous) / (x * x - 1.0);
+                    double step = current / derivative;
+                    x -= step;
+                    if (std::fabs(step) < 1e-15)
+                        break;
+                }
+                double w = 2.0 / ((1.0 - x * x) * derivative * derivative);
+                for (int side = 0; side < 2; ++side)
+                {
+                    int k = side == 0 ? i : PC_NODES - 1 - i;
+                    double phi = 0.5 * M_PI * (side == 0 ? -x : x);
+                    sine[k] = std::sin(phi);
+                    cosine[k] = std::cos(phi);
+                    weight[k] = 0.5 * M_PI * w;
+                }
+            }
+        }
+    };
+
+    // erf(a) - erf(b) for a >= b, taken from the tails so that a small
+    // difference far from the centre keeps its digits: the signs cancel
+    // exactly when a and b are on the same side
+    inline double erfDifference(double a, double b)
+    {
+        double tailA = std::erfc(std::fabs(a));
+        double tailB = std::erfc(std::fabs(b));
+        double signA = std::copysign(1.0, a), signB = std::copysign(1.0, b);
+        return (signA - signB) + (signB * tailB - signA * tailA);
+    }
+
+    // A conjunction in the principal axes of its encounter plane, km;
+    // sigmaX is the larger sigma
+    struct EncounterPlane
+    {
+        double sigmaX, sigmaY;
+        double missX, missY;
+        double radius;
+    };
+
+    // RTN covariance to TEME, about the object's own position and velocity
+    void addInertialCovariance(const double position[3], const double velocity[3], const RtnCovariance &c,
+                               double out[3][3])
+    {
+        double axes[3][3];
+        std::copy(position, position + 3, axes[0]);
+        normalize(axes[0]);
+        cross(position, velocity, axes[2]);
+        normalize(axes[2]);
+        cross(axes[2], axes[0], axes[1]);
+        const double rtn[3][3] = {{c.rr, c.rt, c.rn}, {c.rt, c.tt, c.tn}, {c.rn, c.tn, c.nn}};
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                for (int a = 0; a < 3; ++a)
+                {
+                    for (int b = 0; b < 3; ++b)
+                        out[i][j] += axes[a][i] * rtn[a][b] * axes[b][j];
+                }
+            }
+        }
+    }
+
+    // Encounter frame: z along the relative velocity, x along the miss
+    void encounterAxes(const Conjunction &c, double relative[3], double x[3], double y[3], double z[3])
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            relative[axis] = c.position[0][axis] - c.position[1][axis];
+            z[axis] = c.velocity[0][axis] - c.velocity[1][axis];
+        }
+        normalize(z);
+        double along = dot(relative, z);
+        for (int axis = 0; axis < 3; ++axis)
+            x[axis] = relative[axis] - along * z[axis];
+        if (dot(x, x) < 1e-24)
+        {
+            // A direct hit: any direction across the relative velocity will do
+            double pick[3] = {0.0, 0.0, 0.0};
+            pick[std::fabs(z[0]) < 0.5 ? 0 : std::fabs(z[1]) < 0.5 ? 1 : 2] = 1.0;
+            cross(z, pick, x);
+        }
+        normalize(x);
+        cross(z, x, y);
+    }
+
+    EncounterPlane encounterPlane(const Conjunction &c, const RtnCovariance &first, const RtnCovariance &second,
+                                  double radius)
+    {
+        double combined[3][3] = {};
+        addInertialCovariance(c.position[0], c.velocity[0], first, combined);
+        addInertialCovariance(c.position[1], c.velocity[1], second, combined);
+
+        double relative[3], x[3], y[3], z[3];
+        encounterAxes(c, relative, x, y, z);
+        double cx[3], cy[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            cx[i] = dot(combined[i], x);
+            cy[i] = dot(combined[i], y);
+        }
+        double pxx = dot(x, cx), pxy = dot(x, cy), pyy = dot(y, cy);
+
+        double mean = 0.5 * (pxx + pyy);
+        double spread = std::sqrt(0.25 * (pxx - pyy) * (pxx - pyy) + pxy * pxy);
+        double theta = 0.5 * std::atan2(2.0 * pxy, pxx - pyy);
+        double miss = dot(relative, x);
+
+        EncounterPlane plane;
+        plane.sigmaX = std::sqrt(std::max(mean + spread, 1e-16));
+        plane.sigmaY = std::sqrt(std::max(mean - spread, 1e-16));
+        plane.missX = miss * std::cos(theta);
+        plane.missY = -miss * std::sin(theta);
+        plane.radius = radius;
+        return plane;
+    }
+
+    // Alfano's form of the Foster integral:
+    //   Pc = 1 / (sqrt(8 pi) sx) * integral over |x| < R of
+    //        exp(-(x - mx)^2 / (2 sx^2)) * (erf((my + h) / (sqrt2 sy)) - erf((my - h) / (sqrt2 sy))) dx
+    // with h = sqrt(R^2 - x^2); every lane runs the same nodes
+    void pcBatch(const EncounterPlane planes[PC_LANES], double pc[PC_LANES])
+    {
+        static const CircleRule rule;
+        const int L = PC_LANES;
+        double radius[L], missX[L], missY[L], gaussScale[L], erfScale[L];
+        for (int i = 0; i < L; ++i)
+        {
+            radius[i] = planes[i].radius;
+            missX[i] = planes[i].missX;
+            missY[i] = planes[i].missY;
+            gaussScale[i] = -0.5 / (planes[i].sigmaX * planes[i].sigmaX);
+            erfScale[i] = M_SQRT1_2 / planes[i].sigmaY;
+            pc[i] = 0.0;
+        }
+        for (int k = 0; k < PC_NODES; ++k)
+        {
+            double weight = rule.weight[k] * rule.cosine[k];
+            for (int i = 0; i < L; ++i)
+            {
+                double x = radius[i] * rule.sine[k] - missX[i];
+                double h = radius[i] * rule.cosine[k];
+                double across = erfDifference((missY[i] + h) * erfScale[i], (missY[i] - h) * erfScale[i]);
+                pc[i] += weight * std::exp(x * x * gaussScale[i]) * across;
+            }
+        }
+        for (int i = 0; i < L; ++i)
+            pc[i] *= radius[i] / (std::sqrt(8.0 * M_PI) * planes[i].sigmaX);
+    }
+
+    // Lower Cholesky factor of a covariance; directions with no variance stay zero
+    void cholesky(const double c[3][3], double l[3][3])
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                l[i][j] = 0.0;
+                if (j > i)
+                    continue;
+                double sum = c[i][j];
+                for (int k = 0; k < j; ++k)
+                    sum -= l[i][k] * l[j][k];
+                if (i == j)
+                    l[i][i] = sum > 0.0 ? std::sqrt(sum) : 0.0;
+                else
+                    l[i][j] = l[j][j] > 0.0 ? sum / l[j][j] : 0.0;
+            }
+        }
+    }
+
+    struct MonteCarloRun
+    {
+        double miss[3];           // relative position at TCA, km
+        double direction[3];      // unit relative velocity
+        double factors[2][3][3];  // Cholesky factors of the two TEME covariances
+        double radiusSquared;
+        unsigned int seed;
+        uint64_t samples[MONTE_CARLO_SLICES];
+        uint64_t hits[MONTE_CARLO_SLICES];
+    };
+
+    struct MonteCarloSlice
+    {
+        MonteCarloRun *run;
+        int index;
+    };
+
+    void monteCarloJob(void *context)
+    {
+        MonteCarloSlice &slice = *static_cast<MonteCarloSlice *>(context);
+        MonteCarloRun &run = *slice.run;
+        std::seed_seq sequence{run.seed, static_cast<unsigned int>(slice.index)};
+        std::mt19937_64 random(sequence);
+        std::normal_distribution<double> normal;
+
+        uint64_t hits = 0;
+        for (uint64_t sample = 0; sample < run.samples[slice.index]; ++sample)
+        {
+            double relative[3] = {run.miss[0], run.miss[1], run.miss[2]};
+            for (int object = 0; object < 2; ++object)
+            {
+                double sign = object == 0 ? 1.0 : -1.0;
+                double draw[3] = {normal(random), normal(random), normal(random)};
+                for (int i = 0; i < 3; ++i)
+                    relative[i] += sign * dot(run.factors[object][i], draw);
+            }
+            // Closest approach of the straight-line pass through this offset
+            double along = dot(relative, run.direction);
+            hits += dot(relative, relative) - along * along < run.radiusSquared;
+        }
+        run.hits[slice.index] = hits;
+    }
+}
+
+RtnCovariance diagonalCovariance(double radialKm, double inTrackKm, double crossTrackKm)
+{
+    RtnCovariance c = {};
+    c.rr = radialKm * radialKm;
+    c.tt = inTrackKm * inTrackKm;
+    c.nn = crossTrackKm * crossTrackKm;
+    return c;
+}
+
+void collisionProbabilities(const std::vector<Conjunction> &conjunctions, const std::vector<RtnCovariance> &covariances,
+                            const std::vector<double> &radiusKm, std::vector<double> &pc)
+{
+    pc.assign(conjunctions.size(), 0.0);
+    EncounterPlane planes[PC_LANES];
+    double lanePc[PC_LANES];
+    for (size_t start = 0; start < conjunctions.size(); start += PC_LANES)
+    {
+        // Unused lanes repeat the last conjunction
+        size_t count = std::min(conjunctions.size() - start, static_cast<size_t>(PC_LANES));
+        for (size_t lane = 0; lane < PC_LANES; ++lane)
+        {
+            const Conjunction &c = conjunctions[start + std::min(lane, count - 1)];
+            planes[lane] = encounterPlane(c, covariances[c.first], covariances[c.second],
+                                          radiusKm[c.first] + radiusKm[c.second]);
+        }
+        pcBatch(planes, lanePc);
+        std::copy(lanePc, lanePc + count, pc.begin() + start);
+    }
+}
+
+MonteCarloPc monteCarloPc(const Conjunction &conjunction, const RtnCovariance &first, const RtnCovariance &second,
+                          double hardBodyRadiusKm, uint64_t samples, unsigned int seed)
+{
+    MonteCarloRun run;
+    double x[3], y[3];
+    encounterAxes(conjunction, run.miss, x, y, run.direction);
+    const RtnCovariance *covariances[2] = {&first, &second};
+    for (int object = 0; object < 2; ++object)
+    {
+        double inertial[3][3] = {};
+        addInertialCovariance(conjunction.position[object], conjunction.velocity[object], *covariances[object],
+                              inertial);
+        cholesky(inertial, run.factors[object]);
+    }
+    run.radiusSquared = hardBodyRadiusKm * hardBodyRadiusKm;
+    run.seed = seed;
+
+    JobGraph graph("monteCarloPc");
+    MonteCarloSlice slices[MONTE_CARLO_SLICES];
+    for (int i = 0; i < MONTE_CARLO_SLICES; ++i)
+    {
+        run.samples[i] = samples * (i + 1) / MONTE_CARLO_SLICES - samples * i / MONTE_CARLO_SLICES;
+        run.hits[i] = 0;
+        slices[i] = {&run, i};
+        graph.addJob("monteCarloPc", monteCarloJob, &slices[i]);
+    }
+    graph.run();
+
+    MonteCarloPc result = {};
+    result.samples = samples;
+    for (int i = 0; i < MONTE_CARLO_SLICES; ++i)
+        result.hits += run.hits[i];
+    if (samples > 0)
+    {
+        result.pc = static_cast<double>(result.hits) / samples;
+        result.standardError = std::sqrt(result.pc * (1.0 - result.pc) / samples);
+    }
+    return result;
+}
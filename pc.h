@@ -0,0 +1,51 @@
+#pragma once
+
+#include "conjunction.h"
+#include <cstdint>
+#include <vector>
+
+// Probability of collision (Pc) of screened conjunctions, from each
+// object's position covariance and hard-body radius at TCA.
+//
+// The 2D method (Foster, in Alfano's one-dimensional form) assumes a short
+// encounter: relative motion is a straight line, so the combined covariance
+// is projected onto the plane normal to the relative velocity and the Pc is
+// the Gaussian's mass inside the combined hard-body circle around the miss.
+// Along the principal axis with the larger sigma the integral is taken by
+// Gauss-Legendre quadrature, across it by erf. PC_LANES conjunctions go
+// through the same nodes together with no per-lane branches, so their
+// library calls overlap. It stays accurate while that larger sigma is above
+// about a tenth of the radius.
+//
+// The Monte Carlo cross-check samples both objects' positions from their
+// covariances and counts the straight-line passes inside the radius, split
+// across job graph slices.
+
+const int PC_LANES = 8;
+
+// Symmetric position covariance at TCA in the object's radial, in-track
+// and cross-track frame, km^2
+struct RtnCovariance
+{
+    double rr, rt, rn;
+    double tt, tn;
+    double nn;
+};
+
+RtnCovariance diagonalCovariance(double radialKm, double inTrackKm, double crossTrackKm);
+
+// One Pc per conjunction. covariances and radiusKm are per element table
+// row; a pair's hard-body radius is the sum of its objects'.
+void collisionProbabilities(const std::vector<Conjunction> &conjunctions, const std::vector<RtnCovariance> &covariances,
+                            const std::vector<double> &radiusKm, std::vector<double> &pc);
+
+struct MonteCarloPc
+{
+    double pc;
+    double standardError;
+    uint64_t hits;
+    uint64_t samples;
+};
+
+MonteCarloPc monteCarloPc(const Conjunction &conjunction, const RtnCovariance &first, const RtnCovariance &second,
+                          double hardBodyRadiusKm, uint64_t samples, unsigned int seed);
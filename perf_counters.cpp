@@ -0,0 +1,245 @@
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct StageTotals
+    {
+        const char *name;
+        uint64_t calls;
+        double values[PERF_COUNTER_COUNT];
+    };
+
+    const char *COUNTER_NAMES[PERF_COUNTER_COUNT] = {
+        "cycles", "instructions", "L1D read misses", "LLC references", "LLC misses", "branches", "branch misses"};
+
+    bool gPerfEnabled = false;
+    std::mutex gStageMutex;
+    std::vector<StageTotals> gStages;
+
+#ifdef __linux__
+    // One counter group per thread; slot[i] maps the group read order to a PerfCounterId
+    struct ThreadCounters
+    {
+        int leaderFd = -1;
+        std::vector<int> fds;
+        std::vector<int> slots;
+        bool opened = false;
+
+        ~ThreadCounters()
+        {
+            for (int fd : fds)
+                close(fd);
+        }
+    };
+
+    thread_local ThreadCounters tCounters;
+
+    void describeCounter(int id, perf_event_attr &attr)
+    {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        switch (id)
+        {
+        case PERF_CYCLES:
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_LLC_REFERENCES:
+            attr.config = PERF_COUNT_HW_CACHE_REFERENCES;
+            break;
+        case PERF_LLC_MISSES:
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_BRANCHES:
+            attr.config = PERF_COUNT_HW_BRANCH_INSTRUCTIONS;
+            break;
+        case PERF_BRANCH_MISSES:
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        }
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    }
+
+    int openCounter(perf_event_attr &attr, int groupFd)
+    {
+        // pid 0 / cpu -1: count the calling thread on any CPU
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+
+    // Open the calling thread's group on first use; counters the PMU lacks are skipped
+    bool openThreadCounters()
+    {
+        ThreadCounters &counters = tCounters;
+        if (counters.opened)
+            return counters.leaderFd >= 0;
+        counters.opened = true;
+
+        for (int id = 0; id < PERF_COUNTER_COUNT; ++id)
+        {
+            perf_event_attr attr;
+            describeCounter(id, attr);
+            attr.disabled = id == PERF_CYCLES ? 1 : 0;
+            int fd = openCounter(attr, counters.leaderFd);
+            if (fd < 0)
+            {
+                if (id == PERF_CYCLES)
+                    return false;
+                continue;
+            }
+            if (id == PERF_CYCLES)
+                counters.leaderFd = fd;
+            counters.fds.push_back(fd);
+            counters.slots.push_back(id);
+        }
+
+        ioctl(counters.leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters.leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        return true;
+    }
+#endif
+}
+
+void perfCountersInit()
+{
+#ifdef __linux__
+    const char *env = getenv("ORBITAL_PERF_COUNTERS");
+    if (!env || strcmp(env, "1") != 0)
+        return;
+
+    gPerfEnabled = openThreadCounters();
+    if (!gPerfEnabled)
+        std::cerr << "ERROR::PERF::PERF_EVENT_OPEN_FAILED " << strerror(errno)
+                  << " (check /proc/sys/kernel/perf_event_paranoid)" << std::endl;
+#else
+    if (getenv("ORBITAL_PERF_COUNTERS"))
+        std::cerr << "Hardware counters need Linux perf_event, ignoring ORBITAL_PERF_COUNTERS" << std::endl;
+#endif
+}
+
+bool perfCountersEnabled()
+{
+    return gPerfEnabled;
+}
+
+bool perfReadCounters(PerfSample &sample)
+{
+    sample.valid = false;
+#ifdef __linux__
+    if (!openThreadCounters())
+        return false;
+
+    ThreadCounters &counters = tCounters;
+    uint64_t buffer[3 + PERF_COUNTER_COUNT];
+    ssize_t expected = static_cast<ssize_t>((3 + counters.slots.size()) * sizeof(uint64_t));
+    if (read(counters.leaderFd, buffer, sizeof(buffer)) != expected)
+        return false;
+
+    memset(sample.values, 0, sizeof(sample.values));
+    for (size_t i = 0; i < counters.slots.size(); ++i)
+        sample.values[counters.slots[i]] = buffer[3 + i];
+    sample.timeEnabled = buffer[1];
+    sample.timeRunning = buffer[2];
+    sample.valid = true;
+#endif
+    return sample.valid;
+}
+
+void perfAccumulateStage(const char *name, const PerfSample &begin, const PerfSample &end)
+{
+    // Scale up when the kernel multiplexed the group off the PMU for part of the stage
+    uint64_t enabled = end.timeEnabled - begin.timeEnabled;
+    uint64_t running = end.timeRunning - begin.timeRunning;
+    double scale = running > 0 ? static_cast<double>(enabled) / running : 1.0;
+
+    std::lock_guard<std::mutex> lock(gStageMutex);
+    StageTotals *stage = nullptr;
+    for (StageTotals &candidate : gStages)
+    {
+        if (candidate.name == name || strcmp(candidate.name, name) == 0)
+        {
+            stage = &candidate;
+            break;
+        }
+    }
+    if (!stage)
+    {
+        gStages.push_back(StageTotals());
+        stage = &gStages.back();
+        memset(stage, 0, sizeof(*stage));
+        stage->name = name;
+    }
+
+    ++stage->calls;
+    for (int id = 0; id < PERF_COUNTER_COUNT; ++id)
+        stage->values[id] += (end.values[id] - begin.values[id]) * scale;
+}
+
+void perfPrintSummary()
+{
+    if (!gPerfEnabled)
+        return;
+
+    std::lock_guard<std::mutex> lock(gStageMutex);
+    std::cerr << "\nHardware counters per stage (per call, inclusive of nested stages)\n";
+    std::cerr << std::left << std::setw(18) << "stage" << std::right << std::setw(10) << "calls"
+              << std::setw(14) << "cycles" << std::setw(14) << "instr" << std::setw(8) << "IPC"
+              << std::setw(12) << "L1D MPKI" << std::setw(12) << "LLC miss%" << std::setw(12) << "br miss%"
+              << "\n";
+    std::cerr << std::fixed;
+    for (const StageTotals &stage : gStages)
+    {
+        double calls = static_cast<double>(stage.calls);
+        const double *v = stage.values;
+        double ipc = v[PERF_CYCLES] > 0 ? v[PERF_INSTRUCTIONS] / v[PERF_CYCLES] : 0.0;
+        double l1dMpki = v[PERF_INSTRUCTIONS] > 0 ? v[PERF_L1D_MISSES] * 1000.0 / v[PERF_INSTRUCTIONS] : 0.0;
+        double llcMissRate = v[PERF_LLC_REFERENCES] > 0 ? v[PERF_LLC_MISSES] * 100.0 / v[PERF_LLC_REFERENCES] : 0.0;
+        double branchMissRate = v[PERF_BRANCHES] > 0 ? v[PERF_BRANCH_MISSES] * 100.0 / v[PERF_BRANCHES] : 0.0;
+
+        std::cerr << std::left << std::setw(18) << stage.name << std::right << std::setw(10) << stage.calls
+                  << std::setprecision(0) << std::setw(14) << v[PERF_CYCLES] / calls << std::setw(14)
+                  << v[PERF_INSTRUCTIONS] / calls << std::setprecision(2) << std::setw(8) << ipc << std::setw(12)
+                  << l1dMpki << std::setw(12) << llcMissRate << std::setw(12) << branchMissRate << "\n";
+    }
+
+    // Counters that could not be opened read as zero; say so instead of reporting perfect hit rates
+    bool anyZero = false;
+    for (int id = 0; id < PERF_COUNTER_COUNT && !gStages.empty(); ++id)
+    {
+        bool zero = true;
+        for (const StageTotals &stage : gStages)
+            zero = zero && stage.values[id] == 0.0;
+        if (zero)
+        {
+            std::cerr << (anyZero ? ", " : "Unavailable counters: ") << COUNTER_NAMES[id];
+            anyZero = true;
+        }
+    }
+    if (anyZero)
+        std::cerr << "\n";
+    std::cerr.unsetf(std::ios::fixed);
+    std::cerr << std::flush;
+}
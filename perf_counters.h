@@ -0,0 +1,72 @@
+#pragma once
+
+#include "profiler.h"
+#include <cstdint>
+
+// Per-stage hardware counters via Linux perf_event_open.
+// Compiled into PROFILE=1 builds on Linux and switched on at runtime with
+// ORBITAL_PERF_COUNTERS=1. Counts are inclusive of nested stages and are
+// summarized per stage at exit.
+
+enum PerfCounterId
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_REFERENCES,
+    PERF_LLC_MISSES,
+    PERF_BRANCHES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+// Snapshot of the calling thread's counters
+struct PerfSample
+{
+    uint64_t values[PERF_COUNTER_COUNT];
+    uint64_t timeEnabled;
+    uint64_t timeRunning;
+    bool valid;
+};
+
+// Read ORBITAL_PERF_COUNTERS and probe perf_event_open support
+void perfCountersInit();
+bool perfCountersEnabled();
+
+bool perfReadCounters(PerfSample &sample);
+void perfAccumulateStage(const char *name, const PerfSample &begin, const PerfSample &end);
+
+// Print cycles, IPC, cache and branch miss rates per stage
+void perfPrintSummary();
+
+// RAII helper measuring one stage on the calling thread
+struct PerfStageScope
+{
+    const char *name;
+    PerfSample begin;
+
+    explicit PerfStageScope(const char *stageName) : name(stageName)
+    {
+        begin.valid = perfCountersEnabled() && perfReadCounters(begin);
+    }
+
+    ~PerfStageScope()
+    {
+        if (!begin.valid)
+            return;
+        PerfSample end;
+        if (perfReadCounters(end))
+            perfAccumulateStage(name, begin, end);
+    }
+};
+
+#if defined(ENABLE_PROFILER) && defined(__linux__)
+#define PERF_STAGE(name) PerfStageScope PROFILE_CONCAT(perfStage, __LINE__)(name)
+#else
+#define PERF_STAGE(name) ((void)0)
+#endif
+
+// Profiler zone plus hardware counters for a pipeline stage
+#define PROFILE_STAGE(name) \
+    PROFILE_ZONE(name);     \
+    PERF_STAGE(name)
@@ -0,0 +1,257 @@
+#include "profiler.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+std::atomic<bool> gProfilerCapturing(false);
+
+namespace
+{
+    // Single-producer/single-consumer ring owned by one recording thread
+    struct ThreadRing
+    {
+        static const size_t CAPACITY = 1 << 14;
+
+        ProfileEvent events[CAPACITY];
+        std::atomic<size_t> head{0}; // advanced by the owning thread
+        std::atomic<size_t> tail{0}; // advanced by the draining thread
+        std::atomic<uint64_t> dropped{0};
+        int threadId = 0;
+        std::string threadName;
+    };
+
+    struct CapturedEvent
+    {
+        ProfileEvent event;
+        int threadId;
+    };
+
+    const int GPU_TRACK_ID = 1000;
+    const int MAX_TRACKS = 16;
+    const size_t MAX_CAPTURED_EVENTS = 1 << 21;
+
+    std::mutex gRingRegistryMutex;
+    std::vector<ThreadRing *> gRings; // rings live for the whole process
+    thread_local ThreadRing *tRing = nullptr;
+    ThreadRing *gTracks[MAX_TRACKS] = {};
+    std::atomic<int> gTrackCount(0);
+
+    std::vector<CapturedEvent> gCaptured;
+    uint64_t gCaptureStartNs = 0;
+    uint64_t gCaptureDropped = 0;
+
+    void (*gGpuResolver)(bool) = nullptr;
+
+    // Caller must hold gRingRegistryMutex
+    ThreadRing *registerRing()
+    {
+        ThreadRing *ring = new ThreadRing();
+        ring->threadId = static_cast<int>(gRings.size()) + 1;
+        ring->threadName = "thread " + std::to_string(ring->threadId);
+        gRings.push_back(ring);
+        return ring;
+    }
+
+    ThreadRing *threadRing()
+    {
+        if (!tRing)
+        {
+            std::lock_guard<std::mutex> lock(gRingRegistryMutex);
+            tRing = registerRing();
+        }
+        return tRing;
+    }
+
+    void pushToRing(ThreadRing *ring, const char *name, uint64_t startNs, uint64_t endNs)
+    {
+        size_t head = ring->head.load(std::memory_order_relaxed);
+        size_t tail = ring->tail.load(std::memory_order_acquire);
+        if (head - tail >= ThreadRing::CAPACITY)
+        {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring->events[head & (ThreadRing::CAPACITY - 1)] = {name, startNs, endNs - startNs};
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    void pushCaptured(const ProfileEvent &event, int threadId)
+    {
+        if (gCaptured.size() >= MAX_CAPTURED_EVENTS)
+        {
+            ++gCaptureDropped;
+            return;
+        }
+        gCaptured.push_back({event, threadId});
+    }
+
+    // Move everything recorded so far into the capture buffer
+    void drainRings()
+    {
+        std::lock_guard<std::mutex> lock(gRingRegistryMutex);
+        for (ThreadRing *ring : gRings)
+        {
+            size_t tail = ring->tail.load(std::memory_order_relaxed);
+            size_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail)
+            {
+                pushCaptured(ring->events[tail & (ThreadRing::CAPACITY - 1)], ring->threadId);
+            }
+            ring->tail.store(tail, std::memory_order_release);
+            gCaptureDropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+        }
+    }
+
+    void writeJsonString(std::ostream &out, const char *text)
+    {
+        out << '"';
+        for (const char *c = text; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+
+    bool writeTrace(const char *path)
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            std::cerr << "ERROR::PROFILER::CANNOT_OPEN " << path << std::endl;
+            return false;
+        }
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GPU_TRACK_ID
+            << ",\"args\":{\"name\":\"GPU\"}}";
+        {
+            std::lock_guard<std::mutex> lock(gRingRegistryMutex);
+            for (const ThreadRing *ring : gRings)
+            {
+                out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadId
+                    << ",\"args\":{\"name\":";
+                writeJsonString(out, ring->threadName.c_str());
+                out << "}}";
+            }
+        }
+
+        out.setf(std::ios::fixed);
+        out.precision(3);
+        for (const CapturedEvent &captured : gCaptured)
+        {
+            double ts = (captured.event.startNs - gCaptureStartNs) / 1000.0;
+            double dur = captured.event.durationNs / 1000.0;
+            out << ",\n{\"name\":";
+            writeJsonString(out, captured.event.name);
+            out << ",\"cat\":\"" << (captured.threadId == GPU_TRACK_ID ? "gpu" : "cpu")
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << captured.threadId
+                << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+}
+
+uint64_t profilerNowNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+void profilerSetThreadName(const char *name)
+{
+    ThreadRing *ring = threadRing();
+    std::lock_guard<std::mutex> lock(gRingRegistryMutex);
+    ring->threadName = name;
+}
+
+void profilerRecord(const char *name, uint64_t startNs, uint64_t endNs)
+{
+    pushToRing(threadRing(), name, startNs, endNs);
+}
+
+int profilerCreateTrack(const char *name)
+{
+    std::lock_guard<std::mutex> lock(gRingRegistryMutex);
+    int track = gTrackCount.load(std::memory_order_relaxed);
+    if (track >= MAX_TRACKS)
+        return -1;
+
+    ThreadRing *ring = registerRing();
+    ring->threadName = name;
+    gTracks[track] = ring;
+    gTrackCount.store(track + 1, std::memory_order_release);
+    return track;
+}
+
+void profilerRecordOnTrack(int track, const char *name, uint64_t startNs, uint64_t endNs)
+{
+    if (track < 0 || track >= gTrackCount.load(std::memory_order_acquire))
+        return;
+    pushToRing(gTracks[track], name, startNs, endNs);
+}
+
+void profilerStartCapture()
+{
+    if (gProfilerCapturing.load())
+        return;
+
+    // Throw away anything recorded before the capture started
+    drainRings();
+    gCaptured.clear();
+    gCaptureDropped = 0;
+    gCaptureStartNs = profilerNowNs();
+    gProfilerCapturing.store(true);
+    std::cout << "Profiler capture started" << std::endl;
+}
+
+bool profilerStopCapture(const char *path)
+{
+    if (!gProfilerCapturing.load())
+        return false;
+
+    drainRings();
+    if (gGpuResolver)
+        gGpuResolver(true);
+    gProfilerCapturing.store(false);
+
+    bool written = writeTrace(path);
+    std::cout << "Profiler capture: " << gCaptured.size() << " zones written to " << path;
+    if (gCaptureDropped > 0)
+        std::cout << " (" << gCaptureDropped << " dropped)";
+    std::cout << std::endl;
+
+    gCaptured.clear();
+    gCaptured.shrink_to_fit();
+    return written;
+}
+
+bool profilerIsCapturing()
+{
+    return gProfilerCapturing.load(std::memory_order_relaxed);
+}
+
+void profilerEndFrame()
+{
+    if (gProfilerCapturing.load(std::memory_order_relaxed))
+        drainRings();
+    if (gGpuResolver)
+        gGpuResolver(false);
+}
+
+void profilerSetGpuResolver(void (*resolve)(bool wait))
+{
+    gGpuResolver = resolve;
+}
+
+void profilerRecordGpu(const char *name, uint64_t startNs, uint64_t durationNs)
+{
+    if (gProfilerCapturing.load(std::memory_order_relaxed))
+        pushCaptured({name, startNs, durationNs}, GPU_TRACK_ID);
+}
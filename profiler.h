@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Scoped CPU/GPU profiler with Chrome trace (Perfetto) JSON export.
+// Zones are only compiled in when ENABLE_PROFILER is defined (make PROFILE=1)
+// and only recorded while a capture is running. This part needs no GL; GPU
+// zones live in profiler_gpu.h, so headless tools link without GL.
+
+// Single recorded zone
+struct ProfileEvent
+{
+    const char *name;
+    uint64_t startNs;
+    uint64_t durationNs;
+};
+
+extern std::atomic<bool> gProfilerCapturing;
+
+// Monotonic clock in nanoseconds
+uint64_t profilerNowNs();
+
+// Name the calling thread in the exported trace
+void profilerSetThreadName(const char *name);
+
+// Record a finished CPU zone into the calling thread's ring buffer
+void profilerRecord(const char *name, uint64_t startNs, uint64_t endNs);
+
+// Extra trace track that is not tied to a thread (returns -1 when out of
+// tracks). Each track must only be recorded from one thread at a time.
+int profilerCreateTrack(const char *name);
+void profilerRecordOnTrack(int track, const char *name, uint64_t startNs, uint64_t endNs);
+
+// Capture control; the trace is written when the capture stops
+void profilerStartCapture();
+bool profilerStopCapture(const char *path);
+bool profilerIsCapturing();
+
+// Must be called once per frame on the GL thread (drains rings, resolves GPU queries)
+void profilerEndFrame();
+
+// GPU zone support for profiler_gpu.cpp: a resolver collecting finished
+// queries (all of them with wait set), run by profilerEndFrame and before a
+// capture is written, and the GPU track its zones are recorded on
+void profilerSetGpuResolver(void (*resolve)(bool wait));
+void profilerRecordGpu(const char *name, uint64_t startNs, uint64_t durationNs);
+
+// RAII helper for CPU zones
+struct ProfileScope
+{
+    const char *name;
+    uint64_t startNs;
+
+    explicit ProfileScope(const char *zoneName)
+        : name(zoneName),
+          startNs(gProfilerCapturing.load(std::memory_order_relaxed) ? profilerNowNs() : 0)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if (startNs != 0)
+            profilerRecord(name, startNs, profilerNowNs());
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,83 @@
+#include "profiler_gpu.h"
+#include <GL/glew.h>
+#include <deque>
+#include <vector>
+
+namespace
+{
+    struct PendingGpuQuery
+    {
+        GLuint query;
+        const char *name;
+        uint64_t cpuStartNs;
+    };
+
+    std::vector<GLuint> gFreeQueries;
+    std::deque<PendingGpuQuery> gPendingQueries;
+    PendingGpuQuery gOpenQuery = {0, nullptr, 0};
+    int gGpuDepth = 0;
+
+    // Collect finished GPU queries; with wait set, block until all are available
+    void resolveGpuQueries(bool wait)
+    {
+        while (!gPendingQueries.empty())
+        {
+            PendingGpuQuery &pending = gPendingQueries.front();
+            if (!wait)
+            {
+                GLint available = 0;
+                glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    break;
+            }
+
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsedNs);
+            profilerRecordGpu(pending.name, pending.cpuStartNs, elapsedNs);
+
+            gFreeQueries.push_back(pending.query);
+            gPendingQueries.pop_front();
+        }
+    }
+}
+
+void profilerGpuBegin(const char *name)
+{
+    if (gGpuDepth++ > 0)
+        return;
+
+    GLuint query;
+    if (gFreeQueries.empty())
+    {
+        profilerSetGpuResolver(resolveGpuQueries);
+        glGenQueries(1, &query);
+    }
+    else
+    {
+        query = gFreeQueries.back();
+        gFreeQueries.pop_back();
+    }
+
+    gOpenQuery = {query, name, profilerNowNs()};
+    glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void profilerGpuEnd()
+{
+    if (gGpuDepth == 0 || --gGpuDepth > 0)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    gPendingQueries.push_back(gOpenQuery);
+}
+
+void profilerShutdownGpu()
+{
+    profilerSetGpuResolver(nullptr);
+    for (const PendingGpuQuery &pending : gPendingQueries)
+        glDeleteQueries(1, &pending.query);
+    gPendingQueries.clear();
+    if (!gFreeQueries.empty())
+        glDeleteQueries(static_cast<GLsizei>(gFreeQueries.size()), gFreeQueries.data());
+    gFreeQueries.clear();
+}
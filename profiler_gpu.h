@@ -0,0 +1,37 @@
+#pragma once
+
+#include "profiler.h"
+
+// GPU zones for the profiler (GL_TIME_ELAPSED queries), resolved a few
+// frames late by profilerEndFrame and shown on the trace's GPU track. Only
+// the GL thread may use them.
+
+// Zones cannot nest; nested zones are skipped
+void profilerGpuBegin(const char *name);
+void profilerGpuEnd();
+void profilerShutdownGpu();
+
+// RAII helper for GPU zones
+struct GpuProfileScope
+{
+    bool active;
+
+    explicit GpuProfileScope(const char *zoneName)
+        : active(gProfilerCapturing.load(std::memory_order_relaxed))
+    {
+        if (active)
+            profilerGpuBegin(zoneName);
+    }
+
+    ~GpuProfileScope()
+    {
+        if (active)
+            profilerGpuEnd();
+    }
+};
+
+#ifdef ENABLE_PROFILER
+#define PROFILE_GPU_ZONE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
+#else
+#define PROFILE_GPU_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,218 @@
+#include "satellite_catalog.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    const double MU_KM3_S2 = 398600.8;           // WGS-72, as in the propagator
+    const double LOW_ORBIT_CEILING_KM = 2000.0;
+    const double GEOSYNCHRONOUS_REVS_PER_DAY = 1.0027;
+
+    double revolutionsPerDay(double semiMajorAxisKm)
+    {
+        return std::sqrt(MU_KM3_S2 / (semiMajorAxisKm * semiMajorAxisKm * semiMajorAxisKm)) * 86400.0 / (2.0 * M_PI);
+    }
+
+    float classify(const Sgp4Satellite &satellite)
+    {
+        double revsPerDay = satellite.no * 1440.0 / (2.0 * M_PI);
+        double semiMajorAxisKm = std::cbrt(MU_KM3_S2 / std::pow(satellite.no / 60.0, 2.0));
+        double apogeeKm = semiMajorAxisKm * (1.0 + satellite.ecco) - SGP4_EARTH_RADIUS_KM;
+        if (satellite.ecco > 0.25)
+            return CATALOG_ELLIPTICAL;
+        if (apogeeKm < LOW_ORBIT_CEILING_KM)
+            return CATALOG_LOW;
+        if (std::fabs(revsPerDay - GEOSYNCHRONOUS_REVS_PER_DAY) < 0.05)
+            return CATALOG_GEOSYNCHRONOUS;
+        return CATALOG_MEDIUM;
+    }
+
+    // Scene units and axes (see satellite_catalog.h)
+    glm::vec4 scenePosition(double x, double y, double z, float regime)
+    {
+        const double scale = 1.0 / SGP4_EARTH_RADIUS_KM;
+        return glm::vec4(static_cast<float>(x * scale), static_cast<float>(z * scale), static_cast<float>(-y * scale),
+                         regime);
+    }
+}
+
+void catalogBuild(SatelliteCatalog &catalog, const ElementTable &elements)
+{
+    catalog = SatelliteCatalog();
+    catalog.rejected = elements.rejected;
+    std::vector<Sgp4Satellite> nearEarth;
+    nearEarth.reserve(elementTableSize(elements));
+    catalog.deepSpace.reserve(elementTableSize(elements) / 8);
+
+    Sgp4Satellite satellite;
+    for (int row = 0; row < elementTableSize(elements); ++row)
+    {
+        if (sgp4Init(elementTableRow(elements, row), satellite) != SGP4_OK)
+        {
+            ++catalog.rejected;
+            continue;
+        }
+        if (satellite.deepSpace)
+            catalog.deepSpace.push_back(satellite);
+        else
+            nearEarth.push_back(satellite);
+        catalog.newestEpochJd = std::max(catalog.newestEpochJd, satellite.epochJd);
+    }
+
+    // Unused lanes of the last batch repeat its last satellite
+    catalog.nearEarthCount = static_cast<int>(nearEarth.size());
+    catalog.batches.resize((nearEarth.size() + SGP4_LANES - 1) / SGP4_LANES);
+    for (size_t b = 0; b < catalog.batches.size(); ++b)
+    {
+        Sgp4Batch &batch = catalog.batches[b];
+        batch.count = static_cast<int>(std::min<size_t>(SGP4_LANES, nearEarth.size() - b * SGP4_LANES));
+        for (int lane = 0; lane < SGP4_LANES; ++lane)
+            sgp4BatchSet(batch, lane, nearEarth[b * SGP4_LANES + std::min(lane, batch.count - 1)]);
+    }
+
+    catalog.catalogNumbers.reserve(catalogSize(catalog));
+    catalog.regimes.reserve(catalogSize(catalog));
+    for (const Sgp4Satellite &near : nearEarth)
+    {
+        catalog.catalogNumbers.push_back(near.catalogNumber);
+        catalog.regimes.push_back(classify(near));
+    }
+    for (const Sgp4Satellite &deep : catalog.deepSpace)
+    {
+        catalog.catalogNumbers.push_back(deep.catalogNumber);
+        catalog.regimes.push_back(classify(deep));
+    }
+}
+
+bool catalogLoad(SatelliteCatalog &catalog, const char *path)
+{
+    ElementTable elements;
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (!parseCatalogFile(path, elements, &bytes))
+        return false;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    catalogBuild(catalog, elements);
+    std::cout << "Catalog: " << catalogSize(catalog) << " objects (" << catalog.deepSpace.size()
+              << " deep space) from " << path;
+    if (catalog.rejected > 0)
+        std::cout << ", " << catalog.rejected << " element sets rejected";
+    std::cout << "; read " << bytes / 1.0e6 << " MB in " << elapsed.count() * 1e3 << " ms ("
+              << (elapsed.count() > 0.0 ? bytes / elapsed.count() / 1.0e9 : 0.0) << " GB/s)" << std::endl;
+    return true;
+}
+
+void catalogGenerateElements(ElementTable &elements, int count, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto between = [&](double low, double high) { return low + (high - low) * unit(random); };
+    const double degrees = M_PI / 180.0;
+    const double epochJd = 2460310.5; // 2024 January 1
+
+    elementTableReserve(elements, elementTableSize(elements) + count);
+    for (int i = 0; i < count; ++i)
+    {
+        TleElements element;
+        element.catalogNumber = i + 1;
+        element.epochJd = epochJd - between(0.0, 3.0);
+        element.bstar = 0.0;
+        element.rightAscension = between(0.0, 2.0 * M_PI);
+        element.argumentOfPerigee = between(0.0, 2.0 * M_PI);
+        element.meanAnomaly = between(0.0, 2.0 * M_PI);
+
+        // Roughly the mix of the public catalog: mostly low orbits, then
+        // the geosynchronous belt, eccentric orbits and navigation constellations
+        double semiMajorAxisKm;
+        double kind = unit(random);
+        if (kind < 0.75)
+        {
+            semiMajorAxisKm = SGP4_EARTH_RADIUS_KM + between(300.0, 1400.0);
+            element.eccentricity = between(0.0, 0.01);
+            double plane = unit(random);
+            element.inclination = (plane < 0.3 ? between(97.0, 99.0) : plane < 0.6 ? 53.0 : between(0.0, 100.0)) * degrees;
+            element.bstar = between(1.0e-5, 5.0e-4);
+        }
+        else if (kind < 0.85)
+        {
+            semiMajorAxisKm = 42164.0 + between(-50.0, 50.0);
+            element.eccentricity = between(0.0, 0.001);
+            element.inclination = between(0.0, 15.0) * degrees;
+        }
+        else if (kind < 0.94)
+        {
+            if (unit(random) < 0.5)
+            {
+                // Molniya
+                semiMajorAxisKm = 26560.0;
+                element.eccentricity = between(0.68, 0.74);
+                element.inclination = 63.4 * degrees;
+                element.argumentOfPerigee = 270.0 * degrees;
+            }
+            else
+            {
+                // Geosynchronous transfer
+                double perigeeKm = SGP4_EARTH_RADIUS_KM + between(250.0, 600.0);
+                double apogeeKm = SGP4_EARTH_RADIUS_KM + 35786.0;
+                semiMajorAxisKm = 0.5 * (perigeeKm + apogeeKm);
+                element.eccentricity = (apogeeKm - perigeeKm) / (apogeeKm + perigeeKm);
+                element.inclination = between(0.0, 28.0) * degrees;
+                element.bstar = between(1.0e-5, 1.0e-4);
+            }
+        }
+        else
+        {
+            semiMajorAxisKm = SGP4_EARTH_RADIUS_KM + between(19000.0, 23500.0);
+            element.eccentricity = between(0.0, 0.01);
+            element.inclination = between(54.0, 65.0) * degrees;
+        }
+        element.meanMotion = revolutionsPerDay(semiMajorAxisKm) * 2.0 * M_PI / 1440.0;
+        elementTableAppend(elements, element);
+    }
+}
+
+void catalogGenerate(SatelliteCatalog &catalog, int count, unsigned int seed)
+{
+    ElementTable elements;
+    catalogGenerateElements(elements, count, seed);
+    catalogBuild(catalog, elements);
+}
+
+void catalogPropagate(SatelliteCatalog &catalog, double jd, int slice, int slices, glm::vec4 *out)
+{
+    double position[3][SGP4_LANES];
+    double velocity[3][SGP4_LANES];
+    int errors[SGP4_LANES];
+
+    // Each slice takes the same share of the batches and of the deep-space objects
+    int batchCount = static_cast<int>(catalog.batches.size());
+    for (int b = batchCount * slice / slices; b < batchCount * (slice + 1) / slices; ++b)
+    {
+        const Sgp4Batch &batch = catalog.batches[b];
+        sgp4PropagateBatch(batch, jd, position, velocity, errors);
+        for (int lane = 0; lane < batch.count; ++lane)
+        {
+            int object = b * SGP4_LANES + lane;
+            out[object] = errors[lane] == SGP4_OK
+                              ? scenePosition(position[0][lane], position[1][lane], position[2][lane],
+                                              catalog.regimes[object])
+                              : glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+        }
+    }
+
+    int deepCount = static_cast<int>(catalog.deepSpace.size());
+    for (int d = deepCount * slice / slices; d < deepCount * (slice + 1) / slices; ++d)
+    {
+        Sgp4Satellite &satellite = catalog.deepSpace[d];
+        double r[3], v[3];
+        int object = catalog.nearEarthCount + d;
+        if (sgp4Propagate(satellite, (jd - satellite.epochJd) * 1440.0, r, v) == SGP4_OK)
+            out[object] = scenePosition(r[0], r[1], r[2], catalog.regimes[object]);
+        else
+            out[object] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "catalog_reader.h"
+#include "sgp4.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Catalog of Earth-orbiting objects from two-line element sets, propagated
+// with SGP4/SDP4 (see sgp4.h). Near-Earth objects are packed SGP4_LANES to
+// a batch and propagated together; deep-space objects (periods of 225
+// minutes and more) keep their own state for the lunar-solar and resonance
+// terms. Propagation splits into independent slices, so a step can spread
+// the catalog over the worker threads.
+//
+// Objects are numbered near-Earth first (batch by batch), then deep space.
+// Positions are in scene units (Earth radii) with the TEME z axis (the
+// Earth's pole) along the scene's y axis: scene = (x, z, -y).
+
+enum CatalogRegime
+{
+    CATALOG_LOW = 0,         // perigee and apogee below 2000 km
+    CATALOG_MEDIUM = 1,      // up to the geosynchronous belt
+    CATALOG_GEOSYNCHRONOUS = 2,
+    CATALOG_ELLIPTICAL = 3,  // highly eccentric (Molniya, transfer orbits)
+};
+
+struct SatelliteCatalog
+{
+    std::vector<Sgp4Batch> batches;          // near-Earth objects
+    std::vector<Sgp4Satellite> deepSpace;
+    std::vector<int> catalogNumbers;         // per object
+    std::vector<float> regimes;              // per object, a CatalogRegime
+    int nearEarthCount = 0;
+    int rejected = 0;                        // element sets that failed to parse or initialize
+    double newestEpochJd = 0.0;
+};
+
+inline int catalogSize(const SatelliteCatalog &catalog)
+{
+    return catalog.nearEarthCount + static_cast<int>(catalog.deepSpace.size());
+}
+
+// Build the catalog from element sets; ones SGP4 rejects are counted and skipped
+void catalogBuild(SatelliteCatalog &catalog, const ElementTable &elements);
+
+// Load a TLE or OMM (KVN or XML) file, see catalog_reader.h; false if it cannot be read
+bool catalogLoad(SatelliteCatalog &catalog, const char *path);
+
+// Element sets with a realistic mix of orbits, for benchmarks without a catalog file
+void catalogGenerateElements(ElementTable &elements, int count, unsigned int seed);
+void catalogGenerate(SatelliteCatalog &catalog, int count, unsigned int seed);
+
+// Propagate slice `slice` of `slices` to the Julian date jd. out holds one
+// entry per object: the position in scene units and the regime, or w = -1
+// if the object could not be propagated (decayed, or its elements broke down).
+// Different slices may run concurrently.
+void catalogPropagate(SatelliteCatalog &catalog, double jd, int slice, int slices, glm::vec4 *out);
+
+// Julian date (UTC) of a Unix time
+inline double julianDateFromUnix(double seconds)
+{
+    return seconds / 86400.0 + 2440587.5;
+}
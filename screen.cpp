@@ -0,0 +1,160 @@
+// Headless conjunction screening of a catalog file or a synthetic catalog,
+// with the collision probability of every conjunction found:
+//   orbital_screen --catalog active.txt --days 7 --threshold 5 --out conjunctions.csv
+#include "conjunction.h"
+#include "job_graph.h"
+#include "pc.h"
+#include "satellite_catalog.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+
+// Element sets carry no covariance, so every object gets the same assumed
+// position sigmas (km) and hard-body radius unless told otherwise
+struct PcOptions
+{
+    double sigmaKm[3] = {0.1, 0.5, 0.1}; // radial, in-track, cross-track
+    double radiusKm = 0.01;
+    uint64_t monteCarloSamples = 0;       // cross-check the highest Pcs when set
+};
+
+static void printUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " (--catalog <file> | --synthetic <count>) [--seed <n>] [--days <d>]"
+              << " [--threshold <km>] [--segment <minutes>] [--start-jd <jd>] [--sigma <radial> <in-track> <cross-track>]"
+              << " [--radius <km>] [--monte-carlo <samples>] [--out <csv>]" << std::endl;
+}
+
+static bool writeConjunctions(const std::string &path, const ElementTable &elements,
+                              const std::vector<Conjunction> &conjunctions, const std::vector<double> &pc)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "ERROR::SCREEN::FILE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    file << "first,second,tca_jd,miss_km,relative_speed_km_s,pc\n";
+    char line[160];
+    for (size_t i = 0; i < conjunctions.size(); ++i)
+    {
+        const Conjunction &c = conjunctions[i];
+        double speed = 0.0;
+        for (int axis = 0; axis < 3; ++axis)
+            speed += (c.velocity[0][axis] - c.velocity[1][axis]) * (c.velocity[0][axis] - c.velocity[1][axis]);
+        snprintf(line, sizeof(line), "%d,%d,%.8f,%.4f,%.4f,%.6e\n", elements.catalogNumber[c.first],
+                 elements.catalogNumber[c.second], c.tcaJd, c.missKm, std::sqrt(speed), pc[i]);
+        file << line;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *catalogPath = nullptr;
+    int synthetic = 0;
+    unsigned int seed = 42;
+    std::string outPath;
+    ScreeningSettings settings;
+    PcOptions pcOptions;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--catalog") && i + 1 < argc)
+            catalogPath = argv[++i];
+        else if (!strcmp(argv[i], "--synthetic") && i + 1 < argc)
+            synthetic = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            seed = static_cast<unsigned int>(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--days") && i + 1 < argc)
+            settings.days = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+            settings.thresholdKm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--segment") && i + 1 < argc)
+            settings.segmentMinutes = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--start-jd") && i + 1 < argc)
+            settings.startJd = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--sigma") && i + 3 < argc)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+                pcOptions.sigmaKm[axis] = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--radius") && i + 1 < argc)
+            pcOptions.radiusKm = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--monte-carlo") && i + 1 < argc)
+            pcOptions.monteCarloSamples = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if ((catalogPath == nullptr) == (synthetic <= 0) || settings.days <= 0.0 || settings.segmentMinutes <= 0.0)
+    {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    ElementTable elements;
+    if (catalogPath && !parseCatalogFile(catalogPath, elements, nullptr))
+        return -1;
+    if (synthetic > 0)
+        catalogGenerateElements(elements, synthetic, seed);
+
+    jobWorkersStart(0);
+    std::vector<Conjunction> conjunctions;
+    ScreeningStats stats;
+    screenConjunctions(elements, settings, conjunctions, stats);
+
+    auto pcStart = std::chrono::steady_clock::now();
+    RtnCovariance covariance = diagonalCovariance(pcOptions.sigmaKm[0], pcOptions.sigmaKm[1], pcOptions.sigmaKm[2]);
+    std::vector<RtnCovariance> covariances(elementTableSize(elements), covariance);
+    std::vector<double> radiusKm(elementTableSize(elements), pcOptions.radiusKm);
+    std::vector<double> pc;
+    collisionProbabilities(conjunctions, covariances, radiusKm, pc);
+    double pcMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pcStart).count();
+
+    printf("Screened %d objects over %.2f days in %d segments: %zu conjunctions under %.2f km in %.1f s\n",
+           stats.objects, settings.days, stats.segments, conjunctions.size(), settings.thresholdKm,
+           stats.wallMs / 1000.0);
+    printf("  pairs            %llu\n", static_cast<unsigned long long>(stats.pairs));
+    printf("  apogee/perigee   %llu\n", static_cast<unsigned long long>(stats.apogeePerigeePairs));
+    printf("  orbit path       %llu\n", static_cast<unsigned long long>(stats.pathPairs));
+    printf("  time windows     %llu\n", static_cast<unsigned long long>(stats.windows));
+    printf("  job time (s)     elements %.2f, sort %.2f, filters %.2f, refinement %.2f\n", stats.stageMs[0] / 1000.0,
+           stats.stageMs[1] / 1000.0, stats.stageMs[2] / 1000.0, stats.stageMs[3] / 1000.0);
+    printf("Pc of %zu conjunctions in %.1f ms (sigmas %.3f/%.3f/%.3f km, hard-body radius %.3f km each)\n",
+           conjunctions.size(), pcMs, pcOptions.sigmaKm[0], pcOptions.sigmaKm[1], pcOptions.sigmaKm[2],
+           pcOptions.radiusKm);
+
+    // The highest Pcs, each checked by Monte Carlo if asked
+    std::vector<size_t> order(conjunctions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return pc[a] > pc[b]; });
+    for (size_t i = 0; i < order.size() && i < 10; ++i)
+    {
+        const Conjunction &c = conjunctions[order[i]];
+        printf("  %6d x %6d  TCA %.6f  miss %.3f km  Pc %.3e", elements.catalogNumber[c.first],
+               elements.catalogNumber[c.second], c.tcaJd, c.missKm, pc[order[i]]);
+        if (pcOptions.monteCarloSamples > 0)
+        {
+            MonteCarloPc check = monteCarloPc(c, covariance, covariance, 2.0 * pcOptions.radiusKm,
+                                              pcOptions.monteCarloSamples, static_cast<unsigned int>(i));
+            printf("  Monte Carlo %.3e +- %.1e", check.pc, check.standardError);
+        }
+        printf("\n");
+    }
+    jobWorkersStop();
+
+    if (!outPath.empty() && !writeConjunctions(outPath, elements, conjunctions, pc))
+        return -1;
+    return 0;
+}
@@ -0,0 +1,1204 @@
+#include "sgp4.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // WGS-72
+    const double MU = 398600.8; // km^3 / s^2
+    const double RADIUS = SGP4_EARTH_RADIUS_KM;
+    const double J2 = 0.001082616;
+    const double J3 = -0.00000253881;
+    const double J4 = -0.00000165597;
+    const double J3OJ2 = J3 / J2;
+
+    const double TWO_PI = 2.0 * M_PI;
+    const double X2O3 = 2.0 / 3.0;
+    const double TEMP4 = 1.5e-12;
+    const double DEG_TO_RAD = M_PI / 180.0;
+    const double MINUTES_PER_DAY = 1440.0;
+
+    double xke()
+    {
+        static const double value = 60.0 / std::sqrt(RADIUS * RADIUS * RADIUS / MU);
+        return value;
+    }
+
+    double velocityKmPerSecond()
+    {
+        return RADIUS * xke() / 60.0;
+    }
+
+    // ---------------------------------------------------------------- TLE fields
+
+    // Columns are 1-based and inclusive, as in the format description
+    bool field(const char *line, size_t length, int first, int last, char *out)
+    {
+        if (static_cast<size_t>(last) > length)
+            return false;
+        memcpy(out, line + first - 1, last - first + 1);
+        out[last - first + 1] = '\0';
+        return true;
+    }
+
+    bool parseDouble(const char *text, double &value)
+    {
+        char *end;
+        value = strtod(text, &end);
+        while (*end == ' ')
+            ++end;
+        return end != text && *end == '\0';
+    }
+
+    // "-12345-6" means -0.12345e-6; the leading sign and the mantissa's digits may be blank
+    bool parseExponential(const char *text, double &value)
+    {
+        char mantissa[16] = "0.";
+        size_t used = 2;
+        const char *p = text;
+        while (*p == ' ')
+            ++p;
+        bool negative = *p == '-';
+        if (*p == '-' || *p == '+')
+            ++p;
+        while (*p >= '0' && *p <= '9' && used < sizeof(mantissa) - 1)
+            mantissa[used++] = *p++;
+        mantissa[used] = '\0';
+        if (*p != '-' && *p != '+')
+            return false;
+        int exponent = (p[1] >= '0' && p[1] <= '9') ? p[1] - '0' : -1;
+        if (exponent < 0)
+            return false;
+        value = strtod(mantissa, nullptr) * std::pow(10.0, *p == '-' ? -exponent : exponent);
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    // Five characters; Alpha-5 numbers start with a letter for 100000 and up (I and O are skipped)
+    bool parseCatalogNumber(const char *text, int &number)
+    {
+        int high = 0;
+        char first = text[0];
+        if (first >= 'A' && first <= 'Z' && first != 'I' && first != 'O')
+            high = 10 + (first - 'A') - (first > 'I') - (first > 'O');
+        else if (first == ' ' || (first >= '0' && first <= '9'))
+            high = first == ' ' ? 0 : first - '0';
+        else
+            return false;
+        double low;
+        if (!parseDouble(text + 1, low))
+            return false;
+        number = high * 10000 + static_cast<int>(low);
+        return true;
+    }
+
+    // Sum of the digits, with 1 for each minus sign, modulo 10
+    bool checksumMatches(const char *line, size_t length)
+    {
+        if (length < 69 || line[68] < '0' || line[68] > '9')
+            return false;
+        int sum = 0;
+        for (int i = 0; i < 68; ++i)
+        {
+            if (line[i] >= '0' && line[i] <= '9')
+                sum += line[i] - '0';
+            else if (line[i] == '-')
+                ++sum;
+        }
+        return sum % 10 == line[68] - '0';
+    }
+
+    // ---------------------------------------------------------------- deep space
+
+    // Lunar-solar terms that depend only on the epoch elements
+    struct DeepSpaceCommon
+    {
+        double snodm, cnodm, sinim, cosim, sinomm, cosomm, day, em, emsq, gam, rtemsq, nm;
+        double s1, s2, s3, s4, s5, s6, s7, ss1, ss2, ss3, ss4, ss5, ss6, ss7;
+        double sz1, sz2, sz3, sz11, sz12, sz13, sz21, sz22, sz23, sz31, sz32, sz33;
+        double z1, z2, z3, z11, z12, z13, z21, z22, z23, z31, z32, z33;
+    };
+
+    void deepSpaceCommon(double epoch, double ep, double argpp, double tc, double inclp, double nodep, double np,
+                         Sgp4Satellite &satellite, DeepSpaceCommon &c)
+    {
+        const double zes = 0.01675, zel = 0.05490;
+        const double c1ss = 2.9864797e-6, c1l = 4.7968065e-7;
+        const double zsinis = 0.39785416, zcosis = 0.91744867;
+        const double zcosgs = 0.1945905, zsings = -0.98088458;
+
+        c.nm = np;
+        c.em = ep;
+        c.snodm = std::sin(nodep);
+        c.cnodm = std::cos(nodep);
+        c.sinomm = std::sin(argpp);
+        c.cosomm = std::cos(argpp);
+        c.sinim = std::sin(inclp);
+        c.cosim = std::cos(inclp);
+        c.emsq = c.em * c.em;
+        double betasq = 1.0 - c.emsq;
+        c.rtemsq = std::sqrt(betasq);
+
+        satellite.peo = 0.0;
+        satellite.pinco = 0.0;
+        satellite.plo = 0.0;
+        satellite.pgho = 0.0;
+        satellite.pho = 0.0;
+        c.day = epoch + 18261.5 + tc / MINUTES_PER_DAY;
+        double xnodce = std::fmod(4.5236020 - 9.2422029e-4 * c.day, TWO_PI);
+        double stem = std::sin(xnodce);
+        double ctem = std::cos(xnodce);
+        double zcosil = 0.91375164 - 0.03568096 * ctem;
+        double zsinil = std::sqrt(1.0 - zcosil * zcosil);
+        double zsinhl = 0.089683511 * stem / zsinil;
+        double zcoshl = std::sqrt(1.0 - zsinhl * zsinhl);
+        c.gam = 5.8351514 + 0.0019443680 * c.day;
+        double zx = 0.39785416 * stem / zsinil;
+        double zy = zcoshl * ctem + 0.91744867 * zsinhl * stem;
+        zx = std::atan2(zx, zy);
+        zx = c.gam + zx - xnodce;
+        double zcosgl = std::cos(zx);
+        double zsingl = std::sin(zx);
+
+        // Solar terms first, then lunar
+        double zcosg = zcosgs, zsing = zsings, zcosi = zcosis, zsini = zsinis;
+        double zcosh = c.cnodm, zsinh = c.snodm;
+        double cc = c1ss;
+        double xnoi = 1.0 / c.nm;
+        for (int body = 1; body <= 2; ++body)
+        {
+            double a1 = zcosg * zcosh + zsing * zcosi * zsinh;
+            double a3 = -zsing * zcosh + zcosg * zcosi * zsinh;
+            double a7 = -zcosg * zsinh + zsing * zcosi * zcosh;
+            double a8 = zsing * zsini;
+            double a9 = zsing * zsinh + zcosg * zcosi * zcosh;
+            double a10 = zcosg * zsini;
+            double a2 = c.cosim * a7 + c.sinim * a8;
+            double a4 = c.cosim * a9 + c.sinim * a10;
+            double a5 = -c.sinim * a7 + c.cosim * a8;
+            double a6 = -c.sinim * a9 + c.cosim * a10;
+
+            double x1 = a1 * c.cosomm + a2 * c.sinomm;
+            double x2 = a3 * c.cosomm + a4 * c.sinomm;
+            double x3 = -a1 * c.sinomm + a2 * c.cosomm;
+            double x4 = -a3 * c.sinomm + a4 * c.cosomm;
+            double x5 = a5 * c.sinomm;
+            double x6 = a6 * c.sinomm;
+            double x7 = a5 * c.cosomm;
+            double x8 = a6 * c.cosomm;
+
+            c.z31 = 12.0 * x1 * x1 - 3.0 * x3 * x3;
+            c.z32 = 24.0 * x1 * x2 - 6.0 * x3 * x4;
+            c.z33 = 12.0 * x2 * x2 - 3.0 * x4 * x4;
+            c.z1 = 3.0 * (a1 * a1 + a2 * a2) + c.z31 * c.emsq;
+            c.z2 = 6.0 * (a1 * a3 + a2 * a4) + c.z32 * c.emsq;
+            c.z3 = 3.0 * (a3 * a3 + a4 * a4) + c.z33 * c.emsq;
+            c.z11 = -6.0 * a1 * a5 + c.emsq * (-24.0 * x1 * x7 - 6.0 * x3 * x5);
+            c.z12 = -6.0 * (a1 * a6 + a3 * a5) + c.emsq * (-24.0 * (x2 * x7 + x1 * x8) - 6.0 * (x3 * x6 + x4 * x5));
+            c.z13 = -6.0 * a3 * a6 + c.emsq * (-24.0 * x2 * x8 - 6.0 * x4 * x6);
+            c.z21 = 6.0 * a2 * a5 + c.emsq * (24.0 * x1 * x5 - 6.0 * x3 * x7);
+            c.z22 = 6.0 * (a4 * a5 + a2 * a6) + c.emsq * (24.0 * (x2 * x5 + x1 * x6) - 6.0 * (x4 * x7 + x3 * x8));
+            c.z23 = 6.0 * a4 * a6 + c.emsq * (24.0 * x2 * x6 - 6.0 * x4 * x8);
+            c.z1 = c.z1 + c.z1 + betasq * c.z31;
+            c.z2 = c.z2 + c.z2 + betasq * c.z32;
+            c.z3 = c.z3 + c.z3 + betasq * c.z33;
+            c.s3 = cc * xnoi;
+            c.s2 = -0.5 * c.s3 / c.rtemsq;
+            c.s4 = c.s3 * c.rtemsq;
+            c.s1 = -15.0 * c.em * c.s4;
+            c.s5 = x1 * x3 + x2 * x4;
+            c.s6 = x2 * x3 + x1 * x4;
+            c.s7 = x2 * x4 - x1 * x3;
+
+            if (body == 1)
+            {
+                c.ss1 = c.s1;
+                c.ss2 = c.s2;
+                c.ss3 = c.s3;
+                c.ss4 = c.s4;
+                c.ss5 = c.s5;
+                c.ss6 = c.s6;
+                c.ss7 = c.s7;
+                c.sz1 = c.z1;
+                c.sz2 = c.z2;
+                c.sz3 = c.z3;
+                c.sz11 = c.z11;
+                c.sz12 = c.z12;
+                c.sz13 = c.z13;
+                c.sz21 = c.z21;
+                c.sz22 = c.z22;
+                c.sz23 = c.z23;
+                c.sz31 = c.z31;
+                c.sz32 = c.z32;
+                c.sz33 = c.z33;
+                zcosg = zcosgl;
+                zsing = zsingl;
+                zcosi = zcosil;
+                zsini = zsinil;
+                zcosh = zcoshl * c.cnodm + zsinhl * c.snodm;
+                zsinh = c.snodm * zcoshl - c.cnodm * zsinhl;
+                cc = c1l;
+            }
+        }
+
+        satellite.zmol = std::fmod(4.7199672 + 0.22997150 * c.day - c.gam, TWO_PI);
+        satellite.zmos = std::fmod(6.2565837 + 0.017201977 * c.day, TWO_PI);
+
+        // Solar periodics
+        satellite.se2 = 2.0 * c.ss1 * c.ss6;
+        satellite.se3 = 2.0 * c.ss1 * c.ss7;
+        satellite.si2 = 2.0 * c.ss2 * c.sz12;
+        satellite.si3 = 2.0 * c.ss2 * (c.sz13 - c.sz11);
+        satellite.sl2 = -2.0 * c.ss3 * c.sz2;
+        satellite.sl3 = -2.0 * c.ss3 * (c.sz3 - c.sz1);
+        satellite.sl4 = -2.0 * c.ss3 * (-21.0 - 9.0 * c.emsq) * zes;
+        satellite.sgh2 = 2.0 * c.ss4 * c.sz32;
+        satellite.sgh3 = 2.0 * c.ss4 * (c.sz33 - c.sz31);
+        satellite.sgh4 = -18.0 * c.ss4 * zes;
+        satellite.sh2 = -2.0 * c.ss2 * c.sz22;
+        satellite.sh3 = -2.0 * c.ss2 * (c.sz23 - c.sz21);
+
+        // Lunar periodics
+        satellite.ee2 = 2.0 * c.s1 * c.s6;
+        satellite.e3 = 2.0 * c.s1 * c.s7;
+        satellite.xi2 = 2.0 * c.s2 * c.z12;
+        satellite.xi3 = 2.0 * c.s2 * (c.z13 - c.z11);
+        satellite.xl2 = -2.0 * c.s3 * c.z2;
+        satellite.xl3 = -2.0 * c.s3 * (c.z3 - c.z1);
+        satellite.xl4 = -2.0 * c.s3 * (-21.0 - 9.0 * c.emsq) * zel;
+        satellite.xgh2 = 2.0 * c.s4 * c.z32;
+        satellite.xgh3 = 2.0 * c.s4 * (c.z33 - c.z31);
+        satellite.xgh4 = -18.0 * c.s4 * zel;
+        satellite.xh2 = -2.0 * c.s2 * c.z22;
+        satellite.xh3 = -2.0 * c.s2 * (c.z23 - c.z21);
+    }
+
+    // Lunar-solar periodics at time t, applied to the elements (not at initialization)
+    void deepSpacePeriodics(const Sgp4Satellite &s, double t, bool init, double &ep, double &inclp, double &nodep,
+                            double &argpp, double &mp)
+    {
+        const double zns = 1.19459e-5, zes = 0.01675;
+        const double znl = 1.5835218e-4, zel = 0.05490;
+
+        double zm = init ? s.zmos : s.zmos + zns * t;
+        double zf = zm + 2.0 * zes * std::sin(zm);
+        double sinzf = std::sin(zf);
+        double f2 = 0.5 * sinzf * sinzf - 0.25;
+        double f3 = -0.5 * sinzf * std::cos(zf);
+        double ses = s.se2 * f2 + s.se3 * f3;
+        double sis = s.si2 * f2 + s.si3 * f3;
+        double sls = s.sl2 * f2 + s.sl3 * f3 + s.sl4 * sinzf;
+        double sghs = s.sgh2 * f2 + s.sgh3 * f3 + s.sgh4 * sinzf;
+        double shs = s.sh2 * f2 + s.sh3 * f3;
+
+        zm = init ? s.zmol : s.zmol + znl * t;
+        zf = zm + 2.0 * zel * std::sin(zm);
+        sinzf = std::sin(zf);
+        f2 = 0.5 * sinzf * sinzf - 0.25;
+        f3 = -0.5 * sinzf * std::cos(zf);
+        double sel = s.ee2 * f2 + s.e3 * f3;
+        double sil = s.xi2 * f2 + s.xi3 * f3;
+        double sll = s.xl2 * f2 + s.xl3 * f3 + s.xl4 * sinzf;
+        double sghl = s.xgh2 * f2 + s.xgh3 * f3 + s.xgh4 * sinzf;
+        double shll = s.xh2 * f2 + s.xh3 * f3;
+
+        if (init)
+            return;
+
+        double pe = ses + sel - s.peo;
+        double pinc = sis + sil - s.pinco;
+        double pl = sls + sll - s.plo;
+        double pgh = sghs + sghl - s.pgho;
+        double ph = shs + shll - s.pho;
+        inclp = inclp + pinc;
+        ep = ep + pe;
+        double sinip = std::sin(inclp);
+        double cosip = std::cos(inclp);
+
+        if (inclp >= 0.2)
+        {
+            ph = ph / sinip;
+            pgh = pgh - cosip * ph;
+            argpp = argpp + pgh;
+            nodep = nodep + ph;
+            mp = mp + pl;
+        }
+        else
+        {
+            // Lyddane modification for low inclinations
+            double sinop = std::sin(nodep);
+            double cosop = std::cos(nodep);
+            double alfdp = sinip * sinop;
+            double betdp = sinip * cosop;
+            double dalf = ph * cosop + pinc * cosip * sinop;
+            double dbet = -ph * sinop + pinc * cosip * cosop;
+            alfdp = alfdp + dalf;
+            betdp = betdp + dbet;
+            nodep = std::fmod(nodep, TWO_PI);
+            double xls = mp + argpp + cosip * nodep;
+            double dls = pl + pgh - pinc * nodep * sinip;
+            xls = xls + dls;
+            double xnoh = nodep;
+            nodep = std::atan2(alfdp, betdp);
+            if (std::fabs(xnoh - nodep) > M_PI)
+                nodep = nodep < xnoh ? nodep + TWO_PI : nodep - TWO_PI;
+            mp = mp + pl;
+            argpp = xls - mp - cosip * nodep;
+        }
+    }
+
+    // Deep-space secular rates and, for resonant orbits, the resonance coefficients
+    void deepSpaceInit(Sgp4Satellite &s, const DeepSpaceCommon &c, double t, double tc, double eccsq, double &em,
+                       double &argpm, double &inclm, double &mm, double &nm, double &nodem)
+    {
+        const double q22 = 1.7891679e-6, q31 = 2.1460748e-6, q33 = 2.2123015e-7;
+        const double root22 = 1.7891679e-6, root44 = 7.3636953e-9, root54 = 2.1765803e-9;
+        const double rptim = 4.37526908801129966e-3; // Earth rotation, rad/min
+        const double root32 = 3.7393792e-7, root52 = 1.1428639e-7;
+        const double znl = 1.5835218e-4, zns = 1.19459e-5;
+
+        s.irez = 0;
+        if (nm < 0.0052359877 && nm > 0.0034906585)
+            s.irez = 1;
+        if (nm >= 8.26e-3 && nm <= 9.24e-3 && em >= 0.5)
+            s.irez = 2;
+
+        // Solar secular terms
+        double ses = c.ss1 * zns * c.ss5;
+        double sis = c.ss2 * zns * (c.sz11 + c.sz13);
+        double sls = -zns * c.ss3 * (c.sz1 + c.sz3 - 14.0 - 6.0 * c.emsq);
+        double sghs = c.ss4 * zns * (c.sz31 + c.sz33 - 6.0);
+        double shs = -zns * c.ss2 * (c.sz21 + c.sz23);
+        if (inclm < 5.2359877e-2 || inclm > M_PI - 5.2359877e-2)
+            shs = 0.0;
+        if (c.sinim != 0.0)
+            shs = shs / c.sinim;
+        double sgs = sghs - c.cosim * shs;
+
+        // Lunar secular terms
+        s.dedt = ses + c.s1 * znl * c.s5;
+        s.didt = sis + c.s2 * znl * (c.z11 + c.z13);
+        s.dmdt = sls - znl * c.s3 * (c.z1 + c.z3 - 14.0 - 6.0 * c.emsq);
+        double sghl = c.s4 * znl * (c.z31 + c.z33 - 6.0);
+        double shll = -znl * c.s2 * (c.z21 + c.z23);
+        if (inclm < 5.2359877e-2 || inclm > M_PI - 5.2359877e-2)
+            shll = 0.0;
+        s.domdt = sgs + sghl;
+        s.dnodt = shs;
+        if (c.sinim != 0.0)
+        {
+            s.domdt = s.domdt - c.cosim / c.sinim * shll;
+            s.dnodt = s.dnodt + shll / c.sinim;
+        }
+
+        double theta = std::fmod(s.gsto + tc * rptim, TWO_PI);
+        em = em + s.dedt * t;
+        inclm = inclm + s.didt * t;
+        argpm = argpm + s.domdt * t;
+        nodem = nodem + s.dnodt * t;
+        mm = mm + s.dmdt * t;
+
+        if (s.irez == 0)
+            return;
+
+        double aonv = std::pow(nm / xke(), X2O3);
+        double dndt = 0.0;
+
+        if (s.irez == 2)
+        {
+            // Half-day (Molniya-like) geopotential resonance
+            double cosisq = c.cosim * c.cosim;
+            double emo = em;
+            em = s.ecco;
+            double emsq = eccsq;
+            double eoc = em * emsq;
+            double g201 = -0.306 - (em - 0.64) * 0.440;
+            double g211, g310, g322, g410, g422, g520, g521, g532, g533;
+            if (em <= 0.65)
+            {
+                g211 = 3.616 - 13.2470 * em + 16.2900 * emsq;
+                g310 = -19.302 + 117.3900 * em - 228.4190 * emsq + 156.5910 * eoc;
+                g322 = -18.9068 + 109.7927 * em - 214.6334 * emsq + 146.5816 * eoc;
+                g410 = -41.122 + 242.6940 * em - 471.0940 * emsq + 313.9530 * eoc;
+                g422 = -146.407 + 841.8800 * em - 1629.014 * emsq + 1083.4350 * eoc;
+                g520 = -532.114 + 3017.977 * em - 5740.032 * emsq + 3708.2760 * eoc;
+            }
+            else
+            {
+                g211 = -72.099 + 331.819 * em - 508.738 * emsq + 266.724 * eoc;
+                g310 = -346.844 + 1582.851 * em - 2415.925 * emsq + 1246.113 * eoc;
+                g322 = -342.585 + 1554.908 * em - 2366.899 * emsq + 1215.972 * eoc;
+                g410 = -1052.797 + 4758.686 * em - 7193.992 * emsq + 3651.957 * eoc;
+                g422 = -3581.690 + 16178.110 * em - 24462.770 * emsq + 12422.520 * eoc;
+                if (em > 0.715)
+                    g520 = -5149.66 + 29936.92 * em - 54087.36 * emsq + 31324.56 * eoc;
+                else
+                    g520 = 1464.74 - 4664.75 * em + 3763.64 * emsq;
+            }
+            if (em < 0.7)
+            {
+                g533 = -919.22770 + 4988.6100 * em - 9064.7700 * emsq + 5542.21 * eoc;
+                g521 = -822.71072 + 4568.6173 * em - 8491.4146 * emsq + 5337.524 * eoc;
+                g532 = -853.66600 + 4690.2500 * em - 8624.7700 * emsq + 5341.4 * eoc;
+            }
+            else
+            {
+                g533 = -37995.780 + 161616.52 * em - 229838.20 * emsq + 109377.94 * eoc;
+                g521 = -51752.104 + 218913.95 * em - 309468.16 * emsq + 146349.42 * eoc;
+                g532 = -40023.880 + 170470.89 * em - 242699.48 * emsq + 115605.82 * eoc;
+            }
+
+            double sini2 = c.sinim * c.sinim;
+            double f220 = 0.75 * (1.0 + 2.0 * c.cosim + cosisq);
+            double f221 = 1.5 * sini2;
+            double f321 = 1.875 * c.sinim * (1.0 - 2.0 * c.cosim - 3.0 * cosisq);
+            double f322 = -1.875 * c.sinim * (1.0 + 2.0 * c.cosim - 3.0 * cosisq);
+            double f441 = 35.0 * sini2 * f220;
+            double f442 = 39.3750 * sini2 * sini2;
+            double f522 = 9.84375 * c.sinim *
+                          (sini2 * (1.0 - 2.0 * c.cosim - 5.0 * cosisq) + 0.33333333 * (-2.0 + 4.0 * c.cosim + 6.0 * cosisq));
+            double f523 = c.sinim * (4.92187512 * sini2 * (-2.0 - 4.0 * c.cosim + 10.0 * cosisq) +
+                                     6.56250012 * (1.0 + 2.0 * c.cosim - 3.0 * cosisq));
+            double f542 = 29.53125 * c.sinim * (2.0 - 8.0 * c.cosim + cosisq * (-12.0 + 8.0 * c.cosim + 10.0 * cosisq));
+            double f543 = 29.53125 * c.sinim * (-2.0 - 8.0 * c.cosim + cosisq * (12.0 + 8.0 * c.cosim - 10.0 * cosisq));
+
+            double xno2 = nm * nm;
+            double ainv2 = aonv * aonv;
+            double temp1 = 3.0 * xno2 * ainv2;
+            double temp = temp1 * root22;
+            s.d2201 = temp * f220 * g201;
+            s.d2211 = temp * f221 * g211;
+            temp1 = temp1 * aonv;
+            temp = temp1 * root32;
+            s.d3210 = temp * f321 * g310;
+            s.d3222 = temp * f322 * g322;
+            temp1 = temp1 * aonv;
+            temp = 2.0 * temp1 * root44;
+            s.d4410 = temp * f441 * g410;
+            s.d4422 = temp * f442 * g422;
+            temp1 = temp1 * aonv;
+            temp = temp1 * root52;
+            s.d5220 = temp * f522 * g520;
+            s.d5232 = temp * f523 * g532;
+            temp = 2.0 * temp1 * root54;
+            s.d5421 = temp * f542 * g521;
+            s.d5433 = temp * f543 * g533;
+            s.xlamo = std::fmod(s.mo + s.nodeo + s.nodeo - theta - theta, TWO_PI);
+            s.xfact = s.mdot + s.dmdt + 2.0 * (s.nodedot + s.dnodt - rptim) - s.no;
+            em = emo;
+        }
+        else
+        {
+            // One-day (geosynchronous) resonance
+            double emsq = c.emsq;
+            double g200 = 1.0 + emsq * (-2.5 + 0.8125 * emsq);
+            double g310 = 1.0 + 2.0 * emsq;
+            double g300 = 1.0 + emsq * (-6.0 + 6.60937 * emsq);
+            double f220 = 0.75 * (1.0 + c.cosim) * (1.0 + c.cosim);
+            double f311 = 0.9375 * c.sinim * c.sinim * (1.0 + 3.0 * c.cosim) - 0.75 * (1.0 + c.cosim);
+            double f330 = 1.0 + c.cosim;
+            f330 = 1.875 * f330 * f330 * f330;
+            s.del1 = 3.0 * nm * nm * aonv * aonv;
+            s.del2 = 2.0 * s.del1 * f220 * g200 * q22;
+            s.del3 = 3.0 * s.del1 * f330 * g300 * q33 * aonv;
+            s.del1 = s.del1 * f311 * g310 * q31 * aonv;
+            s.xlamo = std::fmod(s.mo + s.nodeo + s.argpo - theta, TWO_PI);
+            s.xfact = s.mdot + (s.argpdot + s.nodedot) - rptim + s.dmdt + s.domdt + s.dnodt - s.no;
+        }
+
+        // Start the resonance integrator at epoch
+        s.xli = s.xlamo;
+        s.xni = s.no;
+        s.atime = 0.0;
+        nm = s.no + dndt;
+    }
+
+    // Deep-space secular effects and resonance integration up to time t
+    void deepSpaceSecular(Sgp4Satellite &s, double t, double &em, double &argpm, double &inclm, double &mm,
+                          double &nodem, double &nm)
+    {
+        const double fasx2 = 0.13130908, fasx4 = 2.8843198, fasx6 = 0.37448087;
+        const double g22 = 5.7686396, g32 = 0.95240898, g44 = 1.8014998, g52 = 1.0508330, g54 = 4.4108898;
+        const double rptim = 4.37526908801129966e-3;
+        const double stepp = 720.0, stepn = -720.0, step2 = 259200.0;
+
+        double theta = std::fmod(s.gsto + t * rptim, TWO_PI);
+        em = em + s.dedt * t;
+        inclm = inclm + s.didt * t;
+        argpm = argpm + s.domdt * t;
+        nodem = nodem + s.dnodt * t;
+        mm = mm + s.dmdt * t;
+
+        if (s.irez == 0)
+            return;
+
+        // Euler-Maclaurin steps of 720 minutes from epoch, or from where the last call stopped
+        if (s.atime == 0.0 || t * s.atime <= 0.0 || std::fabs(t) < std::fabs(s.atime))
+        {
+            s.atime = 0.0;
+            s.xni = s.no;
+            s.xli = s.xlamo;
+        }
+        double delt = t > 0.0 ? stepp : stepn;
+        double ft = 0.0;
+        double xndt, xldot, xnddt;
+        for (;;)
+        {
+            if (s.irez != 2)
+            {
+                xndt = s.del1 * std::sin(s.xli - fasx2) + s.del2 * std::sin(2.0 * (s.xli - fasx4)) +
+                       s.del3 * std::sin(3.0 * (s.xli - fasx6));
+                xldot = s.xni + s.xfact;
+                xnddt = s.del1 * std::cos(s.xli - fasx2) + 2.0 * s.del2 * std::cos(2.0 * (s.xli - fasx4)) +
+                        3.0 * s.del3 * std::cos(3.0 * (s.xli - fasx6));
+                xnddt = xnddt * xldot;
+            }
+            else
+            {
+                double xomi = s.argpo + s.argpdot * s.atime;
+                double x2omi = xomi + xomi;
+                double x2li = s.xli + s.xli;
+                xndt = s.d2201 * std::sin(x2omi + s.xli - g22) + s.d2211 * std::sin(s.xli - g22) +
+                       s.d3210 * std::sin(xomi + s.xli - g32) + s.d3222 * std::sin(-xomi + s.xli - g32) +
+                       s.d4410 * std::sin(x2omi + x2li - g44) + s.d4422 * std::sin(x2li - g44) +
+                       s.d5220 * std::sin(xomi + s.xli - g52) + s.d5232 * std::sin(-xomi + s.xli - g52) +
+                       s.d5421 * std::sin(xomi + x2li - g54) + s.d5433 * std::sin(-xomi + x2li - g54);
+                xldot = s.xni + s.xfact;
+                xnddt = s.d2201 * std::cos(x2omi + s.xli - g22) + s.d2211 * std::cos(s.xli - g22) +
+                        s.d3210 * std::cos(xomi + s.xli - g32) + s.d3222 * std::cos(-xomi + s.xli - g32) +
+                        s.d5220 * std::cos(xomi + s.xli - g52) + s.d5232 * std::cos(-xomi + s.xli - g52) +
+                        2.0 * (s.d4410 * std::cos(x2omi + x2li - g44) + s.d4422 * std::cos(x2li - g44) +
+                               s.d5421 * std::cos(xomi + x2li - g54) + s.d5433 * std::cos(-xomi + x2li - g54));
+                xnddt = xnddt * xldot;
+            }
+
+            if (std::fabs(t - s.atime) < stepp)
+            {
+                ft = t - s.atime;
+                break;
+            }
+            s.xli = s.xli + xldot * delt + xndt * step2;
+            s.xni = s.xni + xndt * delt + xnddt * step2;
+            s.atime = s.atime + delt;
+        }
+
+        nm = s.xni + xndt * ft + xnddt * ft * ft * 0.5;
+        double xl = s.xli + xldot * ft + xndt * ft * ft * 0.5;
+        if (s.irez != 1)
+            mm = xl - 2.0 * nodem + 2.0 * theta;
+        else
+            mm = xl - nodem - argpm + theta;
+    }
+
+    // sin and cos together without branches, for the batch lanes: Cody-Waite
+    // reduction by pi/2 (exact for |x| < 2^20 quadrants) and the fdlibm
+    // kernels on [-pi/4, pi/4]. Within a few ulp of the library functions.
+    inline void sinCos(double x, double &sine, double &cosine)
+    {
+        const double roundShift = 6755399441055744.0; // 1.5 * 2^52: adding it rounds to an integer
+        double n = (x * (2.0 / M_PI) + roundShift) - roundShift;
+        double r = ((x - n * 1.57079632673412561417e+00) - n * 6.07710050650619224932e-11) -
+                   n * 2.02226624871116645580e-21;
+        double z = r * r;
+        double s = r + r * z *
+                           (-1.66666666666666324348e-01 +
+                            z * (8.33333333332248946124e-03 +
+                                 z * (-1.98412698298579493134e-04 +
+                                      z * (2.75573137070700676789e-06 +
+                                           z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+        double c = 1.0 - 0.5 * z +
+                   z * z *
+                       (4.16666666666666019037e-02 +
+                        z * (-1.38888888888741095749e-03 +
+                             z * (2.48015872894767294178e-05 +
+                                  z * (-2.75573143513906633035e-07 +
+                                       z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+        int quadrant = static_cast<int>(n) & 3;
+        double swappedSine = (quadrant & 1) ? c : s;
+        double swappedCosine = (quadrant & 1) ? s : c;
+        sine = (quadrant & 2) ? -swappedSine : swappedSine;
+        cosine = ((quadrant + 1) & 2) ? -swappedCosine : swappedCosine;
+    }
+
+    // fmod(x, TWO_PI) without the library call, for the batch lanes (|x| below 2^31 turns)
+    inline double wrapAngle(double x)
+    {
+        return x - TWO_PI * static_cast<double>(static_cast<int>(x / TWO_PI));
+    }
+
+    // Secular gravity and drag (plus the deep-space secular terms) at t
+    // minutes: the mean elements before any periodic terms
+    int secularElements(Sgp4Satellite &s, double t, double &am, double &em, double &inclm, double &nodem,
+                        double &argpm, double &mm, double &nm)
+    {
+        double xmdf = s.mo + s.mdot * t;
+        double argpdf = s.argpo + s.argpdot * t;
+        double nodedf = s.nodeo + s.nodedot * t;
+        argpm = argpdf;
+        mm = xmdf;
+        double t2 = t * t;
+        nodem = nodedf + s.nodecf * t2;
+        double tempa = 1.0 - s.cc1 * t;
+        double tempe = s.bstar * s.cc4 * t;
+        double templ = s.t2cof * t2;
+
+        if (!s.simple)
+        {
+            double delomg = s.omgcof * t;
+            double delmtemp = 1.0 + s.eta * std::cos(xmdf);
+            double delm = s.xmcof * (delmtemp * delmtemp * delmtemp - s.delmo);
+            double temp = delomg + delm;
+            mm = xmdf + temp;
+            argpm = argpdf - temp;
+            double t3 = t2 * t;
+            double t4 = t3 * t;
+            tempa = tempa - s.d2 * t2 - s.d3 * t3 - s.d4 * t4;
+            tempe = tempe + s.bstar * s.cc5 * (std::sin(mm) - s.sinmao);
+            templ = templ + s.t3cof * t3 + t4 * (s.t4cof + t * s.t5cof);
+        }
+
+        nm = s.no;
+        em = s.ecco;
+        inclm = s.inclo;
+        if (s.deepSpace)
+            deepSpaceSecular(s, t, em, argpm, inclm, mm, nodem, nm);
+
+        if (nm <= 0.0)
+            return SGP4_BAD_MEAN_MOTION;
+        am = std::pow(xke() / nm, X2O3) * tempa * tempa;
+        nm = xke() / std::pow(am, 1.5);
+        em = em - tempe;
+
+        if (em >= 1.0 || em < -0.001)
+            return SGP4_BAD_ECCENTRICITY;
+        if (em < 1.0e-6)
+            em = 1.0e-6;
+        mm = mm + s.no * templ;
+        double xlm = mm + argpm + nodem;
+        nodem = std::fmod(nodem, TWO_PI);
+        argpm = std::fmod(argpm, TWO_PI);
+        xlm = std::fmod(xlm, TWO_PI);
+        mm = std::fmod(xlm - argpm - nodem, TWO_PI);
+        return SGP4_OK;
+    }
+
+    int finishPropagation(double am, double em, double inclm, double nodem, double argpm, double mm, double nm,
+                          double aycof, double xlcof, double con41, double x1mth2, double x7thm1, double sinip,
+                          double cosip, double position[3], double velocity[3])
+    {
+        double axnl = em * std::cos(argpm);
+        double temp = 1.0 / (am * (1.0 - em * em));
+        double aynl = em * std::sin(argpm) + temp * aycof;
+        double xl = mm + argpm + nodem + temp * xlcof * axnl;
+
+        // Kepler's equation for the eccentric longitude
+        double u = std::fmod(xl - nodem, TWO_PI);
+        double eo1 = u;
+        double tem5 = 9999.9;
+        double sineo1 = 0.0, coseo1 = 0.0;
+        for (int iteration = 0; std::fabs(tem5) >= 1.0e-12 && iteration < 10; ++iteration)
+        {
+            sineo1 = std::sin(eo1);
+            coseo1 = std::cos(eo1);
+            tem5 = 1.0 - coseo1 * axnl - sineo1 * aynl;
+            tem5 = (u - aynl * coseo1 + axnl * sineo1 - eo1) / tem5;
+            if (std::fabs(tem5) >= 0.95)
+                tem5 = tem5 > 0.0 ? 0.95 : -0.95;
+            eo1 = eo1 + tem5;
+        }
+
+        double ecose = axnl * coseo1 + aynl * sineo1;
+        double esine = axnl * sineo1 - aynl * coseo1;
+        double el2 = axnl * axnl + aynl * aynl;
+        double pl = am * (1.0 - el2);
+        if (pl < 0.0)
+            return SGP4_BAD_SEMI_LATUS_RECTUM;
+
+        double rl = am * (1.0 - ecose);
+        double rdotl = std::sqrt(am) * esine / rl;
+        double rvdotl = std::sqrt(pl) / rl;
+        double betal = std::sqrt(1.0 - el2);
+        temp = esine / (1.0 + betal);
+        double sinu = am / rl * (sineo1 - aynl - axnl * temp);
+        double cosu = am / rl * (coseo1 - axnl + aynl * temp);
+        double su = std::atan2(sinu, cosu);
+        double sin2u = (cosu + cosu) * sinu;
+        double cos2u = 1.0 - 2.0 * sinu * sinu;
+        temp = 1.0 / pl;
+        double temp1 = 0.5 * J2 * temp;
+        double temp2 = temp1 * temp;
+
+        double mrt = rl * (1.0 - 1.5 * temp2 * betal * con41) + 0.5 * temp1 * x1mth2 * cos2u;
+        su = su - 0.25 * temp2 * x7thm1 * sin2u;
+        double xnode = nodem + 1.5 * temp2 * cosip * sin2u;
+        double xinc = inclm + 1.5 * temp2 * cosip * sinip * cos2u;
+        double mvt = rdotl - nm * temp1 * x1mth2 * sin2u / xke();
+        double rvdot = rvdotl + nm * temp1 * (x1mth2 * cos2u + 1.5 * con41) / xke();
+
+        double sinsu = std::sin(su);
+        double cossu = std::cos(su);
+        double snod = std::sin(xnode);
+        double cnod = std::cos(xnode);
+        double sini = std::sin(xinc);
+        double cosi = std::cos(xinc);
+        double xmx = -snod * cosi;
+        double xmy = cnod * cosi;
+        double ux = xmx * sinsu + cnod * cossu;
+        double uy = xmy * sinsu + snod * cossu;
+        double uz = sini * sinsu;
+        double vx = xmx * cossu - cnod * sinsu;
+        double vy = xmy * cossu - snod * sinsu;
+        double vz = sini * cossu;
+
+        double vkmpersec = velocityKmPerSecond();
+        position[0] = mrt * ux * RADIUS;
+        position[1] = mrt * uy * RADIUS;
+        position[2] = mrt * uz * RADIUS;
+        velocity[0] = (mvt * ux + rvdot * vx) * vkmpersec;
+        velocity[1] = (mvt * uy + rvdot * vy) * vkmpersec;
+        velocity[2] = (mvt * uz + rvdot * vz) * vkmpersec;
+
+        return mrt < 1.0 ? SGP4_DECAYED : SGP4_OK;
+    }
+}
+
+double julianDate(int year, int month, int day, int hour, int minute, double second)
+{
+    return 367.0 * year - std::floor(7.0 * (year + std::floor((month + 9) / 12.0)) / 4.0) +
+           std::floor(275.0 * month / 9.0) + day + 1721013.5 + ((second / 60.0 + minute) / 60.0 + hour) / 24.0;
+}
+
+double greenwichSiderealTime(double jdut1)
+{
+    double tut1 = (jdut1 - 2451545.0) / 36525.0;
+    double seconds = -6.2e-6 * tut1 * tut1 * tut1 + 0.093104 * tut1 * tut1 +
+                     (876600.0 * 3600.0 + 8640184.812866) * tut1 + 67310.54841;
+    double angle = std::fmod(seconds * DEG_TO_RAD / 240.0, TWO_PI);
+    return angle < 0.0 ? angle + TWO_PI : angle;
+}
+
+bool parseTle(const char *line1, const char *line2, TleElements &elements)
+{
+    size_t length1 = strlen(line1);
+    size_t length2 = strlen(line2);
+    while (length1 > 0 && (line1[length1 - 1] == '\r' || line1[length1 - 1] == '\n'))
+        --length1;
+    while (length2 > 0 && (line2[length2 - 1] == '\r' || line2[length2 - 1] == '\n'))
+        --length2;
+    if (line1[0] != '1' || line2[0] != '2' || !checksumMatches(line1, length1) || !checksumMatches(line2, length2))
+        return false;
+
+    char text[16];
+    int number2;
+    double year, dayOfYear, bstar, inclination, node, eccentricity, perigee, anomaly, meanMotion;
+    bool valid = field(line1, length1, 3, 7, text) && parseCatalogNumber(text, elements.catalogNumber) &&
+                 field(line1, length1, 19, 20, text) && parseDouble(text, year) &&
+                 field(line1, length1, 21, 32, text) && parseDouble(text, dayOfYear) &&
+                 field(line1, length1, 54, 61, text) && parseExponential(text, bstar) &&
+                 field(line2, length2, 3, 7, text) && parseCatalogNumber(text, number2) &&
+                 number2 == elements.catalogNumber &&
+                 field(line2, length2, 9, 16, text) && parseDouble(text, inclination) &&
+                 field(line2, length2, 18, 25, text) && parseDouble(text, node) &&
+                 field(line2, length2, 27, 33, text) && parseDouble(text, eccentricity) &&
+                 field(line2, length2, 35, 42, text) && parseDouble(text, perigee) &&
+                 field(line2, length2, 44, 51, text) && parseDouble(text, anomaly) &&
+                 field(line2, length2, 53, 63, text) && parseDouble(text, meanMotion);
+    if (!valid)
+        return false;
+
+    // Two-digit years: 57-99 are 1957-1999
+    int fullYear = static_cast<int>(year) + (year < 57.0 ? 2000 : 1900);
+    elements.epochJd = julianDate(fullYear, 1, 0, 0, 0, 0.0) + dayOfYear; // day 0 is December 31
+    elements.bstar = bstar;
+    elements.inclination = inclination * DEG_TO_RAD;
+    elements.rightAscension = node * DEG_TO_RAD;
+    elements.eccentricity = eccentricity * 1.0e-7; // implied leading decimal point
+    elements.argumentOfPerigee = perigee * DEG_TO_RAD;
+    elements.meanAnomaly = anomaly * DEG_TO_RAD;
+    elements.meanMotion = meanMotion * TWO_PI / MINUTES_PER_DAY;
+    return true;
+}
+
+int sgp4Init(const TleElements &elements, Sgp4Satellite &satellite)
+{
+    Sgp4Satellite &s = satellite;
+    memset(&s, 0, sizeof(s));
+    s.catalogNumber = elements.catalogNumber;
+    s.epochJd = elements.epochJd;
+    s.bstar = elements.bstar;
+    s.inclo = elements.inclination;
+    s.nodeo = elements.rightAscension;
+    s.ecco = elements.eccentricity;
+    s.argpo = elements.argumentOfPerigee;
+    s.mo = elements.meanAnomaly;
+
+    const double ss = 78.0 / RADIUS + 1.0;
+    const double qzms2t = std::pow((120.0 - 78.0) / RADIUS, 4.0);
+    double epoch = elements.epochJd - 2433281.5; // days since 1950 January 0
+
+    // Un-Kozai the mean motion
+    double eccsq = s.ecco * s.ecco;
+    double omeosq = 1.0 - eccsq;
+    double rteosq = std::sqrt(omeosq);
+    double cosio = std::cos(s.inclo);
+    double cosio2 = cosio * cosio;
+    double ak = std::pow(xke() / elements.meanMotion, X2O3);
+    double d1 = 0.75 * J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+    double del = d1 / (ak * ak);
+    double adel = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+    del = d1 / (adel * adel);
+    s.no = elements.meanMotion / (1.0 + del);
+
+    double ao = std::pow(xke() / s.no, X2O3);
+    double sinio = std::sin(s.inclo);
+    double po = ao * omeosq;
+    double con42 = 1.0 - 5.0 * cosio2;
+    s.con41 = -con42 - cosio2 - cosio2;
+    double posq = po * po;
+    double rp = ao * (1.0 - s.ecco);
+    s.gsto = greenwichSiderealTime(epoch + 2433281.5);
+
+    if (omeosq < 0.0 && s.no < 0.0)
+        return SGP4_BAD_MEAN_MOTION;
+
+    s.simple = rp < 220.0 / RADIUS + 1.0;
+    double sfour = ss;
+    double qzms24 = qzms2t;
+    double perige = (rp - 1.0) * RADIUS;
+
+    // Lower the atmospheric model's reference altitude for perigees below 156 km
+    if (perige < 156.0)
+    {
+        sfour = perige - 78.0;
+        if (perige < 98.0)
+            sfour = 20.0;
+        qzms24 = std::pow((120.0 - sfour) / RADIUS, 4.0);
+        sfour = sfour / RADIUS + 1.0;
+    }
+    double pinvsq = 1.0 / posq;
+
+    double tsi = 1.0 / (ao - sfour);
+    s.eta = ao * s.ecco * tsi;
+    double etasq = s.eta * s.eta;
+    double eeta = s.ecco * s.eta;
+    double psisq = std::fabs(1.0 - etasq);
+    double coef = qzms24 * std::pow(tsi, 4.0);
+    double coef1 = coef / std::pow(psisq, 3.5);
+    double cc2 = coef1 * s.no *
+                 (ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq)) +
+                  0.375 * J2 * tsi / psisq * s.con41 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+    s.cc1 = s.bstar * cc2;
+    double cc3 = 0.0;
+    if (s.ecco > 1.0e-4)
+        cc3 = -2.0 * coef * tsi * J3OJ2 * s.no * sinio / s.ecco;
+    s.x1mth2 = 1.0 - cosio2;
+    s.cc4 = 2.0 * s.no * coef1 * ao * omeosq *
+            (s.eta * (2.0 + 0.5 * etasq) + s.ecco * (0.5 + 2.0 * etasq) -
+             J2 * tsi / (ao * psisq) *
+                 (-3.0 * s.con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta)) +
+                  0.75 * s.x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * std::cos(2.0 * s.argpo)));
+    s.cc5 = 2.0 * coef1 * ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+
+    double cosio4 = cosio2 * cosio2;
+    double temp1 = 1.5 * J2 * pinvsq * s.no;
+    double temp2 = 0.5 * temp1 * J2 * pinvsq;
+    double temp3 = -0.46875 * J4 * pinvsq * pinvsq * s.no;
+    s.mdot = s.no + 0.5 * temp1 * rteosq * s.con41 + 0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+    s.argpdot = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4) +
+                temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+    double xhdot1 = -temp1 * cosio;
+    s.nodedot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * cosio;
+    s.omgcof = s.bstar * cc3 * std::cos(s.argpo);
+    s.xmcof = 0.0;
+    if (s.ecco > 1.0e-4)
+        s.xmcof = -X2O3 * coef * s.bstar / eeta;
+    s.nodecf = 3.5 * omeosq * xhdot1 * s.cc1;
+    s.t2cof = 1.5 * s.cc1;
+    // Avoid dividing by zero at an inclination of 180 degrees
+    if (std::fabs(cosio + 1.0) > TEMP4)
+        s.xlcof = -0.25 * J3OJ2 * sinio * (3.0 + 5.0 * cosio) / (1.0 + cosio);
+    else
+        s.xlcof = -0.25 * J3OJ2 * sinio * (3.0 + 5.0 * cosio) / TEMP4;
+    s.aycof = -0.5 * J3OJ2 * sinio;
+    s.delmo = std::pow(1.0 + s.eta * std::cos(s.mo), 3.0);
+    s.sinmao = std::sin(s.mo);
+    s.x7thm1 = 7.0 * cosio2 - 1.0;
+
+    // Periods of 225 minutes and more are deep space
+    if (TWO_PI / s.no >= 225.0)
+    {
+        s.deepSpace = true;
+        s.simple = true;
+        DeepSpaceCommon common = DeepSpaceCommon();
+        deepSpaceCommon(epoch, s.ecco, s.argpo, 0.0, s.inclo, s.nodeo, s.no, s, common);
+
+        double em = common.em, argpm = 0.0, inclm = s.inclo, mm = 0.0, nm = common.nm, nodem = 0.0;
+        deepSpaceInit(s, common, 0.0, 0.0, eccsq, em, argpm, inclm, mm, nm, nodem);
+    }
+
+    if (!s.simple)
+    {
+        double cc1sq = s.cc1 * s.cc1;
+        s.d2 = 4.0 * ao * tsi * cc1sq;
+        double temp = s.d2 * tsi * s.cc1 / 3.0;
+        s.d3 = (17.0 * ao + sfour) * temp;
+        s.d4 = 0.5 * temp * ao * tsi * (221.0 * ao + 31.0 * sfour) * s.cc1;
+        s.t3cof = s.d2 + 2.0 * cc1sq;
+        s.t4cof = 0.25 * (3.0 * s.d3 + s.cc1 * (12.0 * s.d2 + 10.0 * cc1sq));
+        s.t5cof = 0.2 * (3.0 * s.d4 + 12.0 * s.cc1 * s.d3 + 6.0 * s.d2 * s.d2 + 15.0 * cc1sq * (2.0 * s.d2 + cc1sq));
+    }
+
+    double position[3], velocity[3];
+    return sgp4Propagate(s, 0.0, position, velocity);
+}
+
+int sgp4Propagate(Sgp4Satellite &s, double t, double position[3], double velocity[3])
+{
+    double am, em, inclm, nodem, argpm, mm, nm;
+    int error = secularElements(s, t, am, em, inclm, nodem, argpm, mm, nm);
+    if (error != SGP4_OK)
+        return error;
+
+    // Lunar-solar periodics
+    double sinip = std::sin(inclm);
+    double cosip = std::cos(inclm);
+    double ep = em, xincp = inclm, argpp = argpm, nodep = nodem, mp = mm;
+    double aycof = s.aycof, xlcof = s.xlcof, con41 = s.con41, x1mth2 = s.x1mth2, x7thm1 = s.x7thm1;
+    if (s.deepSpace)
+    {
+        deepSpacePeriodics(s, t, false, ep, xincp, nodep, argpp, mp);
+        if (xincp < 0.0)
+        {
+            xincp = -xincp;
+            nodep = nodep + M_PI;
+            argpp = argpp - M_PI;
+        }
+        if (ep < 0.0 || ep > 1.0)
+            return SGP4_BAD_PERTURBED_ECCENTRICITY;
+
+        // Long-period coefficients for the perturbed inclination
+        sinip = std::sin(xincp);
+        cosip = std::cos(xincp);
+        aycof = -0.5 * J3OJ2 * sinip;
+        if (std::fabs(cosip + 1.0) > TEMP4)
+            xlcof = -0.25 * J3OJ2 * sinip * (3.0 + 5.0 * cosip) / (1.0 + cosip);
+        else
+            xlcof = -0.25 * J3OJ2 * sinip * (3.0 + 5.0 * cosip) / TEMP4;
+        double cosisq = cosip * cosip;
+        con41 = 3.0 * cosisq - 1.0;
+        x1mth2 = 1.0 - cosisq;
+        x7thm1 = 7.0 * cosisq - 1.0;
+    }
+
+    return finishPropagation(am, ep, xincp, nodep, argpp, mp, nm, aycof, xlcof, con41, x1mth2, x7thm1, sinip, cosip,
+                             position, velocity);
+}
+
+int sgp4MeanElements(Sgp4Satellite &s, double t, Sgp4MeanElements &mean)
+{
+    double am, em, inclm, nodem, argpm, mm, nm;
+    int error = secularElements(s, t, am, em, inclm, nodem, argpm, mm, nm);
+    if (error != SGP4_OK)
+        return error;
+    if (s.deepSpace)
+    {
+        deepSpacePeriodics(s, t, false, em, inclm, nodem, argpm, mm);
+        if (inclm < 0.0)
+        {
+            inclm = -inclm;
+            nodem = nodem + M_PI;
+            argpm = argpm - M_PI;
+        }
+        if (em < 0.0 || em > 1.0)
+            return SGP4_BAD_PERTURBED_ECCENTRICITY;
+    }
+
+    mean.semiMajorAxis = am * RADIUS;
+    mean.eccentricity = em;
+    mean.inclination = inclm;
+    mean.rightAscension = nodem;
+    mean.argumentOfPerigee = argpm;
+    mean.meanAnomaly = mm;
+    mean.meanMotion = nm;
+    return SGP4_OK;
+}
+
+void sgp4BatchSet(Sgp4Batch &batch, int lane, const Sgp4Satellite &s)
+{
+    // Simple orbits drop the higher order drag terms; zero coefficients make the batch formulas do the same
+    bool full = !s.simple;
+    batch.bstar[lane] = s.bstar;
+    batch.inclo[lane] = s.inclo;
+    batch.nodeo[lane] = s.nodeo;
+    batch.ecco[lane] = s.ecco;
+    batch.argpo[lane] = s.argpo;
+    batch.mo[lane] = s.mo;
+    batch.no[lane] = s.no;
+    batch.aycof[lane] = s.aycof;
+    batch.con41[lane] = s.con41;
+    batch.cc1[lane] = s.cc1;
+    batch.cc4[lane] = s.cc4;
+    batch.cc5[lane] = full ? s.cc5 : 0.0;
+    batch.d2[lane] = full ? s.d2 : 0.0;
+    batch.d3[lane] = full ? s.d3 : 0.0;
+    batch.d4[lane] = full ? s.d4 : 0.0;
+    batch.delmo[lane] = s.delmo;
+    batch.eta[lane] = s.eta;
+    batch.argpdot[lane] = s.argpdot;
+    batch.omgcof[lane] = full ? s.omgcof : 0.0;
+    batch.sinmao[lane] = s.sinmao;
+    batch.t2cof[lane] = s.t2cof;
+    batch.t3cof[lane] = full ? s.t3cof : 0.0;
+    batch.t4cof[lane] = full ? s.t4cof : 0.0;
+    batch.t5cof[lane] = full ? s.t5cof : 0.0;
+    batch.x1mth2[lane] = s.x1mth2;
+    batch.x7thm1[lane] = s.x7thm1;
+    batch.mdot[lane] = s.mdot;
+    batch.nodedot[lane] = s.nodedot;
+    batch.xlcof[lane] = s.xlcof;
+    batch.xmcof[lane] = full ? s.xmcof : 0.0;
+    batch.nodecf[lane] = s.nodecf;
+    batch.epochJd[lane] = s.epochJd;
+    batch.ao[lane] = std::pow(xke() / s.no, X2O3);
+    batch.sinio[lane] = std::sin(s.inclo);
+    batch.cosio[lane] = std::cos(s.inclo);
+}
+
+void sgp4PropagateBatch(const Sgp4Batch &b, double jd, double position[3][SGP4_LANES],
+                        double velocity[3][SGP4_LANES], int errors[SGP4_LANES])
+{
+    const int L = SGP4_LANES;
+    double am[L], em[L], nodem[L], argpm[L], mm[L], nm[L];
+
+    // Secular terms; every lane takes the same path
+    for (int i = 0; i < L; ++i)
+    {
+        double t = (jd - b.epochJd[i]) * MINUTES_PER_DAY;
+        double xmdf = b.mo[i] + b.mdot[i] * t;
+        double argpdf = b.argpo[i] + b.argpdot[i] * t;
+        double nodedf = b.nodeo[i] + b.nodedot[i] * t;
+        double t2 = t * t;
+        double t3 = t2 * t;
+        double t4 = t3 * t;
+        nodem[i] = nodedf + b.nodecf[i] * t2;
+        double sinxmdf, cosxmdf;
+        sinCos(xmdf, sinxmdf, cosxmdf);
+        double delmtemp = 1.0 + b.eta[i] * cosxmdf;
+        double temp = b.omgcof[i] * t + b.xmcof[i] * (delmtemp * delmtemp * delmtemp - b.delmo[i]);
+        mm[i] = xmdf + temp;
+        argpm[i] = argpdf - temp;
+        double sinmm, cosmm;
+        sinCos(mm[i], sinmm, cosmm);
+        double tempa = 1.0 - b.cc1[i] * t - b.d2[i] * t2 - b.d3[i] * t3 - b.d4[i] * t4;
+        double tempe = b.bstar[i] * b.cc4[i] * t + b.bstar[i] * b.cc5[i] * (sinmm - b.sinmao[i]);
+        double templ = b.t2cof[i] * t2 + b.t3cof[i] * t3 + t4 * (b.t4cof[i] + t * b.t5cof[i]);
+
+        am[i] = b.ao[i] * tempa * tempa;
+        nm[i] = xke() / (am[i] * std::sqrt(am[i]));
+        em[i] = b.ecco[i] - tempe;
+        errors[i] = em[i] >= 1.0 || em[i] < -0.001 ? SGP4_BAD_ECCENTRICITY : SGP4_OK;
+        em[i] = std::max(em[i], 1.0e-6);
+        mm[i] = mm[i] + b.no[i] * templ;
+        double xlm = wrapAngle(mm[i] + argpm[i] + nodem[i]);
+        nodem[i] = wrapAngle(nodem[i]);
+        argpm[i] = wrapAngle(argpm[i]);
+        mm[i] = wrapAngle(xlm - argpm[i] - nodem[i]);
+    }
+
+    // Kepler's equation, iterated until every lane has converged
+    double axnl[L], aynl[L], u[L], eo1[L], sineo1[L], coseo1[L];
+    bool converged[L];
+    for (int i = 0; i < L; ++i)
+    {
+        double sinargpm, cosargpm;
+        sinCos(argpm[i], sinargpm, cosargpm);
+        axnl[i] = em[i] * cosargpm;
+        double temp = 1.0 / (am[i] * (1.0 - em[i] * em[i]));
+        aynl[i] = em[i] * sinargpm + temp * b.aycof[i];
+        double xl = mm[i] + argpm[i] + nodem[i] + temp * b.xlcof[i] * axnl[i];
+        u[i] = wrapAngle(xl - nodem[i]);
+        eo1[i] = u[i];
+        converged[i] = false;
+    }
+    for (int iteration = 0; iteration < 10; ++iteration)
+    {
+        bool done = true;
+        for (int i = 0; i < L; ++i)
+        {
+            double s, c;
+            sinCos(eo1[i], s, c);
+            double tem5 = (u[i] - aynl[i] * c + axnl[i] * s - eo1[i]) / (1.0 - c * axnl[i] - s * aynl[i]);
+            tem5 = std::min(std::max(tem5, -0.95), 0.95);
+            // Converged lanes keep the values of their last step, as the scalar loop does
+            sineo1[i] = converged[i] ? sineo1[i] : s;
+            coseo1[i] = converged[i] ? coseo1[i] : c;
+            eo1[i] = converged[i] ? eo1[i] : eo1[i] + tem5;
+            converged[i] = converged[i] || std::fabs(tem5) < 1.0e-12;
+            done = done && converged[i];
+        }
+        if (done)
+            break;
+    }
+
+    // Short-period periodics and orientation
+    double vkmpersec = velocityKmPerSecond();
+    for (int i = 0; i < L; ++i)
+    {
+        double ecose = axnl[i] * coseo1[i] + aynl[i] * sineo1[i];
+        double esine = axnl[i] * sineo1[i] - aynl[i] * coseo1[i];
+        double el2 = axnl[i] * axnl[i] + aynl[i] * aynl[i];
+        double pl = am[i] * (1.0 - el2);
+        if (pl < 0.0 && errors[i] == SGP4_OK)
+            errors[i] = SGP4_BAD_SEMI_LATUS_RECTUM;
+        pl = std::max(pl, 1.0e-12);
+
+        double rl = am[i] * (1.0 - ecose);
+        double rdotl = std::sqrt(am[i]) * esine / rl;
+        double rvdotl = std::sqrt(pl) / rl;
+        double betal = std::sqrt(1.0 - el2);
+        double temp = esine / (1.0 + betal);
+        double sinu = am[i] / rl * (sineo1[i] - aynl[i] - axnl[i] * temp);
+        double cosu = am[i] / rl * (coseo1[i] - axnl[i] + aynl[i] * temp);
+        double sin2u = (cosu + cosu) * sinu;
+        double cos2u = 1.0 - 2.0 * sinu * sinu;
+        temp = 1.0 / pl;
+        double temp1 = 0.5 * J2 * temp;
+        double temp2 = temp1 * temp;
+
+        double cosip = b.cosio[i];
+        double sinip = b.sinio[i];
+        double mrt = rl * (1.0 - 1.5 * temp2 * betal * b.con41[i]) + 0.5 * temp1 * b.x1mth2[i] * cos2u;
+        double dsu = 0.25 * temp2 * b.x7thm1[i] * sin2u; // su = atan2(sinu, cosu) - dsu
+        double xnode = nodem[i] + 1.5 * temp2 * cosip * sin2u;
+        double xinc = b.inclo[i] + 1.5 * temp2 * cosip * sinip * cos2u;
+        double mvt = rdotl - nm[i] * temp1 * b.x1mth2[i] * sin2u / xke();
+        double rvdot = rvdotl + nm[i] * temp1 * (b.x1mth2[i] * cos2u + 1.5 * b.con41[i]) / xke();
+
+        double sindsu, cosdsu, snod, cnod, sini, cosi;
+        sinCos(dsu, sindsu, cosdsu);
+        double sinsu = sinu * cosdsu - cosu * sindsu;
+        double cossu = cosu * cosdsu + sinu * sindsu;
+        sinCos(xnode, snod, cnod);
+        sinCos(xinc, sini, cosi);
+        double xmx = -snod * cosi;
+        double xmy = cnod * cosi;
+        double ux = xmx * sinsu + cnod * cossu;
+        double uy = xmy * sinsu + snod * cossu;
+        double uz = sini * sinsu;
+        double vx = xmx * cossu - cnod * sinsu;
+        double vy = xmy * cossu - snod * sinsu;
+        double vz = sini * cossu;
+
+        position[0][i] = mrt * ux * RADIUS;
+        position[1][i] = mrt * uy * RADIUS;
+        position[2][i] = mrt * uz * RADIUS;
+        velocity[0][i] = (mvt * ux + rvdot * vx) * vkmpersec;
+        velocity[1][i] = (mvt * uy + rvdot * vy) * vkmpersec;
+        velocity[2][i] = (mvt * uz + rvdot * vz) * vkmpersec;
+        if (mrt < 1.0 && errors[i] == SGP4_OK)
+            errors[i] = SGP4_DECAYED;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+// SGP4/SDP4 propagation of two-line element sets, following the revised
+// reference implementation (Vallado, Crawford, Hujsak and Kelso,
+// "Revisiting Spacetrack Report #3", 2006) with WGS-72 constants in its
+// improved mode. Orbits with periods of 225 minutes or more get the
+// deep-space (SDP4) lunar-solar and resonance terms. Positions and
+// velocities are in the TEME frame of the element set, in km and km/s.
+//
+// Near-Earth satellites can also be propagated SGP4_LANES at a time from a
+// structure-of-arrays batch. Every lane runs the same instructions, with
+// no per-lane branches and a polynomial sin/cos in place of the library
+// calls, so the lanes' arithmetic overlaps; positions agree with the scalar
+// path to well under a millimetre.
+
+const double SGP4_EARTH_RADIUS_KM = 6378.135; // WGS-72
+
+// Mean elements of one TLE, in radians and radians per minute
+struct TleElements
+{
+    int catalogNumber;
+    double epochJd;           // Julian date (UTC) of the element epoch
+    double bstar;             // drag term, 1 / earth radii
+    double inclination;
+    double rightAscension;    // of the ascending node
+    double eccentricity;
+    double argumentOfPerigee;
+    double meanAnomaly;
+    double meanMotion;        // Kozai mean motion
+};
+
+// Julian date of a UTC calendar date (valid 1900 to 2100)
+double julianDate(int year, int month, int day, int hour, int minute, double second);
+
+// Greenwich mean sidereal angle (rad, IAU 1982) at a UT1 Julian date: TEME to pseudo Earth-fixed
+double greenwichSiderealTime(double jdut1);
+
+// Parse one TLE line pair (fixed columns; both checksums must match); false if malformed
+bool parseTle(const char *line1, const char *line2, TleElements &elements);
+
+enum Sgp4Error
+{
+    SGP4_OK = 0,
+    SGP4_BAD_ECCENTRICITY = 1,   // mean eccentricity left [0, 1)
+    SGP4_BAD_MEAN_MOTION = 2,
+    SGP4_BAD_PERTURBED_ECCENTRICITY = 3,
+    SGP4_BAD_SEMI_LATUS_RECTUM = 4,
+    SGP4_DECAYED = 6,            // below the Earth's surface
+};
+
+// Propagation state of one satellite, derived once from its elements. The
+// names follow the reference implementation.
+struct Sgp4Satellite
+{
+    int catalogNumber;
+    double epochJd;
+    bool deepSpace;
+    bool simple; // perigee below 220 km (or deep space): higher order drag terms dropped
+
+    // Mean elements at epoch (no is the un-Kozai'd mean motion)
+    double bstar, inclo, nodeo, ecco, argpo, mo, no;
+
+    // Near-Earth secular and drag coefficients
+    double aycof, con41, cc1, cc4, cc5, d2, d3, d4, delmo, eta, argpdot, omgcof, sinmao, t2cof, t3cof, t4cof,
+        t5cof, x1mth2, x7thm1, mdot, nodedot, xlcof, xmcof, nodecf;
+
+    // Deep-space lunar-solar periodics and secular rates
+    double e3, ee2, peo, pgho, pho, pinco, plo, se2, se3, sgh2, sgh3, sgh4, sh2, sh3, si2, si3, sl2, sl3, sl4,
+        xgh2, xgh3, xgh4, xh2, xh3, xi2, xi3, xl2, xl3, xl4, zmol, zmos, dedt, didt, dmdt, dnodt, domdt, gsto;
+
+    // Deep-space resonance (irez 1: one day, 2: half day) and its integrator state
+    int irez;
+    double d2201, d2211, d3210, d3222, d4410, d4422, d5220, d5232, d5421, d5433, del1, del2, del3, xfact, xlamo;
+    double atime, xli, xni;
+};
+
+// Returns an Sgp4Error (the state is only usable on SGP4_OK)
+int sgp4Init(const TleElements &elements, Sgp4Satellite &satellite);
+
+// Propagate to minutes after the element epoch. Deep-space resonant orbits
+// keep their integrator state between calls, so a satellite must not be
+// propagated from two threads at once. Returns an Sgp4Error.
+int sgp4Propagate(Sgp4Satellite &satellite, double minutes, double position[3], double velocity[3]);
+
+// Mean elements: the secular terms (and for deep space the lunar-solar
+// periodics) without the short-period ones, so the orbit is an ellipse
+// that turns slowly. Good to about 10 km in position in low orbit.
+struct Sgp4MeanElements
+{
+    double semiMajorAxis; // km
+    double eccentricity;
+    double inclination;
+    double rightAscension;
+    double argumentOfPerigee;
+    double meanAnomaly;
+    double meanMotion;    // rad / min
+};
+
+// Mean elements at minutes after the epoch (same state rules as sgp4Propagate); returns an Sgp4Error
+int sgp4MeanElements(Sgp4Satellite &satellite, double minutes, Sgp4MeanElements &mean);
+
+const int SGP4_LANES = 8;
+
+// Near-Earth satellites, one per lane (structure of arrays)
+struct Sgp4Batch
+{
+    int count; // lanes in use; unused lanes repeat the last satellite
+    double bstar[SGP4_LANES], inclo[SGP4_LANES], nodeo[SGP4_LANES], ecco[SGP4_LANES], argpo[SGP4_LANES],
+        mo[SGP4_LANES], no[SGP4_LANES];
+    double aycof[SGP4_LANES], con41[SGP4_LANES], cc1[SGP4_LANES], cc4[SGP4_LANES], cc5[SGP4_LANES],
+        d2[SGP4_LANES], d3[SGP4_LANES], d4[SGP4_LANES], delmo[SGP4_LANES], eta[SGP4_LANES], argpdot[SGP4_LANES],
+        omgcof[SGP4_LANES], sinmao[SGP4_LANES], t2cof[SGP4_LANES], t3cof[SGP4_LANES], t4cof[SGP4_LANES],
+        t5cof[SGP4_LANES], x1mth2[SGP4_LANES], x7thm1[SGP4_LANES], mdot[SGP4_LANES], nodedot[SGP4_LANES],
+        xlcof[SGP4_LANES], xmcof[SGP4_LANES], nodecf[SGP4_LANES];
+    double epochJd[SGP4_LANES];
+    double ao[SGP4_LANES], sinio[SGP4_LANES], cosio[SGP4_LANES]; // derived once per lane
+};
+
+// Fill one lane from a near-Earth satellite
+void sgp4BatchSet(Sgp4Batch &batch, int lane, const Sgp4Satellite &satellite);
+
+// Propagate every lane to the Julian date jd. Positions and velocities are
+// written per lane (km, km/s); errors holds an Sgp4Error per lane.
+void sgp4PropagateBatch(const Sgp4Batch &batch, double jd, double position[3][SGP4_LANES],
+                        double velocity[3][SGP4_LANES], int errors[SGP4_LANES]);
@@ -0,0 +1,244 @@
+#include "shader_cache.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const uint32_t CACHE_MAGIC = 0x4370424f; // "OBpC"
+    const uint32_t CACHE_VERSION = 1;
+
+    // Fixed-size start of every cache file; the driver string and the binary follow
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t binaryFormat;
+        uint32_t driverLength;
+        uint32_t binaryLength;
+    };
+
+    bool gEnabled = false;
+    std::string gDirectory;
+    std::string gDriver; // vendor, renderer and version of the current context
+
+    int gHits = 0;
+    int gMisses = 0;   // no entry for these sources
+    int gRejected = 0; // entry for another driver, or refused by glProgramBinary
+    double gBuildMs = 0.0;
+
+    // FNV-1a, 64-bit
+    uint64_t hashBytes(uint64_t hash, const char *data, size_t length)
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hashSources(const char *vertexSource, const char *fragmentSource)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        hash = hashBytes(hash, vertexSource, strlen(vertexSource) + 1); // the terminator separates the stages
+        return hashBytes(hash, fragmentSource, strlen(fragmentSource));
+    }
+
+    std::string cachePath(const char *name, uint64_t sourceHash)
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(sourceHash));
+        return gDirectory + "/" + name + "-" + hex + ".bin";
+    }
+
+    const char *glString(GLenum name)
+    {
+        const char *value = reinterpret_cast<const char *>(glGetString(name));
+        return value ? value : "";
+    }
+
+    bool checkLinkStatus(GLuint program, bool report)
+    {
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success && report)
+        {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+                      << infoLog << std::endl;
+        }
+        return success == GL_TRUE;
+    }
+
+    // The cached program, or 0 if there is no usable entry
+    GLuint loadCachedProgram(const std::string &path, uint64_t sourceHash)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            ++gMisses;
+            return 0;
+        }
+
+        CacheHeader header;
+        std::string driver;
+        std::vector<char> binary;
+        bool valid = static_cast<bool>(in.read(reinterpret_cast<char *>(&header), sizeof(header))) &&
+                     header.magic == CACHE_MAGIC && header.version == CACHE_VERSION &&
+                     header.sourceHash == sourceHash && header.driverLength == gDriver.size();
+        if (valid)
+        {
+            driver.resize(header.driverLength);
+            binary.resize(header.binaryLength);
+            valid = in.read(&driver[0], driver.size()) && in.read(binary.data(), binary.size()) && driver == gDriver;
+        }
+        if (!valid)
+        {
+            ++gRejected;
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+        if (!checkLinkStatus(program, false))
+        {
+            // Drivers may refuse their own binaries, e.g. after an update that kept the version string
+            glDeleteProgram(program);
+            ++gRejected;
+            return 0;
+        }
+        ++gHits;
+        return program;
+    }
+
+    void storeProgram(const std::string &path, uint64_t sourceHash, GLuint program)
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, &length, &format, binary.data());
+
+        CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, sourceHash, format,
+                              static_cast<uint32_t>(gDriver.size()), static_cast<uint32_t>(length)};
+
+        // Write a temporary file and rename it so a concurrent launch never reads half an entry
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(gDriver.data(), gDriver.size());
+            out.write(binary.data(), length);
+            if (!out)
+            {
+                std::cerr << "ERROR::SHADER_CACHE::WRITE_FAILED " << temporary << std::endl;
+                return;
+            }
+        }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "ERROR::SHADER_CACHE::WRITE_FAILED " << path << std::endl;
+            std::remove(temporary.c_str());
+        }
+    }
+}
+
+GLuint compileShader(GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    // Check for compilation errors
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        GLchar infoLog[512];
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "ERROR::SHADER::COMPILATION_FAILED\n"
+                  << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+void shaderCacheInit()
+{
+    const char *directory = getenv("ORBITAL_SHADER_CACHE");
+    gDirectory = directory ? directory : ".shader_cache";
+    gDriver = std::string(glString(GL_VENDOR)) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+    GLint formats = 0;
+    if (GLEW_ARB_get_program_binary || GLEW_VERSION_4_1)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    gEnabled = formats > 0 && !gDirectory.empty() && gDirectory != "0";
+
+    std::error_code error;
+    if (gEnabled && !std::filesystem::is_directory(gDirectory, error) &&
+        !std::filesystem::create_directories(gDirectory, error))
+    {
+        std::cerr << "ERROR::SHADER_CACHE::CREATE_DIRECTORY_FAILED " << gDirectory << std::endl;
+        gEnabled = false;
+    }
+}
+
+GLuint linkProgram(const char *name, const char *vertexSource, const char *fragmentSource)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t sourceHash = hashSources(vertexSource, fragmentSource);
+    std::string path = gEnabled ? cachePath(name, sourceHash) : std::string();
+
+    GLuint program = gEnabled ? loadCachedProgram(path, sourceHash) : 0;
+    if (!program)
+    {
+        GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+        GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+        if (vertexShader && fragmentShader)
+        {
+            program = glCreateProgram();
+            if (gEnabled)
+                glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glAttachShader(program, vertexShader);
+            glAttachShader(program, fragmentShader);
+            glLinkProgram(program);
+        }
+
+        // Shaders are no longer needed once linked
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+
+        if (program && !checkLinkStatus(program, true))
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+        if (program && gEnabled)
+            storeProgram(path, sourceHash, program);
+    }
+
+    gBuildMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return program;
+}
+
+void shaderCachePrintSummary()
+{
+    if (!gEnabled)
+        return;
+
+    fprintf(stderr, "\nShader cache (%s): %d loaded, %d compiled (%d new, %d stale or rejected), %.2f ms building programs\n",
+            gDirectory.c_str(), gHits, gMisses + gRejected, gMisses, gRejected, gBuildMs);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Shader compilation with a program binary cache. A linked program's
+// glGetProgramBinary blob is saved under the cache directory, keyed by a
+// hash of its sources and checked against the GL vendor/renderer/version
+// string it was built with. The next launch reloads it with glProgramBinary.
+// A missing, stale or rejected entry (different sources or driver, or a
+// driver that refuses its own binary) falls back to compiling from source
+// and rewrites the entry.
+
+// Compile one stage; 0 (after logging) on failure
+GLuint compileShader(GLenum type, const char *source);
+
+// Call after the context is current. ORBITAL_SHADER_CACHE overrides the
+// directory (default ".shader_cache"); setting it to 0 turns the cache off.
+// The cache also stays off without program binary support.
+void shaderCacheInit();
+
+// Build a program from vertex and fragment sources, through the cache when
+// it is on. name only labels the cache file. Returns 0 if compiling or
+// linking fails.
+GLuint linkProgram(const char *name, const char *vertexSource, const char *fragmentSource);
+
+// Cache hits, misses and time spent building programs
+void shaderCachePrintSummary();
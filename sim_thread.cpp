@@ -0,0 +1,607 @@
+#include "sim_thread.h"
+#include "body_bvh.h"
+#include "frame_arena.h"
+#include "frame_governor.h"
+#include "geometry.h"
+#include "trails.h"
+#include "job_graph.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "satellite_catalog.h"
+#include "simulation.h"
+#include "triple_buffer.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <glm/gtc/matrix_transform.hpp>
+#include <mutex>
+#include <thread>
+
+// Satellite and moon orbits (owned by the simulation thread)
+float satelliteOrbitRadius = 1.75f;
+float satelliteAngle = 0.0f;
+float satelliteX = satelliteOrbitRadius;
+float satelliteY = 0.0f;
+
+float satelliteOrbitRadius2 = 1.75f;
+float satelliteAngle2 = 0.0f;
+float satelliteX2 = satelliteOrbitRadius2;
+float satelliteY2 = 0.0f;
+float satelliteZ2 = 0.0f;
+
+namespace
+{
+    // A slot released while building snapshot `sequence`; older snapshots may still draw it
+    struct RetiredSlot
+    {
+        int slot;
+        uint64_t sequence;
+    };
+
+    SimConfig gConfig;
+    TripleBuffer<SimSnapshot> gSnapshots;
+    std::thread gThread;
+    std::atomic<bool> gRunning(false);
+    std::atomic<unsigned> gInput(0);
+
+    // Pacing only; snapshots themselves never go through the mutex
+    std::mutex gPaceMutex;
+    std::condition_variable gPaceCondition;
+    uint64_t gPublishedSequence = 0; // guarded by gPaceMutex
+    uint64_t gConsumedSequence = 0;  // guarded by gPaceMutex
+    std::atomic<uint64_t> gConsumedAtomic(0);
+
+    // Render-thread state
+    uint64_t gHeldSequence = 0;
+
+    // Slot free list (simulation thread)
+    std::vector<int> gFreeSlots;
+    std::vector<RetiredSlot> gRetiredSlots;
+    uint64_t gBuildingSequence = 0;
+    uint32_t gLastAsteroidId = 0;
+
+    // Picking (simulation thread). Bodies are numbered as in the trails:
+    // satellite 0, moon 1, then asteroid slot + 2.
+    BodyBvh gBodyBvh;
+    std::vector<int> gNeighbours;
+    uint32_t gSelectedId = 0;
+
+    // Satellite catalog (simulation thread and its slice jobs)
+    const int CATALOG_SLICES = 8;
+    SatelliteCatalog gCatalog;
+
+    // Newest pick request from the render thread
+    std::mutex gPickMutex;
+    glm::vec3 gPickOrigin;    // guarded by gPickMutex
+    glm::vec3 gPickDirection; // guarded by gPickMutex
+    std::atomic<bool> gPickPending(false);
+
+    // Single-producer/single-consumer queue of meshes waiting for upload,
+    // sized at two entries per slot so a full queue only happens if the
+    // render thread stops draining it
+    std::vector<int> gUploadSlots;
+    std::vector<float> gUploadPositions;
+    std::atomic<size_t> gUploadHead(0); // advanced by the simulation thread
+    std::atomic<size_t> gUploadTail(0); // advanced by the render thread
+
+    // Transient data of a step (simulation thread and its jobs), double-buffered
+    // like the render thread's frame arenas and advanced once per step
+    FrameArenas gStepArenas;
+    const size_t STEP_ARENA_BYTES = 256 * 1024;
+
+    LinearArena &stepArena()
+    {
+        return gStepArenas.arenas[gStepArenas.current];
+    }
+
+    size_t slotFloats()
+    {
+        return static_cast<size_t>(gConfig.vertsPerSlot) * 3;
+    }
+
+    // Hand a removed asteroid's slot back once no snapshot the render thread can still hold uses it
+    void retireAsteroidSlot(Asteroid &asteroid)
+    {
+        gRetiredSlots.push_back({asteroid.slot, gBuildingSequence});
+        bvhRemoveBody(gBodyBvh, asteroid.slot + 2);
+        asteroid.slot = -1;
+    }
+
+    void recycleSlots()
+    {
+        uint64_t consumed = gConsumedAtomic.load(std::memory_order_acquire);
+        size_t kept = 0;
+        for (const RetiredSlot &retired : gRetiredSlots)
+        {
+            if (retired.sequence <= consumed)
+                gFreeSlots.push_back(retired.slot);
+            else
+                gRetiredSlots[kept++] = retired;
+        }
+        gRetiredSlots.resize(kept);
+    }
+
+    glm::mat4 asteroidModelMatrix(const Asteroid &asteroid)
+    {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, asteroid.position);
+        model = glm::rotate(model, glm::radians(asteroid.rotation), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::scale(model, glm::vec3(asteroid.size / 2));
+        return model;
+    }
+
+    // Function to spawn a new asteroid; false when no slot (or upload entry) is free
+    bool spawnAsteroid()
+    {
+        PROFILE_STAGE("spawnAsteroid");
+        if (gFreeSlots.empty())
+            return false;
+
+        Asteroid asteroid;
+
+        // Random angle for spawn position
+        float angle = static_cast<float>(rand()) / RAND_MAX * 2.0f * M_PI;
+
+        // Set random position on circle
+        asteroid.position = glm::vec3(
+            SPAWN_RADIUS * cos(angle),
+            SPAWN_RADIUS * sin(angle),
+            0.0f);
+
+        // Calculate velocity vector towards center
+        glm::vec3 direction = glm::normalize(-asteroid.position);
+        float speed = 2.0f + static_cast<float>(rand()) / RAND_MAX * 2.0f;
+        asteroid.velocity = direction * speed;
+
+        // Random size and rotation
+        asteroid.size = MIN_ASTEROID_SIZE +
+                        static_cast<float>(rand()) / RAND_MAX * (MAX_ASTEROID_SIZE - MIN_ASTEROID_SIZE);
+        asteroid.rotation = static_cast<float>(rand()) / RAND_MAX * 360.0f;
+
+        // Generate the mesh into scratch from this step's arena
+        FrameVector<float> vertices = makeFrameVector<float>(stepArena());
+        FrameVector<unsigned int> indices = makeFrameVector<unsigned int>(stepArena());
+        generateAsteroidMesh(asteroid.size, ASTEROID_SECTORS, ASTEROID_STACKS, vertices, indices);
+        if (vertices.size() != slotFloats())
+            return false;
+
+        // Queue the mesh; the render thread uploads it before drawing the next snapshot
+        size_t head = gUploadHead.load(std::memory_order_relaxed);
+        if (head - gUploadTail.load(std::memory_order_acquire) >= gUploadSlots.size())
+            return false;
+
+        // Ids 1 and 2 are the satellite's and the moon's
+        gLastAsteroidId = gLastAsteroidId >= TRAIL_MAX_ID ? 3 : std::max(gLastAsteroidId + 1, 3u);
+        asteroid.id = gLastAsteroidId;
+        asteroid.slot = gFreeSlots.back();
+        gFreeSlots.pop_back();
+
+        size_t entry = head % gUploadSlots.size();
+        gUploadSlots[entry] = asteroid.slot;
+        memcpy(&gUploadPositions[entry * slotFloats()], vertices.data(), slotFloats() * sizeof(float));
+        gUploadHead.store(head + 1, std::memory_order_release);
+
+        asteroids.push_back(asteroid);
+        return true;
+    }
+
+    // Inputs and outputs of one step, shared by the step's jobs
+    struct SimStep
+    {
+        SimSnapshot *snapshot;
+        float currentTime;
+        float deltaTime;
+        float lastSpawnTime;
+        glm::vec3 satellitePos;
+        glm::vec3 moonPos;
+        glm::vec3 satelliteVelocity;
+        glm::vec3 moonVelocity;
+        float moonTilt;
+        int selectedAsteroid; // index of the selected asteroid, -1 if none
+        double catalogJd;
+    };
+
+    struct CatalogSlice
+    {
+        SimStep *step;
+        int index;
+    };
+
+    const float SATELLITE_RADIUS = 0.08f;
+    const float SATELLITE_BOUNDS = 0.16f; // drawn radius: the 0.08 sphere scaled by 2
+    const float MOON_BOUNDS = 0.32f;      // the same sphere scaled by 4
+
+    void spawnJob(void *context)
+    {
+        SimStep &step = *static_cast<SimStep *>(context);
+        recycleSlots();
+
+        // Update spawn timer
+        if (gConfig.holdAsteroids > 0)
+        {
+            // Keep the asteroid population fixed
+            while (asteroids.size() < static_cast<size_t>(gConfig.holdAsteroids) && spawnAsteroid())
+            {
+            }
+        }
+        else if (step.currentTime - step.lastSpawnTime >= gConfig.spawnInterval * governorSpawnIntervalScale())
+        {
+            spawnAsteroid();
+            step.lastSpawnTime = step.currentTime;
+        }
+    }
+
+    void orbitsJob(void *context)
+    {
+        SimStep &step = *static_cast<SimStep *>(context);
+
+        // Satellite movement logic
+        unsigned input = gInput.load(std::memory_order_relaxed);
+        if (input & SIM_INPUT_ANGLE_UP)
+            satelliteAngle += 0.02f;
+        if (input & SIM_INPUT_ANGLE_DOWN)
+            satelliteAngle -= 0.02f;
+        if (input & SIM_INPUT_RADIUS_UP)
+            satelliteOrbitRadius += 0.01f;
+        if (input & SIM_INPUT_RADIUS_DOWN)
+            satelliteOrbitRadius -= 0.01f;
+
+        // Clamp the orbit radius
+        if (satelliteOrbitRadius < 0.1f)
+            satelliteOrbitRadius = 0.1f;
+
+        satelliteX = satelliteOrbitRadius * cos(satelliteAngle);
+        satelliteY = satelliteOrbitRadius * sin(satelliteAngle);
+        glm::vec3 satellitePos(satelliteX, satelliteY, 0.0f);
+        if (step.deltaTime > 0.0f)
+            step.satelliteVelocity = (satellitePos - step.satellitePos) / step.deltaTime;
+        step.satellitePos = satellitePos;
+
+        // Reduced speed for tilt oscillation (from 10.0f to 2.0f)
+        float tiltAngle = glm::radians(45.0f + 2.0f * sin(step.currentTime));
+        step.moonTilt = tiltAngle;
+
+        // Calculate position with tilt
+        satelliteX2 = satelliteOrbitRadius2 * cos(satelliteAngle2);
+        satelliteY2 = satelliteOrbitRadius2 * sin(satelliteAngle2) * sin(tiltAngle);
+        satelliteZ2 = satelliteOrbitRadius2 * sin(satelliteAngle2) * cos(tiltAngle);
+
+        glm::vec3 moonPos(satelliteX2, satelliteY2, satelliteZ2);
+        if (step.deltaTime > 0.0f)
+            step.moonVelocity = (moonPos - step.moonPos) / step.deltaTime;
+        step.moonPos = moonPos;
+
+        // Reduced orbital rotation speed (from 0.01f to 0.003f)
+        satelliteAngle2 += 0.01f;
+    }
+
+    void integrateJob(void *context)
+    {
+        SimStep &step = *static_cast<SimStep *>(context);
+        integrateAsteroids(asteroids, step.deltaTime);
+    }
+
+    void collideJob(void *context)
+    {
+        SimStep &step = *static_cast<SimStep *>(context);
+        removeAsteroids(asteroids, step.satellitePos, SATELLITE_RADIUS, retireAsteroidSlot, step.deltaTime,
+                        governorSubsteps());
+    }
+
+    void refitBvhJob(void *context)
+    {
+        SimStep &step = *static_cast<SimStep *>(context);
+        bvhSetBody(gBodyBvh, 0, step.satellitePos, SATELLITE_BOUNDS);
+        bvhSetBody(gBodyBvh, 1, step.moonPos, MOON_BOUNDS);
+        step.selectedAsteroid = -1;
+        for (size_t i = 0; i < asteroids.size(); ++i)
+        {
+            const Asteroid &asteroid = asteroids[i];
+            bvhSetBody(gBodyBvh, asteroid.slot + 2, asteroid.position, asteroidBoundingRadius(asteroid));
+            if (asteroid.id == gSelectedId)
+                step.selectedAsteroid = static_cast<int>(i);
+        }
+        bvhUpdate(gBodyBvh);
+    }
+
+    // Apply the newest pick request, then report the selected body
+    void inspectJob(void *context)
+    {
+        SimStep &step = *static_cast<SimStep *>(context);
+        if (gPickPending.exchange(false, std::memory_order_acquire))
+        {
+            glm::vec3 origin, direction;
+            {
+                std::lock_guard<std::mutex> lock(gPickMutex);
+                origin = gPickOrigin;
+                direction = gPickDirection;
+            }
+
+            // Nothing behind the Earth can be picked
+            float maxDistance = FLT_MAX;
+            float along = glm::dot(-origin, direction);
+            float missSquared = glm::dot(origin, origin) - along * along;
+            if (along > 0.0f && missSquared < EARTH_RADIUS * EARTH_RADIUS)
+                maxDistance = along - std::sqrt(EARTH_RADIUS * EARTH_RADIUS - missSquared);
+
+            int body = bvhRayPick(gBodyBvh, origin, direction, maxDistance, nullptr);
+            gSelectedId = body >= 0 && body < 2 ? body + 1 : 0;
+            step.selectedAsteroid = -1;
+            for (size_t i = 0; body >= 2 && i < asteroids.size(); ++i)
+            {
+                if (asteroids[i].slot == body - 2)
+                {
+                    gSelectedId = asteroids[i].id;
+                    step.selectedAsteroid = static_cast<int>(i);
+                    break;
+                }
+            }
+        }
+
+        SimSnapshot &snapshot = *step.snapshot;
+        snapshot.selectedId = 0;
+        snapshot.selectedNeighbours = 0;
+        if (gSelectedId == 1)
+        {
+            snapshot.selectedPosition = step.satellitePos;
+            snapshot.selectedVelocity = step.satelliteVelocity;
+        }
+        else if (gSelectedId == 2)
+        {
+            snapshot.selectedPosition = step.moonPos;
+            snapshot.selectedVelocity = step.moonVelocity;
+        }
+        else if (step.selectedAsteroid >= 0)
+        {
+            snapshot.selectedPosition = asteroids[step.selectedAsteroid].position;
+            snapshot.selectedVelocity = asteroids[step.selectedAsteroid].velocity;
+        }
+        else
+        {
+            gSelectedId = 0; // the selected asteroid is gone
+            return;
+        }
+
+        snapshot.selectedId = gSelectedId;
+        bvhQueryRadius(gBodyBvh, snapshot.selectedPosition, SIM_NEIGHBOUR_RADIUS, gNeighbours);
+        snapshot.selectedNeighbours = static_cast<int>(gNeighbours.size()) - 1; // not counting itself
+    }
+
+    // Slices write disjoint parts of the positions (and own disjoint deep-space states)
+    void catalogJob(void *context)
+    {
+        CatalogSlice &slice = *static_cast<CatalogSlice *>(context);
+        catalogPropagate(gCatalog, slice.step->catalogJd, slice.index, CATALOG_SLICES,
+                         slice.step->snapshot->catalogPositions.data());
+    }
+
+    void buildInstancesJob(void *context)
+    {
+        SimStep &step = *static_cast<SimStep *>(context);
+        SimSnapshot &snapshot = *step.snapshot;
+        snapshot.sequence = gBuildingSequence;
+        snapshot.time = step.currentTime;
+        snapshot.satellitePos = step.satellitePos;
+        snapshot.moonPos = step.moonPos;
+        snapshot.satelliteOrbitRadius = satelliteOrbitRadius;
+        snapshot.moonOrbitRadius = satelliteOrbitRadius2;
+        snapshot.moonOrbitTilt = step.moonTilt;
+        snapshot.catalogJd = step.catalogJd;
+
+        // Near asteroids fill the instances from the front, far ones from the back
+        float lodDistance = governorLodDistance();
+        int near = 0;
+        int far = static_cast<int>(asteroids.size());
+        snapshot.asteroidInstances.resize(asteroids.size());
+        snapshot.asteroidIds.resize(asteroids.size());
+        for (const Asteroid &asteroid : asteroids)
+        {
+            int row = glm::length(asteroid.position - CAMERA_POSITION) < lodDistance ? near++ : --far;
+            snapshot.asteroidInstances[row] = {asteroidModelMatrix(asteroid), asteroid.slot};
+            snapshot.asteroidIds[row] = asteroid.id;
+        }
+        snapshot.fullDetailCount = near;
+    }
+
+    void simThreadMain()
+    {
+#ifdef ENABLE_PROFILER
+        profilerSetThreadName("simulation");
+#endif
+        SimStep step = {};
+
+        // spawn -> integrate -> collide -> buildInstances, with the orbits alongside;
+        // refitBvh -> inspect also follow collide. The catalog slices depend on nothing.
+        JobGraph graph("simulation");
+        int spawn = graph.addJob("spawn", spawnJob, &step);
+        int orbits = graph.addJob("orbits", orbitsJob, &step);
+        int integrate = graph.addJob("integrate", integrateJob, &step);
+        int collide = graph.addJob("collide", collideJob, &step);
+        int buildInstances = graph.addJob("buildInstances", buildInstancesJob, &step);
+        int refitBvh = graph.addJob("refitBvh", refitBvhJob, &step);
+        int inspect = graph.addJob("inspect", inspectJob, &step);
+        graph.addDependency(spawn, integrate);
+        graph.addDependency(integrate, collide);
+        graph.addDependency(orbits, collide);
+        graph.addDependency(collide, buildInstances);
+        graph.addDependency(collide, refitBvh);
+        graph.addDependency(refitBvh, inspect);
+        CatalogSlice catalogSlices[CATALOG_SLICES];
+        for (int i = 0; i < CATALOG_SLICES && catalogSize(gCatalog) > 0; ++i)
+        {
+            catalogSlices[i] = {&step, i};
+            graph.addJob("catalog", catalogJob, &catalogSlices[i]);
+        }
+        double catalogStartJd = gConfig.catalogStartJd > 0.0 ? gConfig.catalogStartJd : gCatalog.newestEpochJd;
+
+        auto start = std::chrono::steady_clock::now();
+        float lastTime = 0.0f;
+        uint64_t stepIndex = 0;
+
+        while (gRunning.load(std::memory_order_relaxed))
+        {
+            // Run at most one snapshot ahead of the render thread
+            {
+                std::unique_lock<std::mutex> lock(gPaceMutex);
+                gPaceCondition.wait(lock, [] {
+                    return gConsumedSequence >= gPublishedSequence || !gRunning.load(std::memory_order_relaxed);
+                });
+            }
+            if (!gRunning.load(std::memory_order_relaxed))
+                break;
+
+            float currentTime = gConfig.fixedStep > 0.0f
+                                    ? stepIndex * gConfig.fixedStep
+                                    : std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+            float deltaTime = currentTime - lastTime;
+            lastTime = currentTime;
+
+            gBuildingSequence = stepIndex + 1;
+            frameArenasAdvance(gStepArenas);
+            step.snapshot = &gSnapshots.writeBuffer();
+            step.currentTime = currentTime;
+            step.deltaTime = deltaTime;
+            step.catalogJd = catalogStartJd + static_cast<double>(currentTime) * gConfig.catalogTimeScale / 86400.0;
+            {
+                PROFILE_STAGE("simStep");
+                graph.run();
+            }
+            step.snapshot->stepNs = graph.lastWallNs();
+            gSnapshots.publish();
+            ++stepIndex;
+
+            {
+                std::lock_guard<std::mutex> lock(gPaceMutex);
+                gPublishedSequence = gBuildingSequence;
+            }
+            gPaceCondition.notify_all();
+        }
+
+#ifdef ENABLE_PROFILER
+        graph.printSummary();
+#endif
+    }
+}
+
+bool simThreadStart(const SimConfig &config)
+{
+    if (gRunning.load() || config.slotCapacity <= 0 || config.vertsPerSlot <= 0)
+        return false;
+
+    gConfig = config;
+    asteroids.clear();
+    asteroids.reserve(config.slotCapacity);
+
+    // A catalog file that cannot be read leaves the catalog empty
+    gCatalog = SatelliteCatalog();
+    if (!config.catalogPath.empty())
+        catalogLoad(gCatalog, config.catalogPath.c_str());
+    else if (config.syntheticCatalog > 0)
+        catalogGenerate(gCatalog, config.syntheticCatalog, config.catalogSeed);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        gSnapshots.buffer(i).asteroidInstances.reserve(config.slotCapacity);
+        gSnapshots.buffer(i).asteroidIds.reserve(config.slotCapacity);
+        gSnapshots.buffer(i).catalogPositions.assign(catalogSize(gCatalog), glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+    }
+
+    // Hand out low slots first
+    gFreeSlots.clear();
+    gFreeSlots.reserve(config.slotCapacity);
+    for (int slot = config.slotCapacity - 1; slot >= 0; --slot)
+        gFreeSlots.push_back(slot);
+    gRetiredSlots.clear();
+    gRetiredSlots.reserve(config.slotCapacity);
+
+    gUploadSlots.assign(2 * config.slotCapacity, -1);
+    gUploadPositions.assign(gUploadSlots.size() * slotFloats(), 0.0f);
+    gUploadHead.store(0);
+    gUploadTail.store(0);
+
+    frameArenasInit(gStepArenas, STEP_ARENA_BYTES);
+
+    gPublishedSequence = 0;
+    gConsumedSequence = 0;
+    gConsumedAtomic.store(0);
+    gHeldSequence = 0;
+    gLastAsteroidId = 0;
+
+    bvhInit(gBodyBvh, config.slotCapacity + 2);
+    gNeighbours.reserve(config.slotCapacity + 2);
+    gSelectedId = 0;
+    gPickPending.store(false);
+
+    gRunning.store(true);
+    gThread = std::thread(simThreadMain);
+    return true;
+}
+
+void simThreadStop()
+{
+    if (!gRunning.load())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(gPaceMutex);
+        gRunning.store(false);
+    }
+    gPaceCondition.notify_all();
+    gThread.join();
+}
+
+void simSetInput(unsigned bits)
+{
+    gInput.store(bits, std::memory_order_relaxed);
+}
+
+void simRequestPick(const glm::vec3 &origin, const glm::vec3 &direction)
+{
+    {
+        std::lock_guard<std::mutex> lock(gPickMutex);
+        gPickOrigin = origin;
+        gPickDirection = glm::normalize(direction);
+    }
+    gPickPending.store(true, std::memory_order_release);
+}
+
+const SimSnapshot *simAcquireSnapshot(bool waitForNew)
+{
+    if (waitForNew || gHeldSequence == 0)
+    {
+        PROFILE_ZONE("waitForSnapshot");
+        std::unique_lock<std::mutex> lock(gPaceMutex);
+        gPaceCondition.wait(lock, [] {
+            return gPublishedSequence > gHeldSequence || !gRunning.load(std::memory_order_relaxed);
+        });
+    }
+
+    if (gSnapshots.update())
+    {
+        gHeldSequence = gSnapshots.readBuffer().sequence;
+        gConsumedAtomic.store(gHeldSequence, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(gPaceMutex);
+            gConsumedSequence = gHeldSequence;
+        }
+        gPaceCondition.notify_all();
+    }
+    return gHeldSequence > 0 ? &gSnapshots.readBuffer() : nullptr;
+}
+
+void simUploadPendingMeshes(AsteroidPool &pool)
+{
+    size_t tail = gUploadTail.load(std::memory_order_relaxed);
+    size_t head = gUploadHead.load(std::memory_order_acquire);
+    for (; tail != head; ++tail)
+    {
+        size_t entry = tail % gUploadSlots.size();
+        asteroidPoolUpload(pool, gUploadSlots[entry], &gUploadPositions[entry * slotFloats()]);
+    }
+    gUploadTail.store(tail, std::memory_order_release);
+}
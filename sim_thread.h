@@ -0,0 +1,84 @@
+#pragma once
+
+#include "asteroid_pool.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+// Simulation thread. Asteroid spawning and stepping, the satellite and
+// moon orbits, the bounding volume hierarchy used for picking and the
+// propagation of the satellite catalog (spread over the worker threads in
+// slices) run here, and every step is published as an immutable
+// snapshot through a lock-free triple buffer. The render thread draws the
+// newest snapshot while the next step is being computed, so a slow physics
+// step delays the next snapshot instead of stalling the frame being drawn.
+// The spawn rate, collision substeps and asteroid LOD distance follow the
+// frame governor's current settings (see frame_governor.h).
+
+// State of one simulation step
+struct SimSnapshot
+{
+    uint64_t sequence = 0;
+    float time = 0.0f;
+    glm::vec3 satellitePos;
+    glm::vec3 moonPos;
+    // Orbit elements, for drawing the orbit tracks
+    float satelliteOrbitRadius = 0.0f; // circle in the XY plane
+    float moonOrbitRadius = 0.0f;      // circle in the plane of X and (0, sin(tilt), cos(tilt))
+    float moonOrbitTilt = 0.0f;
+    std::vector<AsteroidInstance> asteroidInstances; // reserved to the slot capacity
+    std::vector<uint32_t> asteroidIds;               // spawn id of each instance
+    int fullDetailCount = 0;                         // leading instances drawn with the full mesh
+    uint64_t stepNs = 0;                             // wall time of the step that built this snapshot
+    // Body picked with the mouse (ids as in the trails: 1 satellite, 2 moon, then asteroids)
+    uint32_t selectedId = 0; // 0 if nothing is selected
+    glm::vec3 selectedPosition;
+    glm::vec3 selectedVelocity;
+    int selectedNeighbours = 0; // other bodies within SIM_NEIGHBOUR_RADIUS of it
+    // Satellite catalog at catalogJd, one entry per object (see catalogPropagate)
+    double catalogJd = 0.0;
+    std::vector<glm::vec4> catalogPositions;
+};
+
+const float SIM_NEIGHBOUR_RADIUS = 1.0f;
+
+// Satellite controls sampled on the render thread (GLFW input stays on the main thread)
+enum SimInputBits
+{
+    SIM_INPUT_ANGLE_UP = 1 << 0,    // A
+    SIM_INPUT_ANGLE_DOWN = 1 << 1,  // D
+    SIM_INPUT_RADIUS_UP = 1 << 2,   // W
+    SIM_INPUT_RADIUS_DOWN = 1 << 3, // S
+};
+
+struct SimConfig
+{
+    int slotCapacity = 1024;
+    int vertsPerSlot = 0;
+    float fixedStep = 0.0f;     // > 0: advance time by exactly this much per step
+    int holdAsteroids = 0;      // > 0: keep this many asteroids alive instead of timed spawns
+    float spawnInterval = 2.0f; // seconds between timed spawns, before the governor's scale
+    std::string catalogPath;    // TLE or OMM file of the satellite catalog, empty for none
+    int syntheticCatalog = 0;   // without a file: objects of a made-up catalog
+    unsigned int catalogSeed = 1;
+    double catalogStartJd = 0.0;    // catalog time at the first step; 0: its newest element epoch
+    float catalogTimeScale = 60.0f; // catalog seconds per simulation second
+};
+
+bool simThreadStart(const SimConfig &config);
+void simThreadStop();
+
+void simSetInput(unsigned bits);
+
+// Select the nearest body the ray (world space) hits in front of the Earth,
+// or clear the selection if it hits none. Applied by the next step.
+void simRequestPick(const glm::vec3 &origin, const glm::vec3 &direction);
+
+// Take the newest published snapshot. With waitForNew (or before the first
+// snapshot) this blocks until one newer than the held snapshot is ready;
+// otherwise the held snapshot is returned again. Null once stopped.
+const SimSnapshot *simAcquireSnapshot(bool waitForNew);
+
+// Upload the meshes of asteroids spawned since the last call (render thread)
+void simUploadPendingMeshes(AsteroidPool &pool);
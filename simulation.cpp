@@ -0,0 +1,105 @@
+#include "simulation.h"
+#include <cmath>
+#include <cstdlib>
+
+// Global variables
+std::vector<Asteroid> asteroids;
+
+bool checkCollision(const glm::vec3 &satellitePos, float satelliteRadius, const Asteroid &asteroid)
+{
+    // Calculate distance between centers
+    float distance = glm::length(satellitePos - asteroid.position);
+
+    // If distance is less than satellite radius + asteroid size, collision occurred
+    return distance < (satelliteRadius + asteroid.size);
+}
+
+float asteroidBoundingRadius(const Asteroid &asteroid)
+{
+    // The mesh has radius size with up to 15% noise, and is drawn scaled by size / 2
+    return asteroid.size * 1.15f * asteroid.size / 2;
+}
+
+// Function to generate random star positions
+void generateStars(int numStars, std::vector<glm::vec3> &stars)
+{
+    for (int i = 0; i < numStars; ++i)
+    {
+        // Random distance from the center (you can adjust the range)
+        float distance = 4.0f + static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0f; // Range from 8 to 10
+        // Random initial angle
+        float angle = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * 2.0f * M_PI; // Random angle in radians
+
+        // Push the generated star position into the vector
+        stars.push_back(glm::vec3(distance * cos(angle), distance * sin(angle), 0.0f)); // Using the proper constructor
+    }
+}
+
+// Function to advance asteroids without touching any GL state
+void integrateAsteroids(std::vector<Asteroid> &field, float deltaTime)
+{
+    integrateAsteroids(field, deltaTime, AsteroidForces(), ForceStep());
+}
+
+// Test the satellite against earlier points of the asteroid's last step
+static bool checkSweptCollision(const glm::vec3 &satellitePos, float satelliteRadius, const Asteroid &asteroid,
+                                float sweepTime, int substeps)
+{
+    for (int k = 1; k < substeps; ++k)
+    {
+        glm::vec3 position = asteroid.position - asteroid.velocity * (sweepTime * k / substeps);
+        if (glm::length(satellitePos - position) < satelliteRadius + asteroid.size)
+            return true;
+    }
+    return false;
+}
+
+void removeAsteroids(std::vector<Asteroid> &field, const glm::vec3 &satellitePos, float satelliteRadius,
+                     void (*onRemove)(Asteroid &), float sweepTime, int substeps)
+{
+    size_t i = 0;
+    while (i < field.size())
+    {
+        Asteroid &asteroid = field[i];
+
+        // Check for collision with satellite, or if asteroid is too close to center or too far
+        float distance = glm::length(asteroid.position);
+        if (checkCollision(satellitePos, satelliteRadius, asteroid) ||
+            checkSweptCollision(satellitePos, satelliteRadius, asteroid, sweepTime, substeps) ||
+            distance < 1.0f || distance > SPAWN_RADIUS + 2.0f)
+        {
+            if (onRemove)
+                onRemove(asteroid);
+
+            // Swap-and-pop; the swapped-in asteroid is checked on the next pass
+            asteroid = field.back();
+            field.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void stepAsteroids(std::vector<Asteroid> &field, float deltaTime, const glm::vec3 &satellitePos,
+                   float satelliteRadius, void (*onRemove)(Asteroid &))
+{
+    integrateAsteroids(field, deltaTime);
+    removeAsteroids(field, satellitePos, satelliteRadius, onRemove);
+}
+
+void computeStarPositions(const std::vector<glm::vec3> &stars, float time, float starDistance,
+                          glm::vec3 *positions)
+{
+    for (size_t i = 0; i < stars.size(); ++i)
+    {
+        // Calculate angle for revolution
+        float angle = time + (i * (2.0f * M_PI / stars.size())); // Offset each star's angle
+
+        // Position stars in a circular path around the sphere
+        float x = starDistance * cos(angle);         // Circular motion on x-axis
+        float z = starDistance * sin(angle);         // Circular motion on z-axis
+        positions[i] = glm::vec3(x, stars[i].y, z); // Keep the original y position of the star
+    }
+}
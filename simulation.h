@@ -0,0 +1,80 @@
+#pragma once
+
+#include "force_model.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+// Structure for asteroid
+struct Asteroid
+{
+    glm::vec3 position;
+    glm::vec3 velocity;
+    float size;
+    float rotation;
+    int slot;         // mesh slot in the asteroid pool, -1 if none
+    unsigned int id;  // distinct for every spawn (used by the trails)
+};
+
+// Global variables
+extern std::vector<Asteroid> asteroids;
+const float SPAWN_RADIUS = 8.0f;
+const float MIN_ASTEROID_SIZE = 0.4f;
+const float MAX_ASTEROID_SIZE = 0.6f;
+const glm::vec3 CAMERA_POSITION(0.0f, 0.0f, 5.0f);
+const float EARTH_RADIUS = 1.0f;
+
+bool checkCollision(const glm::vec3 &satellitePos, float satelliteRadius, const Asteroid &asteroid);
+
+// Radius of a sphere around the asteroid's drawn mesh
+float asteroidBoundingRadius(const Asteroid &asteroid);
+
+// Forces on the asteroid field, in scene units: none, so asteroids keep
+// their velocity. A term added here (say PointMass with mu in scene units)
+// compiles straight into the integration loop.
+typedef ForceModel<> AsteroidForces;
+
+// Advance asteroid positions and rotations under AsteroidForces
+void integrateAsteroids(std::vector<Asteroid> &field, float deltaTime);
+
+// Advance asteroid positions and rotations under a force model, by
+// semi-implicit Euler: the velocity takes the step's acceleration, then the
+// position moves along the new velocity. Each asteroid therefore moves in a
+// straight line over a step, which is the path removeAsteroids sweeps back
+// along, so collisions need no knowledge of the model. An empty model
+// leaves the velocity out altogether.
+template <typename Model>
+void integrateAsteroids(std::vector<Asteroid> &field, float deltaTime, const Model &model, const ForceStep &step)
+{
+    for (Asteroid &asteroid : field)
+    {
+        if constexpr (!Model::empty)
+        {
+            glm::vec3 acceleration;
+            model.acceleration(step, ForceBody(), &asteroid.position[0], &asteroid.velocity[0], &acceleration[0]);
+            asteroid.velocity += acceleration * deltaTime;
+        }
+        asteroid.position += asteroid.velocity * deltaTime;
+        asteroid.rotation += 45.0f * deltaTime;
+    }
+}
+
+// Remove the asteroids that hit the satellite or left the field.
+// onRemove (may be null) is called for each asteroid before it is removed.
+// Removal swaps in the last asteroid, so the order of the field is not kept.
+// With substeps > 1 the satellite is also tested against that many points
+// along each asteroid's motion over the last sweepTime seconds, so a fast
+// asteroid cannot pass through it between two steps.
+void removeAsteroids(std::vector<Asteroid> &field, const glm::vec3 &satellitePos, float satelliteRadius,
+                     void (*onRemove)(Asteroid &), float sweepTime = 0.0f, int substeps = 1);
+
+// integrateAsteroids followed by removeAsteroids
+void stepAsteroids(std::vector<Asteroid> &field, float deltaTime, const glm::vec3 &satellitePos,
+                   float satelliteRadius, void (*onRemove)(Asteroid &));
+
+// Function to generate random star positions
+void generateStars(int numStars, std::vector<glm::vec3> &stars);
+
+// Function to compute the current position of every star on its circular path
+// (positions must hold stars.size() entries)
+void computeStarPositions(const std::vector<glm::vec3> &stars, float time, float starDistance,
+                          glm::vec3 *positions);
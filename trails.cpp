@@ -0,0 +1,85 @@
+#include "trails.h"
+#include "frame_bench.h"
+#include <algorithm>
+#include <iostream>
+
+bool trailsInit(TrailBuffer &trails, GLuint program, int bodies)
+{
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    if (static_cast<long long>(bodies) * TRAIL_LENGTH > maxTexels)
+    {
+        std::cerr << "ERROR::TRAILS::BODIES_EXCEED_TEXTURE_BUFFER " << bodies << std::endl;
+        return false;
+    }
+
+    trails.bodies = bodies;
+    trails.head = -1;
+    trails.drawBodies = 0;
+    trails.column.assign(bodies, glm::vec4(0.0f));
+
+    // Every sample starts empty (id 0)
+    std::vector<glm::vec4> empty(static_cast<size_t>(bodies) * TRAIL_LENGTH, glm::vec4(0.0f));
+    glGenVertexArrays(1, &trails.vao);
+    glGenBuffers(1, &trails.sampleBuffer);
+    glGenTextures(1, &trails.sampleTexture);
+    glBindBuffer(GL_TEXTURE_BUFFER, trails.sampleBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, empty.size() * sizeof(glm::vec4), empty.data(), GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, trails.sampleTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, trails.sampleBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    trails.headLocation = glGetUniformLocation(program, "head");
+    trails.bodiesLocation = glGetUniformLocation(program, "bodies");
+    trails.lengthLocation = glGetUniformLocation(program, "trailLength");
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "trailSamples"), 0);
+    return true;
+}
+
+void trailsDestroy(TrailBuffer &trails)
+{
+    glDeleteVertexArrays(1, &trails.vao);
+    glDeleteBuffers(1, &trails.sampleBuffer);
+    glDeleteTextures(1, &trails.sampleTexture);
+    trails = TrailBuffer();
+}
+
+void trailsBeginSample(TrailBuffer &trails)
+{
+    std::fill(trails.column.begin(), trails.column.begin() + trails.drawBodies, glm::vec4(0.0f));
+    trails.drawBodies = 0;
+}
+
+void trailsSetBody(TrailBuffer &trails, int body, const glm::vec3 &position, uint32_t id)
+{
+    if (body < 0 || body >= trails.bodies)
+        return;
+    trails.column[body] = glm::vec4(position, static_cast<float>(id));
+    trails.drawBodies = std::max(trails.drawBodies, body + 1);
+}
+
+void trailsEndSample(TrailBuffer &trails)
+{
+    // Bodies past drawBodies are not drawn, so their stale texels never matter
+    trails.head = (trails.head + 1) % TRAIL_LENGTH;
+    glBindBuffer(GL_TEXTURE_BUFFER, trails.sampleBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(trails.head) * trails.bodies * sizeof(glm::vec4),
+                    trails.drawBodies * sizeof(glm::vec4), trails.column.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void trailsDraw(TrailBuffer &trails)
+{
+    if (trails.head < 0 || trails.drawBodies == 0)
+        return;
+
+    glUniform1i(trails.headLocation, trails.head);
+    glUniform1i(trails.bodiesLocation, trails.bodies);
+    glUniform1i(trails.lengthLocation, TRAIL_LENGTH);
+    glActiveTexture(GL_TEXTURE0);
+    statsBindTexture(GL_TEXTURE_BUFFER, trails.sampleTexture);
+    statsBindVertexArray(trails.vao);
+    statsDrawArraysInstanced(GL_LINES, 0, 2 * (TRAIL_LENGTH - 1), trails.drawBodies);
+}
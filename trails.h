@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Motion trails for every moving body. The GPU holds a ring of the last
+// TRAIL_LENGTH positions of each body: one column per sample, one RGBA32F
+// texel per body (xyz position, w the id of the body that wrote it). Each
+// new sample is a single glBufferSubData of one column, and all trails are
+// one instanced GL_LINES draw that reads the ring in the vertex shader
+// (instance = body, vertex pair = segment). Segments that reach back past
+// a body's spawn, into samples of a slot's previous owner or of an empty
+// slot, are moved outside the clip volume.
+
+const int TRAIL_LENGTH = 32; // samples per trail, one per simulation snapshot
+
+struct TrailBuffer
+{
+    GLuint vao = 0; // no attributes; core profile still needs one bound
+    GLuint sampleBuffer = 0;
+    GLuint sampleTexture = 0; // GL_RGBA32F texture buffer view of sampleBuffer
+    int bodies = 0;
+    int head = -1;              // column of the newest sample
+    int drawBodies = 0;         // highest live body + 1 in the newest sample
+    std::vector<glm::vec4> column; // the sample being built
+    GLint headLocation = -1;
+    GLint bodiesLocation = -1;
+    GLint lengthLocation = -1;
+};
+
+// Ids are stored as floats; keep them in 1..TRAIL_MAX_ID (0 marks an empty body)
+const uint32_t TRAIL_MAX_ID = (1u << 24) - 1;
+
+// program is the trail shader program (for its uniform locations)
+bool trailsInit(TrailBuffer &trails, GLuint program, int bodies);
+void trailsDestroy(TrailBuffer &trails);
+
+// Build and upload one sample: begin (every body empty), set the live
+// bodies, end (upload the column and make it the newest)
+void trailsBeginSample(TrailBuffer &trails);
+void trailsSetBody(TrailBuffer &trails, int body, const glm::vec3 &position, uint32_t id);
+void trailsEndSample(TrailBuffer &trails);
+
+// Draw every trail with one instanced call. The trail program must already
+// be in use; the sample texture goes on unit 0.
+void trailsDraw(TrailBuffer &trails);
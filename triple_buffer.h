@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single-producer/single-consumer triple buffer. The writer fills
+// its back buffer and publishes it; the reader always takes the most recent
+// published buffer. Neither side ever waits on the other, and a buffer the
+// reader holds is never written until the reader lets go of it.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : back(0), middle(1), front(2) {}
+
+    // Writer side
+    T &writeBuffer() { return buffers[back]; }
+
+    void publish()
+    {
+        back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader side; returns true if a newer buffer was published since the last call
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T &readBuffer() const { return buffers[front]; }
+
+    // Setup only (before the threads start): touch every buffer, e.g. to preallocate
+    T &buffer(int index) { return buffers[index]; }
+
+private:
+    static const unsigned FRESH_BIT = 4;
+    static const unsigned INDEX_MASK = 3;
+
+    T buffers[3];
+    unsigned back;                // owned by the writer
+    std::atomic<unsigned> middle; // index of the shared buffer, plus FRESH_BIT
+    unsigned front;               // owned by the reader
+};